@@ -23,6 +23,7 @@
 #include "Precompiled.h"
 #include "../Container/Sort.h"
 #include "../Core/Context.h"
+#include "../Core/ParallelSort.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
@@ -438,7 +439,7 @@ void Renderer2D::UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* cam
         }
     }
 
-    Sort(soruceBatches.Begin(), soruceBatches.End(), CompareSourceBatch2Ds);
+    ParallelSort(GetSubsystem<WorkQueue>(), soruceBatches.Begin(), soruceBatches.End(), CompareSourceBatch2Ds);
 
     viewBatchInfo.batchCount_ = 0;
     Material* currMaterial = 0;
@@ -25,12 +25,15 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../IO/Log.h"
-#include "../Core/Mutex.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../IO/Serializer.h"
+#include "../Container/Sort.h"
 #include "../Audio/Sound.h"
 #include "../Audio/SoundListener.h"
 #include "../Audio/SoundSource3D.h"
+#include "../Audio/SoundStreamDecoder.h"
+#include "../Audio/OggVorbisSoundStream.h"
 
 #include <SDL/include/SDL.h>
 
@@ -45,15 +48,32 @@ static const int MIN_BUFFERLENGTH = 20;
 static const int MIN_MIXRATE = 11025;
 static const int MAX_MIXRATE = 48000;
 static const StringHash SOUND_MASTER_HASH("MASTER");
+/// Command queue capacity. Must be a power of two.
+static const unsigned COMMAND_QUEUE_SIZE = 4096;
+/// Gain below which a sound source is inaudible and always a virtual voice.
+static const float MIN_AUDIBLE_GAIN = 0.5f / 256.0f;
+/// Score multiplier of currently mixed sound sources, to keep voices from switching back and forth.
+static const float VOICE_HYSTERESIS = 1.25f;
+/// Default sound stream decoding lookahead in milliseconds.
+static const int DEFAULT_STREAM_LOOKAHEAD = 250;
 
 static void SDLAudioCallback(void *userdata, Uint8 *stream, int len);
 
 Audio::Audio(Context* context) :
     Object(context),
+    commandWrite_(0),
+    commandRead_(0),
     deviceID_(0),
     sampleSize_(0),
-    playing_(false)
+    playing_(false),
+    offline_(false),
+    maxVoices_(0),
+    numRealVoices_(0),
+    numVirtualVoices_(0),
+    streamLookahead_(DEFAULT_STREAM_LOOKAHEAD)
 {
+    commands_.Resize(COMMAND_QUEUE_SIZE);
+
     // Set the master to the default value
     masterGain_[SOUND_MASTER_HASH] = 1.0f;
 
@@ -66,6 +86,7 @@ Audio::Audio(Context* context) :
 Audio::~Audio()
 {
     Release();
+    streamDecoder_.Reset();
 }
 
 bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpolation)
@@ -121,13 +142,9 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     }
 #endif
 
-    stereo_ = obtained.channels == 2;
-    sampleSize_ = stereo_ ? sizeof(int) : sizeof(short);
     // Guarantee a fragment size that is low enough so that Vorbis decoding buffers do not wrap
-    fragmentSize_ = Min((int)NextPowerOfTwo(mixRate >> 6), (int)obtained.samples);
-    mixRate_ = obtained.freq;
-    interpolation_ = interpolation;
-    clipBuffer_ = new int[stereo ? fragmentSize_ << 1 : fragmentSize_];
+    SetFormat(obtained.freq, obtained.channels == 2, interpolation, Min((int)NextPowerOfTwo(mixRate >> 6),
+        (int)obtained.samples));
 
     LOGINFO("Set audio mode " + String(mixRate_) + " Hz " + (stereo_ ? "stereo" : "mono") + " " +
         (interpolation_ ? "interpolated" : ""));
@@ -135,6 +152,65 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     return Play();
 }
 
+bool Audio::SetOfflineMode(int mixRate, bool stereo, bool interpolation)
+{
+    Release();
+
+    mixRate = Clamp(mixRate, MIN_MIXRATE, MAX_MIXRATE);
+    SetFormat(mixRate, stereo, interpolation, NextPowerOfTwo(mixRate >> 6));
+    offline_ = true;
+
+    LOGINFO("Set offline audio mode " + String(mixRate_) + " Hz " + (stereo_ ? "stereo" : "mono") + " " +
+        (interpolation_ ? "interpolated" : ""));
+
+    return Play();
+}
+
+bool Audio::RenderToWav(Serializer& dest, float duration)
+{
+    if (!offline_)
+    {
+        LOGERROR("Audio is not in offline mode, can not render to WAV");
+        return false;
+    }
+
+    unsigned samples = (unsigned)(Max(duration, 0.0f) * mixRate_);
+    unsigned frameSize = sampleSize_ * SAMPLE_SIZE_MUL;
+    unsigned channels = stereo_ ? 2 : 1;
+    unsigned dataLength = samples * frameSize;
+
+    // Output is 16-bit integer, or 32-bit float on Emscripten
+    bool success = true;
+    success &= dest.WriteFileID("RIFF");
+    success &= dest.WriteUInt(dataLength + 36);
+    success &= dest.WriteFileID("WAVE");
+    success &= dest.WriteFileID("fmt ");
+    success &= dest.WriteUInt(16);
+    success &= dest.WriteUShort(SAMPLE_SIZE_MUL == 2 ? 3 : 1);
+    success &= dest.WriteUShort((unsigned short)channels);
+    success &= dest.WriteUInt((unsigned)mixRate_);
+    success &= dest.WriteUInt(mixRate_ * frameSize);
+    success &= dest.WriteUShort((unsigned short)frameSize);
+    success &= dest.WriteUShort((unsigned short)(frameSize / channels * 8));
+    success &= dest.WriteFileID("data");
+    success &= dest.WriteUInt(dataLength);
+
+    SharedArrayPtr<unsigned char> buffer(new unsigned char[fragmentSize_ * frameSize]);
+    while (samples && success)
+    {
+        unsigned workSamples = Min((int)samples, (int)fragmentSize_);
+        Update((float)workSamples / (float)mixRate_);
+        MixOutput(buffer.Get(), workSamples);
+        success &= dest.Write(buffer.Get(), workSamples * frameSize) == workSamples * frameSize;
+        samples -= workSamples;
+    }
+
+    if (!success)
+        LOGERROR("Could not write rendered audio");
+
+    return success;
+}
+
 void Audio::Update(float timeStep)
 {
     PROFILE(UpdateAudio);
@@ -142,6 +218,19 @@ void Audio::Update(float timeStep)
     // Update in reverse order, because sound sources might remove themselves
     for (unsigned i = soundSources_.Size() - 1; i < soundSources_.Size(); --i)
         soundSources_[i]->Update(timeStep);
+
+    UpdateVoices();
+
+    // Release sounds and streams the audio thread is done with. The sequence numbers are in increasing order
+    unsigned numReleased = 0;
+    while (numReleased < pendingReleases_.Size() && IsCommandProcessed(pendingReleases_[numReleased].first_))
+        ++numReleased;
+    if (numReleased)
+        pendingReleases_.Erase(0, numReleased);
+
+    // Stop decoding streams that are no longer played
+    if (streamDecoder_)
+        streamDecoder_->ReleaseUnusedStreams();
 }
 
 bool Audio::Play()
@@ -149,13 +238,14 @@ bool Audio::Play()
     if (playing_)
         return true;
 
-    if (!deviceID_)
+    if (!deviceID_ && !offline_)
     {
         LOGERROR("No audio mode set, can not start playback");
         return false;
     }
 
-    SDL_PauseAudioDevice(deviceID_, 0);
+    if (deviceID_)
+        SDL_PauseAudioDevice(deviceID_, 0);
 
     playing_ = true;
     return true;
@@ -188,6 +278,16 @@ void Audio::StopSound(Sound* soundClip)
     }
 }
 
+void Audio::SetMaxVoices(unsigned voices)
+{
+    maxVoices_ = voices;
+}
+
+void Audio::SetStreamLookahead(int msec)
+{
+    streamLookahead_ = Max(msec, 0);
+}
+
 float Audio::GetMasterGain(const String& type) const
 {
     // By definition previously unknown types return full volume
@@ -205,8 +305,12 @@ SoundListener* Audio::GetListener() const
 
 void Audio::AddSoundSource(SoundSource* channel)
 {
-    MutexLock lock(audioMutex_);
     soundSources_.Push(channel);
+
+    AudioCommand command;
+    command.type_ = AUDIO_ADD_SOURCE;
+    command.source_ = channel;
+    SendCommand(command);
 }
 
 void Audio::RemoveSoundSource(SoundSource* channel)
@@ -214,11 +318,54 @@ void Audio::RemoveSoundSource(SoundSource* channel)
     PODVector<SoundSource*>::Iterator i = soundSources_.Find(channel);
     if (i != soundSources_.End())
     {
-        MutexLock lock(audioMutex_);
         soundSources_.Erase(i);
+
+        AudioCommand command;
+        command.type_ = AUDIO_REMOVE_SOURCE;
+        command.source_ = channel;
+        SendCommand(command);
+
+        // The sound source is being destroyed, so the audio thread must not refer to it after returning
+        if (!IsCommandProcessed(commandWrite_))
+            FlushCommands();
     }
 }
 
+unsigned Audio::SendCommand(const AudioCommand& command)
+{
+    // Without an audio device there is no audio thread, so execute immediately
+    if (!deviceID_)
+    {
+        ExecuteCommand(command);
+        return commandWrite_;
+    }
+
+    // If the audio thread has fallen a full queue behind, execute the pending commands here
+    if (commandWrite_ - commandRead_ >= COMMAND_QUEUE_SIZE)
+        FlushCommands();
+
+    commands_[commandWrite_ & (COMMAND_QUEUE_SIZE - 1)] = command;
+    // Make sure the command is written before the audio thread can see it
+    SDL_MemoryBarrierRelease();
+    commandWrite_ = commandWrite_ + 1;
+    return commandWrite_;
+}
+
+bool Audio::IsCommandProcessed(unsigned sequence) const
+{
+    unsigned read = commandRead_;
+    SDL_MemoryBarrierAcquire();
+    return (int)(read - sequence) >= 0;
+}
+
+void Audio::ReleaseAfterMix(RefCounted* object)
+{
+    if (!object || IsCommandProcessed(commandWrite_))
+        return;
+
+    pendingReleases_.Push(MakePair((unsigned)commandWrite_, SharedPtr<RefCounted>(object)));
+}
+
 float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
 {
     HashMap<StringHash, Variant>::ConstIterator masterIt = masterGain_.Find(SOUND_MASTER_HASH);
@@ -237,14 +384,39 @@ float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
 void SDLAudioCallback(void *userdata, Uint8* stream, int len)
 {
     Audio* audio = static_cast<Audio*>(userdata);
+    audio->MixOutput(stream, len / audio->GetSampleSize() / Audio::SAMPLE_SIZE_MUL);
+}
+
+void Audio::PrefetchStream(SoundStream* stream)
+{
+    // Offline output is mixed on request, so decode in the mixing thread to keep the output deterministic
+    if (!streamLookahead_ || offline_)
+        return;
+
+    OggVorbisSoundStream* oggStream = dynamic_cast<OggVorbisSoundStream*>(stream);
+    if (!oggStream || oggStream->IsPrefetching())
+        return;
+
+    if (!streamDecoder_)
     {
-        MutexLock Lock(audio->GetMutex());
-        audio->MixOutput(stream, len / audio->GetSampleSize() / Audio::SAMPLE_SIZE_MUL);
+        streamDecoder_ = new SoundStreamDecoder();
+        if (!streamDecoder_->Run())
+        {
+            LOGWARNING("Could not start sound stream decoder thread, decoding sound streams in the audio thread");
+            streamLookahead_ = 0;
+            streamDecoder_.Reset();
+            return;
+        }
     }
+
+    oggStream->EnablePrefetch(oggStream->GetSampleSize() * oggStream->GetIntFrequency() * streamLookahead_ / 1000,
+        streamDecoder_);
 }
 
 void Audio::MixOutput(void *dest, unsigned samples)
 {
+    ProcessCommands();
+
     if (!playing_ || !clipBuffer_)
     {
         memset(dest, 0, samples * sampleSize_ * SAMPLE_SIZE_MUL);
@@ -264,7 +436,7 @@ void Audio::MixOutput(void *dest, unsigned samples)
         memset(clipPtr, 0, clipSamples * sizeof(int));
 
         // Mix samples to clip buffer
-        for (PODVector<SoundSource*>::Iterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+        for (PODVector<SoundSource*>::Iterator i = mixSources_.Begin(); i != mixSources_.End(); ++i)
             (*i)->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
 
         // Copy output from clip buffer to destination
@@ -298,7 +470,123 @@ void Audio::Release()
         SDL_CloseAudioDevice(deviceID_);
         deviceID_ = 0;
         clipBuffer_.Reset();
+
+        // The audio thread has stopped, so execute the remaining commands and release everything it used
+        ProcessCommands();
+        pendingReleases_.Clear();
     }
+
+    if (offline_)
+    {
+        offline_ = false;
+        clipBuffer_.Reset();
+    }
+}
+
+void Audio::SetFormat(int mixRate, bool stereo, bool interpolation, unsigned fragmentSize)
+{
+    stereo_ = stereo;
+    sampleSize_ = stereo_ ? sizeof(int) : sizeof(short);
+    fragmentSize_ = fragmentSize;
+    mixRate_ = mixRate;
+    interpolation_ = interpolation;
+    clipBuffer_ = new int[stereo_ ? fragmentSize_ << 1 : fragmentSize_];
+}
+
+static bool CompareVoiceCandidates(const Pair<float, SoundSource*>& lhs, const Pair<float, SoundSource*>& rhs)
+{
+    return lhs.first_ > rhs.first_;
+}
+
+void Audio::UpdateVoices()
+{
+    // Score the playing sound sources by audibility and priority. Inaudible sound sources do not need a voice
+    voiceCandidates_.Clear();
+    for (PODVector<SoundSource*>::ConstIterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+    {
+        SoundSource* source = *i;
+        // Stopped sound sources keep a real voice so that their onset is mixed as soon as playback starts
+        if (!source->IsPlaying())
+        {
+            source->SetVirtual(false);
+            continue;
+        }
+
+        float audibility = source->GetAudibility();
+        if (audibility < MIN_AUDIBLE_GAIN)
+            source->SetVirtual(true);
+        else
+        {
+            float score = audibility * source->GetPriority();
+            if (!source->IsVirtual())
+                score *= VOICE_HYSTERESIS;
+            voiceCandidates_.Push(MakePair(score, source));
+        }
+    }
+
+    // Mix the highest scoring sound sources up to the voice limit, the rest become virtual voices
+    unsigned numRealVoices = voiceCandidates_.Size();
+    if (maxVoices_ && numRealVoices > maxVoices_)
+    {
+        Sort(voiceCandidates_.Begin(), voiceCandidates_.End(), CompareVoiceCandidates);
+        numRealVoices = maxVoices_;
+    }
+
+    for (unsigned i = 0; i < voiceCandidates_.Size(); ++i)
+        voiceCandidates_[i].second_->SetVirtual(i >= numRealVoices);
+
+    numRealVoices_ = numRealVoices;
+    numVirtualVoices_ = 0;
+    for (PODVector<SoundSource*>::ConstIterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+    {
+        if ((*i)->IsPlaying() && (*i)->IsVirtual())
+            ++numVirtualVoices_;
+        (*i)->SendParams();
+    }
+}
+
+void Audio::ProcessCommands()
+{
+    unsigned write = commandWrite_;
+    // Make sure the commands are read only after seeing the write position
+    SDL_MemoryBarrierAcquire();
+
+    unsigned read = commandRead_;
+    while (read != write)
+    {
+        ExecuteCommand(commands_[read & (COMMAND_QUEUE_SIZE - 1)]);
+        ++read;
+    }
+
+    // Make sure the commands are executed before the main thread can see them as processed
+    SDL_MemoryBarrierRelease();
+    commandRead_ = read;
+}
+
+void Audio::ExecuteCommand(const AudioCommand& command)
+{
+    switch (command.type_)
+    {
+    case AUDIO_ADD_SOURCE:
+        mixSources_.Push(command.source_);
+        break;
+
+    case AUDIO_REMOVE_SOURCE:
+        mixSources_.Remove(command.source_);
+        break;
+
+    default:
+        command.source_->ExecuteCommand(command);
+        break;
+    }
+}
+
+void Audio::FlushCommands()
+{
+    // Locking the device waits for the audio callback to return and keeps it from running
+    SDL_LockAudioDevice(deviceID_);
+    ProcessCommands();
+    SDL_UnlockAudioDevice(deviceID_);
 }
 
 void RegisterAudioLibrary(Context* context)
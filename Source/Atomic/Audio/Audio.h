@@ -24,16 +24,80 @@
 
 #include "../Container/ArrayPtr.h"
 #include "../Audio/AudioDefs.h"
-#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
 namespace Atomic
 {
 
 class AudioImpl;
+class Serializer;
 class Sound;
 class SoundListener;
 class SoundSource;
+class SoundStream;
+class SoundStreamDecoder;
+
+/// Mixing parameters of a sound source.
+struct SoundSourceParams
+{
+    /// Construct with defaults.
+    SoundSourceParams() :
+        frequency_(0.0f),
+        gain_(0.0f),
+        panning_(0.0f),
+        enabled_(false),
+        virtual_(false)
+    {
+    }
+
+    /// Test for inequality.
+    bool operator !=(const SoundSourceParams& rhs) const
+    {
+        return frequency_ != rhs.frequency_ || gain_ != rhs.gain_ || panning_ != rhs.panning_ || enabled_ != rhs.enabled_ ||
+            virtual_ != rhs.virtual_;
+    }
+
+    /// Frequency.
+    float frequency_;
+    /// Total gain, including master gain and attenuation.
+    float gain_;
+    /// Stereo panning.
+    float panning_;
+    /// Enabled flag.
+    bool enabled_;
+    /// Virtual voice flag. A virtual voice advances its playback position without being mixed.
+    bool virtual_;
+};
+
+/// %Audio command type.
+enum AudioCommandType
+{
+    AUDIO_ADD_SOURCE = 0,
+    AUDIO_REMOVE_SOURCE,
+    AUDIO_SET_PARAMS,
+    AUDIO_PLAY,
+    AUDIO_STOP,
+    AUDIO_SET_POSITION
+};
+
+/// Command from the main thread to the audio thread.
+struct AudioCommand
+{
+    /// Command type.
+    AudioCommandType type_;
+    /// Sound source.
+    SoundSource* source_;
+    /// Mixing parameters.
+    SoundSourceParams params_;
+    /// Sound to play.
+    Sound* sound_;
+    /// Sound stream to play.
+    SoundStream* stream_;
+    /// Decode buffer of the sound stream.
+    Sound* streamBuffer_;
+    /// Playback position.
+    signed char* position_;
+};
 
 /// %Audio subsystem.
 class ATOMIC_API Audio : public Object
@@ -48,6 +112,10 @@ public:
 
     /// Initialize sound output with specified buffer length and output mode.
     bool SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpolation = true);
+    /// Initialize offline sound output without an audio device. Output is mixed only on request by MixOutput() or RenderToWav(), in the calling thread.
+    bool SetOfflineMode(int mixRate, bool stereo, bool interpolation = true);
+    /// Mix output in offline mode and write it to a WAV file. Updates the sound sources before each mixed fragment with the corresponding time step. Return true if successful.
+    bool RenderToWav(Serializer& dest, float duration);
     /// Run update on sound sources. Not required for continued playback, but frees unused sound sources & sounds and updates 3D positions.
     void Update(float timeStep);
     /// Restart sound output.
@@ -60,6 +128,10 @@ public:
     void SetListener(SoundListener* listener);
     /// Stop any sound source playing a certain sound clip.
     void StopSound(Sound* sound);
+    /// Set maximum number of sound sources to mix. The rest of the playing sound sources become virtual voices. 0 (default) is unlimited.
+    void SetMaxVoices(unsigned voices);
+    /// Set how far ahead to decode compressed sound streams in a background thread, in milliseconds. 0 decodes in the audio thread. Affects streams started afterward.
+    void SetStreamLookahead(int msec);
 
     /// Return byte size of one sample.
     unsigned GetSampleSize() const { return sampleSize_; }
@@ -71,26 +143,42 @@ public:
     bool IsStereo() const { return stereo_; }
     /// Return whether audio is being output.
     bool IsPlaying() const { return playing_; }
-    /// Return whether an audio stream has been reserved.
-    bool IsInitialized() const { return deviceID_ != 0; }
+    /// Return whether an audio stream has been reserved, or offline output initialized.
+    bool IsInitialized() const { return deviceID_ != 0 || offline_; }
+    /// Return whether output is mixed offline instead of by an audio device.
+    bool IsOffline() const { return offline_; }
     /// Return master gain for a specific sound source type. Unknown sound types will return full gain (1).
     float GetMasterGain(const String& type) const;
     /// Return active sound listener.
     SoundListener* GetListener() const;
     /// Return all sound sources.
     const PODVector<SoundSource*>& GetSoundSources() const { return soundSources_; }
+    /// Return maximum number of sound sources to mix.
+    unsigned GetMaxVoices() const { return maxVoices_; }
+    /// Return number of playing sound sources that are mixed.
+    unsigned GetNumRealVoices() const { return numRealVoices_; }
+    /// Return number of playing sound sources that are virtual voices.
+    unsigned GetNumVirtualVoices() const { return numVirtualVoices_; }
+    /// Return how far ahead compressed sound streams are decoded in a background thread, in milliseconds.
+    int GetStreamLookahead() const { return streamLookahead_; }
 
     /// Return whether the specified master gain has been defined.
     bool HasMasterGain(const String& type) const { return masterGain_.Contains(type); }
 
     /// Add a sound source to keep track of. Called by SoundSource.
     void AddSoundSource(SoundSource* soundSource);
-    /// Remove a sound source. Called by SoundSource.
+    /// Remove a sound source. Called by SoundSource. Waits until the audio thread no longer refers to the sound source.
     void RemoveSoundSource(SoundSource* soundSource);
-    /// Return audio thread mutex.
-    Mutex& GetMutex() { return audioMutex_; }
+    /// Send a command to the audio thread without blocking it. Return the sequence number of the command. Called by SoundSource.
+    unsigned SendCommand(const AudioCommand& command);
+    /// Return whether the audio thread has processed a command.
+    bool IsCommandProcessed(unsigned sequence) const;
+    /// Keep an object alive until the audio thread has processed the commands sent so far. Called by SoundSource when replacing a sound or stream.
+    void ReleaseAfterMix(RefCounted* object);
     /// Return sound type specific gain multiplied by master gain.
     float GetSoundSourceMasterGain(StringHash typeHash) const;
+    /// Start decoding a sound stream ahead in the background decoder's thread if possible. Called by SoundSource before starting playback of a stream.
+    void PrefetchStream(SoundStream* stream);
 
     /// Mix sound sources into the buffer.
     void MixOutput(void *dest, unsigned samples);
@@ -106,10 +194,27 @@ private:
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
     /// Stop sound output and release the sound buffer.
     void Release();
+    /// Set up the output format and the clip buffer.
+    void SetFormat(int mixRate, bool stereo, bool interpolation, unsigned fragmentSize);
+    /// Choose the sound sources to mix and send the mixing parameters of all sound sources.
+    void UpdateVoices();
+    /// Execute the commands sent by the main thread. Called in the audio thread, or in the main thread when there is no audio thread.
+    void ProcessCommands();
+    /// Execute a command.
+    void ExecuteCommand(const AudioCommand& command);
+    /// Execute the pending commands in the main thread while the audio device is locked.
+    void FlushCommands();
+
     /// Clipping buffer for mixing.
     SharedArrayPtr<int> clipBuffer_;
-    /// Audio thread mutex.
-    Mutex audioMutex_;
+    /// Command queue from the main thread to the audio thread.
+    PODVector<AudioCommand> commands_;
+    /// Number of commands sent. Written only by the main thread.
+    volatile unsigned commandWrite_;
+    /// Number of commands processed. Written only by the audio thread.
+    volatile unsigned commandRead_;
+    /// Objects to release once the audio thread has processed the command with the stored sequence number.
+    Vector<Pair<unsigned, SharedPtr<RefCounted> > > pendingReleases_;
     /// SDL audio device ID.
     unsigned deviceID_;
     /// Sample size.
@@ -124,12 +229,28 @@ private:
     bool stereo_;
     /// Playing flag.
     bool playing_;
+    /// Offline output flag.
+    bool offline_;
     /// Master gain by sound source type.
     HashMap<StringHash, Variant> masterGain_;
     /// Sound sources.
     PODVector<SoundSource*> soundSources_;
+    /// Sound sources being mixed. Accessed only by the audio thread.
+    PODVector<SoundSource*> mixSources_;
+    /// Playing sound sources competing for voices.
+    PODVector<Pair<float, SoundSource*> > voiceCandidates_;
+    /// Maximum number of sound sources to mix.
+    unsigned maxVoices_;
+    /// Number of playing sound sources that are mixed.
+    unsigned numRealVoices_;
+    /// Number of playing sound sources that are virtual voices.
+    unsigned numVirtualVoices_;
     /// Sound listener.
     WeakPtr<SoundListener> listener_;
+    /// Background decoder of compressed sound streams.
+    SharedPtr<SoundStreamDecoder> streamDecoder_;
+    /// Sound stream decoding lookahead in milliseconds.
+    int streamLookahead_;
 };
 
 /// Register Audio library objects.
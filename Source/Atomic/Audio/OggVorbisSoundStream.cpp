@@ -23,6 +23,9 @@
 #include "Precompiled.h"
 #include "../Audio/OggVorbisSoundStream.h"
 #include "../Audio/Sound.h"
+#include "../Audio/SoundStreamDecoder.h"
+
+#include <SDL/include/SDL.h>
 
 #include <STB/stb_vorbis.h>
 
@@ -31,7 +34,14 @@
 namespace Atomic
 {
 
-OggVorbisSoundStream::OggVorbisSoundStream(const Sound* sound)
+/// Maximum bytes to decode for one stream at a time, so that the other streams are not held up.
+static const unsigned PREFETCH_CHUNK_SIZE = 16384;
+
+OggVorbisSoundStream::OggVorbisSoundStream(const Sound* sound) :
+    prefetchSize_(0),
+    readPos_(0),
+    writePos_(0),
+    ended_(false)
 {
     assert(sound && sound->IsCompressed());
     
@@ -59,6 +69,94 @@ OggVorbisSoundStream::~OggVorbisSoundStream()
 }
 
 unsigned OggVorbisSoundStream::GetData(signed char* dest, unsigned numBytes)
+{
+    if (!prefetchBuffer_)
+        return DecodeData(dest, numBytes);
+
+    // Check for the end before the amount of data, so that no data decoded before the end is missed
+    bool ended = ended_;
+    SDL_MemoryBarrierAcquire();
+    unsigned available = writePos_ - readPos_;
+    SDL_MemoryBarrierAcquire();
+
+    unsigned copyBytes = numBytes < available ? numBytes : available;
+    unsigned readIndex = readPos_ % prefetchSize_;
+    unsigned firstBytes = prefetchSize_ - readIndex;
+    if (firstBytes > copyBytes)
+        firstBytes = copyBytes;
+    memcpy(dest, prefetchBuffer_.Get() + readIndex, firstBytes);
+    if (copyBytes > firstBytes)
+        memcpy(dest + firstBytes, prefetchBuffer_.Get(), copyBytes - firstBytes);
+
+    // Make sure the data has been copied before the decoder may overwrite it
+    SDL_MemoryBarrierRelease();
+    readPos_ += copyBytes;
+
+    if (copyBytes < numBytes && !ended)
+    {
+        // The decoder has fallen behind: output silence rather than let the sound source stop
+        memset(dest + copyBytes, 0, numBytes - copyBytes);
+        return numBytes;
+    }
+
+    return copyBytes;
+}
+
+void OggVorbisSoundStream::EnablePrefetch(unsigned bufferSize, SoundStreamDecoder* decoder)
+{
+    if (!decoder_ || !decoder || prefetchBuffer_)
+        return;
+
+    // Keep the buffer size a multiple of the sample size so that decoding never splits a sample
+    unsigned sampleSize = GetSampleSize();
+    prefetchSize_ = bufferSize >= sampleSize ? bufferSize - bufferSize % sampleSize : sampleSize;
+    prefetchBuffer_ = new signed char[prefetchSize_];
+    readPos_ = 0;
+    writePos_ = 0;
+    ended_ = false;
+
+    // Fill the buffer now so that playback can start without waiting for the decoder thread
+    while (Prefetch())
+    {
+    }
+
+    decoder->AddStream(this);
+}
+
+unsigned OggVorbisSoundStream::Prefetch()
+{
+    if (ended_)
+        return 0;
+
+    unsigned freeBytes = prefetchSize_ - (writePos_ - readPos_);
+    // Make sure the mixing thread has finished copying the data before overwriting it
+    SDL_MemoryBarrierAcquire();
+
+    unsigned writeIndex = writePos_ % prefetchSize_;
+    unsigned decodeBytes = prefetchSize_ - writeIndex;
+    if (decodeBytes > freeBytes)
+        decodeBytes = freeBytes;
+    if (decodeBytes > PREFETCH_CHUNK_SIZE)
+        decodeBytes = PREFETCH_CHUNK_SIZE;
+    decodeBytes -= decodeBytes % GetSampleSize();
+    if (!decodeBytes)
+        return 0;
+
+    unsigned outBytes = DecodeData(prefetchBuffer_.Get() + writeIndex, decodeBytes);
+
+    // Publish the data before the end flag
+    SDL_MemoryBarrierRelease();
+    writePos_ += outBytes;
+    if (outBytes < decodeBytes && stopAtEnd_)
+    {
+        SDL_MemoryBarrierRelease();
+        ended_ = true;
+    }
+
+    return outBytes;
+}
+
+unsigned OggVorbisSoundStream::DecodeData(signed char* dest, unsigned numBytes)
 {
     if (!decoder_)
         return 0;
@@ -23,12 +23,14 @@
 #pragma once
 
 #include "../Container/ArrayPtr.h"
+#include "../Container/Ptr.h"
 #include "../Audio/SoundStream.h"
 
 namespace Atomic
 {
 
 class Sound;
+class SoundStreamDecoder;
 
 /// Ogg Vorbis sound stream.
 class ATOMIC_API OggVorbisSoundStream : public SoundStream
@@ -39,16 +41,37 @@ public:
     /// Destruct.
     ~OggVorbisSoundStream();
     
-    /// Produce sound data into destination. Return number of bytes produced. Called by SoundSource from the mixing thread.
+    /// Produce sound data into destination. Return number of bytes produced. Called by SoundSource from the mixing thread. With prefetch enabled only copies already decoded data, and fills with silence if the decoder has fallen behind.
     virtual unsigned GetData(signed char* dest, unsigned numBytes);
-    
+
+    /// Decode ahead into a buffer of the specified size in the background decoder's thread. Fills the buffer before returning. Must be called before playback starts.
+    void EnablePrefetch(unsigned bufferSize, SoundStreamDecoder* decoder);
+    /// Decode into the free space of the prefetch buffer. Return number of bytes decoded. Called by the background decoder.
+    unsigned Prefetch();
+
+    /// Return whether decodes ahead in the background decoder's thread.
+    bool IsPrefetching() const { return prefetchBuffer_.NotNull(); }
+
 protected:
+    /// Decode sound data into destination, rewinding if looped. Return number of bytes produced.
+    unsigned DecodeData(signed char* dest, unsigned numBytes);
+
     /// Decoder state.
     void* decoder_;
     /// Compressed sound data.
     SharedArrayPtr<signed char> data_;
     /// Compressed sound data size in bytes.
     unsigned dataSize_;
+    /// Prefetch buffer of decoded sound data.
+    SharedArrayPtr<signed char> prefetchBuffer_;
+    /// Prefetch buffer size in bytes.
+    unsigned prefetchSize_;
+    /// Total bytes read from the prefetch buffer. Written only by the mixing thread.
+    volatile unsigned readPos_;
+    /// Total bytes decoded into the prefetch buffer. Written only by the decoding thread.
+    volatile unsigned writePos_;
+    /// End of a non-looped stream reached by the decoder flag.
+    volatile bool ended_;
 };
 
 }
@@ -30,66 +30,195 @@
 
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ATOMIC_AUDIO_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Atomic
 {
 
-#define INC_POS_LOOPED() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_ONESHOT() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define INC_POS_STEREO_LOOPED() \
-    pos += (intAdd << 1); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_STEREO_ONESHOT() \
-    pos += (intAdd << 1); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define GET_IP_SAMPLE() (((((int)pos[1] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_LEFT() (((((int)pos[2] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_RIGHT() (((((int)pos[3] - (int)pos[1]) * fractPos) / 65536) + (int)pos[1])
+/// Source position of the mixing loops.
+template <class T> struct MixPosition
+{
+    /// Current sample.
+    T* pos_;
+    /// End of the sound.
+    T* end_;
+    /// Loop start of the sound.
+    T* repeat_;
+    /// Fractional position in 1/65536ths of a sample frame.
+    int fractPos_;
+    /// Whole sample frames to advance per output sample.
+    int intAdd_;
+    /// Fractional sample frames to advance per output sample.
+    int fractAdd_;
+};
+
+/// Advance the source position by one output sample. Return false if a one-shot sound ended.
+template <class T, unsigned SrcChannels, bool Looped> inline bool AdvancePosition(MixPosition<T>& position)
+{
+    position.pos_ += position.intAdd_ * SrcChannels;
+    position.fractPos_ += position.fractAdd_;
+    if (position.fractPos_ > 65535)
+    {
+        position.fractPos_ &= 65535;
+        position.pos_ += SrcChannels;
+    }
+
+    if (Looped)
+    {
+        while (position.pos_ >= position.end_)
+            position.pos_ -= (position.end_ - position.repeat_);
+    }
+    else if (position.pos_ >= position.end_)
+    {
+        position.pos_ = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/// Return a channel of a source sample, interpolated if requested.
+template <class T, unsigned SrcChannels, bool Interpolate> inline int GetSample(const T* pos, int fractPos, unsigned channel)
+{
+    int sample = pos[channel];
+    if (Interpolate)
+        sample += (((int)pos[channel + SrcChannels] - sample) * fractPos) / 65536;
+    return sample;
+}
+
+/// Apply volume to a 16-bit sample.
+inline int ApplyVolume(int sample, int vol, const short*) { return (sample * vol) / 256; }
+
+/// Apply volume to an 8-bit sample.
+inline int ApplyVolume(int sample, int vol, const signed char*) { return sample * vol; }
+
+/// Mix one source sample to the destination buffer.
+template <class T, unsigned SrcChannels, bool StereoDest, bool Interpolate> inline void MixSample(int*& dest, const T* pos,
+    int fractPos, int leftVol, int rightVol)
+{
+    if (SrcChannels == 1)
+    {
+        int s = GetSample<T, 1, Interpolate>(pos, fractPos, 0);
+        *dest = *dest + ApplyVolume(s, leftVol, pos);
+        ++dest;
+        if (StereoDest)
+        {
+            *dest = *dest + ApplyVolume(s, rightVol, pos);
+            ++dest;
+        }
+    }
+    else
+    {
+        int left = GetSample<T, 2, Interpolate>(pos, fractPos, 0);
+        int right = GetSample<T, 2, Interpolate>(pos, fractPos, 1);
+        if (StereoDest)
+        {
+            *dest = *dest + ApplyVolume(left, leftVol, pos);
+            ++dest;
+            *dest = *dest + ApplyVolume(right, rightVol, pos);
+            ++dest;
+        }
+        else
+        {
+            *dest = *dest + ApplyVolume((left + right) / 2, leftVol, pos);
+            ++dest;
+        }
+    }
+}
+
+#ifdef ATOMIC_AUDIO_SSE2
+/// Return volume as a floating point multiplier for 16-bit samples.
+inline float GetVolumeScale(int vol, const short*) { return (float)vol / 256.0f; }
+
+/// Return volume as a floating point multiplier for 8-bit samples.
+inline float GetVolumeScale(int vol, const signed char*) { return (float)vol; }
+
+/// Mix four gathered source samples to the destination buffer.
+template <bool StereoDest> inline void MixBlock(int*& dest, __m128 left, __m128 right, __m128 leftScale, __m128 rightScale)
+{
+    __m128i leftOut = _mm_cvttps_epi32(_mm_mul_ps(left, leftScale));
+    if (StereoDest)
+    {
+        __m128i rightOut = _mm_cvttps_epi32(_mm_mul_ps(right, rightScale));
+        __m128i* destPtr = reinterpret_cast<__m128i*>(dest);
+        _mm_storeu_si128(destPtr, _mm_add_epi32(_mm_loadu_si128(destPtr), _mm_unpacklo_epi32(leftOut, rightOut)));
+        _mm_storeu_si128(destPtr + 1, _mm_add_epi32(_mm_loadu_si128(destPtr + 1), _mm_unpackhi_epi32(leftOut, rightOut)));
+        dest += 8;
+    }
+    else
+    {
+        __m128i* destPtr = reinterpret_cast<__m128i*>(dest);
+        _mm_storeu_si128(destPtr, _mm_add_epi32(_mm_loadu_si128(destPtr), leftOut));
+        dest += 4;
+    }
+}
+#endif
+
+/// Mix source samples to the destination buffer, advancing the source position.
+template <class T, unsigned SrcChannels, bool StereoDest, bool Interpolate, bool Looped> void MixSamples(int* dest,
+    unsigned samples, MixPosition<T>& position, int leftVol, int rightVol)
+{
+#ifdef ATOMIC_AUDIO_SSE2
+    // Gather four output samples at a time, then interpolate, apply volume and accumulate them with SIMD. Stepping
+    // the source position stays scalar, as each step depends on the previous
+    const __m128 fractScale = _mm_set1_ps(1.0f / 65536.0f);
+    const __m128 leftScale = _mm_set1_ps(GetVolumeScale(leftVol, position.pos_));
+    const __m128 rightScale = _mm_set1_ps(GetVolumeScale(rightVol, position.pos_));
+    float left0[4], left1[4], right0[4], right1[4], fract[4];
+
+    while (samples >= 4)
+    {
+        // A one-shot sound must not end within the block
+        if (!Looped && (position.end_ - position.pos_ - 1) / (int)SrcChannels < (position.intAdd_ + 1) * 4)
+            break;
+
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            const T* pos = position.pos_;
+            left0[i] = pos[0];
+            right0[i] = pos[SrcChannels - 1];
+            if (Interpolate)
+            {
+                left1[i] = pos[SrcChannels];
+                right1[i] = pos[SrcChannels * 2 - 1];
+                fract[i] = (float)position.fractPos_;
+            }
+            AdvancePosition<T, SrcChannels, true>(position);
+        }
+
+        __m128 left = _mm_loadu_ps(left0);
+        __m128 right = _mm_loadu_ps(right0);
+        if (Interpolate)
+        {
+            __m128 t = _mm_mul_ps(_mm_loadu_ps(fract), fractScale);
+            left = _mm_add_ps(left, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(left1), left), t));
+            if (SrcChannels == 2)
+                right = _mm_add_ps(right, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(right1), right), t));
+        }
+
+        if (SrcChannels == 1)
+            MixBlock<StereoDest>(dest, left, left, leftScale, rightScale);
+        else if (StereoDest)
+            MixBlock<StereoDest>(dest, left, right, leftScale, rightScale);
+        else
+            MixBlock<StereoDest>(dest, _mm_mul_ps(_mm_add_ps(left, right), _mm_set1_ps(0.5f)), left, leftScale, rightScale);
+
+        samples -= 4;
+    }
+#endif
+
+    while (samples--)
+    {
+        MixSample<T, SrcChannels, StereoDest, Interpolate>(dest, position.pos_, position.fractPos_, leftVol, rightVol);
+        if (!AdvancePosition<T, SrcChannels, Looped>(position))
+            break;
+    }
+}
 
 static const float AUTOREMOVE_DELAY = 0.25f;
 
@@ -106,11 +235,18 @@ SoundSource::SoundSource(Context* context) :
     attenuation_(1.0f),
     panning_(0.0f),
     autoRemoveTimer_(0.0f),
+    priority_(1.0f),
     autoRemove_(false),
+    virtual_(false),
     position_(0),
     fractPosition_(0),
     timePosition_(0.0f),
-    unusedStreamSize_(0)
+    unusedStreamSize_(0),
+    mixSound_(0),
+    mixStream_(0),
+    mixStreamBuffer_(0),
+    playCommand_(0),
+    playRequested_(false)
 {
     audio_ = GetSubsystem<Audio>();
 
@@ -137,6 +273,7 @@ void SoundSource::RegisterObject(Context* context)
     ATTRIBUTE("Gain", float, gain_, 1.0f, AM_DEFAULT);
     ATTRIBUTE("Attenuation", float, attenuation_, 1.0f, AM_DEFAULT);
     ATTRIBUTE("Panning", float, panning_, 0.0f, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Priority", GetPriority, SetPriority, float, 1.0f, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE("Is Playing", IsPlaying, SetPlayingAttr, bool, false, AM_DEFAULT);
     ATTRIBUTE("Autoremove on Stop", bool, autoRemove_, false, AM_FILE);
     ACCESSOR_ATTRIBUTE("Play Position", GetPositionAttr, SetPositionAttr, int, 0, AM_FILE);
@@ -151,14 +288,7 @@ void SoundSource::Play(Sound* sound)
     if (frequency_ == 0.0f && sound)
         SetFrequency(sound->GetFrequency());
 
-    // If sound source is currently playing, have to lock the audio mutex
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        PlayLockless(sound);
-    }
-    else
-        PlayLockless(sound);
+    PlayInternal(sound);
 
     MarkNetworkUpdate();
 }
@@ -193,21 +323,8 @@ void SoundSource::Play(SoundStream* stream)
     if (frequency_ == 0.0f && stream)
         SetFrequency(stream->GetFrequency());
 
-    SharedPtr<SoundStream> streamPtr(stream);
-
-    // If sound source is currently playing, have to lock the audio mutex. When stream playback is explicitly
-    // requested, clear the existing sound if any
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        sound_.Reset();
-        PlayLockless(streamPtr);
-    }
-    else
-    {
-        sound_.Reset();
-        PlayLockless(streamPtr);
-    }
+    // When stream playback is explicitly requested, clear the existing sound if any
+    PlayInternal(SharedPtr<SoundStream>(stream), 0);
 
     // Stream playback is not supported for network replication, no need to mark network dirty
 }
@@ -217,14 +334,7 @@ void SoundSource::Stop()
     if (!audio_)
         return;
 
-    // If sound source is currently playing, have to lock the audio mutex
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        StopLockless();
-    }
-    else
-        StopLockless();
+    StopInternal();
 
     MarkNetworkUpdate();
 }
@@ -270,9 +380,30 @@ void SoundSource::SetAutoRemove(bool enable)
     autoRemove_ = enable;
 }
 
+void SoundSource::SetPriority(float priority)
+{
+    priority_ = Max(priority, 0.0f);
+    MarkNetworkUpdate();
+}
+
 bool SoundSource::IsPlaying() const
 {
-    return (sound_ || soundStream_) && position_ != 0;
+    if (!sound_ && !soundStream_)
+        return false;
+
+    // Until the audio thread has seen the last play or stop, report the requested state
+    if (audio_ && !audio_->IsCommandProcessed(playCommand_))
+        return playRequested_;
+
+    return position_ != 0;
+}
+
+float SoundSource::GetAudibility() const
+{
+    if (!IsPlaying() || !IsEnabledEffective())
+        return 0.0f;
+
+    return masterGain_ * attenuation_ * gain_;
 }
 
 void SoundSource::SetPlayPosition(signed char* pos)
@@ -281,8 +412,22 @@ void SoundSource::SetPlayPosition(signed char* pos)
     if (!audio_ || !sound_ || soundStream_)
         return;
 
-    MutexLock lock(audio_->GetMutex());
-    SetPlayPositionLockless(pos);
+    signed char* start = sound_->GetStart();
+    signed char* end = sound_->GetEnd();
+    if (pos < start)
+        pos = start;
+    if (sound_->IsSixteenBit() && (pos - start) & 1)
+        ++pos;
+    if (pos > end)
+        pos = end;
+
+    AudioCommand command;
+    command.type_ = AUDIO_SET_POSITION;
+    command.source_ = this;
+    command.sound_ = sound_;
+    command.position_ = pos;
+    playCommand_ = audio_->SendCommand(command);
+    playRequested_ = true;
 }
 
 void SoundSource::Update(float timeStep)
@@ -295,8 +440,8 @@ void SoundSource::Update(float timeStep)
         MixNull(timeStep);
 
     // Free the stream if playback has stopped
-    if (soundStream_ && !position_)
-        StopLockless();
+    if (soundStream_ && !IsPlaying())
+        StopInternal();
 
     // Check for autoremove
     if (autoRemove_)
@@ -318,28 +463,28 @@ void SoundSource::Update(float timeStep)
 
 void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
 {
-    if (!position_ || (!sound_ && !soundStream_) || !IsEnabledEffective())
+    if (!position_ || (!mixSound_ && !mixStream_) || !mixParams_.enabled_)
         return;
 
     int streamFilledSize, outBytes;
 
-    if (soundStream_ && streamBuffer_)
+    if (mixStream_ && mixStreamBuffer_)
     {
-        int streamBufferSize = streamBuffer_->GetDataSize();
+        int streamBufferSize = mixStreamBuffer_->GetDataSize();
         // Calculate how many bytes of stream sound data is needed
-        int neededSize = (int)((float)samples * frequency_ / (float)mixRate);
+        int neededSize = (int)((float)samples * mixParams_.frequency_ / (float)mixRate);
         // Add a little safety buffer. Subtract previous unused data
         neededSize += STREAM_SAFETY_SAMPLES;
-        neededSize *= soundStream_->GetSampleSize();
+        neededSize *= mixStream_->GetSampleSize();
         neededSize -= unusedStreamSize_;
         neededSize = Clamp(neededSize, 0, streamBufferSize - unusedStreamSize_);
 
         // Always start play position at the beginning of the stream buffer
-        position_ = streamBuffer_->GetStart();
+        position_ = mixStreamBuffer_->GetStart();
 
         // Request new data from the stream
-        signed char* dest = streamBuffer_->GetStart() + unusedStreamSize_;
-        outBytes = neededSize ? soundStream_->GetData(dest, neededSize) : 0;
+        signed char* dest = mixStreamBuffer_->GetStart() + unusedStreamSize_;
+        outBytes = neededSize ? mixStream_->GetData(dest, neededSize) : 0;
         dest += outBytes;
         // Zero-fill rest if stream did not produce enough data
         if (outBytes < neededSize)
@@ -350,12 +495,14 @@ void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, boo
     }
 
     // If streaming, play the stream buffer. Otherwise play the original sound
-    Sound* sound = soundStream_ ? streamBuffer_ : sound_;
+    Sound* sound = mixStream_ ? mixStreamBuffer_ : mixSound_;
     if (!sound)
         return;
 
-    // Choose the correct mixing routine
-    if (!sound->IsStereo())
+    // Choose the correct mixing routine. Virtual voices only advance the playback position
+    if (mixParams_.virtual_)
+        MixZeroVolume(sound, samples, mixRate);
+    else if (!sound->IsStereo())
     {
         if (interpolation)
         {
@@ -391,23 +538,64 @@ void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, boo
     }
 
     // Update the time position. In stream mode, copy unused data back to the beginning of the stream buffer
-    if (soundStream_)
+    if (mixStream_)
     {
-        timePosition_ += ((float)samples / (float)mixRate) * frequency_ / soundStream_->GetFrequency();
+        timePosition_ += ((float)samples / (float)mixRate) * mixParams_.frequency_ / mixStream_->GetFrequency();
 
-        unusedStreamSize_ = Max(streamFilledSize - (int)(size_t)(position_ - streamBuffer_->GetStart()), 0);
+        unusedStreamSize_ = Max(streamFilledSize - (int)(size_t)(position_ - mixStreamBuffer_->GetStart()), 0);
         if (unusedStreamSize_)
-            memcpy(streamBuffer_->GetStart(), (const void*)position_, unusedStreamSize_);
+            memcpy(mixStreamBuffer_->GetStart(), (const void*)position_, unusedStreamSize_);
 
         // If stream did not produce any data, stop if applicable
-        if (!outBytes && soundStream_->GetStopAtEnd())
+        if (!outBytes && mixStream_->GetStopAtEnd())
         {
             position_ = 0;
             return;
         }
     }
-    else if (sound_)
-        timePosition_ = ((float)(int)(size_t)(position_ - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
+    else if (mixSound_)
+        timePosition_ = ((float)(int)(size_t)(position_ - mixSound_->GetStart())) / (mixSound_->GetSampleSize() * mixSound_->GetFrequency());
+}
+
+void SoundSource::ExecuteCommand(const AudioCommand& command)
+{
+    switch (command.type_)
+    {
+    case AUDIO_SET_PARAMS:
+        mixParams_ = command.params_;
+        break;
+
+    case AUDIO_PLAY:
+        mixParams_ = command.params_;
+        mixSound_ = command.sound_;
+        mixStream_ = command.stream_;
+        mixStreamBuffer_ = command.streamBuffer_;
+        position_ = command.position_;
+        fractPosition_ = 0;
+        timePosition_ = 0.0f;
+        unusedStreamSize_ = 0;
+        break;
+
+    case AUDIO_STOP:
+        mixSound_ = 0;
+        mixStream_ = 0;
+        mixStreamBuffer_ = 0;
+        position_ = 0;
+        timePosition_ = 0.0f;
+        break;
+
+    case AUDIO_SET_POSITION:
+        mixSound_ = command.sound_;
+        mixStream_ = 0;
+        mixStreamBuffer_ = 0;
+        position_ = command.position_;
+        timePosition_ = ((float)(int)(size_t)(command.position_ - mixSound_->GetStart())) / (mixSound_->GetSampleSize() *
+            mixSound_->GetFrequency());
+        break;
+
+    default:
+        break;
+    }
 }
 
 void SoundSource::UpdateMasterGain()
@@ -425,6 +613,7 @@ void SoundSource::SetSoundAttr(const ResourceRef& value)
     else
     {
         // When changing the sound and not playing, free previous sound stream and stream buffer (if any)
+        ReleaseAfterMix();
         soundStream_.Reset();
         streamBuffer_.Reset();
         sound_ = newSound;
@@ -461,255 +650,212 @@ int SoundSource::GetPositionAttr() const
         return 0;
 }
 
-void SoundSource::PlayLockless(Sound* sound)
+void SoundSource::PlayInternal(Sound* sound)
 {
-    // Reset the time position in any case
-    timePosition_ = 0.0f;
-
     if (sound)
     {
         if (!sound->IsCompressed())
         {
-            // Uncompressed sound start
+            // Uncompressed sound start. Frees the existing stream & stream buffer if any
             signed char* start = sound->GetStart();
             if (start)
             {
-                // Free existing stream & stream buffer if any
-                soundStream_.Reset();
-                streamBuffer_.Reset();
-                sound_ = sound;
-                position_ = start;
-                fractPosition_ = 0;
+                StartPlayback(sound, SharedPtr<SoundStream>(), SharedPtr<Sound>(), start);
                 return;
             }
         }
         else
         {
             // Compressed sound start
-            PlayLockless(sound->GetDecoderStream());
-            sound_ = sound;
+            PlayInternal(sound->GetDecoderStream(), sound);
             return;
         }
     }
 
     // If sound pointer is null or if sound has no data, stop playback
-    StopLockless();
+    StopInternal();
+    ReleaseAfterMix();
     sound_.Reset();
 }
 
-void SoundSource::PlayLockless(SharedPtr<SoundStream> stream)
+void SoundSource::PlayInternal(SharedPtr<SoundStream> stream, Sound* sound)
 {
-    // Reset the time position in any case
-    timePosition_ = 0.0f;
-
     if (stream)
     {
         // Setup the stream buffer
         unsigned sampleSize = stream->GetSampleSize();
         unsigned streamBufferSize = sampleSize * stream->GetIntFrequency() * STREAM_BUFFER_LENGTH / 1000;
 
-        streamBuffer_ = new Sound(context_);
-        streamBuffer_->SetSize(streamBufferSize);
-        streamBuffer_->SetFormat(stream->GetIntFrequency(), stream->IsSixteenBit(), stream->IsStereo());
-        streamBuffer_->SetLooped(true);
+        SharedPtr<Sound> streamBuffer(new Sound(context_));
+        streamBuffer->SetSize(streamBufferSize);
+        streamBuffer->SetFormat(stream->GetIntFrequency(), stream->IsSixteenBit(), stream->IsStereo());
+        streamBuffer->SetLooped(true);
 
-        soundStream_ = stream;
-        unusedStreamSize_ = 0;
-        position_ = streamBuffer_->GetStart();
-        fractPosition_ = 0;
+        audio_->PrefetchStream(stream);
+        StartPlayback(sound, stream, streamBuffer, streamBuffer->GetStart());
         return;
     }
 
     // If stream pointer is null, stop playback
-    StopLockless();
+    StopInternal();
+    if (sound != sound_)
+    {
+        ReleaseAfterMix();
+        sound_ = sound;
+    }
 }
 
-void SoundSource::StopLockless()
+void SoundSource::StartPlayback(Sound* sound, SharedPtr<SoundStream> stream, SharedPtr<Sound> streamBuffer, signed char* position)
 {
-    position_ = 0;
-    timePosition_ = 0.0f;
+    // Start with a real voice so that the onset is not lost; the voice limit is applied on the next audio update
+    virtual_ = false;
 
-    // Free the sound stream and decode buffer if a stream was playing
-    soundStream_.Reset();
-    streamBuffer_.Reset();
+    AudioCommand command;
+    command.type_ = AUDIO_PLAY;
+    command.source_ = this;
+    command.params_ = GetParams();
+    command.sound_ = sound;
+    command.stream_ = stream;
+    command.streamBuffer_ = streamBuffer;
+    command.position_ = position;
+    playCommand_ = audio_->SendCommand(command);
+    playRequested_ = true;
+    params_ = command.params_;
+
+    // The audio thread may use the previous sound and stream until it has executed the command
+    ReleaseAfterMix();
+    sound_ = sound;
+    soundStream_ = stream;
+    streamBuffer_ = streamBuffer;
 }
 
-void SoundSource::SetPlayPositionLockless(signed char* pos)
+void SoundSource::StopInternal()
 {
-    // Setting position on a stream is not supported
-    if (!sound_ || soundStream_)
-        return;
+    AudioCommand command;
+    command.type_ = AUDIO_STOP;
+    command.source_ = this;
+    playCommand_ = audio_->SendCommand(command);
+    playRequested_ = false;
 
-    signed char* start = sound_->GetStart();
-    signed char* end = sound_->GetEnd();
-    if (pos < start)
-        pos = start;
-    if (sound_->IsSixteenBit() && (pos - start) & 1)
-        ++pos;
-    if (pos > end)
-        pos = end;
+    // Free the sound stream and decode buffer if a stream was playing
+    if (soundStream_)
+    {
+        ReleaseAfterMix();
+        soundStream_.Reset();
+        streamBuffer_.Reset();
+    }
+}
 
-    position_ = pos;
-    timePosition_ = ((float)(int)(size_t)(pos - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
+SoundSourceParams SoundSource::GetParams() const
+{
+    SoundSourceParams params;
+    params.frequency_ = frequency_;
+    params.gain_ = masterGain_ * attenuation_ * gain_;
+    params.panning_ = panning_;
+    params.enabled_ = IsEnabledEffective();
+    params.virtual_ = virtual_;
+    return params;
 }
 
-void SoundSource::MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::SendParams()
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    int vol = (int)(256.0f * totalGain + 0.5f);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
+    if (!audio_)
         return;
+
+    SoundSourceParams params = GetParams();
+    if (params != params_)
+    {
+        AudioCommand command;
+        command.type_ = AUDIO_SET_PARAMS;
+        command.source_ = this;
+        command.params_ = params;
+        audio_->SendCommand(command);
+        params_ = params;
     }
+}
+
+void SoundSource::ReleaseAfterMix()
+{
+    audio_->ReleaseAfterMix(sound_);
+    audio_->ReleaseAfterMix(soundStream_);
+    audio_->ReleaseAfterMix(streamBuffer_);
+}
 
-    float add = frequency_ / (float)mixRate;
+template <unsigned SrcChannels, bool StereoDest, bool Interpolate> void SoundSource::MixSound(Sound* sound, int* dest,
+    unsigned samples, int mixRate, int leftVol, int rightVol)
+{
+    float add = mixParams_.frequency_ / (float)mixRate;
     int intAdd = (int)add;
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
 
     if (sound->IsSixteenBit())
     {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
+        MixPosition<short> position;
+        position.pos_ = (short*)position_;
+        position.end_ = (short*)sound->GetEnd();
+        position.repeat_ = (short*)sound->GetRepeat();
+        position.fractPos_ = fractPosition_;
+        position.intAdd_ = intAdd;
+        position.fractAdd_ = fractAdd;
 
         if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
+            MixSamples<short, SrcChannels, StereoDest, Interpolate, true>(dest, samples, position, leftVol, rightVol);
         else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
+            MixSamples<short, SrcChannels, StereoDest, Interpolate, false>(dest, samples, position, leftVol, rightVol);
+
+        position_ = (signed char*)position.pos_;
+        fractPosition_ = position.fractPos_;
     }
     else
     {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
+        MixPosition<signed char> position;
+        position.pos_ = (signed char*)position_;
+        position.end_ = sound->GetEnd();
+        position.repeat_ = sound->GetRepeat();
+        position.fractPos_ = fractPosition_;
+        position.intAdd_ = intAdd;
+        position.fractAdd_ = fractAdd;
 
         if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
+            MixSamples<signed char, SrcChannels, StereoDest, Interpolate, true>(dest, samples, position, leftVol, rightVol);
         else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
+            MixSamples<signed char, SrcChannels, StereoDest, Interpolate, false>(dest, samples, position, leftVol, rightVol);
+
+        position_ = position.pos_;
+        fractPosition_ = position.fractPos_;
     }
-    fractPosition_ = fractPos;
 }
 
-void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    int leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    int rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
+    float totalGain = mixParams_.gain_;
+    int vol = (int)(256.0f * totalGain + 0.5f);
+    if (!vol)
     {
         MixZeroVolume(sound, samples, mixRate);
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
+    MixSound<1, false, false>(sound, dest, samples, mixRate, vol, vol);
+}
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
+void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
+{
+    float totalGain = mixParams_.gain_;
+    int leftVol = (int)((-mixParams_.panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
+    int rightVol = (int)((mixParams_.panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
+    if (!leftVol && !rightVol)
     {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
+        MixZeroVolume(sound, samples, mixRate);
+        return;
     }
 
-    fractPosition_ = fractPos;
+    MixSound<1, true, false>(sound, dest, samples, mixRate, leftVol, rightVol);
 }
 
 void SoundSource::MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
+    float totalGain = mixParams_.gain_;
     int vol = (int)(256.0f * totalGain + 0.5f);
     if (!vol)
     {
@@ -717,158 +863,26 @@ void SoundSource::MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    MixSound<1, false, true>(sound, dest, samples, mixRate, vol, vol);
 }
 
 void SoundSource::MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    int leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    int rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
+    float totalGain = mixParams_.gain_;
+    int leftVol = (int)((-mixParams_.panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
+    int rightVol = (int)((mixParams_.panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
     if (!leftVol && !rightVol)
     {
         MixZeroVolume(sound, samples, mixRate);
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    MixSound<1, true, true>(sound, dest, samples, mixRate, leftVol, rightVol);
 }
 
 void SoundSource::MixStereoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
+    float totalGain = mixParams_.gain_;
     int vol = (int)(256.0f * totalGain + 0.5f);
     if (!vol)
     {
@@ -876,76 +890,12 @@ void SoundSource::MixStereoToMono(Sound* sound, int* dest, unsigned samples, int
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    MixSound<2, false, false>(sound, dest, samples, mixRate, vol, vol);
 }
 
 void SoundSource::MixStereoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
+    float totalGain = mixParams_.gain_;
     int vol = (int)(256.0f * totalGain + 0.5f);
     if (!vol)
     {
@@ -953,80 +903,12 @@ void SoundSource::MixStereoToStereo(Sound* sound, int* dest, unsigned samples, i
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    MixSound<2, true, false>(sound, dest, samples, mixRate, vol, vol);
 }
 
 void SoundSource::MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
+    float totalGain = mixParams_.gain_;
     int vol = (int)(256.0f * totalGain + 0.5f);
     if (!vol)
     {
@@ -1034,76 +916,12 @@ void SoundSource::MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, i
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    MixSound<2, false, true>(sound, dest, samples, mixRate, vol, vol);
 }
 
 void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
+    float totalGain = mixParams_.gain_;
     int vol = (int)(256.0f * totalGain + 0.5f);
     if (!vol)
     {
@@ -1111,80 +929,12 @@ void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples,
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    int intAdd = (int)add;
-    int fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        short* pos = (short*)position_;
-        short* end = (short*)sound->GetEnd();
-        short* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        signed char* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    MixSound<2, true, true>(sound, dest, samples, mixRate, vol, vol);
 }
 
 void SoundSource::MixZeroVolume(Sound* sound, unsigned samples, int mixRate)
 {
-    float add = frequency_ * (float)samples / (float)mixRate;
+    float add = mixParams_.frequency_ * (float)samples / (float)mixRate;
     int intAdd = (int)add;
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     unsigned sampleSize = sound->GetSampleSize();
@@ -22,16 +22,12 @@
 
 #pragma once
 
-#include "../Audio/AudioDefs.h"
+#include "../Audio/Audio.h"
 #include "../Scene/Component.h"
 
 namespace Atomic
 {
 
-class Audio;
-class Sound;
-class SoundStream;
-
 // Compressed audio decode buffer length in milliseconds
 static const int STREAM_BUFFER_LENGTH = 100;
 
@@ -74,6 +70,8 @@ public:
     void SetAutoRemove(bool enable);
     /// Set new playback position.
     void SetPlayPosition(signed char* pos);
+    /// Set priority for getting mixed when the number of voices is limited. Multiplies the audibility of the sound source.
+    void SetPriority(float priority);
     
     /// Return sound.
     Sound* GetSound() const { return sound_; }
@@ -93,13 +91,25 @@ public:
     float GetPanning() const { return panning_; }
     /// Return autoremove mode.
     bool GetAutoRemove() const { return autoRemove_; }
+    /// Return priority.
+    float GetPriority() const { return priority_; }
     /// Return whether is playing.
     bool IsPlaying() const;
+    /// Return whether is a virtual voice, which advances the playback position without being mixed.
+    bool IsVirtual() const { return virtual_; }
+    /// Return audibility used for choosing the sound sources to mix. Zero when not playing.
+    float GetAudibility() const;
     
     /// Update the sound source. Perform subclass specific operations. Called by Audio.
     virtual void Update(float timeStep);
-    /// Mix sound source output to a 32-bit clipping buffer. Called by Audio.
+    /// Mix sound source output to a 32-bit clipping buffer. Called by Audio in the audio thread.
     void Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation);
+    /// Execute a command sent from the main thread. Called by Audio in the audio thread.
+    void ExecuteCommand(const AudioCommand& command);
+    /// Set whether is a virtual voice. Called by Audio.
+    void SetVirtual(bool enable) { virtual_ = enable; }
+    /// Send the mixing parameters to the audio thread if they have changed. Called by Audio.
+    void SendParams();
     /// Update the effective master gain. Called internally and by Audio when the master gain changes.
     void UpdateMasterGain();
     
@@ -133,18 +143,26 @@ protected:
     float autoRemoveTimer_;
     /// Effective master gain.
     float masterGain_;
+    /// Priority.
+    float priority_;
     /// Autoremove flag.
     bool autoRemove_;
+    /// Virtual voice flag.
+    bool virtual_;
     
 private:
-    /// Play a sound without locking the audio mutex. Called internally.
-    void PlayLockless(Sound* sound);
-    /// Play a sound stream without locking the audio mutex. Called internally.
-    void PlayLockless(SharedPtr<SoundStream> stream);
-    /// Stop sound without locking the audio mutex. Called internally.
-    void StopLockless();
-    /// Set new playback position without locking the audio mutex. Called internally.
-    void SetPlayPositionLockless(signed char* position);
+    /// Play a sound. Called internally.
+    void PlayInternal(Sound* sound);
+    /// Play a sound stream, optionally decoding a compressed sound. Called internally.
+    void PlayInternal(SharedPtr<SoundStream> stream, Sound* sound);
+    /// Send a play command to the audio thread and take the new sound, stream and decode buffer into use.
+    void StartPlayback(Sound* sound, SharedPtr<SoundStream> stream, SharedPtr<Sound> streamBuffer, signed char* position);
+    /// Stop playback. Called internally.
+    void StopInternal();
+    /// Return current mixing parameters.
+    SoundSourceParams GetParams() const;
+    /// Keep the current sound, stream and decode buffer alive until the audio thread is done with them.
+    void ReleaseAfterMix();
     /// Mix mono sample to mono buffer.
     void MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate);
     /// Mix mono sample to stereo buffer.
@@ -163,6 +181,9 @@ private:
     void MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
     /// Advance playback pointer without producing audible output.
     void MixZeroVolume(Sound* sound, unsigned samples, int mixRate);
+    /// Mix a sound with the given source and destination format. Called by the specific mixing functions.
+    template <unsigned SrcChannels, bool StereoDest, bool Interpolate> void MixSound(Sound* sound, int* dest,
+        unsigned samples, int mixRate, int leftVol, int rightVol);
     /// Advance playback pointer to simulate audio playback in headless mode.
     void MixNull(float timeStep);
     
@@ -180,6 +201,20 @@ private:
     SharedPtr<Sound> streamBuffer_;
     /// Unused stream bytes from previous frame.
     int unusedStreamSize_;
+    /// Mixing parameters last sent to the audio thread.
+    SoundSourceParams params_;
+    /// Mixing parameters used by the audio thread.
+    SoundSourceParams mixParams_;
+    /// Sound used by the audio thread.
+    Sound* mixSound_;
+    /// Sound stream used by the audio thread.
+    SoundStream* mixStream_;
+    /// Decode buffer used by the audio thread.
+    Sound* mixStreamBuffer_;
+    /// Sequence number of the last command that started or stopped playback.
+    unsigned playCommand_;
+    /// Whether the last command that started or stopped playback started it.
+    bool playRequested_;
 };
 
 }
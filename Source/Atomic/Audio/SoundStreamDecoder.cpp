@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Audio/OggVorbisSoundStream.h"
+#include "../Audio/SoundStreamDecoder.h"
+#include "../Core/Timer.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Time to sleep when all prefetch buffers are full.
+static const unsigned DECODE_SLEEP_MS = 5;
+
+SoundStreamDecoder::SoundStreamDecoder()
+{
+}
+
+SoundStreamDecoder::~SoundStreamDecoder()
+{
+    Stop();
+}
+
+void SoundStreamDecoder::ThreadFunction()
+{
+    Vector<SharedPtr<OggVorbisSoundStream> > decodeStreams;
+
+    while (shouldRun_)
+    {
+        unsigned decodedBytes = 0;
+
+        // Decode outside the lock, so that the main thread is not held up by a decoding pass. The copied references keep
+        // the streams alive meanwhile. They are never the last references, as ReleaseUnusedStreams() skips streams
+        // that are referenced elsewhere
+        {
+            MutexLock lock(streamMutex_);
+            decodeStreams = streams_;
+        }
+
+        for (Vector<SharedPtr<OggVorbisSoundStream> >::Iterator i = decodeStreams.Begin(); i != decodeStreams.End(); ++i)
+            decodedBytes += (*i)->Prefetch();
+
+        decodeStreams.Clear();
+
+        if (!decodedBytes)
+            Time::Sleep(DECODE_SLEEP_MS);
+    }
+}
+
+void SoundStreamDecoder::AddStream(OggVorbisSoundStream* stream)
+{
+    if (!stream)
+        return;
+
+    MutexLock lock(streamMutex_);
+    SharedPtr<OggVorbisSoundStream> streamPtr(stream);
+    if (!streams_.Contains(streamPtr))
+        streams_.Push(streamPtr);
+}
+
+void SoundStreamDecoder::ReleaseUnusedStreams()
+{
+    Vector<SharedPtr<OggVorbisSoundStream> > unusedStreams;
+
+    {
+        // While the lock is held, only the streams still in use can gain references. A stream referenced only by the
+        // list is not being decoded either
+        MutexLock lock(streamMutex_);
+        for (unsigned i = streams_.Size() - 1; i < streams_.Size(); --i)
+        {
+            if (streams_[i].Refs() == 1)
+            {
+                unusedStreams.Push(streams_[i]);
+                streams_.Erase(i);
+            }
+        }
+    }
+
+    // Destroy the streams outside the lock
+    unusedStreams.Clear();
+}
+
+unsigned SoundStreamDecoder::GetNumStreams() const
+{
+    MutexLock lock(streamMutex_);
+    return streams_.Size();
+}
+
+}
@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/RefCounted.h"
+#include "../Core/Mutex.h"
+#include "../Core/Thread.h"
+
+namespace Atomic
+{
+
+class OggVorbisSoundStream;
+
+/// Background decoder of sound streams. Keeps the prefetch buffers of the streams filled so that the audio thread only copies decoded data. Owned by Audio.
+class SoundStreamDecoder : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    SoundStreamDecoder();
+    /// Destruct. Stop the decoding thread.
+    virtual ~SoundStreamDecoder();
+
+    /// Stream decoding loop.
+    virtual void ThreadFunction();
+
+    /// Start decoding a stream. Its prefetch buffer must have been set up. The decoder holds a reference to the stream.
+    void AddStream(OggVorbisSoundStream* stream);
+    /// Stop decoding the streams that are referenced only by the decoder and release them. Called by Audio from the main thread, so that the streams are never destroyed in the decoding thread.
+    void ReleaseUnusedStreams();
+
+    /// Return number of streams being decoded.
+    unsigned GetNumStreams() const;
+
+private:
+    /// Mutex for the streams.
+    mutable Mutex streamMutex_;
+    /// Streams being decoded.
+    Vector<SharedPtr<OggVorbisSoundStream> > streams_;
+};
+
+}
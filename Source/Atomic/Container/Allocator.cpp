@@ -122,4 +122,23 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+AllocatorStats AllocatorGetStats(AllocatorBlock* allocator)
+{
+    AllocatorStats stats;
+    if (!allocator)
+        return stats;
+    
+    // The first block holds the total capacity and the free nodes of the whole chain
+    stats.capacity_ = allocator->capacity_;
+    for (AllocatorBlock* block = allocator; block; block = block->next_)
+        ++stats.numBlocks_;
+    
+    unsigned numFree = 0;
+    for (AllocatorNode* node = allocator->free_; node; node = node->next_)
+        ++numFree;
+    stats.numInUse_ = stats.capacity_ - numFree;
+    
+    return stats;
+}
+
 }
@@ -52,6 +52,25 @@ struct AllocatorNode
     /// Data follows.
 };
 
+/// %Allocator statistics.
+struct AllocatorStats
+{
+    /// Construct.
+    AllocatorStats() :
+        numBlocks_(0),
+        capacity_(0),
+        numInUse_(0)
+    {
+    }
+    
+    /// Number of memory blocks.
+    unsigned numBlocks_;
+    /// Total number of nodes in the blocks.
+    unsigned capacity_;
+    /// Number of reserved nodes.
+    unsigned numInUse_;
+};
+
 /// Initialize a fixed-size allocator with the node size and initial capacity.
 ATOMIC_API AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity = 1);
 /// Uninitialize a fixed-size allocator. Frees all blocks in the chain.
@@ -60,6 +79,8 @@ ATOMIC_API void AllocatorUninitialize(AllocatorBlock* allocator);
 ATOMIC_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 ATOMIC_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
+/// Return statistics of a fixed-size allocator.
+ATOMIC_API AllocatorStats AllocatorGetStats(AllocatorBlock* allocator);
 
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
@@ -108,6 +129,9 @@ public:
         AllocatorFree(allocator_, object);
     }
     
+    /// Return statistics.
+    AllocatorStats GetStats() const { return AllocatorGetStats(allocator_); }
+    
 private:
     /// Prevent copy construction.
     Allocator(const Allocator<T>& rhs);
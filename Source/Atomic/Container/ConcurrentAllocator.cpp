@@ -0,0 +1,269 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Container/ConcurrentAllocator.h"
+#include "../Container/ThreadLocal.h"
+
+#include <SDL/include/SDL_atomic.h>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Number of threads that get their own cache of free nodes. Further threads share one cache guarded by a spinlock.
+static const unsigned MAX_THREAD_CACHES = 32;
+/// Assumed CPU cache line size, to keep the caches of different threads apart.
+static const unsigned CACHE_LINE_SIZE = 64;
+
+/// Per-thread cache of free nodes.
+struct ConcurrentAllocatorCache
+{
+    /// Nodes freed in this thread, reserved from first.
+    AllocatorNode* freed_;
+    /// Last node freed in this thread.
+    AllocatorNode* lastFreed_;
+    /// Nodes taken from the shared free list or a new block.
+    AllocatorNode* available_;
+    /// Number of nodes freed in this thread.
+    unsigned numFreed_;
+    /// Nodes reserved minus nodes freed in this thread. Negative when the thread frees nodes reserved elsewhere.
+    int numReserved_;
+    /// Padding to the cache line size.
+    unsigned char padding_[CACHE_LINE_SIZE - 3 * sizeof(void*) - 2 * sizeof(int)];
+};
+
+/// Thread-safe allocator memory block header. Nodes follow.
+struct ConcurrentAllocatorBlock
+{
+    /// Next allocator block.
+    ConcurrentAllocatorBlock* next_;
+    /// Padding to keep the nodes aligned.
+    void* padding_;
+};
+
+/// Thread-safe allocator.
+struct ConcurrentAllocatorPool
+{
+    /// Size of a node, excluding the node header.
+    unsigned nodeSize_;
+    /// Number of nodes in a block.
+    unsigned blockCapacity_;
+    /// Number of nodes a thread may free before it returns them to the shared free list.
+    unsigned cacheLimit_;
+    /// Number of blocks.
+    SDL_atomic_t numBlocks_;
+    /// Shared lock-free free list. Only pushed to, or taken whole, which avoids the ABA problem.
+    void* free_;
+    /// Blocks. Only pushed to until the allocator is uninitialized.
+    void* blocks_;
+    /// Spinlock for the cache shared by threads beyond MAX_THREAD_CACHES.
+    SDL_SpinLock sharedCacheLock_;
+    /// Per-thread caches, followed by the shared cache.
+    ConcurrentAllocatorCache caches_[MAX_THREAD_CACHES + 1];
+};
+
+/// Thread index plus one of the calling thread, or null if not assigned yet.
+static ThreadLocalPtr threadIndex;
+/// Number of thread indices assigned.
+static SDL_atomic_t numThreadIndices;
+
+static unsigned GetThreadIndex()
+{
+    size_t index = reinterpret_cast<size_t>(threadIndex.Get());
+    if (!index)
+    {
+        // Indices are never reused, so threads created after the first MAX_THREAD_CACHES use the shared cache
+        index = (size_t)SDL_AtomicAdd(&numThreadIndices, 1) + 1;
+        threadIndex.Set(reinterpret_cast<void*>(index));
+    }
+    
+    return (unsigned)index - 1;
+}
+
+static void PushNodes(void** list, AllocatorNode* first, AllocatorNode* last)
+{
+    void* head;
+    do
+    {
+        head = SDL_AtomicGetPtr(list);
+        last->next_ = static_cast<AllocatorNode*>(head);
+    }
+    while (!SDL_AtomicCASPtr(list, head, first));
+}
+
+static AllocatorNode* ReserveBlock(ConcurrentAllocatorPool* pool)
+{
+    unsigned nodeStride = sizeof(AllocatorNode) + pool->nodeSize_;
+    unsigned char* blockPtr = new unsigned char[sizeof(ConcurrentAllocatorBlock) + pool->blockCapacity_ * nodeStride];
+    ConcurrentAllocatorBlock* newBlock = reinterpret_cast<ConcurrentAllocatorBlock*>(blockPtr);
+    
+    void* head;
+    do
+    {
+        head = SDL_AtomicGetPtr(&pool->blocks_);
+        newBlock->next_ = static_cast<ConcurrentAllocatorBlock*>(head);
+    }
+    while (!SDL_AtomicCASPtr(&pool->blocks_, head, newBlock));
+    SDL_AtomicIncRef(&pool->numBlocks_);
+    
+    // Chain the nodes for the calling thread's cache
+    unsigned char* nodePtr = blockPtr + sizeof(ConcurrentAllocatorBlock);
+    for (unsigned i = 0; i < pool->blockCapacity_ - 1; ++i)
+    {
+        reinterpret_cast<AllocatorNode*>(nodePtr)->next_ = reinterpret_cast<AllocatorNode*>(nodePtr + nodeStride);
+        nodePtr += nodeStride;
+    }
+    reinterpret_cast<AllocatorNode*>(nodePtr)->next_ = 0;
+    
+    return reinterpret_cast<AllocatorNode*>(blockPtr + sizeof(ConcurrentAllocatorBlock));
+}
+
+static void* ReserveFromCache(ConcurrentAllocatorPool* pool, ConcurrentAllocatorCache& cache)
+{
+    AllocatorNode* node;
+    
+    if (cache.freed_)
+    {
+        // Prefer the most recently freed nodes, which are likely still in the CPU cache
+        node = cache.freed_;
+        cache.freed_ = node->next_;
+        if (!cache.freed_)
+            cache.lastFreed_ = 0;
+        --cache.numFreed_;
+    }
+    else
+    {
+        if (!cache.available_)
+        {
+            cache.available_ = static_cast<AllocatorNode*>(SDL_AtomicSetPtr(&pool->free_, 0));
+            if (!cache.available_)
+                cache.available_ = ReserveBlock(pool);
+        }
+        
+        node = cache.available_;
+        cache.available_ = node->next_;
+    }
+    
+    node->next_ = 0;
+    ++cache.numReserved_;
+    return reinterpret_cast<unsigned char*>(node) + sizeof(AllocatorNode);
+}
+
+static void FreeToCache(ConcurrentAllocatorPool* pool, ConcurrentAllocatorCache& cache, AllocatorNode* node)
+{
+    node->next_ = cache.freed_;
+    cache.freed_ = node;
+    if (!cache.lastFreed_)
+        cache.lastFreed_ = node;
+    ++cache.numFreed_;
+    --cache.numReserved_;
+    
+    // Return the freed nodes to the shared free list when there are too many, so that a thread which mostly frees
+    // nodes reserved in other threads does not hoard them
+    if (cache.numFreed_ > pool->cacheLimit_)
+    {
+        PushNodes(&pool->free_, cache.freed_, cache.lastFreed_);
+        cache.freed_ = 0;
+        cache.lastFreed_ = 0;
+        cache.numFreed_ = 0;
+    }
+}
+
+ConcurrentAllocatorPool* ConcurrentAllocatorInitialize(unsigned nodeSize, unsigned blockCapacity)
+{
+    ConcurrentAllocatorPool* pool = new ConcurrentAllocatorPool();
+    // Round the node size so that all nodes stay pointer-aligned
+    pool->nodeSize_ = (nodeSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    pool->blockCapacity_ = blockCapacity ? blockCapacity : 1;
+    pool->cacheLimit_ = pool->blockCapacity_ * 2;
+    return pool;
+}
+
+void ConcurrentAllocatorUninitialize(ConcurrentAllocatorPool* pool)
+{
+    if (!pool)
+        return;
+    
+    ConcurrentAllocatorBlock* block = static_cast<ConcurrentAllocatorBlock*>(pool->blocks_);
+    while (block)
+    {
+        ConcurrentAllocatorBlock* next = block->next_;
+        delete[] reinterpret_cast<unsigned char*>(block);
+        block = next;
+    }
+    
+    delete pool;
+}
+
+void* ConcurrentAllocatorReserve(ConcurrentAllocatorPool* pool)
+{
+    if (!pool)
+        return 0;
+    
+    unsigned index = GetThreadIndex();
+    if (index < MAX_THREAD_CACHES)
+        return ReserveFromCache(pool, pool->caches_[index]);
+    
+    SDL_AtomicLock(&pool->sharedCacheLock_);
+    void* ptr = ReserveFromCache(pool, pool->caches_[MAX_THREAD_CACHES]);
+    SDL_AtomicUnlock(&pool->sharedCacheLock_);
+    return ptr;
+}
+
+void ConcurrentAllocatorFree(ConcurrentAllocatorPool* pool, void* ptr)
+{
+    if (!pool || !ptr)
+        return;
+    
+    AllocatorNode* node = reinterpret_cast<AllocatorNode*>(static_cast<unsigned char*>(ptr) - sizeof(AllocatorNode));
+    
+    unsigned index = GetThreadIndex();
+    if (index < MAX_THREAD_CACHES)
+        FreeToCache(pool, pool->caches_[index], node);
+    else
+    {
+        SDL_AtomicLock(&pool->sharedCacheLock_);
+        FreeToCache(pool, pool->caches_[MAX_THREAD_CACHES], node);
+        SDL_AtomicUnlock(&pool->sharedCacheLock_);
+    }
+}
+
+AllocatorStats ConcurrentAllocatorGetStats(ConcurrentAllocatorPool* pool)
+{
+    AllocatorStats stats;
+    if (!pool)
+        return stats;
+    
+    stats.numBlocks_ = (unsigned)SDL_AtomicGet(&pool->numBlocks_);
+    stats.capacity_ = stats.numBlocks_ * pool->blockCapacity_;
+    
+    int numInUse = 0;
+    for (unsigned i = 0; i <= MAX_THREAD_CACHES; ++i)
+        numInUse += pool->caches_[i].numReserved_;
+    stats.numInUse_ = numInUse > 0 ? (unsigned)numInUse : 0;
+    
+    return stats;
+}
+
+}
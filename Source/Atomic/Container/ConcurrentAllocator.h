@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Allocator.h"
+
+namespace Atomic
+{
+
+struct ConcurrentAllocatorPool;
+
+/// Initialize a thread-safe fixed-size allocator with the node size and the number of nodes in each memory block.
+ATOMIC_API ConcurrentAllocatorPool* ConcurrentAllocatorInitialize(unsigned nodeSize, unsigned blockCapacity = 64);
+/// Uninitialize a thread-safe fixed-size allocator. Frees all blocks. Not thread-safe.
+ATOMIC_API void ConcurrentAllocatorUninitialize(ConcurrentAllocatorPool* pool);
+/// Reserve a node. Creates a new block if necessary. Thread-safe.
+ATOMIC_API void* ConcurrentAllocatorReserve(ConcurrentAllocatorPool* pool);
+/// Free a node, which may have been reserved in another thread. Does not free any blocks. Thread-safe.
+ATOMIC_API void ConcurrentAllocatorFree(ConcurrentAllocatorPool* pool, void* ptr);
+/// Return statistics of a thread-safe fixed-size allocator. The number of nodes in use is approximate while other threads reserve or free nodes.
+ATOMIC_API AllocatorStats ConcurrentAllocatorGetStats(ConcurrentAllocatorPool* pool);
+
+/// Thread-safe %allocator template class. Allocates objects of a specific class. Each thread reserves from and frees to its own cache of free nodes without locking, and the caches exchange nodes through a shared lock-free free list.
+template <class T> class ConcurrentAllocator
+{
+public:
+    /// Construct with the number of objects in each memory block. The first block is allocated on first use.
+    ConcurrentAllocator(unsigned blockCapacity = 64) :
+        pool_(ConcurrentAllocatorInitialize(sizeof(T), blockCapacity))
+    {
+    }
+    
+    /// Destruct. All objects must have been freed.
+    ~ConcurrentAllocator()
+    {
+        ConcurrentAllocatorUninitialize(pool_);
+    }
+    
+    /// Reserve and default-construct an object.
+    T* Reserve()
+    {
+        T* newObject = static_cast<T*>(ConcurrentAllocatorReserve(pool_));
+        new(newObject) T();
+        
+        return newObject;
+    }
+    
+    /// Reserve and copy-construct an object.
+    T* Reserve(const T& object)
+    {
+        T* newObject = static_cast<T*>(ConcurrentAllocatorReserve(pool_));
+        new(newObject) T(object);
+        
+        return newObject;
+    }
+    
+    /// Destruct and free an object.
+    void Free(T* object)
+    {
+        (object)->~T();
+        ConcurrentAllocatorFree(pool_, object);
+    }
+    
+    /// Return statistics.
+    AllocatorStats GetStats() const { return ConcurrentAllocatorGetStats(pool_); }
+    
+private:
+    /// Prevent copy construction.
+    ConcurrentAllocator(const ConcurrentAllocator<T>& rhs);
+    /// Prevent assignment.
+    ConcurrentAllocator<T>& operator = (const ConcurrentAllocator<T>& rhs);
+    
+    /// Allocator pool.
+    ConcurrentAllocatorPool* pool_;
+};
+
+}
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Container/FlatHashBase.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+unsigned FlatHashBase::BucketsForSize(unsigned size)
+{
+    unsigned numBuckets = MIN_BUCKETS;
+    while (size * 100 > numBuckets * MAX_LOAD_PERCENT)
+        numBuckets <<= 1;
+    return numBuckets;
+}
+
+void FlatHashBase::AllocateSlots(unsigned numBuckets)
+{
+    delete[] slots_;
+    slots_ = new FlatHashSlot[numBuckets];
+    numBuckets_ = numBuckets;
+
+    shift_ = 32;
+    while (numBuckets > 1)
+    {
+        numBuckets >>= 1;
+        --shift_;
+    }
+
+    ResetSlots();
+}
+
+void FlatHashBase::FreeSlots()
+{
+    delete[] slots_;
+    slots_ = 0;
+    numBuckets_ = 0;
+    shift_ = 0;
+}
+
+void FlatHashBase::ResetSlots()
+{
+    for (unsigned i = 0; i < numBuckets_; ++i)
+        slots_[i].hash_ = 0;
+}
+
+void FlatHashBase::InsertSlot(unsigned hash, unsigned index)
+{
+    FlatHashSlot slot;
+    slot.hash_ = hash;
+    slot.index_ = index;
+
+    unsigned mask = numBuckets_ - 1;
+    unsigned bucket = IdealBucket(hash);
+    unsigned distance = 0;
+
+    for (;;)
+    {
+        FlatHashSlot& current = slots_[bucket];
+        if (!current.hash_)
+        {
+            current = slot;
+            return;
+        }
+
+        // Take the place of a slot closer to its ideal bucket, and continue inserting that one instead
+        unsigned currentDistance = ProbeDistance(current.hash_, bucket);
+        if (currentDistance < distance)
+        {
+            Atomic::Swap(current, slot);
+            distance = currentDistance;
+        }
+
+        bucket = (bucket + 1) & mask;
+        ++distance;
+    }
+}
+
+void FlatHashBase::EraseSlot(unsigned bucket)
+{
+    unsigned mask = numBuckets_ - 1;
+
+    for (;;)
+    {
+        unsigned next = (bucket + 1) & mask;
+        FlatHashSlot& nextSlot = slots_[next];
+        if (!nextSlot.hash_ || !ProbeDistance(nextSlot.hash_, next))
+        {
+            slots_[bucket].hash_ = 0;
+            return;
+        }
+
+        slots_[bucket] = nextSlot;
+        bucket = next;
+    }
+}
+
+unsigned FlatHashBase::FindSlot(unsigned hash, unsigned index) const
+{
+    unsigned mask = numBuckets_ - 1;
+    unsigned bucket = IdealBucket(hash);
+
+    while (slots_[bucket].index_ != index || slots_[bucket].hash_ != hash)
+        bucket = (bucket + 1) & mask;
+
+    return bucket;
+}
+
+}
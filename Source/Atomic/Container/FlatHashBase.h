@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+#include "../Container/VectorBase.h"
+
+namespace Atomic
+{
+
+/// Open addressing hash table slot. Refers to an element in the dense element array.
+struct FlatHashSlot
+{
+    /// Mixed hash of the element's key, with the lowest bit set. Zero if the slot is empty.
+    unsigned hash_;
+    /// Index of the element.
+    unsigned index_;
+};
+
+/// Flat hash set/map base class. Stores the elements contiguously in insertion order, except that erasing moves the last element into the erased position, and finds them through a Robin Hood hashed table of slots.
+/** Like %HashBase, intentionally does not declare a virtual destructor and therefore %FlatHashBase pointers should never be used.
+  */
+class ATOMIC_API FlatHashBase
+{
+public:
+    /// Initial amount of buckets.
+    static const unsigned MIN_BUCKETS = 8;
+    /// Maximum load factor in percent.
+    static const unsigned MAX_LOAD_PERCENT = 80;
+    /// Index returned when a key is not found.
+    static const unsigned NOT_FOUND = 0xffffffff;
+
+    /// Construct.
+    FlatHashBase() :
+        slots_(0),
+        elements_(0),
+        size_(0),
+        capacity_(0),
+        numBuckets_(0),
+        shift_(0)
+    {
+    }
+
+    /// Swap with another flat hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        Atomic::Swap(slots_, rhs.slots_);
+        Atomic::Swap(elements_, rhs.elements_);
+        Atomic::Swap(size_, rhs.size_);
+        Atomic::Swap(capacity_, rhs.capacity_);
+        Atomic::Swap(numBuckets_, rhs.numBuckets_);
+        Atomic::Swap(shift_, rhs.shift_);
+    }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+    /// Return number of buckets.
+    unsigned NumBuckets() const { return numBuckets_; }
+    /// Return element capacity.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Spread a key hash over all bits with Fibonacci hashing, so that the bucket can be taken from the high bits. The lowest bit is set to tell used slots from empty ones.
+    static unsigned MixHash(unsigned hash) { return (hash * 2654435769u) | 1; }
+
+    /// Return the bucket a mixed hash would ideally occupy.
+    unsigned IdealBucket(unsigned hash) const { return hash >> shift_; }
+    /// Return the probe distance of a mixed hash in a bucket.
+    unsigned ProbeDistance(unsigned hash, unsigned bucket) const { return (bucket - IdealBucket(hash)) & (numBuckets_ - 1); }
+    /// Return whether inserting one more element requires more buckets.
+    bool NeedMoreBuckets() const { return (size_ + 1) * 100 > numBuckets_ * MAX_LOAD_PERCENT; }
+    /// Return the bucket count needed for an element count.
+    static unsigned BucketsForSize(unsigned size);
+
+    /// Allocate empty slots. The bucket count must be a power of two.
+    void AllocateSlots(unsigned numBuckets);
+    /// Free the slots.
+    void FreeSlots();
+    /// Empty all slots.
+    void ResetSlots();
+    /// Insert a slot for an element. The key must not exist yet, and there must be free buckets.
+    void InsertSlot(unsigned hash, unsigned index);
+    /// Erase a slot by shifting the following slots of the probe sequence backward.
+    void EraseSlot(unsigned bucket);
+    /// Return the bucket of the slot referring to an element.
+    unsigned FindSlot(unsigned hash, unsigned index) const;
+
+    /// Slots.
+    FlatHashSlot* slots_;
+    /// Element buffer.
+    unsigned char* elements_;
+    /// Number of elements.
+    unsigned size_;
+    /// Element buffer capacity.
+    unsigned capacity_;
+    /// Number of buckets.
+    unsigned numBuckets_;
+    /// Right shift of a mixed hash to get its ideal bucket.
+    unsigned shift_;
+};
+
+}
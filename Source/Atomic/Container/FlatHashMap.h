@@ -0,0 +1,367 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+#include <new>
+
+namespace Atomic
+{
+
+/// Open addressing hash map template class. Faster to look up and iterate than %HashMap, but inserting or erasing invalidates iterators and references to the values, and erasing changes the iteration order.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator == (const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+        /// Test for inequality with another pair.
+        bool operator != (const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+
+    private:
+        /// Prevent assignment.
+        KeyValue& operator = (const KeyValue& rhs);
+    };
+
+    typedef RandomAccessIterator<KeyValue> Iterator;
+    typedef RandomAccessConstIterator<KeyValue> ConstIterator;
+
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        *this = map;
+    }
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        Clear();
+        FreeSlots();
+        delete[] elements_;
+    }
+
+    /// Assign a hash map.
+    FlatHashMap& operator = (const FlatHashMap<T, U>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator += (const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash map.
+    FlatHashMap& operator += (const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash map.
+    bool operator == (const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash map.
+    bool operator != (const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [] (const T& key)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned bucket = FindBucket(key, hash);
+        unsigned index = bucket != NOT_FOUND ? slots_[bucket].index_ : InsertElement(key, U(), hash);
+        return Pairs()[index].second_;
+    }
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        unsigned hash = MixHash(MakeHash(pair.first_));
+        unsigned bucket = FindBucket(pair.first_, hash);
+        if (bucket != NOT_FOUND)
+        {
+            // If exists, just change the value
+            KeyValue* existing = Pairs() + slots_[bucket].index_;
+            existing->second_ = pair.second_;
+            return Iterator(existing);
+        }
+        else
+            return Iterator(Pairs() + InsertElement(pair.first_, pair.second_, hash));
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+            Insert(MakePair(i->first_, i->second_));
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned bucket = FindBucket(key, MixHash(MakeHash(key)));
+        if (bucket == NOT_FOUND)
+            return false;
+
+        EraseElement(bucket);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair, which is the pair moved into the erased position.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it.ptr_ - Pairs());
+        if (index >= size_)
+            return End();
+
+        EraseElement(FindSlot(MixHash(MakeHash(it->first_)), index));
+        return Iterator(Pairs() + index);
+    }
+
+    /// Clear the map. Keeps the allocated memory.
+    void Clear()
+    {
+        KeyValue* pairs = Pairs();
+        for (unsigned i = 0; i < size_; ++i)
+            (pairs + i)->~KeyValue();
+        size_ = 0;
+
+        ResetSlots();
+    }
+
+    /// Reserve memory for a number of pairs.
+    void Reserve(unsigned numPairs)
+    {
+        if (numPairs > capacity_)
+            SetCapacity(numPairs);
+
+        unsigned numBuckets = BucketsForSize(numPairs);
+        if (numBuckets > numBuckets_)
+            Rehash(numBuckets);
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned bucket = FindBucket(key, MixHash(MakeHash(key)));
+        return bucket != NOT_FOUND ? Iterator(Pairs() + slots_[bucket].index_) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned bucket = FindBucket(key, MixHash(MakeHash(key)));
+        return bucket != NOT_FOUND ? ConstIterator(Pairs() + slots_[bucket].index_) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindBucket(key, MixHash(MakeHash(key))) != NOT_FOUND; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(Pairs()); }
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(Pairs()); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(Pairs() + size_); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(Pairs() + size_); }
+
+private:
+    /// Return the pairs.
+    KeyValue* Pairs() const { return reinterpret_cast<KeyValue*>(elements_); }
+
+    /// Return the bucket of a key, or NOT_FOUND.
+    unsigned FindBucket(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return NOT_FOUND;
+
+        KeyValue* pairs = Pairs();
+        unsigned mask = numBuckets_ - 1;
+        unsigned bucket = IdealBucket(hash);
+
+        for (unsigned distance = 0;; ++distance)
+        {
+            const FlatHashSlot& slot = slots_[bucket];
+            // The key would have displaced a slot closer to its ideal bucket, so it can not be further on
+            if (!slot.hash_ || ProbeDistance(slot.hash_, bucket) < distance)
+                return NOT_FOUND;
+            if (slot.hash_ == hash && pairs[slot.index_].first_ == key)
+                return bucket;
+            bucket = (bucket + 1) & mask;
+        }
+    }
+
+    /// Insert a key that does not exist yet. Return the index of the new pair.
+    unsigned InsertElement(const T& key, const U& value, unsigned hash)
+    {
+        if (!slots_ || NeedMoreBuckets())
+            Rehash(slots_ ? numBuckets_ << 1 : MIN_BUCKETS);
+        if (size_ == capacity_)
+            SetCapacity(capacity_ ? capacity_ << 1 : MIN_BUCKETS);
+
+        new(Pairs() + size_) KeyValue(key, value);
+        InsertSlot(hash, size_);
+        return size_++;
+    }
+
+    /// Erase the pair of a slot. The last pair is moved into its position.
+    void EraseElement(unsigned bucket)
+    {
+        unsigned index = slots_[bucket].index_;
+        unsigned last = size_ - 1;
+        KeyValue* pairs = Pairs();
+
+        EraseSlot(bucket);
+        (pairs + index)->~KeyValue();
+
+        if (index != last)
+        {
+            slots_[FindSlot(MixHash(MakeHash(pairs[last].first_)), last)].index_ = index;
+            new(pairs + index) KeyValue(pairs[last]);
+            (pairs + last)->~KeyValue();
+        }
+
+        --size_;
+    }
+
+    /// Reallocate the pairs.
+    void SetCapacity(unsigned newCapacity)
+    {
+        unsigned char* newElements = new unsigned char[newCapacity * sizeof(KeyValue)];
+        KeyValue* pairs = Pairs();
+        KeyValue* newPairs = reinterpret_cast<KeyValue*>(newElements);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(newPairs + i) KeyValue(pairs[i]);
+            (pairs + i)->~KeyValue();
+        }
+
+        delete[] elements_;
+        elements_ = newElements;
+        capacity_ = newCapacity;
+    }
+
+    /// Reallocate the slots and insert the pairs again.
+    void Rehash(unsigned numBuckets)
+    {
+        AllocateSlots(numBuckets);
+
+        KeyValue* pairs = Pairs();
+        for (unsigned i = 0; i < size_; ++i)
+            InsertSlot(MixHash(MakeHash(pairs[i].first_)), i);
+    }
+};
+
+}
+
+namespace std
+{
+
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::ConstIterator begin(const Atomic::FlatHashMap<T, U>& v) { return v.Begin(); }
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::ConstIterator end(const Atomic::FlatHashMap<T, U>& v) { return v.End(); }
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::Iterator begin(Atomic::FlatHashMap<T, U>& v) { return v.Begin(); }
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::Iterator end(Atomic::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Vector.h"
+
+#include <new>
+
+namespace Atomic
+{
+
+/// Open addressing hash set template class. Faster to look up and iterate than %HashSet, but inserting or erasing invalidates iterators, and erasing changes the iteration order.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef RandomAccessConstIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+    /// Construct from another hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        *this = set;
+    }
+
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        Clear();
+        FreeSlots();
+        delete[] elements_;
+    }
+
+    /// Assign a hash set.
+    FlatHashSet& operator = (const FlatHashSet<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator += (const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash set.
+    FlatHashSet& operator += (const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash set.
+    bool operator == (const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash set.
+    bool operator != (const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned bucket = FindBucket(key, hash);
+        unsigned index = bucket != NOT_FOUND ? slots_[bucket].index_ : InsertElement(key, hash);
+        return Iterator(Keys() + index);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        for (ConstIterator i = set.Begin(); i != set.End(); ++i)
+            Insert(*i);
+    }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned bucket = FindBucket(key, MixHash(MakeHash(key)));
+        if (bucket == NOT_FOUND)
+            return false;
+
+        EraseElement(bucket);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key, which is the key moved into the erased position.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it.ptr_ - Keys());
+        if (index >= size_)
+            return End();
+
+        EraseElement(FindSlot(MixHash(MakeHash(*it)), index));
+        return Iterator(Keys() + index);
+    }
+
+    /// Clear the set. Keeps the allocated memory.
+    void Clear()
+    {
+        T* keys = Keys();
+        for (unsigned i = 0; i < size_; ++i)
+            (keys + i)->~T();
+        size_ = 0;
+
+        ResetSlots();
+    }
+
+    /// Reserve memory for a number of keys.
+    void Reserve(unsigned numKeys)
+    {
+        if (numKeys > capacity_)
+            SetCapacity(numKeys);
+
+        unsigned numBuckets = BucketsForSize(numKeys);
+        if (numBuckets > numBuckets_)
+            Rehash(numBuckets);
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned bucket = FindBucket(key, MixHash(MakeHash(key)));
+        return bucket != NOT_FOUND ? ConstIterator(Keys() + slots_[bucket].index_) : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindBucket(key, MixHash(MakeHash(key))) != NOT_FOUND; }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(Keys()); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(Keys() + size_); }
+    /// Return first key.
+    const T& Front() const { return *Begin(); }
+    /// Return last key.
+    const T& Back() const { return Keys()[size_ - 1]; }
+
+private:
+    /// Return the keys.
+    T* Keys() const { return reinterpret_cast<T*>(elements_); }
+
+    /// Return the bucket of a key, or NOT_FOUND.
+    unsigned FindBucket(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return NOT_FOUND;
+
+        T* keys = Keys();
+        unsigned mask = numBuckets_ - 1;
+        unsigned bucket = IdealBucket(hash);
+
+        for (unsigned distance = 0;; ++distance)
+        {
+            const FlatHashSlot& slot = slots_[bucket];
+            // The key would have displaced a slot closer to its ideal bucket, so it can not be further on
+            if (!slot.hash_ || ProbeDistance(slot.hash_, bucket) < distance)
+                return NOT_FOUND;
+            if (slot.hash_ == hash && keys[slot.index_] == key)
+                return bucket;
+            bucket = (bucket + 1) & mask;
+        }
+    }
+
+    /// Insert a key that does not exist yet. Return its index.
+    unsigned InsertElement(const T& key, unsigned hash)
+    {
+        if (!slots_ || NeedMoreBuckets())
+            Rehash(slots_ ? numBuckets_ << 1 : MIN_BUCKETS);
+        if (size_ == capacity_)
+            SetCapacity(capacity_ ? capacity_ << 1 : MIN_BUCKETS);
+
+        new(Keys() + size_) T(key);
+        InsertSlot(hash, size_);
+        return size_++;
+    }
+
+    /// Erase the key of a slot. The last key is moved into its position.
+    void EraseElement(unsigned bucket)
+    {
+        unsigned index = slots_[bucket].index_;
+        unsigned last = size_ - 1;
+        T* keys = Keys();
+
+        EraseSlot(bucket);
+        (keys + index)->~T();
+
+        if (index != last)
+        {
+            slots_[FindSlot(MixHash(MakeHash(keys[last])), last)].index_ = index;
+            new(keys + index) T(keys[last]);
+            (keys + last)->~T();
+        }
+
+        --size_;
+    }
+
+    /// Reallocate the keys.
+    void SetCapacity(unsigned newCapacity)
+    {
+        unsigned char* newElements = new unsigned char[newCapacity * sizeof(T)];
+        T* keys = Keys();
+        T* newKeys = reinterpret_cast<T*>(newElements);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(newKeys + i) T(keys[i]);
+            (keys + i)->~T();
+        }
+
+        delete[] elements_;
+        elements_ = newElements;
+        capacity_ = newCapacity;
+    }
+
+    /// Reallocate the slots and insert the keys again.
+    void Rehash(unsigned numBuckets)
+    {
+        AllocateSlots(numBuckets);
+
+        T* keys = Keys();
+        for (unsigned i = 0; i < size_; ++i)
+            InsertSlot(MixHash(MakeHash(keys[i])), i);
+    }
+};
+
+}
+
+namespace std
+{
+
+template <class T> typename Atomic::FlatHashSet<T>::ConstIterator begin(const Atomic::FlatHashSet<T>& v) { return v.Begin(); }
+template <class T> typename Atomic::FlatHashSet<T>::ConstIterator end(const Atomic::FlatHashSet<T>& v) { return v.End(); }
+
+}
@@ -92,39 +92,39 @@ Atomic::RandomAccessConstIterator<T> End(const Atomic::Vector<T> *v) {
 
 // podvector support functions
 
-template <class T>
-Atomic::RandomAccessIterator<T> Begin(Atomic::PODVector<T> &v) {
+template <class T, class A>
+Atomic::RandomAccessIterator<T> Begin(Atomic::PODVector<T, A> &v) {
     return v.Begin();
 }
-template <class T>
-Atomic::RandomAccessIterator<T> Begin(Atomic::PODVector<T> *v) {
+template <class T, class A>
+Atomic::RandomAccessIterator<T> Begin(Atomic::PODVector<T, A> *v) {
     return v->Begin();
 }
 
-template <class T>
-Atomic::RandomAccessConstIterator<T> Begin(const Atomic::PODVector<T> &v) {
+template <class T, class A>
+Atomic::RandomAccessConstIterator<T> Begin(const Atomic::PODVector<T, A> &v) {
     return v.Begin();
 }
-template <class T>
-Atomic::RandomAccessConstIterator<T> Begin(const Atomic::PODVector<T> *v) {
+template <class T, class A>
+Atomic::RandomAccessConstIterator<T> Begin(const Atomic::PODVector<T, A> *v) {
     return v->Begin();
 }
 
-template <class T>
-Atomic::RandomAccessIterator<T> End(Atomic::PODVector<T> &v) {
+template <class T, class A>
+Atomic::RandomAccessIterator<T> End(Atomic::PODVector<T, A> &v) {
     return v.End();
 }
-template <class T>
-Atomic::RandomAccessIterator<T> End(Atomic::PODVector<T> *v) {
+template <class T, class A>
+Atomic::RandomAccessIterator<T> End(Atomic::PODVector<T, A> *v) {
     return v->End();
 }
 
-template <class T>
-Atomic::RandomAccessConstIterator<T> End(const Atomic::PODVector<T> &v) {
+template <class T, class A>
+Atomic::RandomAccessConstIterator<T> End(const Atomic::PODVector<T, A> &v) {
     return v.End();
 }
-template <class T>
-Atomic::RandomAccessConstIterator<T> End(const Atomic::PODVector<T> *v) {
+template <class T, class A>
+Atomic::RandomAccessConstIterator<T> End(const Atomic::PODVector<T, A> *v) {
     return v->End();
 }
 
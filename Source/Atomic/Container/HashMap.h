@@ -86,9 +86,9 @@ public:
         {
         }
         
-        /// Construct with key and value.
-        Node(const T& key, const U& value) :
-            pair_(key, value)
+        /// Construct with key and value, which is copied or moved.
+        template <class V> Node(const T& key, V&& value) :
+            pair_(key, static_cast<V&&>(value))
         {
         }
         
@@ -186,6 +186,14 @@ public:
         *this = map;
     }
     
+    /// Construct by taking the contents of another hash map, which is left empty.
+    HashMap(HashMap<T, U>&& map)
+    {
+        allocator_ = AllocatorInitialize(sizeof(Node));
+        head_ = tail_ = ReserveNode();
+        Swap(map);
+    }
+    
     /// Destruct.
     ~HashMap()
     {
@@ -203,6 +211,13 @@ public:
         return *this;
     }
     
+    /// Assign by exchanging contents with another hash map.
+    HashMap& operator = (HashMap<T, U>&& rhs)
+    {
+        Swap(rhs);
+        return *this;
+    }
+    
     /// Add-assign a pair.
     HashMap& operator += (const Pair<T, U>& rhs)
     {
@@ -274,6 +289,12 @@ public:
         return Iterator(InsertNode(pair.first_, pair.second_));
     }
     
+    /// Insert a pair by moving its value. Return an iterator to it.
+    Iterator Insert(Pair<T, U>&& pair)
+    {
+        return Iterator(InsertNode(pair.first_, static_cast<U&&>(pair.second_)));
+    }
+    
     /// Insert a map.
     void Insert(const HashMap<T, U>& map)
     {
@@ -527,7 +548,7 @@ private:
     }
     
     /// Insert a key and value and return either the new or existing node.
-    Node* InsertNode(const T& key, const U& value, bool findExisting = true)
+    template <class V> Node* InsertNode(const T& key, V&& value, bool findExisting = true)
     {
         // If no pointers yet, allocate with minimum bucket count
         if (!ptrs_)
@@ -544,12 +565,12 @@ private:
             Node* existing = FindNode(key, hashKey);
             if (existing)
             {
-                existing->pair_.second_ = value;
+                existing->pair_.second_ = static_cast<V&&>(value);
                 return existing;
             }
         }
         
-        Node* newNode = InsertNode(Tail(), key, value);
+        Node* newNode = InsertNode(Tail(), key, static_cast<V&&>(value));
         newNode->down_ = Ptrs()[hashKey];
         Ptrs()[hashKey] = newNode;
         
@@ -564,12 +585,12 @@ private:
     }
     
     /// Insert a node into the list. Return the new node.
-    Node* InsertNode(Node* dest, const T& key, const U& value)
+    template <class V> Node* InsertNode(Node* dest, const T& key, V&& value)
     {
         if (!dest)
             return 0;
         
-        Node* newNode = ReserveNode(key, value);
+        Node* newNode = ReserveNode(key, static_cast<V&&>(value));
         Node* prev = dest->Prev();
         newNode->next_ = dest;
         newNode->prev_ = prev;
@@ -617,11 +638,11 @@ private:
         return newNode;
     }
     
-    /// Reserve a node with specified key and value.
-    Node* ReserveNode(const T& key, const U& value)
+    /// Reserve a node with specified key and value, which is copied or moved.
+    template <class V> Node* ReserveNode(const T& key, V&& value)
     {
         Node* newNode = static_cast<Node*>(AllocatorReserve(allocator_));
-        new(newNode) Node(key, value);
+        new(newNode) Node(key, static_cast<V&&>(value));
         return newNode;
     }
     
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Container/LinearAllocator.h"
+#include "../Container/ThreadLocal.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+static ThreadLocalPtr threadAllocator;
+
+LinearAllocator::LinearAllocator(unsigned blockSize) :
+    blocks_(0),
+    blockSize_(blockSize ? blockSize : DEFAULT_BLOCK_SIZE),
+    allocatedBytes_(0),
+    numAllocations_(0),
+    lastAllocatedBytes_(0),
+    lastNumAllocations_(0)
+{
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    if (GetThreadAllocator() == this)
+        SetThreadAllocator(0);
+    
+    FreeBlocks();
+}
+
+void* LinearAllocator::Allocate(unsigned size)
+{
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    
+    if (!blocks_ || blocks_->used_ + size > blocks_->size_)
+    {
+        // Grow the block size geometrically so that a large first use settles quickly
+        unsigned newSize = blocks_ ? blocks_->size_ * 2 : blockSize_;
+        if (newSize < size)
+            newSize = size;
+        AllocateBlock(newSize);
+    }
+    
+    void* ret = GetBlockMemory(blocks_) + blocks_->used_;
+    blocks_->used_ += size;
+    allocatedBytes_ += size;
+    ++numAllocations_;
+    return ret;
+}
+
+void LinearAllocator::Reset()
+{
+    lastAllocatedBytes_ = allocatedBytes_;
+    lastNumAllocations_ = numAllocations_;
+    allocatedBytes_ = 0;
+    numAllocations_ = 0;
+    
+    if (!blocks_)
+        return;
+    
+    if (blocks_->next_)
+    {
+        // Replace the blocks with one that would have sufficed
+        unsigned capacity = GetCapacity();
+        FreeBlocks();
+        AllocateBlock(capacity);
+    }
+    else
+        blocks_->used_ = 0;
+}
+
+bool LinearAllocator::Owns(const void* ptr) const
+{
+    const unsigned char* address = static_cast<const unsigned char*>(ptr);
+    
+    for (Block* block = blocks_; block; block = block->next_)
+    {
+        unsigned char* memory = GetBlockMemory(block);
+        if (address >= memory && address < memory + block->size_)
+            return true;
+    }
+    
+    return false;
+}
+
+unsigned LinearAllocator::GetCapacity() const
+{
+    unsigned capacity = 0;
+    for (Block* block = blocks_; block; block = block->next_)
+        capacity += block->size_;
+    return capacity;
+}
+
+void LinearAllocator::SetThreadAllocator(LinearAllocator* allocator)
+{
+    threadAllocator.Set(allocator);
+}
+
+LinearAllocator* LinearAllocator::GetThreadAllocator()
+{
+    return static_cast<LinearAllocator*>(threadAllocator.Get());
+}
+
+void LinearAllocator::AllocateBlock(unsigned size)
+{
+    Block* block = reinterpret_cast<Block*>(new unsigned char[HEADER_SIZE + size]);
+    block->next_ = blocks_;
+    block->size_ = size;
+    block->used_ = 0;
+    blocks_ = block;
+}
+
+void LinearAllocator::FreeBlocks()
+{
+    while (blocks_)
+    {
+        Block* next = blocks_->next_;
+        delete[] reinterpret_cast<unsigned char*>(blocks_);
+        blocks_ = next;
+    }
+}
+
+unsigned char* ThreadBufferAllocator::Allocate(unsigned size)
+{
+    LinearAllocator* allocator = LinearAllocator::GetThreadAllocator();
+    return allocator ? static_cast<unsigned char*>(allocator->Allocate(size)) : new unsigned char[size];
+}
+
+void ThreadBufferAllocator::Free(unsigned char* buffer)
+{
+    if (!buffer)
+        return;
+    
+    LinearAllocator* allocator = LinearAllocator::GetThreadAllocator();
+    if (!allocator || !allocator->Owns(buffer))
+        delete[] buffer;
+}
+
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Atomic
+{
+
+/// %Linear allocator for short-lived temporaries. Allocating advances a pointer in a memory block, allocations are not freed individually, and Reset() releases all of them at once. Not thread-safe, so each thread should use its own.
+class ATOMIC_API LinearAllocator
+{
+public:
+    /// Default size of the first memory block.
+    static const unsigned DEFAULT_BLOCK_SIZE = 64 * 1024;
+    /// Alignment of allocations.
+    static const unsigned ALIGNMENT = 16;
+    
+    /// Construct with the size of the first memory block, which is allocated on first use.
+    LinearAllocator(unsigned blockSize = DEFAULT_BLOCK_SIZE);
+    /// Destruct. Free the memory blocks.
+    ~LinearAllocator();
+    
+    /// Allocate memory. It stays valid until the next reset.
+    void* Allocate(unsigned size);
+    /// Release all allocations. If more than one memory block was needed, replace them with one block large enough for all, so that the same use after the reset does not allocate from the heap.
+    void Reset();
+    
+    /// Return whether memory was allocated from this allocator.
+    bool Owns(const void* ptr) const;
+    /// Return bytes allocated since the last reset.
+    unsigned GetAllocatedBytes() const { return allocatedBytes_; }
+    /// Return number of allocations since the last reset.
+    unsigned GetNumAllocations() const { return numAllocations_; }
+    /// Return bytes allocated between the two latest resets.
+    unsigned GetLastAllocatedBytes() const { return lastAllocatedBytes_; }
+    /// Return number of allocations between the two latest resets.
+    unsigned GetLastNumAllocations() const { return lastNumAllocations_; }
+    /// Return total size of the memory blocks.
+    unsigned GetCapacity() const;
+    
+    /// Set the allocator of the calling thread, or null to clear. Used by ThreadBufferAllocator.
+    static void SetThreadAllocator(LinearAllocator* allocator);
+    /// Return the allocator of the calling thread, or null if not set.
+    static LinearAllocator* GetThreadAllocator();
+    
+private:
+    /// Memory block header. The memory of the block follows.
+    struct Block
+    {
+        /// Next older block.
+        Block* next_;
+        /// Size of the memory.
+        unsigned size_;
+        /// Bytes used.
+        unsigned used_;
+    };
+    
+    /// Prevent copy construction.
+    LinearAllocator(const LinearAllocator& rhs);
+    /// Prevent assignment.
+    LinearAllocator& operator = (const LinearAllocator& rhs);
+    
+    /// Allocate a memory block and make it the current one.
+    void AllocateBlock(unsigned size);
+    /// Free all memory blocks.
+    void FreeBlocks();
+    /// Return the memory of a block.
+    static unsigned char* GetBlockMemory(Block* block) { return reinterpret_cast<unsigned char*>(block) + HEADER_SIZE; }
+    
+    /// Size of the block header, rounded up to the alignment.
+    static const unsigned HEADER_SIZE = (sizeof(Block) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    
+    /// Current memory block, which links to the older ones.
+    Block* blocks_;
+    /// Size of the first memory block.
+    unsigned blockSize_;
+    /// Bytes allocated since the last reset.
+    unsigned allocatedBytes_;
+    /// Number of allocations since the last reset.
+    unsigned numAllocations_;
+    /// Bytes allocated between the two latest resets.
+    unsigned lastAllocatedBytes_;
+    /// Number of allocations between the two latest resets.
+    unsigned lastNumAllocations_;
+};
+
+/// %PODVector buffer allocation policy that allocates from the calling thread's linear allocator, or from the heap if the thread has none. The buffer stays valid only until that allocator is reset, and must be freed in the same thread, so use only for temporaries that do not outlive the frame or work item. For example PODVector<Drawable*, ThreadBufferAllocator>.
+struct ATOMIC_API ThreadBufferAllocator
+{
+    /// Allocate a buffer.
+    static unsigned char* Allocate(unsigned size);
+    /// Free a buffer. Does nothing for buffers from the linear allocator.
+    static void Free(unsigned char* buffer);
+};
+
+}
@@ -43,6 +43,13 @@ public:
     {
     }
     
+    /// Construct with values, moving the second.
+    Pair(const T& first, U&& second) :
+        first_(first),
+        second_(static_cast<U&&>(second))
+    {
+    }
+    
     /// Test for equality with another pair.
     bool operator == (const Pair<T, U>& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
     /// Test for inequality with another pair.
@@ -47,6 +47,13 @@ public:
         AddRef();
     }
     
+    /// Construct by taking the object reference of another shared pointer, which is left null.
+    SharedPtr(SharedPtr<T>&& rhs) :
+        ptr_(rhs.ptr_)
+    {
+        rhs.ptr_ = 0;
+    }
+    
     /// Construct from a raw pointer.
     explicit SharedPtr(T* ptr) :
         ptr_(ptr)
@@ -73,6 +80,18 @@ public:
         return *this;
     }
     
+    /// Assign by taking the object reference of another shared pointer, which is left null.
+    SharedPtr<T>& operator = (SharedPtr<T>&& rhs)
+    {
+        // Take the reference before releasing the old one, as releasing may destroy the object that holds rhs
+        T* ptr = rhs.ptr_;
+        rhs.ptr_ = 0;
+        ReleaseRef();
+        ptr_ = ptr;
+        
+        return *this;
+    }
+    
     /// Assign from a raw pointer.
     SharedPtr<T>& operator = (T* ptr)
     {
@@ -109,10 +128,8 @@ public:
     {
         if (ptr_)
         {
-            RefCount* refCount = RefCountPtr();
-            ++refCount->refs_; // 2 refs
-            Reset(); // 1 ref
-            --refCount->refs_; // 0 refs
+            ptr_->ReleaseRefWithoutDelete();
+            ptr_ = 0;
         }
     }
     
@@ -356,7 +373,7 @@ public:
     /// Check if the pointer is not null.
     bool NotNull() const { return refCount_ != 0; }
     /// Return the object's reference count, or 0 if null pointer or if object has expired.
-    int Refs() const { return (refCount_ && refCount_->refs_ >= 0) ? refCount_->refs_ : 0; }
+    int Refs() const { return !Expired() ? ptr_->Refs() : 0; }
     
     /// Return the object's weak reference count.
     int WeakRefs() const
@@ -26,6 +26,10 @@
 
 #include <cassert>
 
+#ifdef ATOMIC_THREADSAFE_REFCOUNT
+#include <SDL/include/SDL_atomic.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Atomic
@@ -34,52 +38,90 @@ namespace Atomic
 static HashMap<unsigned, WeakPtr<RefCounted> > sRefCountedLookup;
 
 RefCounted::RefCounted() :
-    refCount_(new RefCount()),
+    refs_(0),
+    refCount_(0),
     jsHeapPtr_(0)
 {
-    // Hold a weak ref to self to avoid possible double delete of the refcount
-    (refCount_->weakRefs_)++;
-
 }
 
 RefCounted::~RefCounted()
 {
-    assert(refCount_);
-    assert(refCount_->refs_ == 0);
-    assert(refCount_->weakRefs_ > 0);
+    assert(refs_ == 0);
     
     // Mark object as expired, release the self weak ref and delete the refcount if no other weak refs exist
-    refCount_->refs_ = -1;
-    (refCount_->weakRefs_)--;
-    if (!refCount_->weakRefs_)
-        delete refCount_;
-    
-    refCount_ = 0;
+    if (refCount_)
+    {
+        assert(refCount_->weakRefs_ > 0);
+        refCount_->refs_ = -1;
+        (refCount_->weakRefs_)--;
+        if (!refCount_->weakRefs_)
+            delete refCount_;
+        
+        refCount_ = 0;
+    }
 }
 
 void RefCounted::AddRef()
 {
-    assert(refCount_->refs_ >= 0);
-    (refCount_->refs_)++;
+    assert(refs_ >= 0);
+    #ifdef ATOMIC_THREADSAFE_REFCOUNT
+    SDL_AtomicIncRef(reinterpret_cast<SDL_atomic_t*>(&refs_));
+    #else
+    ++refs_;
+    #endif
 }
 
 void RefCounted::ReleaseRef()
 {
-    assert(refCount_->refs_ > 0);
-    (refCount_->refs_)--;
-    if (!refCount_->refs_)
+    assert(refs_ > 0);
+    #ifdef ATOMIC_THREADSAFE_REFCOUNT
+    if (SDL_AtomicAdd(reinterpret_cast<SDL_atomic_t*>(&refs_), -1) == 1)
         delete this;
+    #else
+    if (!--refs_)
+        delete this;
+    #endif
+}
+
+void RefCounted::ReleaseRefWithoutDelete()
+{
+    assert(refs_ > 0);
+    #ifdef ATOMIC_THREADSAFE_REFCOUNT
+    SDL_AtomicAdd(reinterpret_cast<SDL_atomic_t*>(&refs_), -1);
+    #else
+    --refs_;
+    #endif
 }
 
 int RefCounted::Refs() const
 {
-    return refCount_->refs_;
+    return refs_;
 }
 
 int RefCounted::WeakRefs() const
 {
     // Subtract one to not return the internally held reference
-    return refCount_->weakRefs_ - 1;
+    return refCount_ ? refCount_->weakRefs_ - 1 : 0;
+}
+
+RefCount* RefCounted::RefCountPtr()
+{
+    if (!refCount_)
+    {
+        // The structure only marks expiration, as the object holds the reference count. Hold a weak ref to self to
+        // avoid possible double delete of the refcount
+        RefCount* refCount = new RefCount();
+        refCount->weakRefs_ = 1;
+        
+        #ifdef ATOMIC_THREADSAFE_REFCOUNT
+        if (!SDL_AtomicCASPtr(reinterpret_cast<void**>(&refCount_), 0, refCount))
+            delete refCount;
+        #else
+        refCount_ = refCount;
+        #endif
+    }
+    
+    return refCount_;
 }
 
 }
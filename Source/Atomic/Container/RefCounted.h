@@ -43,17 +43,17 @@ struct RefCount
         weakRefs_ = -1;
     }
     
-    /// Reference count. If below zero, the object has been destroyed.
+    /// Reference count. If below zero, the object has been destroyed. For RefCounted objects, which hold their own reference count, only marks destruction.
     int refs_;
     /// Weak reference count.
     int weakRefs_;
 };
 
-/// Base class for intrusively reference-counted objects. These are noncopyable and non-assignable.
+/// Base class for intrusively reference-counted objects. These are noncopyable and non-assignable. The reference count is stored in the object. The reference count structure used by weak pointers is allocated when the first weak pointer is created. With ATOMIC_THREADSAFE_REFCOUNT defined, the reference count is atomic so that shared pointers can be passed between threads. Weak pointers are never thread-safe.
 class ATOMIC_API RefCounted
 {
 public:
-    /// Construct. Allocate the reference count structure and set an initial self weak reference.
+    /// Construct.
     RefCounted();
     /// Destruct. Mark as expired and also delete the reference count structure if no outside weak references exist.
     virtual ~RefCounted();
@@ -62,12 +62,14 @@ public:
     void AddRef();
     /// Decrement reference count and delete self if no more references. Can also be called outside of a SharedPtr for traditional reference counting.
     void ReleaseRef();
+    /// Decrement reference count without deleting self even if no more references. To be used for scripting language interoperation.
+    void ReleaseRefWithoutDelete();
     /// Return reference count.
     int Refs() const;
     /// Return weak reference count.
     int WeakRefs() const;
-    /// Return pointer to the reference count structure.
-    RefCount* RefCountPtr() { return refCount_; }
+    /// Return pointer to the reference count structure. Allocate it and set an initial self weak reference on first call.
+    RefCount* RefCountPtr();
 
     virtual bool IsObject() const { return false; }
 
@@ -80,7 +82,9 @@ private:
     /// Prevent assignment.
     RefCounted& operator = (const RefCounted& rhs);
     
-    /// Pointer to the reference count structure.
+    /// Reference count.
+    int refs_;
+    /// Pointer to the reference count structure, or null if no weak pointers have been created.
     RefCount* refCount_;
 
     void* jsHeapPtr_;
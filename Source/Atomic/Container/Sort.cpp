@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Container/Sort.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+static const unsigned RADIX_BITS = 8;
+static const unsigned RADIX_SIZE = 1 << RADIX_BITS;
+static const unsigned RADIX_PASSES = 64 / RADIX_BITS;
+
+static inline bool CompareKeyIndices(const KeyIndex& lhs, const KeyIndex& rhs)
+{
+    return lhs.key_ < rhs.key_;
+}
+
+void RadixSort(KeyIndex* items, KeyIndex* temp, unsigned count)
+{
+    // Insertion sort is stable and faster for short arrays
+    if (count <= RADIXSORT_THRESHOLD)
+    {
+        if (count > 1)
+            InsertionSort(RandomAccessIterator<KeyIndex>(items), RandomAccessIterator<KeyIndex>(items + count), CompareKeyIndices);
+        return;
+    }
+    
+    // Build the histograms of all digits in one pass
+    unsigned histograms[RADIX_PASSES][RADIX_SIZE];
+    memset(histograms, 0, sizeof histograms);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned long long key = items[i].key_;
+        for (unsigned pass = 0; pass < RADIX_PASSES; ++pass)
+            ++histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)];
+    }
+    
+    KeyIndex* src = items;
+    KeyIndex* dest = temp;
+    
+    for (unsigned pass = 0; pass < RADIX_PASSES; ++pass)
+    {
+        unsigned* histogram = histograms[pass];
+        unsigned shift = pass * RADIX_BITS;
+        
+        // Skip the pass if all keys have the same digit
+        if (histogram[(src[0].key_ >> shift) & (RADIX_SIZE - 1)] == count)
+            continue;
+        
+        // Convert the counts to output offsets
+        unsigned offset = 0;
+        for (unsigned i = 0; i < RADIX_SIZE; ++i)
+        {
+            unsigned digitCount = histogram[i];
+            histogram[i] = offset;
+            offset += digitCount;
+        }
+        
+        for (unsigned i = 0; i < count; ++i)
+            dest[histogram[(src[i].key_ >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+        
+        Swap(src, dest);
+    }
+    
+    if (src != items)
+        memcpy(items, src, count * sizeof(KeyIndex));
+}
+
+}
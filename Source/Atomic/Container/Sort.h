@@ -29,6 +29,16 @@ namespace Atomic
 {
 
 static const int QUICKSORT_THRESHOLD = 16;
+static const unsigned RADIXSORT_THRESHOLD = 64;
+
+/// 64-bit sort key and the index of the element it was calculated from, for sorting with RadixSort.
+struct KeyIndex
+{
+    /// Sort key.
+    unsigned long long key_;
+    /// Index of the element.
+    unsigned index_;
+};
 
 // Based on Comparison of several sorting algorithms by Juha Nieminen
 // http://warp.povusers.org/SortComparison/
@@ -141,4 +151,21 @@ template <class T, class U> void Sort(RandomAccessIterator<T> begin, RandomAcces
     InsertionSort(begin, end, compare);
 }
 
+/// Sort key and index pairs in ascending key order using a least significant digit radix sort. The sort is stable, so sorting first by a secondary key and then by a primary key orders by both. The temporary buffer must hold as many items. Byte positions where all keys are equal are skipped, so short keys cost less.
+ATOMIC_API void RadixSort(KeyIndex* items, KeyIndex* temp, unsigned count);
+
+/// Return a 32-bit radix sort key which orders floats like the less than operator. NaNs are not supported.
+inline unsigned FloatSortKey(float value)
+{
+    union
+    {
+        float f_;
+        unsigned u_;
+    } bits;
+    
+    bits.f_ = value;
+    // Flip all bits of negative values so that larger magnitudes sort first, and set the sign bit of positive values
+    return (bits.u_ & 0x80000000) ? ~bits.u_ : (bits.u_ | 0x80000000);
+}
+
 }
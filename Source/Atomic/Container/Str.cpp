@@ -419,12 +419,21 @@ void String::Resize(unsigned newLength)
         if (!newLength)
             return;
         
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
-        
-        buffer_ = new char[capacity_];
+        // Store short strings inline without allocating
+        if (newLength < LOCAL_CAPACITY)
+        {
+            capacity_ = LOCAL_CAPACITY;
+            buffer_ = localBuffer_;
+        }
+        else
+        {
+            // Calculate initial capacity
+            capacity_ = newLength + 1;
+            if (capacity_ < MIN_CAPACITY)
+                capacity_ = MIN_CAPACITY;
+            
+            buffer_ = new char[capacity_];
+        }
     }
     else
     {
@@ -435,10 +444,11 @@ void String::Resize(unsigned newLength)
                 capacity_ += (capacity_ + 1) >> 1;
             
             char* newBuffer = new char[capacity_];
-            // Move the existing data to the new buffer, then delete the old buffer
+            // Move the existing data to the new buffer, then delete the old buffer if it was not the inline buffer
             if (length_)
                 CopyChars(newBuffer, buffer_, length_);
-            delete[] buffer_;
+            if (buffer_ != localBuffer_)
+                delete[] buffer_;
             
             buffer_ = newBuffer;
         }
@@ -452,13 +462,16 @@ void String::Reserve(unsigned newCapacity)
 {
     if (newCapacity < length_ + 1)
         newCapacity = length_ + 1;
+    // Short strings always use the inline buffer
+    if (newCapacity < LOCAL_CAPACITY)
+        newCapacity = LOCAL_CAPACITY;
     if (newCapacity == capacity_)
         return;
     
-    char* newBuffer = new char[newCapacity];
+    char* newBuffer = newCapacity > LOCAL_CAPACITY ? new char[newCapacity] : localBuffer_;
     // Move the existing data to the new buffer, then delete the old buffer
     CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
+    if (capacity_ > LOCAL_CAPACITY)
         delete[] buffer_;
     
     capacity_ = newCapacity;
@@ -481,6 +494,19 @@ void String::Swap(String& str)
     Atomic::Swap(length_, str.length_);
     Atomic::Swap(capacity_, str.capacity_);
     Atomic::Swap(buffer_, str.buffer_);
+    
+    // Inline buffers can not be swapped by pointer, so exchange their contents and point back to own buffer
+    if (buffer_ == str.localBuffer_ || str.buffer_ == localBuffer_)
+    {
+        char temp[LOCAL_CAPACITY];
+        CopyChars(temp, localBuffer_, LOCAL_CAPACITY);
+        CopyChars(localBuffer_, str.localBuffer_, LOCAL_CAPACITY);
+        CopyChars(str.localBuffer_, temp, LOCAL_CAPACITY);
+        if (buffer_ == str.localBuffer_)
+            buffer_ = localBuffer_;
+        if (str.buffer_ == localBuffer_)
+            str.buffer_ = str.localBuffer_;
+    }
 }
 
 String String::Substring(unsigned pos) const
@@ -60,6 +60,15 @@ public:
         *this = str;
     }
     
+    /// Construct by taking the buffer of another string, which is left empty.
+    String(String&& str) :
+        length_(0),
+        capacity_(0),
+        buffer_(&endZero)
+    {
+        Swap(str);
+    }
+    
     /// Construct from a C string.
     String(const char* str) :
         length_(0),
@@ -148,7 +157,7 @@ public:
     /// Destruct.
     ~String()
     {
-        if (capacity_)
+        if (capacity_ > LOCAL_CAPACITY)
             delete[] buffer_;
     }
     
@@ -161,6 +170,14 @@ public:
         return *this;
     }
     
+    /// Assign by exchanging buffers with another string.
+    String& operator = (String&& rhs)
+    {
+        Swap(rhs);
+        
+        return *this;
+    }
+    
     /// Assign a C string.
     String& operator = (const char* rhs)
     {
@@ -463,6 +480,8 @@ public:
     static const unsigned NPOS = 0xffffffff;
     /// Initial dynamic allocation size.
     static const unsigned MIN_CAPACITY = 8;
+    /// Size of the inline buffer for short strings. Chosen so that a string takes four pointers, which still fits in a Variant.
+    static const unsigned LOCAL_CAPACITY = 3 * sizeof(void*) - 2 * sizeof(unsigned);
     /// Empty string.
     static const String EMPTY;
     
@@ -496,10 +515,12 @@ private:
     
     /// String length.
     unsigned length_;
-    /// Capacity, zero if buffer not allocated.
+    /// Capacity, zero if buffer not allocated. Equal to LOCAL_CAPACITY when using the inline buffer, greater when heap allocated.
     unsigned capacity_;
-    /// String buffer, null if not allocated.
+    /// String buffer. Points to endZero if not allocated, or to the inline buffer for short strings.
     char* buffer_;
+    /// Inline buffer for short strings.
+    char localBuffer_[LOCAL_CAPACITY];
     
     /// End zero for empty strings.
     static char endZero;
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "../Container/FlatHashBase.h"
 #include "../Container/HashBase.h"
 #include "../Container/ListBase.h"
 #include "../Container/Str.h"
@@ -49,4 +50,9 @@ template<> void Swap<HashBase>(HashBase& first, HashBase& second)
     first.Swap(second);
 }
 
+template<> void Swap<FlatHashBase>(FlatHashBase& first, FlatHashBase& second)
+{
+    first.Swap(second);
+}
+
 }
@@ -25,6 +25,7 @@
 namespace Atomic
 {
 
+class FlatHashBase;
 class HashBase;
 class ListBase;
 class String;
@@ -42,5 +43,6 @@ template<> void Swap<String>(String& first, String& second);
 template<> void Swap<VectorBase>(VectorBase& first, VectorBase& second);
 template<> void Swap<ListBase>(ListBase& first, ListBase& second);
 template<> void Swap<HashBase>(HashBase& first, HashBase& second);
+template<> void Swap<FlatHashBase>(FlatHashBase& first, FlatHashBase& second);
 
 }
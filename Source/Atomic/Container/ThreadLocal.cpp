@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Container/ThreadLocal.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+ThreadLocalPtr::ThreadLocalPtr()
+{
+    #ifdef WIN32
+    key_ = TlsAlloc();
+    #else
+    pthread_key_t key;
+    pthread_key_create(&key, 0);
+    key_ = (unsigned long)key;
+    #endif
+}
+
+ThreadLocalPtr::~ThreadLocalPtr()
+{
+    #ifdef WIN32
+    TlsFree((DWORD)key_);
+    #else
+    pthread_key_delete((pthread_key_t)key_);
+    #endif
+}
+
+void ThreadLocalPtr::Set(void* value)
+{
+    #ifdef WIN32
+    TlsSetValue((DWORD)key_, value);
+    #else
+    pthread_setspecific((pthread_key_t)key_, value);
+    #endif
+}
+
+void* ThreadLocalPtr::Get() const
+{
+    #ifdef WIN32
+    return TlsGetValue((DWORD)key_);
+    #else
+    return pthread_getspecific((pthread_key_t)key_);
+    #endif
+}
+
+}
@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Atomic
+{
+
+/// Thread-local pointer. Each thread sees its own value, which is null until set. Construct before other threads access it, for example as a static object.
+class ATOMIC_API ThreadLocalPtr
+{
+public:
+    /// Construct. Allocates the storage key.
+    ThreadLocalPtr();
+    /// Destruct. Frees the storage key.
+    ~ThreadLocalPtr();
+    
+    /// Set the calling thread's value.
+    void Set(void* value);
+    /// Return the calling thread's value.
+    void* Get() const;
+    
+private:
+    /// Prevent copy construction.
+    ThreadLocalPtr(const ThreadLocalPtr& rhs);
+    /// Prevent assignment.
+    ThreadLocalPtr& operator = (const ThreadLocalPtr& rhs);
+    
+    /// Storage key.
+    unsigned long key_;
+};
+
+}
@@ -62,6 +62,12 @@ public:
         *this = vector;
     }
     
+    /// Construct by taking the contents of another vector, which is left empty.
+    Vector(Vector<T>&& vector)
+    {
+        Swap(vector);
+    }
+    
     /// Destruct.
     ~Vector()
     {
@@ -77,6 +83,13 @@ public:
         return *this;
     }
     
+    /// Assign by exchanging contents with another vector.
+    Vector<T>& operator = (Vector<T>&& rhs)
+    {
+        Swap(rhs);
+        return *this;
+    }
+    
     /// Add-assign an element.
     Vector<T>& operator += (const T& rhs)
     {
@@ -151,10 +164,28 @@ public:
     const T& At(unsigned index) const { assert(index < size_); return Buffer()[index]; }
 
     /// Add an element at the end.
-    void Push(const T& value) { Resize(size_ + 1, &value); }
+    void Push(const T& value) { EmplaceBack(value); }
+    /// Add an element at the end by moving it.
+    void Push(T&& value) { EmplaceBack(static_cast<T&&>(value)); }
     /// Add another vector at the end.
     void Push(const Vector<T>& vector) { Resize(size_ + vector.size_, vector.Buffer()); }
     
+    /// Construct an element at the end from the arguments. Return the new element.
+    template <class... Args> T& EmplaceBack(Args&&... args)
+    {
+        if (size_ < capacity_)
+            new(Buffer() + size_) T(static_cast<Args&&>(args)...);
+        else
+        {
+            // Construct the new element before relocating, as the arguments may refer to the current elements
+            T* newBuffer = AllocateGrowBuffer(size_ + 1);
+            new(newBuffer + size_) T(static_cast<Args&&>(args)...);
+            ReplaceBuffer(newBuffer);
+        }
+        
+        return Buffer()[size_++];
+    }
+    
     /// Remove the last element.
     void Pop()
     {
@@ -302,20 +333,8 @@ public:
         
         if (newCapacity != capacity_)
         {
-            T* newBuffer = 0;
             capacity_ = newCapacity;
-            
-            if (capacity_)
-            {
-                newBuffer = reinterpret_cast<T*>(AllocateBuffer(capacity_ * sizeof(T)));
-                // Move the data into the new buffer
-                ConstructElements(newBuffer, Buffer(), size_);
-            }
-            
-            // Delete the old buffer
-            DestructElements(Buffer(), size_);
-            delete[] buffer_;
-            buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
+            ReplaceBuffer(capacity_ ? reinterpret_cast<T*>(AllocateBuffer(capacity_ * sizeof(T))) : 0);
         }
     }
     
@@ -378,34 +397,47 @@ private:
             DestructElements(Buffer() + newSize, size_ - newSize);
         else
         {
-            // Allocate new buffer if necessary and copy the current elements
+            // Allocate new buffer if necessary. Initialize the new elements before relocating the current ones, as the
+            // source data may be in the current buffer
             if (newSize > capacity_)
             {
-                if (!capacity_)
-                    capacity_ = newSize;
-                else
-                {
-                    while (capacity_ < newSize)
-                        capacity_ += (capacity_ + 1) >> 1;
-                }
-                
-                unsigned char* newBuffer = AllocateBuffer(capacity_ * sizeof(T));
-                if (buffer_)
-                {
-                    ConstructElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
-                    DestructElements(Buffer(), size_);
-                    delete[] buffer_;
-                }
-                buffer_ = newBuffer;
+                T* newBuffer = AllocateGrowBuffer(newSize);
+                ConstructElements(newBuffer + size_, src, newSize - size_);
+                ReplaceBuffer(newBuffer);
             }
-            
-            // Initialize the new elements
-            ConstructElements(Buffer() + size_, src, newSize - size_);
+            else
+                ConstructElements(Buffer() + size_, src, newSize - size_);
         }
         
         size_ = newSize;
     }
     
+    /// Grow the capacity to fit at least the new size and allocate a buffer of that capacity. The current buffer is not changed.
+    T* AllocateGrowBuffer(unsigned newSize)
+    {
+        if (!capacity_)
+            capacity_ = newSize;
+        else
+        {
+            while (capacity_ < newSize)
+                capacity_ += (capacity_ + 1) >> 1;
+        }
+        
+        return reinterpret_cast<T*>(AllocateBuffer(capacity_ * sizeof(T)));
+    }
+    
+    /// Relocate the current elements to a new buffer by moving and delete the current buffer.
+    void ReplaceBuffer(T* newBuffer)
+    {
+        if (buffer_)
+        {
+            MoveConstructElements(newBuffer, Buffer(), size_);
+            DestructElements(Buffer(), size_);
+            delete[] buffer_;
+        }
+        buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
+    }
+    
     /// Move a range of elements within the vector.
     void MoveRange(unsigned dest, unsigned src, unsigned count)
     {
@@ -413,12 +445,12 @@ private:
         if (src < dest)
         {
             for (unsigned i = count - 1; i < count; --i)
-                buffer[dest + i] = buffer[src + i];
+                buffer[dest + i] = static_cast<T&&>(buffer[src + i]);
         }
         if (src > dest)
         {
             for (unsigned i = 0; i < count; ++i)
-                buffer[dest + i] = buffer[src + i];
+                buffer[dest + i] = static_cast<T&&>(buffer[src + i]);
         }
     }
     
@@ -437,6 +469,13 @@ private:
         }
     }
     
+    /// Construct elements by moving from source data.
+    static void MoveConstructElements(T* dest, T* src, unsigned count)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            new(dest + i) T(static_cast<T&&>(*(src + i)));
+    }
+    
     /// Copy elements from one buffer to another.
     static void CopyElements(T* dest, const T* src, unsigned count)
     {
@@ -455,8 +494,8 @@ private:
     }
 };
 
-/// %Vector template class for POD types. Does not call constructors or destructors and uses block move.
-template <class T> class PODVector : public VectorBase
+/// %Vector template class for POD types. Does not call constructors or destructors and uses block move. The buffer allocation policy can be changed, see LinearAllocator.h.
+template <class T, class A = HeapBufferAllocator> class PODVector : public VectorBase
 {
 public:
     typedef T ValueType;
@@ -482,7 +521,7 @@ public:
     }
     
     /// Construct from another vector.
-    PODVector(const PODVector<T>& vector)
+    PODVector(const PODVector<T, A>& vector)
     {
         *this = vector;
     }
@@ -490,49 +529,65 @@ public:
     /// Destruct.
     ~PODVector()
     {
-        delete[] buffer_;
+        A::Free(buffer_);
     }
     
+    /// Construct by taking the buffer of another vector, which is left empty.
+    PODVector(PODVector<T, A>&& vector)
+    {
+        Swap(vector);
+    }
+    
+    /// Swap with another vector. Only vectors with the same allocation policy can be swapped.
+    void Swap(PODVector<T, A>& rhs) { VectorBase::Swap(rhs); }
+    
     /// Assign from another vector.
-    PODVector<T>& operator = (const PODVector<T>& rhs)
+    PODVector<T, A>& operator = (const PODVector<T, A>& rhs)
     {
         Resize(rhs.size_);
         CopyElements(Buffer(), rhs.Buffer(), rhs.size_);
         return *this;
     }
     
+    /// Assign by exchanging buffers with another vector.
+    PODVector<T, A>& operator = (PODVector<T, A>&& rhs)
+    {
+        Swap(rhs);
+        return *this;
+    }
+    
     /// Add-assign an element.
-    PODVector<T>& operator += (const T& rhs)
+    PODVector<T, A>& operator += (const T& rhs)
     {
         Push(rhs);
         return *this;
     }
     
     /// Add-assign another vector.
-    PODVector<T>& operator += (const PODVector<T>& rhs)
+    PODVector<T, A>& operator += (const PODVector<T, A>& rhs)
     {
         Push(rhs);
         return *this;
     }
     
     /// Add an element.
-    PODVector<T> operator + (const T& rhs) const
+    PODVector<T, A> operator + (const T& rhs) const
     {
-        PODVector<T> ret(*this);
+        PODVector<T, A> ret(*this);
         ret.Push(rhs);
         return ret;
     }
     
     /// Add another vector.
-    PODVector<T> operator + (const PODVector<T>& rhs) const
+    PODVector<T, A> operator + (const PODVector<T, A>& rhs) const
     {
-        PODVector<T> ret(*this);
+        PODVector<T, A> ret(*this);
         ret.Push(rhs);
         return ret;
     }
     
     /// Test for equality with another vector.
-    bool operator == (const PODVector<T>& rhs) const
+    bool operator == (const PODVector<T, A>& rhs) const
     {
         if (rhs.size_ != size_)
             return false;
@@ -549,7 +604,7 @@ public:
     }
     
     /// Test for inequality with another vector.
-    bool operator != (const PODVector<T>& rhs) const
+    bool operator != (const PODVector<T, A>& rhs) const
     {
         if (rhs.size_ != size_)
             return true;
@@ -584,8 +639,16 @@ public:
         Back() = value;
     }
     
+    /// Construct an element at the end from the arguments. Return the new element.
+    template <class... Args> T& EmplaceBack(Args&&... args)
+    {
+        T value(static_cast<Args&&>(args)...);
+        Push(value);
+        return Back();
+    }
+    
     /// Add another vector at the end.
-    void Push(const PODVector<T>& vector)
+    void Push(const PODVector<T, A>& vector)
     {
         unsigned oldSize = size_;
         Resize(size_ + vector.size_);
@@ -612,7 +675,7 @@ public:
     }
     
     /// Insert another vector at position.
-    void Insert(unsigned pos, const PODVector<T>& vector)
+    void Insert(unsigned pos, const PODVector<T, A>& vector)
     {
         if (pos > size_)
             pos = size_;
@@ -635,7 +698,7 @@ public:
     }
     
     /// Insert a vector by iterator.
-    Iterator Insert(const Iterator& dest, const PODVector<T>& vector)
+    Iterator Insert(const Iterator& dest, const PODVector<T, A>& vector)
     {
         unsigned pos = dest - Begin();
         if (pos > size_)
@@ -739,12 +802,12 @@ public:
                     capacity_ += (capacity_ + 1) >> 1;
             }
             
-            unsigned char* newBuffer = AllocateBuffer(capacity_ * sizeof(T));
+            unsigned char* newBuffer = A::Allocate(capacity_ * sizeof(T));
             // Move the data into the new buffer and delete the old
             if (buffer_)
             {
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
-                delete[] buffer_;
+                A::Free(buffer_);
             }
             buffer_ = newBuffer;
         }
@@ -765,13 +828,13 @@ public:
             
             if (capacity_)
             {
-                newBuffer = AllocateBuffer(capacity_ * sizeof(T));
+                newBuffer = A::Allocate(capacity_ * sizeof(T));
                 // Move the data into the new buffer
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
             }
             
             // Delete the old buffer
-            delete[] buffer_;
+            A::Free(buffer_);
             buffer_ = newBuffer;
         }
     }
@@ -851,9 +914,9 @@ template <class T> typename Atomic::Vector<T>::ConstIterator end(const Atomic::V
 template <class T> typename Atomic::Vector<T>::Iterator begin(Atomic::Vector<T>& v) { return v.Begin(); }
 template <class T> typename Atomic::Vector<T>::Iterator end(Atomic::Vector<T>& v) { return v.End(); }
 
-template <class T> typename Atomic::PODVector<T>::ConstIterator begin(const Atomic::PODVector<T>& v) { return v.Begin(); }
-template <class T> typename Atomic::PODVector<T>::ConstIterator end(const Atomic::PODVector<T>& v) { return v.End(); }
-template <class T> typename Atomic::PODVector<T>::Iterator begin(Atomic::PODVector<T>& v) { return v.Begin(); }
-template <class T> typename Atomic::PODVector<T>::Iterator end(Atomic::PODVector<T>& v) { return v.End(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::ConstIterator begin(const Atomic::PODVector<T, A>& v) { return v.Begin(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::ConstIterator end(const Atomic::PODVector<T, A>& v) { return v.End(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::Iterator begin(Atomic::PODVector<T, A>& v) { return v.Begin(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::Iterator end(Atomic::PODVector<T, A>& v) { return v.End(); }
 
 }
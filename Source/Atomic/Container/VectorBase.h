@@ -149,6 +149,8 @@ template <class T> struct RandomAccessConstIterator
   */
 class ATOMIC_API VectorBase
 {
+    friend struct HeapBufferAllocator;
+    
 public:
     /// Construct.
     VectorBase() :
@@ -177,4 +179,13 @@ protected:
     unsigned char* buffer_;
 };
 
+/// Default %PODVector buffer allocation policy, which uses the heap.
+struct HeapBufferAllocator
+{
+    /// Allocate a buffer.
+    static unsigned char* Allocate(unsigned size) { return VectorBase::AllocateBuffer(size); }
+    /// Free a buffer.
+    static void Free(unsigned char* buffer) { delete[] buffer; }
+};
+
 }
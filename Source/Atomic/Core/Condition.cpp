@@ -57,6 +57,7 @@ void Condition::Wait()
 #else
 Condition::Condition() :
     mutex_(new pthread_mutex_t),
+    signaled_(false),
     event_(new pthread_cond_t)
 {
     pthread_mutex_init((pthread_mutex_t*)mutex_, 0);
@@ -78,7 +79,13 @@ Condition::~Condition()
 
 void Condition::Set()
 {
+    pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
+    
+    // Behave like an auto-reset event: the set is remembered until a thread waits on the condition
+    pthread_mutex_lock(mutex);
+    signaled_ = true;
     pthread_cond_signal((pthread_cond_t*)event_);
+    pthread_mutex_unlock(mutex);
 }
 
 void Condition::Wait()
@@ -87,7 +94,9 @@ void Condition::Wait()
     pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
     
     pthread_mutex_lock(mutex);
-    pthread_cond_wait(cond, mutex);
+    while (!signaled_)
+        pthread_cond_wait(cond, mutex);
+    signaled_ = false;
     pthread_mutex_unlock(mutex);
 }
 #endif
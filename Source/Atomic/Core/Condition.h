@@ -45,6 +45,8 @@ private:
     #ifndef WIN32
     /// Mutex for the event, necessary for pthreads-based implementation.
     void* mutex_;
+    /// Signaled flag, necessary for pthreads-based implementation to not lose a set that happens before waiting.
+    bool signaled_;
     #endif
     /// Operating system specific event.
     void* event_;
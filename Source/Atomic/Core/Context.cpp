@@ -51,6 +51,59 @@ void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attribute
         attributes.Erase(i);
 }
 
+void TypedEventReceivers::Add(TypedEventHandler* handler)
+{
+    handler->SetReceiverIndex(handlers_.Size());
+    handlers_.Push(handler);
+}
+
+void TypedEventReceivers::Remove(TypedEventHandler* handler)
+{
+    unsigned index = handler->GetReceiverIndex();
+    if (index >= handlers_.Size() || handlers_[index] != handler)
+        return;
+
+    if (sendDepth_)
+    {
+        // Keep the indices stable for the send in progress
+        handlers_[index] = 0;
+        hasRemoved_ = true;
+    }
+    else
+    {
+        TypedEventHandler* last = handlers_.Back();
+        handlers_[index] = last;
+        last->SetReceiverIndex(index);
+        handlers_.Pop();
+    }
+}
+
+void TypedEventReceivers::EndSend()
+{
+    if (--sendDepth_ || !hasRemoved_)
+        return;
+
+    unsigned count = 0;
+    for (unsigned i = 0; i < handlers_.Size(); ++i)
+    {
+        TypedEventHandler* handler = handlers_[i];
+        if (handler)
+        {
+            handler->SetReceiverIndex(count);
+            handlers_[count++] = handler;
+        }
+    }
+    handlers_.Resize(count);
+    hasRemoved_ = false;
+}
+
+static void DeleteTypedEventReceivers(PODVector<TypedEventReceivers*>& receivers)
+{
+    for (PODVector<TypedEventReceivers*>::Iterator i = receivers.Begin(); i != receivers.End(); ++i)
+        delete *i;
+    receivers.Clear();
+}
+
 Context::Context() :
     eventHandler_(0)
 {
@@ -76,6 +129,13 @@ Context::~Context()
     subsystems_.Clear();
     factories_.Clear();
     
+    // Delete typed event receiver arrays
+    DeleteTypedEventReceivers(typedEventReceivers_);
+    for (HashMap<Object*, PODVector<TypedEventReceivers*> >::Iterator i = specificTypedEventReceivers_.Begin();
+         i != specificTypedEventReceivers_.End(); ++i)
+        DeleteTypedEventReceivers(i->second_);
+    specificTypedEventReceivers_.Clear();
+    
     // Delete allocated event data maps
     for (PODVector<VariantMap*>::Iterator i = eventDataMaps_.Begin(); i != eventDataMaps_.End(); ++i)
         delete *i;
@@ -229,6 +289,8 @@ void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash even
 
 void Context::RemoveEventSender(Object* sender)
 {
+    postedEvents_.RemoveSender(sender);
+
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificEventReceivers_.Find(sender);
     if (i != specificEventReceivers_.End())
     {
@@ -239,6 +301,29 @@ void Context::RemoveEventSender(Object* sender)
         }
         specificEventReceivers_.Erase(i);
     }
+
+    HashMap<Object*, PODVector<TypedEventReceivers*> >::Iterator j = specificTypedEventReceivers_.Find(sender);
+    if (j != specificTypedEventReceivers_.End())
+    {
+        // Collect the receivers first, as removing the sender from a receiver deletes all its handlers for the sender
+        PODVector<Object*> receivers;
+        for (PODVector<TypedEventReceivers*>::Iterator k = j->second_.Begin(); k != j->second_.End(); ++k)
+        {
+            if (!*k)
+                continue;
+            for (PODVector<TypedEventHandler*>::Iterator l = (*k)->handlers_.Begin(); l != (*k)->handlers_.End(); ++l)
+            {
+                if (*l && !receivers.Contains((*l)->GetReceiver()))
+                    receivers.Push((*l)->GetReceiver());
+            }
+        }
+
+        for (PODVector<Object*>::Iterator k = receivers.Begin(); k != receivers.End(); ++k)
+            (*k)->RemoveEventSender(sender);
+
+        DeleteTypedEventReceivers(j->second_);
+        specificTypedEventReceivers_.Erase(j);
+    }
 }
 
 void Context::RemoveEventReceiver(Object* receiver, StringHash eventType)
@@ -255,4 +340,26 @@ void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash e
         group->Erase(receiver);
 }
 
+void Context::AddTypedEventReceiver(TypedEventHandler* handler)
+{
+    unsigned eventIndex = handler->GetEventIndex();
+    PODVector<TypedEventReceivers*>& groups = handler->GetSender() ? specificTypedEventReceivers_[handler->GetSender()] :
+        typedEventReceivers_;
+    while (groups.Size() <= eventIndex)
+        groups.Push(0);
+    if (!groups[eventIndex])
+        groups[eventIndex] = new TypedEventReceivers();
+
+    groups[eventIndex]->Add(handler);
+    typedEventIndices_[handler->GetEventType()] = eventIndex;
+}
+
+void Context::RemoveTypedEventReceiver(TypedEventHandler* handler)
+{
+    TypedEventReceivers* group = handler->GetSender() ? GetTypedEventReceivers(handler->GetSender(), handler->GetEventIndex()) :
+        GetTypedEventReceivers(handler->GetEventIndex());
+    if (group)
+        group->Remove(handler);
+}
+
 }
@@ -23,12 +23,38 @@
 #pragma once
 
 #include "../Core/Attribute.h"
+#include "../Core/EventQueue.h"
 #include "../Core/Object.h"
 #include "../Container/HashSet.h"
 
 namespace Atomic
 {
 
+/// Typed event handlers of one event, stored contiguously for sending without hash lookups.
+struct ATOMIC_API TypedEventReceivers
+{
+    /// Construct.
+    TypedEventReceivers() :
+        sendDepth_(0),
+        hasRemoved_(false)
+    {
+    }
+
+    /// Add a handler.
+    void Add(TypedEventHandler* handler);
+    /// Remove a handler. During sending only clears its slot.
+    void Remove(TypedEventHandler* handler);
+    /// Finish sending. Compacts the handlers if removed during sending.
+    void EndSend();
+
+    /// Handlers. May contain nulls during sending.
+    PODVector<TypedEventHandler*> handlers_;
+    /// Sending nesting level.
+    unsigned sendDepth_;
+    /// Handlers removed during sending flag.
+    bool hasRemoved_;
+};
+
 /// Atomic execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class ATOMIC_API Context : public RefCounted
 {
@@ -58,6 +84,8 @@ public:
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Send the events posted from any thread so far. Called by Engine at the beginning of each frame.
+    void SendPostedEvents() { postedEvents_.Send(); }
 
     /// Copy base class attributes to derived class.
     void CopyBaseAttributes(StringHash baseType, StringHash derivedType);
@@ -134,6 +162,29 @@ public:
         return i != eventReceivers_.End() ? &i->second_ : 0;
     }
 
+    /// Return typed event receivers for a sender and typed event index, or null if they do not exist.
+    TypedEventReceivers* GetTypedEventReceivers(Object* sender, unsigned eventIndex)
+    {
+        HashMap<Object*, PODVector<TypedEventReceivers*> >::Iterator i = specificTypedEventReceivers_.Find(sender);
+        if (i != specificTypedEventReceivers_.End())
+            return eventIndex < i->second_.Size() ? i->second_[eventIndex] : 0;
+        else
+            return 0;
+    }
+
+    /// Return typed event receivers for a typed event index, or null if they do not exist.
+    TypedEventReceivers* GetTypedEventReceivers(unsigned eventIndex)
+    {
+        return eventIndex < typedEventReceivers_.Size() ? typedEventReceivers_[eventIndex] : 0;
+    }
+
+    /// Return typed event index for an event type, or M_MAX_UNSIGNED if no typed handlers have subscribed to it.
+    unsigned GetTypedEventIndex(StringHash eventType) const
+    {
+        HashMap<StringHash, unsigned>::ConstIterator i = typedEventIndices_.Find(eventType);
+        return i != typedEventIndices_.End() ? i->second_ : M_MAX_UNSIGNED;
+    }
+
 private:
     /// Add event receiver.
     void AddEventReceiver(Object* receiver, StringHash eventType);
@@ -145,6 +196,10 @@ private:
     void RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType);
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
+    /// Add typed event handler.
+    void AddTypedEventReceiver(TypedEventHandler* handler);
+    /// Remove typed event handler.
+    void RemoveTypedEventReceiver(TypedEventHandler* handler);
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
     /// Begin event send.
@@ -164,6 +219,14 @@ private:
     HashMap<StringHash, HashSet<Object*> > eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    /// Typed event receivers for non-specific events by typed event index.
+    PODVector<TypedEventReceivers*> typedEventReceivers_;
+    /// Typed event receivers for specific senders' events by typed event index.
+    HashMap<Object*, PODVector<TypedEventReceivers*> > specificTypedEventReceivers_;
+    /// Typed event indices by event type, for sending events with event data to typed handlers.
+    HashMap<StringHash, unsigned> typedEventIndices_;
+    /// Events posted from any thread.
+    EventQueue postedEvents_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
@@ -58,6 +58,86 @@ EVENT(E_POSTRENDERUPDATE, PostRenderUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of the application-wide logic update event.
+struct UpdateEvent
+{
+    /// Construct.
+    UpdateEvent(float timeStep = 0.0f) :
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_UPDATE; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const { eventData[Update::P_TIMESTEP] = timeStep_; }
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData) { timeStep_ = eventData[Update::P_TIMESTEP].GetFloat(); }
+
+    /// Time step.
+    float timeStep_;
+};
+
+/// Typed payload of the application-wide logic post-update event.
+struct PostUpdateEvent
+{
+    /// Construct.
+    PostUpdateEvent(float timeStep = 0.0f) :
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_POSTUPDATE; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const { eventData[PostUpdate::P_TIMESTEP] = timeStep_; }
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData) { timeStep_ = eventData[PostUpdate::P_TIMESTEP].GetFloat(); }
+
+    /// Time step.
+    float timeStep_;
+};
+
+/// Typed payload of the render update event.
+struct RenderUpdateEvent
+{
+    /// Construct.
+    RenderUpdateEvent(float timeStep = 0.0f) :
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_RENDERUPDATE; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const { eventData[RenderUpdate::P_TIMESTEP] = timeStep_; }
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData) { timeStep_ = eventData[RenderUpdate::P_TIMESTEP].GetFloat(); }
+
+    /// Time step.
+    float timeStep_;
+};
+
+/// Typed payload of the post-render update event.
+struct PostRenderUpdateEvent
+{
+    /// Construct.
+    PostRenderUpdateEvent(float timeStep = 0.0f) :
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_POSTRENDERUPDATE; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const { eventData[PostRenderUpdate::P_TIMESTEP] = timeStep_; }
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData) { timeStep_ = eventData[PostRenderUpdate::P_TIMESTEP].GetFloat(); }
+
+    /// Time step.
+    float timeStep_;
+};
+
 /// Frame end event.
 EVENT(E_ENDFRAME, EndFrame)
 {
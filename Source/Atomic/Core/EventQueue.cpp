@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Core/EventQueue.h"
+#include "../Core/Object.h"
+
+#include <SDL/include/SDL.h>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+EventQueue::EventQueue() :
+    head_(&stub_),
+    tail_(&stub_),
+    freeEvents_(0),
+    freeLock_(0)
+{
+}
+
+EventQueue::~EventQueue()
+{
+    PostedEvent* event;
+    while ((event = Pop()) != 0)
+        delete event;
+
+    while (freeEvents_)
+    {
+        event = freeEvents_;
+        freeEvents_ = event->next_;
+        delete event;
+    }
+}
+
+void EventQueue::Post(Object* sender, StringHash eventType, const VariantMap& eventData)
+{
+    PostedEvent* event = AllocateEvent();
+    event->sender_ = sender;
+    event->eventType_ = eventType;
+    event->eventData_ = eventData;
+    Push(event);
+}
+
+void EventQueue::Send()
+{
+    // Send only the events posted before this call, so that handlers or other threads posting events continuously can
+    // not keep the loop going. The placeholder at the head means that nothing has been posted since the last entry was removed
+    PostedEvent* last = static_cast<PostedEvent*>(SDL_AtomicGetPtr(&head_));
+    if (last == &stub_)
+        return;
+
+    PostedEvent* event;
+    while ((event = Pop()) != 0)
+    {
+        // The sender may destroy objects that have posted events, which are then discarded by RemoveSender()
+        if (event->sender_)
+            event->sender_->SendEvent(event->eventType_, event->eventData_);
+
+        bool isLast = event == last;
+        FreeEvent(event);
+        if (isLast)
+            break;
+    }
+}
+
+void EventQueue::RemoveSender(Object* sender)
+{
+    // The entries from the tail onward are owned by the main thread. An entry still being posted is not reachable yet,
+    // but posting while the sender is being destroyed would be an error anyway
+    for (PostedEvent* event = tail_; event; event = event->next_)
+    {
+        if (event->sender_ == sender)
+            event->sender_ = 0;
+    }
+}
+
+void EventQueue::Push(PostedEvent* event)
+{
+    event->next_ = 0;
+    SDL_MemoryBarrierRelease();
+    PostedEvent* previous = static_cast<PostedEvent*>(SDL_AtomicSetPtr(&head_, event));
+    // Between the exchange and this store the queue is temporarily broken, and Pop() waits for the link
+    previous->next_ = event;
+}
+
+EventQueue::PostedEvent* EventQueue::Pop()
+{
+    PostedEvent* tail = tail_;
+    PostedEvent* next = tail->next_;
+
+    if (tail == &stub_)
+    {
+        if (!next)
+            return 0;
+        tail_ = next;
+        tail = next;
+        next = next->next_;
+    }
+
+    if (next)
+    {
+        SDL_MemoryBarrierAcquire();
+        tail_ = next;
+        return tail;
+    }
+
+    // The tail is the last entry, unless an entry is still being linked after it
+    if (tail != SDL_AtomicGetPtr(&head_))
+        return 0;
+
+    // Push the placeholder so that the last entry can be removed
+    Push(&stub_);
+    next = tail->next_;
+    if (next)
+    {
+        SDL_MemoryBarrierAcquire();
+        tail_ = next;
+        return tail;
+    }
+
+    return 0;
+}
+
+EventQueue::PostedEvent* EventQueue::AllocateEvent()
+{
+    SDL_AtomicLock(&freeLock_);
+    PostedEvent* event = freeEvents_;
+    if (event)
+        freeEvents_ = event->next_;
+    SDL_AtomicUnlock(&freeLock_);
+
+    return event ? event : new PostedEvent();
+}
+
+void EventQueue::FreeEvent(PostedEvent* event)
+{
+    event->sender_ = 0;
+    // Destroy the event data here on the main thread, so that posting threads never destroy Variants when reusing it
+    event->eventData_.Clear();
+
+    SDL_AtomicLock(&freeLock_);
+    event->next_ = freeEvents_;
+    freeEvents_ = event;
+    SDL_AtomicUnlock(&freeLock_);
+}
+
+}
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Variant.h"
+
+namespace Atomic
+{
+
+class Object;
+
+/// Queue of events posted from any thread to be sent in the main thread. Posting does not block, and the queue entries are reused to avoid allocating memory for each event.
+class ATOMIC_API EventQueue
+{
+public:
+    /// Construct.
+    EventQueue();
+    /// Destruct. Discard the events not sent yet.
+    ~EventQueue();
+
+    /// Post an event to be sent by the sender. Thread-safe. The event data is copied, so it must not refer to objects that the posting thread does not own.
+    void Post(Object* sender, StringHash eventType, const VariantMap& eventData);
+    /// Send the events posted so far, in the order they were posted. Call only from the main thread.
+    void Send();
+    /// Discard the events posted by a sender. Called from the main thread on the sender's destruction.
+    void RemoveSender(Object* sender);
+
+private:
+    /// Queue entry.
+    struct PostedEvent
+    {
+        /// Construct.
+        PostedEvent() :
+            next_(0),
+            sender_(0)
+        {
+        }
+
+        /// Next entry in the queue or in the free list.
+        PostedEvent* volatile next_;
+        /// Sender. Null if the sender has been destroyed.
+        Object* sender_;
+        /// Event type.
+        StringHash eventType_;
+        /// Event data. Keeps its memory when the entry is reused.
+        VariantMap eventData_;
+    };
+
+    /// Add an entry to the queue.
+    void Push(PostedEvent* event);
+    /// Remove the oldest entry from the queue. Return null if the queue is empty or the next entry is still being posted.
+    PostedEvent* Pop();
+    /// Take an entry from the free list or allocate a new one.
+    PostedEvent* AllocateEvent();
+    /// Return an entry to the free list.
+    void FreeEvent(PostedEvent* event);
+
+    /// Most recently posted entry. Exchanged atomically by the posting threads.
+    void* head_;
+    /// Oldest entry. Accessed only by the main thread.
+    PostedEvent* tail_;
+    /// Placeholder entry that keeps the queue non-empty.
+    PostedEvent stub_;
+    /// Free entries.
+    PostedEvent* freeEvents_;
+    /// Spin lock for the free entries.
+    int freeLock_;
+};
+
+}
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Container/HashMap.h"
+#include "../Core/InternedString.h"
+#include "../Core/Mutex.h"
+
+#include <SDL/include/SDL_atomic.h>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Global interned string table. Frees the entries at program exit.
+class InternedStringTable
+{
+public:
+    /// Destruct.
+    ~InternedStringTable()
+    {
+        for (HashMap<String, InternedStringEntry*>::Iterator i = entries_.Begin(); i != entries_.End(); ++i)
+            delete i->second_;
+    }
+    
+    /// Entries by string.
+    HashMap<String, InternedStringEntry*> entries_;
+    /// Mutex for the entries.
+    Mutex mutex_;
+};
+
+static InternedStringTable internedStrings;
+
+InternedString::InternedString(const String& str) :
+    entry_(Intern(str.CString(), str.Length()))
+{
+}
+
+InternedString::InternedString(const char* str) :
+    entry_(Intern(str, str ? String::CStringLength(str) : 0))
+{
+}
+
+unsigned InternedString::GetNumInternedStrings()
+{
+    MutexLock lock(internedStrings.mutex_);
+    return internedStrings.entries_.Size();
+}
+
+unsigned InternedString::PurgeUnused()
+{
+    unsigned numPurged = 0;
+    
+    // New references to an unreferenced entry can only be added by Intern(), which holds the same lock
+    MutexLock lock(internedStrings.mutex_);
+    for (HashMap<String, InternedStringEntry*>::Iterator i = internedStrings.entries_.Begin(); i != internedStrings.entries_.End();)
+    {
+        HashMap<String, InternedStringEntry*>::Iterator current = i++;
+        if (SDL_AtomicGet(reinterpret_cast<SDL_atomic_t*>(&current->second_->refs_)) == 0)
+        {
+            delete current->second_;
+            internedStrings.entries_.Erase(current);
+            ++numPurged;
+        }
+    }
+    
+    return numPurged;
+}
+
+InternedStringEntry* InternedString::Intern(const char* str, unsigned length)
+{
+    if (!length)
+        return 0;
+    
+    String key(str, length);
+    
+    MutexLock lock(internedStrings.mutex_);
+    HashMap<String, InternedStringEntry*>::ConstIterator i = internedStrings.entries_.Find(key);
+    if (i != internedStrings.entries_.End())
+    {
+        AddRef(i->second_);
+        return i->second_;
+    }
+    
+    InternedStringEntry* entry = new InternedStringEntry();
+    entry->string_ = key;
+    entry->hash_ = StringHash(key);
+    entry->refs_ = 1;
+    internedStrings.entries_[key] = entry;
+    return entry;
+}
+
+void InternedString::AddRef(InternedStringEntry* entry)
+{
+    if (entry)
+        SDL_AtomicIncRef(reinterpret_cast<SDL_atomic_t*>(&entry->refs_));
+}
+
+void InternedString::ReleaseRef(InternedStringEntry* entry)
+{
+    if (entry)
+        SDL_AtomicAdd(reinterpret_cast<SDL_atomic_t*>(&entry->refs_), -1);
+}
+
+}
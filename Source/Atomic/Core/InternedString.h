@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Math/StringHash.h"
+
+namespace Atomic
+{
+
+/// Interned string table entry.
+struct InternedStringEntry
+{
+    /// String.
+    String string_;
+    /// Case-insensitive string hash.
+    StringHash hash_;
+    /// Number of handles referring to the entry. Modified atomically.
+    int refs_;
+};
+
+/// Handle to a string stored once in a global table, with its StringHash calculated when interned. Copying and comparing handles does not touch the string data. The table entries are reference counted, and entries no longer referred to are freed by PurgeUnused(), which ResourceCache calls when releasing all resources. Meant for resource and attribute names and similar strings that repeat, not for arbitrary text.
+class ATOMIC_API InternedString
+{
+public:
+    /// Construct empty.
+    InternedString() :
+        entry_(0)
+    {
+    }
+    
+    /// Copy-construct from another interned string.
+    InternedString(const InternedString& str) :
+        entry_(str.entry_)
+    {
+        AddRef(entry_);
+    }
+    
+    /// Construct from a string. Thread-safe.
+    InternedString(const String& str);
+    /// Construct from a C string. Thread-safe.
+    InternedString(const char* str);
+    /// Destruct.
+    ~InternedString()
+    {
+        ReleaseRef(entry_);
+    }
+    
+    /// Assign another interned string.
+    InternedString& operator = (const InternedString& rhs)
+    {
+        AddRef(rhs.entry_);
+        ReleaseRef(entry_);
+        entry_ = rhs.entry_;
+        return *this;
+    }
+    
+    /// Test for equality with another interned string.
+    bool operator == (const InternedString& rhs) const { return entry_ == rhs.entry_; }
+    /// Test for inequality with another interned string.
+    bool operator != (const InternedString& rhs) const { return entry_ != rhs.entry_; }
+    
+    /// Return the string.
+    const String& GetString() const { return entry_ ? entry_->string_ : String::EMPTY; }
+    /// Return the C string.
+    const char* CString() const { return GetString().CString(); }
+    /// Return the case-insensitive string hash.
+    StringHash GetHash() const { return entry_ ? entry_->hash_ : StringHash(); }
+    /// Return whether is empty.
+    bool Empty() const { return entry_ == 0; }
+    /// Return hash value for HashSet & HashMap. Unique per interned string.
+    unsigned ToHash() const { return (unsigned)((size_t)entry_ / sizeof(InternedStringEntry)); }
+    
+    /// Return number of interned strings, including unreferenced ones not yet purged.
+    static unsigned GetNumInternedStrings();
+    /// Free the table entries no longer referred to by any handle. Thread-safe. Return number of entries freed.
+    static unsigned PurgeUnused();
+    
+private:
+    /// Find or add the table entry of a string and add a reference to it.
+    static InternedStringEntry* Intern(const char* str, unsigned length);
+    /// Add a reference to a table entry.
+    static void AddRef(InternedStringEntry* entry);
+    /// Release a reference to a table entry. The entry is freed by the next PurgeUnused().
+    static void ReleaseRef(InternedStringEntry* entry);
+    
+    /// Table entry, null if empty.
+    InternedStringEntry* entry_;
+};
+
+}
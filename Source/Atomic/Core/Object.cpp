@@ -30,6 +30,12 @@
 namespace Atomic
 {
 
+unsigned AllocateTypedEventIndex()
+{
+    static unsigned numTypedEvents = 0;
+    return numTypedEvents++;
+}
+
 Object::Object(Context* context) :
     context_(context)
 {
@@ -49,10 +55,11 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
     EventHandler* specific = 0;
     EventHandler* nonSpecific = 0;
     
+    // Typed handlers are invoked through the typed receiver lists, so skip them here
     EventHandler* handler = eventHandlers_.First();
     while (handler)
     {
-        if (handler->GetEventType() == eventType)
+        if (handler->GetEventType() == eventType && !handler->IsTyped())
         {
             if (!handler->GetSender())
                 nonSpecific = handler;
@@ -92,7 +99,12 @@ void Object::SubscribeToEvent(StringHash eventType, EventHandler* handler)
     EventHandler* previous;
     EventHandler* oldHandler = FindSpecificEventHandler(0, eventType, &previous);
     if (oldHandler)
-        eventHandlers_.Erase(oldHandler, previous);
+    {
+        if (oldHandler->IsTyped())
+            RemoveEventHandler(oldHandler, previous);
+        else
+            eventHandlers_.Erase(oldHandler, previous);
+    }
     
     eventHandlers_.InsertFront(handler);
     
@@ -113,13 +125,56 @@ void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler
     EventHandler* previous;
     EventHandler* oldHandler = FindSpecificEventHandler(sender, eventType, &previous);
     if (oldHandler)
-        eventHandlers_.Erase(oldHandler, previous);
+    {
+        if (oldHandler->IsTyped())
+            RemoveEventHandler(oldHandler, previous);
+        else
+            eventHandlers_.Erase(oldHandler, previous);
+    }
     
     eventHandlers_.InsertFront(handler);
     
     context_->AddEventReceiver(this, sender, eventType);
 }
 
+void Object::SubscribeToEvent(TypedEventHandler* handler)
+{
+    if (!handler)
+        return;
+    
+    handler->SetSenderAndEventType(0, handler->GetEventType());
+    // Remove old event handler first, whether typed or not
+    EventHandler* previous;
+    EventHandler* oldHandler = FindSpecificEventHandler(0, handler->GetEventType(), &previous);
+    if (oldHandler)
+        RemoveEventHandler(oldHandler, previous);
+    
+    eventHandlers_.InsertFront(handler);
+    
+    context_->AddTypedEventReceiver(handler);
+}
+
+void Object::SubscribeToEvent(Object* sender, TypedEventHandler* handler)
+{
+    // If a null sender was specified, the event can not be subscribed to. Delete the handler in that case
+    if (!sender || !handler)
+    {
+        delete handler;
+        return;
+    }
+    
+    handler->SetSenderAndEventType(sender, handler->GetEventType());
+    // Remove old event handler first, whether typed or not
+    EventHandler* previous;
+    EventHandler* oldHandler = FindSpecificEventHandler(sender, handler->GetEventType(), &previous);
+    if (oldHandler)
+        RemoveEventHandler(oldHandler, previous);
+    
+    eventHandlers_.InsertFront(handler);
+    
+    context_->AddTypedEventReceiver(handler);
+}
+
 void Object::UnsubscribeFromEvent(StringHash eventType)
 {
     for (;;)
@@ -127,13 +182,7 @@ void Object::UnsubscribeFromEvent(StringHash eventType)
         EventHandler* previous;
         EventHandler* handler = FindEventHandler(eventType, &previous);
         if (handler)
-        {
-            if (handler->GetSender())
-                context_->RemoveEventReceiver(this, handler->GetSender(), eventType);
-            else
-                context_->RemoveEventReceiver(this, eventType);
-            eventHandlers_.Erase(handler, previous);
-        }
+            RemoveEventHandler(handler, previous);
         else
             break;
     }
@@ -147,10 +196,7 @@ void Object::UnsubscribeFromEvent(Object* sender, StringHash eventType)
     EventHandler* previous;
     EventHandler* handler = FindSpecificEventHandler(sender, eventType, &previous);
     if (handler)
-    {
-        context_->RemoveEventReceiver(this, handler->GetSender(), eventType);
-        eventHandlers_.Erase(handler, previous);
-    }
+        RemoveEventHandler(handler, previous);
 }
 
 void Object::UnsubscribeFromEvents(Object* sender)
@@ -163,10 +209,7 @@ void Object::UnsubscribeFromEvents(Object* sender)
         EventHandler* previous;
         EventHandler* handler = FindSpecificEventHandler(sender, &previous);
         if (handler)
-        {
-            context_->RemoveEventReceiver(this, handler->GetSender(), handler->GetEventType());
-            eventHandlers_.Erase(handler, previous);
-        }
+            RemoveEventHandler(handler, previous);
         else
             break;
     }
@@ -178,13 +221,7 @@ void Object::UnsubscribeFromAllEvents()
     {
         EventHandler* handler = eventHandlers_.First();
         if (handler)
-        {
-            if (handler->GetSender())
-                context_->RemoveEventReceiver(this, handler->GetSender(), handler->GetEventType());
-            else
-                context_->RemoveEventReceiver(this, handler->GetEventType());
-            eventHandlers_.Erase(handler);
-        }
+            RemoveEventHandler(handler, 0);
         else
             break;
     }
@@ -200,14 +237,7 @@ void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& excepti
         EventHandler* next = eventHandlers_.Next(handler);
         
         if ((!onlyUserData || handler->GetUserData()) && !exceptions.Contains(handler->GetEventType()))
-        {
-            if (handler->GetSender())
-                context_->RemoveEventReceiver(this, handler->GetSender(), handler->GetEventType());
-            else
-                context_->RemoveEventReceiver(this, handler->GetEventType());
-            
-            eventHandlers_.Erase(handler, previous);
-        }
+            RemoveEventHandler(handler, previous);
         else
             previous = handler;
 
@@ -223,6 +253,11 @@ void Object::SendEvent(StringHash eventType)
 }
 
 void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+{
+    SendEvent(eventType, eventData, true);
+}
+
+void Object::SendEvent(StringHash eventType, VariantMap& eventData, bool typedReceivers)
 {
     if (!Thread::IsMainThread())
     {
@@ -324,7 +359,97 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
         }
     }
     
+    // Then the typed receivers, which convert the event data to their payload
+    if (typedReceivers)
+    {
+        unsigned eventIndex = context->GetTypedEventIndex(eventType);
+        if (eventIndex != M_MAX_UNSIGNED && (!InvokeTypedEventHandlers(true, eventIndex, 0, &eventData) ||
+            !InvokeTypedEventHandlers(false, eventIndex, 0, &eventData)))
+        {
+            context->EndSendEvent();
+            return;
+        }
+    }
+    
+    context->EndSendEvent();
+}
+
+void Object::SendTypedEvent(StringHash eventType, unsigned eventIndex, const void* payload, void (*toVariantMap)(const void*, VariantMap&))
+{
+    if (!Thread::IsMainThread())
+    {
+        LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+    
+    Context* context = context_;
+    
+    // Typed receivers first, without hash lookups per receiver
+    context->BeginSendEvent(this);
+    bool alive = InvokeTypedEventHandlers(true, eventIndex, payload, 0) && InvokeTypedEventHandlers(false, eventIndex, payload, 0);
     context->EndSendEvent();
+    if (!alive)
+        return;
+    
+    // Then the receivers that take event data, such as script functions. Convert only if there are any
+    HashSet<Object*>* specific = context->GetEventReceivers(this, eventType);
+    HashSet<Object*>* nonSpecific = context->GetEventReceivers(eventType);
+    if ((specific && !specific->Empty()) || (nonSpecific && !nonSpecific->Empty()))
+    {
+        VariantMap& eventData = context->GetEventDataMap();
+        toVariantMap(payload, eventData);
+        SendEvent(eventType, eventData, false);
+    }
+}
+
+bool Object::InvokeTypedEventHandlers(bool specific, unsigned eventIndex, const void* payload, VariantMap* eventData)
+{
+    Context* context = context_;
+    TypedEventReceivers* receivers = specific ? context->GetTypedEventReceivers(this, eventIndex) :
+        context->GetTypedEventReceivers(eventIndex);
+    if (!receivers || receivers->handlers_.Empty())
+        return true;
+    
+    // Make a weak pointer to self to check for destruction during event handling
+    WeakPtr<Object> self(this);
+    // Handlers subscribed during the send will receive the next send
+    unsigned numHandlers = receivers->handlers_.Size();
+    ++receivers->sendDepth_;
+    
+    for (unsigned i = 0; i < numHandlers; ++i)
+    {
+        TypedEventHandler* handler = receivers->handlers_[i];
+        if (!handler)
+            continue;
+        
+        context->SetEventHandler(handler);
+        if (payload)
+            handler->InvokeTyped(payload);
+        else
+            handler->Invoke(*eventData);
+        context->SetEventHandler(0);
+        
+        // If self has been destroyed as a result of event handling, exit. The receivers of its own events are destroyed with it
+        if (self.Expired())
+        {
+            if (!specific)
+                receivers->EndSend();
+            return false;
+        }
+    }
+    
+    receivers->EndSend();
+    return true;
+}
+
+void Object::PostEvent(StringHash eventType)
+{
+    context_->postedEvents_.Post(this, eventType, Variant::emptyVariantMap);
+}
+
+void Object::PostEvent(StringHash eventType, const VariantMap& eventData)
+{
+    context_->postedEvents_.Post(this, eventType, eventData);
 }
 
 VariantMap& Object::GetEventDataMap() const
@@ -426,6 +551,18 @@ EventHandler* Object::FindSpecificEventHandler(Object* sender, StringHash eventT
     return 0;
 }
 
+void Object::RemoveEventHandler(EventHandler* handler, EventHandler* previous)
+{
+    if (handler->IsTyped())
+        context_->RemoveTypedEventReceiver(static_cast<TypedEventHandler*>(handler));
+    else if (handler->GetSender())
+        context_->RemoveEventReceiver(this, handler->GetSender(), handler->GetEventType());
+    else
+        context_->RemoveEventReceiver(this, handler->GetEventType());
+    
+    eventHandlers_.Erase(handler, previous);
+}
+
 void Object::RemoveEventSender(Object* sender)
 {
     EventHandler* handler = eventHandlers_.First();
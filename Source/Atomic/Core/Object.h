@@ -30,6 +30,7 @@ namespace Atomic
 
 class Context;
 class EventHandler;
+class TypedEventHandler;
 
 #define OBJECT(typeName) \
     public: \
@@ -70,6 +71,10 @@ public:
     void SubscribeToEvent(StringHash eventType, EventHandler* handler);
     /// Subscribe to a specific sender's event.
     void SubscribeToEvent(Object* sender, StringHash eventType, EventHandler* handler);
+    /// Subscribe to a typed event that can be sent by any sender. The handler receives the event payload struct instead of event data.
+    void SubscribeToEvent(TypedEventHandler* handler);
+    /// Subscribe to a specific sender's typed event.
+    void SubscribeToEvent(Object* sender, TypedEventHandler* handler);
     /// Unsubscribe from an event.
     void UnsubscribeFromEvent(StringHash eventType);
     /// Unsubscribe from a specific sender's event.
@@ -84,6 +89,12 @@ public:
     void SendEvent(StringHash eventType);
     /// Send event with parameters to all subscribers.
     void SendEvent(StringHash eventType, VariantMap& eventData);
+    /// Post an event to be sent to all subscribers in the main thread at the beginning of the next frame. Can be called from any thread.
+    void PostEvent(StringHash eventType);
+    /// Post an event with parameters to be sent to all subscribers in the main thread at the beginning of the next frame. Can be called from any thread. The parameters are copied in the calling thread, so they must not contain object pointers unless called from the main thread.
+    void PostEvent(StringHash eventType, const VariantMap& eventData);
+    /// Send a typed event to all subscribers. Typed subscribers receive the payload as is, others as event data converted from it. Typed subscribers of both this sender and any sender receive the event once from each subscription.
+    template <class T> void SendTypedEvent(const T& payload);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
     
@@ -121,6 +132,14 @@ private:
     EventHandler* FindSpecificEventHandler(Object* sender, StringHash eventType, EventHandler** previous = 0) const;
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Remove an event handler and its receiver registration from the context.
+    void RemoveEventHandler(EventHandler* handler, EventHandler* previous);
+    /// Send event with parameters, optionally also to typed subscribers.
+    void SendEvent(StringHash eventType, VariantMap& eventData, bool typedReceivers);
+    /// Send a typed event payload.
+    void SendTypedEvent(StringHash eventType, unsigned eventIndex, const void* payload, void (*toVariantMap)(const void*, VariantMap&));
+    /// Invoke the typed event handlers of this object's events, or of any sender's events. Return false if this object was destroyed during the invocation.
+    bool InvokeTypedEventHandlers(bool specific, unsigned eventIndex, const void* payload, VariantMap* eventData);
     
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
@@ -128,6 +147,27 @@ private:
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
 
+/// Allocate an index for a typed event payload type.
+ATOMIC_API unsigned AllocateTypedEventIndex();
+
+/// Return the index of a typed event payload type, used to store the typed event receivers in arrays instead of hash maps.
+template <class T> unsigned GetTypedEventIndex()
+{
+    static const unsigned index = AllocateTypedEventIndex();
+    return index;
+}
+
+/// Convert a typed event payload to event data.
+template <class T> void TypedEventToVariantMap(const void* payload, VariantMap& eventData)
+{
+    static_cast<const T*>(payload)->ToVariantMap(eventData);
+}
+
+template <class T> void Object::SendTypedEvent(const T& payload)
+{
+    SendTypedEvent(T::GetEventTypeStatic(), GetTypedEventIndex<T>(), &payload, &TypedEventToVariantMap<T>);
+}
+
 /// Base class for object factories.
 class ATOMIC_API ObjectFactory : public RefCounted
 {
@@ -215,6 +255,8 @@ public:
     virtual void Invoke(VariantMap& eventData) = 0;
     /// Return a unique copy of the event handler.
     virtual EventHandler* Clone() const = 0;
+    /// Return whether is a typed event handler.
+    virtual bool IsTyped() const { return false; }
     
     /// Return event receiver.
     Object* GetReceiver() const { return receiver_; }
@@ -276,6 +318,84 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Internal helper class for invoking typed event handler functions, which receive an event payload struct instead of event data. The payload struct defines the static function GetEventTypeStatic() and the member functions ToVariantMap() and FromVariantMap() to interoperate with event data.
+class ATOMIC_API TypedEventHandler : public EventHandler
+{
+public:
+    /// Construct with specified receiver, event type and typed event index.
+    TypedEventHandler(Object* receiver, StringHash eventType, unsigned eventIndex) :
+        EventHandler(receiver),
+        eventIndex_(eventIndex),
+        receiverIndex_(M_MAX_UNSIGNED)
+    {
+        eventType_ = eventType;
+    }
+
+    /// Invoke event handler function with the event payload.
+    virtual void InvokeTyped(const void* payload) = 0;
+    /// Return whether is a typed event handler.
+    virtual bool IsTyped() const { return true; }
+
+    /// Set index in the typed event receivers. Called by Context.
+    void SetReceiverIndex(unsigned index) { receiverIndex_ = index; }
+    /// Return typed event index.
+    unsigned GetEventIndex() const { return eventIndex_; }
+    /// Return index in the typed event receivers.
+    unsigned GetReceiverIndex() const { return receiverIndex_; }
+
+protected:
+    /// Typed event index.
+    unsigned eventIndex_;
+    /// Index in the typed event receivers.
+    unsigned receiverIndex_;
+};
+
+/// Template implementation of the typed event handler invoke helper (stores a function pointer of specific class and payload type.)
+template <class T, class U> class TypedEventHandlerImpl : public TypedEventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(const U&);
+
+    /// Construct with receiver and function pointers.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function) :
+        TypedEventHandler(receiver, U::GetEventTypeStatic(), GetTypedEventIndex<U>()),
+        function_(function)
+    {
+        assert(function_);
+    }
+
+    /// Invoke event handler function with the payload converted from event data.
+    virtual void Invoke(VariantMap& eventData)
+    {
+        U payload;
+        payload.FromVariantMap(eventData);
+        InvokeTyped(&payload);
+    }
+
+    /// Invoke event handler function with the event payload.
+    virtual void InvokeTyped(const void* payload)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(*static_cast<const U*>(payload));
+    }
+
+    /// Return a unique copy of the event handler.
+    virtual EventHandler* Clone() const
+    {
+        return new TypedEventHandlerImpl(static_cast<T*>(receiver_), function_);
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+/// Construct a typed event handler, deducing the payload type from the handler function.
+template <class T, class U> TypedEventHandler* MakeTypedEventHandler(T* receiver, void (T::*function)(const U&))
+{
+    return new TypedEventHandlerImpl<T, U>(receiver, function);
+}
+
 /// Describe an event's hash ID and begin a namespace in which to define its parameters.
 #define EVENT(eventID, eventName) static const Atomic::StringHash eventID(#eventName); namespace eventName
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
@@ -284,5 +404,7 @@ private:
 #define HANDLER(className, function) (new Atomic::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
 #define HANDLER_USERDATA(className, function, userData) (new Atomic::EventHandlerImpl<className>(this, &className::function, userData))
+/// Convenience macro to construct a TypedEventHandler that points to a receiver object and its member function taking an event payload struct.
+#define TYPED_HANDLER(className, function) (Atomic::MakeTypedEventHandler<className>(this, &className::function))
 
 }
@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/LinearAllocator.h"
+#include "../Container/Sort.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
+#include "../Math/MathDefs.h"
+
+namespace Atomic
+{
+
+/// Minimum number of elements per work item for ParallelSort.
+static const unsigned PARALLELSORT_MIN_CHUNK = 1024;
+
+/// Shared state of a parallel merge sort.
+template <class T, class U> struct ParallelSortData
+{
+    /// Construct.
+    ParallelSortData(U compare) :
+        compare_(compare)
+    {
+    }
+    
+    /// Source array of the current merge round.
+    T* src_;
+    /// Destination array of the current merge round.
+    T* dest_;
+    /// Length of the sorted runs in the source array.
+    unsigned runLength_;
+    /// Compare function.
+    U compare_;
+};
+
+/// Work function for sorting one chunk of the array.
+template <class T, class U> void ParallelSortChunkWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParallelSortData<T, U>* data = reinterpret_cast<ParallelSortData<T, U>*>(item->aux_);
+    Sort(RandomAccessIterator<T>(reinterpret_cast<T*>(item->start_)), RandomAccessIterator<T>(reinterpret_cast<T*>(item->end_)),
+        data->compare_);
+}
+
+/// Work function for merging two adjacent sorted runs into the destination array. Elements of the first run are taken first on ties.
+template <class T, class U> void ParallelSortMergeWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParallelSortData<T, U>* data = reinterpret_cast<ParallelSortData<T, U>*>(item->aux_);
+    T* start = reinterpret_cast<T*>(item->start_);
+    T* end = reinterpret_cast<T*>(item->end_);
+    T* mid = start + data->runLength_ < end ? start + data->runLength_ : end;
+    T* dest = data->dest_ + (start - data->src_);
+    
+    T* i = start;
+    T* j = mid;
+    while (i < mid && j < end)
+    {
+        if (data->compare_(*j, *i))
+            *dest++ = *j++;
+        else
+            *dest++ = *i++;
+    }
+    while (i < mid)
+        *dest++ = *i++;
+    while (j < end)
+        *dest++ = *j++;
+}
+
+/// Sort in ascending order using a compare function, by sorting chunks of the array in the work queue's threads and then merging them pairwise, also in parallel. The compare function must be safe to call from several threads at once. Falls back to Sort() for short arrays, without worker threads, or when not called from the main thread, as only the main thread may complete work. Intended for arrays of pointers or other simple values, which are copied to a temporary buffer from the thread's linear allocator.
+template <class T, class U> void ParallelSort(WorkQueue* queue, RandomAccessIterator<T> begin, RandomAccessIterator<T> end, U compare)
+{
+    unsigned count = end - begin;
+    unsigned numChunks = queue ? Min((int)queue->GetNumThreads() + 1, (int)(count / PARALLELSORT_MIN_CHUNK)) : 0;
+    if (numChunks < 2 || !Thread::IsMainThread())
+    {
+        Sort(begin, end, compare);
+        return;
+    }
+    
+    PODVector<T, ThreadBufferAllocator> temp(count);
+    ParallelSortData<T, U> data(compare);
+    data.src_ = &(*begin);
+    data.dest_ = &temp[0];
+    data.runLength_ = (count + numChunks - 1) / numChunks;
+    
+    for (unsigned start = 0; start < count; start += data.runLength_)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ParallelSortChunkWork<T, U>;
+        item->aux_ = &data;
+        item->start_ = data.src_ + start;
+        item->end_ = data.src_ + Min((int)(start + data.runLength_), (int)count);
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+    
+    // Merge runs pairwise, swapping the source and destination each round
+    while (data.runLength_ < count)
+    {
+        for (unsigned start = 0; start < count; start += data.runLength_ * 2)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = ParallelSortMergeWork<T, U>;
+            item->aux_ = &data;
+            item->start_ = data.src_ + start;
+            item->end_ = data.src_ + Min((int)(start + data.runLength_ * 2), (int)count);
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+        
+        Swap(data.src_, data.dest_);
+        data.runLength_ *= 2;
+    }
+    
+    if (data.src_ != &(*begin))
+    {
+        for (unsigned i = 0; i < count; ++i)
+            *(begin + i) = data.src_[i];
+    }
+}
+
+}
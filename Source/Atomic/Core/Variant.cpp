@@ -25,6 +25,8 @@
 
 #include <cstring>
 
+#include <SDL/include/SDL.h>
+
 namespace Atomic
 {
 
@@ -35,6 +37,45 @@ const ResourceRefList Variant::emptyResourceRefList;
 const VariantMap Variant::emptyVariantMap;
 const VariantVector Variant::emptyVariantVector;
 
+/// Add a reference to shared variant vector or map storage.
+template <class T> static void AddSharedRef(void* ptr)
+{
+    if (ptr)
+        SDL_AtomicAdd(reinterpret_cast<SDL_atomic_t*>(&static_cast<VariantSharedValue<T>*>(ptr)->refs_), 1);
+}
+
+/// Release a reference to shared variant vector or map storage, and delete it when no longer referred to.
+template <class T> static void ReleaseSharedRef(void* ptr)
+{
+    VariantSharedValue<T>* shared = static_cast<VariantSharedValue<T>*>(ptr);
+    if (shared && SDL_AtomicAdd(reinterpret_cast<SDL_atomic_t*>(&shared->refs_), -1) == 1)
+        delete shared;
+}
+
+/// Return modifiable shared variant vector or map storage, allocating or copying it if necessary.
+template <class T> static T* DetachShared(void*& ptr)
+{
+    VariantSharedValue<T>* shared = static_cast<VariantSharedValue<T>*>(ptr);
+    if (!shared)
+        ptr = shared = new VariantSharedValue<T>(T());
+    else if (SDL_AtomicGet(reinterpret_cast<SDL_atomic_t*>(&shared->refs_)) > 1)
+    {
+        // Referred to by other variants, so copy before modifying
+        VariantSharedValue<T>* copy = new VariantSharedValue<T>(shared->value_);
+        ReleaseSharedRef<T>(shared);
+        ptr = shared = copy;
+    }
+    return &shared->value_;
+}
+
+/// Replace shared variant vector or map storage with a new value. An empty value does not allocate.
+template <class T> static void AssignShared(void*& ptr, const T& value)
+{
+    void* newPtr = value.Empty() ? 0 : new VariantSharedValue<T>(value);
+    ReleaseSharedRef<T>(ptr);
+    ptr = newPtr;
+}
+
 static const char* typeNames[] =
 {
     "None",
@@ -85,25 +126,22 @@ Variant& Variant::operator = (const Variant& rhs)
         break;
 
     case VAR_VARIANTVECTOR:
-        *(reinterpret_cast<VariantVector*>(&value_)) = *(reinterpret_cast<const VariantVector*>(&rhs.value_));
+        // Share the vector until either variant modifies it. Add the reference first in case of self-assignment
+        AddSharedRef<VariantVector>(rhs.value_.ptr_);
+        ReleaseSharedRef<VariantVector>(value_.ptr_);
+        value_.ptr_ = rhs.value_.ptr_;
         break;
 
     case VAR_VARIANTMAP:
-        *(reinterpret_cast<VariantMap*>(&value_)) = *(reinterpret_cast<const VariantMap*>(&rhs.value_));
+        AddSharedRef<VariantMap>(rhs.value_.ptr_);
+        ReleaseSharedRef<VariantMap>(value_.ptr_);
+        value_.ptr_ = rhs.value_.ptr_;
         break;
 
     case VAR_PTR:
         *(reinterpret_cast<WeakPtr<RefCounted>*>(&value_)) = *(reinterpret_cast<const WeakPtr<RefCounted>*>(&rhs.value_));
         break;
         
-    case VAR_MATRIX3:
-        *(reinterpret_cast<Matrix3*>(value_.ptr_)) = *(reinterpret_cast<const Matrix3*>(rhs.value_.ptr_));
-        break;
-        
-    case VAR_MATRIX3X4:
-        *(reinterpret_cast<Matrix3x4*>(value_.ptr_)) = *(reinterpret_cast<const Matrix3x4*>(rhs.value_.ptr_));
-        break;
-        
     case VAR_MATRIX4:
         *(reinterpret_cast<Matrix4*>(value_.ptr_)) = *(reinterpret_cast<const Matrix4*>(rhs.value_.ptr_));
         break;
@@ -116,6 +154,75 @@ Variant& Variant::operator = (const Variant& rhs)
     return *this;
 }
 
+Variant& Variant::operator = (Variant&& rhs)
+{
+    if (&rhs == this)
+        return *this;
+
+    switch (rhs.type_)
+    {
+    case VAR_STRING:
+        SetType(VAR_STRING);
+        reinterpret_cast<String*>(&value_)->Swap(*reinterpret_cast<String*>(&rhs.value_));
+        break;
+
+    case VAR_BUFFER:
+        SetType(VAR_BUFFER);
+        reinterpret_cast<PODVector<unsigned char>*>(&value_)->Swap(*reinterpret_cast<PODVector<unsigned char>*>(&rhs.value_));
+        break;
+
+    case VAR_RESOURCEREF:
+        {
+            SetType(VAR_RESOURCEREF);
+            ResourceRef& ref = *reinterpret_cast<ResourceRef*>(&value_);
+            ResourceRef& rhsRef = *reinterpret_cast<ResourceRef*>(&rhs.value_);
+            ref.type_ = rhsRef.type_;
+            ref.name_.Swap(rhsRef.name_);
+        }
+        break;
+
+    case VAR_RESOURCEREFLIST:
+        {
+            SetType(VAR_RESOURCEREFLIST);
+            ResourceRefList& refList = *reinterpret_cast<ResourceRefList*>(&value_);
+            ResourceRefList& rhsRefList = *reinterpret_cast<ResourceRefList*>(&rhs.value_);
+            refList.type_ = rhsRefList.type_;
+            refList.names_.Swap(rhsRefList.names_);
+        }
+        break;
+
+    case VAR_VARIANTVECTOR:
+    case VAR_VARIANTMAP:
+    case VAR_MATRIX4:
+        // Take over the allocated storage
+        SetType(VAR_NONE);
+        type_ = rhs.type_;
+        value_.ptr_ = rhs.value_.ptr_;
+        rhs.type_ = VAR_NONE;
+        break;
+
+    default:
+        *this = rhs;
+        break;
+    }
+
+    return *this;
+}
+
+Variant& Variant::operator = (const VariantVector& rhs)
+{
+    SetType(VAR_VARIANTVECTOR);
+    AssignShared(value_.ptr_, rhs);
+    return *this;
+}
+
+Variant& Variant::operator = (const VariantMap& rhs)
+{
+    SetType(VAR_VARIANTMAP);
+    AssignShared(value_.ptr_, rhs);
+    return *this;
+}
+
 bool Variant::operator == (const Variant& rhs) const
 {
     if (type_ == VAR_VOIDPTR || type_ == VAR_PTR)
@@ -159,10 +266,10 @@ bool Variant::operator == (const Variant& rhs) const
         return *(reinterpret_cast<const ResourceRefList*>(&value_)) == *(reinterpret_cast<const ResourceRefList*>(&rhs.value_));
 
     case VAR_VARIANTVECTOR:
-        return *(reinterpret_cast<const VariantVector*>(&value_)) == *(reinterpret_cast<const VariantVector*>(&rhs.value_));
+        return value_.ptr_ == rhs.value_.ptr_ || GetVariantVector() == rhs.GetVariantVector();
 
     case VAR_VARIANTMAP:
-        return *(reinterpret_cast<const VariantMap*>(&value_)) == *(reinterpret_cast<const VariantMap*>(&rhs.value_));
+        return value_.ptr_ == rhs.value_.ptr_ || GetVariantMap() == rhs.GetVariantMap();
 
     case VAR_INTRECT:
         return *(reinterpret_cast<const IntRect*>(&value_)) == *(reinterpret_cast<const IntRect*>(&rhs.value_));
@@ -171,10 +278,10 @@ bool Variant::operator == (const Variant& rhs) const
         return *(reinterpret_cast<const IntVector2*>(&value_)) == *(reinterpret_cast<const IntVector2*>(&rhs.value_));
 
     case VAR_MATRIX3:
-        return *(reinterpret_cast<const Matrix3*>(value_.ptr_)) == *(reinterpret_cast<const Matrix3*>(rhs.value_.ptr_));
+        return *(reinterpret_cast<const Matrix3*>(&value_)) == *(reinterpret_cast<const Matrix3*>(&rhs.value_));
 
     case VAR_MATRIX3X4:
-        return *(reinterpret_cast<const Matrix3x4*>(value_.ptr_)) == *(reinterpret_cast<const Matrix3x4*>(rhs.value_.ptr_));
+        return *(reinterpret_cast<const Matrix3x4*>(&value_)) == *(reinterpret_cast<const Matrix3x4*>(&rhs.value_));
 
     case VAR_MATRIX4:
         return *(reinterpret_cast<const Matrix4*>(value_.ptr_)) == *(reinterpret_cast<const Matrix4*>(rhs.value_.ptr_));
@@ -322,6 +429,16 @@ void Variant::SetBuffer(const void* data, unsigned size)
         memcpy(&buffer[0], data, size);
 }
 
+VariantVector* Variant::GetVariantVectorPtr()
+{
+    return type_ == VAR_VARIANTVECTOR ? DetachShared<VariantVector>(value_.ptr_) : 0;
+}
+
+VariantMap* Variant::GetVariantMapPtr()
+{
+    return type_ == VAR_VARIANTMAP ? DetachShared<VariantMap>(value_.ptr_) : 0;
+}
+
 String Variant::GetTypeName() const
 {
     return typeNames[type_];
@@ -384,10 +501,10 @@ String Variant::ToString() const
         return String::EMPTY;
 
     case VAR_MATRIX3:
-        return (reinterpret_cast<const Matrix3*>(value_.ptr_))->ToString();
+        return (reinterpret_cast<const Matrix3*>(&value_))->ToString();
 
     case VAR_MATRIX3X4:
-        return (reinterpret_cast<const Matrix3x4*>(value_.ptr_))->ToString();
+        return (reinterpret_cast<const Matrix3x4*>(&value_))->ToString();
         
     case VAR_MATRIX4:
         return (reinterpret_cast<const Matrix4*>(value_.ptr_))->ToString();
@@ -447,10 +564,10 @@ bool Variant::IsZero() const
     }
 
     case VAR_VARIANTVECTOR:
-        return reinterpret_cast<const VariantVector*>(&value_)->Empty();
+        return GetVariantVector().Empty();
 
     case VAR_VARIANTMAP:
-        return reinterpret_cast<const VariantMap*>(&value_)->Empty();
+        return GetVariantMap().Empty();
 
     case VAR_INTRECT:
         return *reinterpret_cast<const IntRect*>(&value_) == IntRect::ZERO;
@@ -462,10 +579,10 @@ bool Variant::IsZero() const
         return *reinterpret_cast<const WeakPtr<RefCounted>*>(&value_) == (RefCounted*)0;
         
     case VAR_MATRIX3:
-        return *reinterpret_cast<const Matrix3*>(value_.ptr_) == Matrix3::IDENTITY;
+        return *reinterpret_cast<const Matrix3*>(&value_) == Matrix3::IDENTITY;
         
     case VAR_MATRIX3X4:
-        return *reinterpret_cast<const Matrix3x4*>(value_.ptr_) == Matrix3x4::IDENTITY;
+        return *reinterpret_cast<const Matrix3x4*>(&value_) == Matrix3x4::IDENTITY;
         
     case VAR_MATRIX4:
         return *reinterpret_cast<const Matrix4*>(value_.ptr_) == Matrix4::IDENTITY;
@@ -499,25 +616,17 @@ void Variant::SetType(VariantType newType)
         break;
 
     case VAR_VARIANTVECTOR:
-        (reinterpret_cast<VariantVector*>(&value_))->~VariantVector();
+        ReleaseSharedRef<VariantVector>(value_.ptr_);
         break;
 
     case VAR_VARIANTMAP:
-        (reinterpret_cast<VariantMap*>(&value_))->~VariantMap();
+        ReleaseSharedRef<VariantMap>(value_.ptr_);
         break;
 
     case VAR_PTR:
         (reinterpret_cast<WeakPtr<RefCounted>*>(&value_))->~WeakPtr<RefCounted>();
         break;
         
-    case VAR_MATRIX3:
-        delete reinterpret_cast<Matrix3*>(value_.ptr_);
-        break;
-        
-    case VAR_MATRIX3X4:
-        delete reinterpret_cast<Matrix3x4*>(value_.ptr_);
-        break;
-        
     case VAR_MATRIX4:
         delete reinterpret_cast<Matrix4*>(value_.ptr_);
         break;
@@ -547,11 +656,9 @@ void Variant::SetType(VariantType newType)
         break;
 
     case VAR_VARIANTVECTOR:
-        new(reinterpret_cast<VariantVector*>(&value_)) VariantVector();
-        break;
-
     case VAR_VARIANTMAP:
-        new(reinterpret_cast<VariantMap*>(&value_)) VariantMap();
+        // Empty until assigned or modified
+        value_.ptr_ = 0;
         break;
 
     case VAR_PTR:
@@ -559,11 +666,11 @@ void Variant::SetType(VariantType newType)
         break;
         
     case VAR_MATRIX3:
-        value_.ptr_ = new Matrix3();
+        new(reinterpret_cast<Matrix3*>(&value_)) Matrix3();
         break;
         
     case VAR_MATRIX3X4:
-        value_.ptr_ = new Matrix3x4();
+        new(reinterpret_cast<Matrix3x4*>(&value_)) Matrix3x4();
         break;
         
     case VAR_MATRIX4:
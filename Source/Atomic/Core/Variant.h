@@ -61,7 +61,7 @@ enum VariantType
     MAX_VAR_TYPES
 };
 
-/// Union for the possible variant values. Also stores non-POD objects such as String which must not exceed 16 bytes in size.
+/// Union for the possible variant values. Also stores non-POD objects such as String and ResourceRef, and math types up to the size of Matrix3x4, without allocating.
 struct VariantValue
 {
     union
@@ -92,6 +92,9 @@ struct VariantValue
         float float4_;
         void* ptr4_;
     };
+
+    /// Additional storage so that a Matrix3x4 fits.
+    unsigned char extra_[sizeof(Matrix3x4) - 4 * sizeof(void*)];
 };
 
 /// Typed resource reference.
@@ -172,6 +175,22 @@ typedef Vector<Variant> VariantVector;
 /// Map of variants.
 typedef HashMap<StringHash, Variant> VariantMap;
 
+/// Reference-counted storage of a variant vector or map, shared by copies of a variant until one of them is modified.
+template <class T> struct VariantSharedValue
+{
+    /// Construct with a value.
+    VariantSharedValue(const T& value) :
+        refs_(1),
+        value_(value)
+    {
+    }
+
+    /// Reference count. Changed with atomic operations, as copies of a variant may be destroyed in different threads.
+    int refs_;
+    /// Value.
+    T value_;
+};
+
 /// Variable that supports a fixed set of types.
 class ATOMIC_API Variant
 {
@@ -385,6 +404,13 @@ public:
         *this = value;
     }
 
+    /// Move-construct from another variant.
+    Variant(Variant&& value) :
+        type_(VAR_NONE)
+    {
+        *this = static_cast<Variant&&>(value);
+    }
+
     /// Destruct.
     ~Variant()
     {
@@ -399,6 +425,8 @@ public:
 
     /// Assign from another variant.
     Variant& operator = (const Variant& rhs);
+    /// Move-assign from another variant. The other variant is left with an unspecified value.
+    Variant& operator = (Variant&& rhs);
 
     /// Assign from an integer.
     Variant& operator = (int rhs)
@@ -529,20 +557,9 @@ public:
     }
 
     /// Assign from a variant vector.
-    Variant& operator = (const VariantVector& rhs)
-    {
-        SetType(VAR_VARIANTVECTOR);
-        *(reinterpret_cast<VariantVector*>(&value_)) = rhs;
-        return *this;
-    }
-
+    Variant& operator = (const VariantVector& rhs);
     /// Assign from a variant map.
-    Variant& operator = (const VariantMap& rhs)
-    {
-        SetType(VAR_VARIANTMAP);
-        *(reinterpret_cast<VariantMap*>(&value_)) = rhs;
-        return *this;
-    }
+    Variant& operator = (const VariantMap& rhs);
 
     /// Assign from an integer rect.
     Variant& operator = (const IntRect& rhs)
@@ -572,7 +589,7 @@ public:
     Variant& operator = (const Matrix3& rhs)
     {
         SetType(VAR_MATRIX3);
-        *(reinterpret_cast<Matrix3*>(value_.ptr_)) = rhs;
+        *(reinterpret_cast<Matrix3*>(&value_)) = rhs;
         return *this;
     }
     
@@ -580,7 +597,7 @@ public:
     Variant& operator = (const Matrix3x4& rhs)
     {
         SetType(VAR_MATRIX3X4);
-        *(reinterpret_cast<Matrix3x4*>(value_.ptr_)) = rhs;
+        *(reinterpret_cast<Matrix3x4*>(&value_)) = rhs;
         return *this;
     }
     
@@ -633,9 +650,9 @@ public:
     /// Test for equality with a resource reference list. To return true, both the type and value must match.
     bool operator == (const ResourceRefList& rhs) const { return type_ == VAR_RESOURCEREFLIST ? *(reinterpret_cast<const ResourceRefList*>(&value_)) == rhs : false; }
     /// Test for equality with a variant vector. To return true, both the type and value must match.
-    bool operator == (const VariantVector& rhs) const { return type_ == VAR_VARIANTVECTOR ? *(reinterpret_cast<const VariantVector*>(&value_)) == rhs : false; }
+    bool operator == (const VariantVector& rhs) const { return type_ == VAR_VARIANTVECTOR ? GetVariantVector() == rhs : false; }
     /// Test for equality with a variant map. To return true, both the type and value must match.
-    bool operator == (const VariantMap& rhs) const { return type_ == VAR_VARIANTMAP ? *(reinterpret_cast<const VariantMap*>(&value_)) == rhs : false; }
+    bool operator == (const VariantMap& rhs) const { return type_ == VAR_VARIANTMAP ? GetVariantMap() == rhs : false; }
     /// Test for equality with an integer rect. To return true, both the type and value must match.
     bool operator == (const IntRect& rhs) const { return type_ == VAR_INTRECT ? *(reinterpret_cast<const IntRect*>(&value_)) == rhs : false; }
     /// Test for equality with an IntVector2. To return true, both the type and value must match.
@@ -655,9 +672,9 @@ public:
     }
     
     /// Test for equality with a Matrix3. To return true, both the type and value must match.
-    bool operator == (const Matrix3& rhs) const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(value_.ptr_)) == rhs : false; }
+    bool operator == (const Matrix3& rhs) const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(&value_)) == rhs : false; }
     /// Test for equality with a Matrix3x4. To return true, both the type and value must match.
-    bool operator == (const Matrix3x4& rhs) const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(value_.ptr_)) == rhs : false; }
+    bool operator == (const Matrix3x4& rhs) const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(&value_)) == rhs : false; }
     /// Test for equality with a Matrix4. To return true, both the type and value must match.
     bool operator == (const Matrix4& rhs) const { return type_ == VAR_MATRIX4 ? *(reinterpret_cast<const Matrix4*>(value_.ptr_)) == rhs : false; }
     
@@ -760,9 +777,9 @@ public:
     /// Return a resource reference list or empty on type mismatch.
     const ResourceRefList& GetResourceRefList() const { return type_ == VAR_RESOURCEREFLIST ? *reinterpret_cast<const ResourceRefList*>(&value_) : emptyResourceRefList; }
     /// Return a variant vector or empty on type mismatch.
-    const VariantVector& GetVariantVector() const { return type_ == VAR_VARIANTVECTOR ? *reinterpret_cast<const VariantVector*>(&value_) : emptyVariantVector; }
+    const VariantVector& GetVariantVector() const { return type_ == VAR_VARIANTVECTOR && value_.ptr_ ? static_cast<const VariantSharedValue<VariantVector>*>(value_.ptr_)->value_ : emptyVariantVector; }
     /// Return a variant map or empty on type mismatch.
-    const VariantMap& GetVariantMap() const { return type_ == VAR_VARIANTMAP ? *reinterpret_cast<const VariantMap*>(&value_) : emptyVariantMap; }
+    const VariantMap& GetVariantMap() const { return type_ == VAR_VARIANTMAP && value_.ptr_ ? static_cast<const VariantSharedValue<VariantMap>*>(value_.ptr_)->value_ : emptyVariantMap; }
     /// Return an integer rect or empty on type mismatch.
     const IntRect& GetIntRect() const { return type_ == VAR_INTRECT ? *reinterpret_cast<const IntRect*>(&value_) : IntRect::ZERO; }
     /// Return an IntVector2 or empty on type mismatch.
@@ -770,9 +787,9 @@ public:
     /// Return a RefCounted pointer or null on type mismatch. Will return null if holding a void pointer, as it can not be safely verified that the object is a RefCounted.
     RefCounted* GetPtr() const { return type_ == VAR_PTR ? *reinterpret_cast<const WeakPtr<RefCounted>*>(&value_) : (RefCounted*)0; }
     /// Return a Matrix3 or identity on type mismatch.
-    const Matrix3& GetMatrix3() const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(value_.ptr_)) : Matrix3::IDENTITY; }
+    const Matrix3& GetMatrix3() const { return type_ == VAR_MATRIX3 ? *(reinterpret_cast<const Matrix3*>(&value_)) : Matrix3::IDENTITY; }
     /// Return a Matrix3x4 or identity on type mismatch.
-    const Matrix3x4& GetMatrix3x4() const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(value_.ptr_)) : Matrix3x4::IDENTITY; }
+    const Matrix3x4& GetMatrix3x4() const { return type_ == VAR_MATRIX3X4 ? *(reinterpret_cast<const Matrix3x4*>(&value_)) : Matrix3x4::IDENTITY; }
     /// Return a Matrix4 or identity on type mismatch.
     const Matrix4& GetMatrix4() const { return type_ == VAR_MATRIX4 ? *(reinterpret_cast<const Matrix4*>(value_.ptr_)) : Matrix4::IDENTITY; }
     /// Return value's type.
@@ -790,10 +807,10 @@ public:
     
     /// Return a pointer to a modifiable buffer or null on type mismatch.
     PODVector<unsigned char>* GetBufferPtr() { return type_ == VAR_BUFFER ? reinterpret_cast<PODVector<unsigned char>*>(&value_) : 0; }
-    /// Return a pointer to a modifiable variant vector or null on type mismatch.
-    VariantVector* GetVariantVectorPtr() { return type_ == VAR_VARIANTVECTOR ? reinterpret_cast<VariantVector*>(&value_) : 0; }
-    /// Return a pointer to a modifiable variant map or null on type mismatch.
-    VariantMap* GetVariantMapPtr() { return type_ == VAR_VARIANTMAP ? reinterpret_cast<VariantMap*>(&value_) : 0; }
+    /// Return a pointer to a modifiable variant vector or null on type mismatch. Copies the vector first if it is shared with other variants.
+    VariantVector* GetVariantVectorPtr();
+    /// Return a pointer to a modifiable variant map or null on type mismatch. Copies the map first if it is shared with other variants.
+    VariantMap* GetVariantMapPtr();
 
     /// Return name for variant type.
     static String GetTypeName(VariantType type);
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "../Container/LinearAllocator.h"
 #include "../Core/CoreEvents.h"
 #include "../IO/Log.h"
 #include "../Core/ProcessUtils.h"
@@ -48,7 +49,9 @@ public:
     {
         // Init FPU state first
         InitFPU();
+        LinearAllocator::SetThreadAllocator(&allocator_);
         owner_->ProcessItems(index_);
+        LinearAllocator::SetThreadAllocator(0);
     }
     
     /// Return thread index.
@@ -59,8 +62,53 @@ private:
     WorkQueue* owner_;
     /// Thread index.
     unsigned index_;
+    /// Allocator for temporaries of the work items.
+    LinearAllocator allocator_;
 };
 
+/// Thread-safe memory pool for work items.
+class WorkItemPool
+{
+public:
+    /// Construct.
+    WorkItemPool() :
+        pool_(ConcurrentAllocatorInitialize(sizeof(WorkItem)))
+    {
+    }
+    
+    /// Destruct.
+    ~WorkItemPool()
+    {
+        ConcurrentAllocatorUninitialize(pool_);
+    }
+    
+    /// Allocator pool.
+    ConcurrentAllocatorPool* pool_;
+};
+
+static WorkItemPool workItemPool;
+
+void* WorkItem::Allocate(size_t size)
+{
+    if (size <= sizeof(WorkItem))
+        return ConcurrentAllocatorReserve(workItemPool.pool_);
+    else
+        return new unsigned char[size];
+}
+
+void WorkItem::Free(void* ptr, size_t size)
+{
+    if (size <= sizeof(WorkItem))
+        ConcurrentAllocatorFree(workItemPool.pool_, ptr);
+    else
+        delete[] static_cast<unsigned char*>(ptr);
+}
+
+AllocatorStats WorkItem::GetAllocatorStats()
+{
+    return ConcurrentAllocatorGetStats(workItemPool.pool_);
+}
+
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
     shutDown_(false),
@@ -314,6 +362,11 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
                 queueMutex_.Release();
                 item->workFunction_(item, threadIndex);
                 item->completed_ = true;
+                
+                // Release the temporaries of the work item
+                LinearAllocator* allocator = LinearAllocator::GetThreadAllocator();
+                if (allocator)
+                    allocator->Reset();
             }
             else
             {
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/ConcurrentAllocator.h"
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
@@ -66,8 +67,27 @@ public:
     bool sendEvent_;
     /// Completed flag.
     volatile bool completed_;
+    
+    /// Allocate memory for a work item. Thread-safe.
+    static void* operator new(size_t size) { return Allocate(size); }
+    /// Free memory of a work item. Thread-safe.
+    static void operator delete(void* ptr, size_t size) { Free(ptr, size); }
+#if defined(_MSC_VER) && defined(_DEBUG)
+    /// Allocate memory for a work item when the debug allocation macro is in use.
+    static void* operator new(size_t size, int, const char*, int) { return Allocate(size); }
+    /// Free memory of a work item if its constructor throws when the debug allocation macro is in use.
+    static void operator delete(void* ptr, int, const char*, int) { Free(ptr, sizeof(WorkItem)); }
+#endif
+    
+    /// Return statistics of the work item memory pool.
+    static AllocatorStats GetAllocatorStats();
 
 private:
+    /// Allocate memory from the thread-safe pool, or from the heap for larger subclasses.
+    static void* Allocate(size_t size);
+    /// Free memory to the thread-safe pool or the heap.
+    static void Free(void* ptr, size_t size);
+    
     bool pooled_;
 };
 
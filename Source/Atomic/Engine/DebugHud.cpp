@@ -132,6 +132,10 @@ void DebugHud::Update()
             renderer->GetNumShadowMaps(true),
             renderer->GetNumOccluders(true));
 
+        const LinearAllocator& frameAllocator = GetSubsystem<Engine>()->GetFrameAllocator();
+        stats.AppendWithFormat("\nFrame allocations %u (%u KB)", frameAllocator.GetLastNumAllocations(),
+            frameAllocator.GetLastAllocatedBytes() / 1024);
+
         if (!appStats_.Empty())
         {
             stats.Append("\n");
@@ -115,6 +115,9 @@ Engine::Engine(Context* context) :
     // Register self as a subsystem
     context_->RegisterSubsystem(this);
 
+    // Let the main thread's temporaries allocate from the frame allocator
+    LinearAllocator::SetThreadAllocator(&frameAllocator_);
+
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
@@ -394,6 +397,8 @@ bool Engine::Initialize(const VariantMap& parameters)
                 GetParameter(parameters, "SoundStereo", true).GetBool(),
                 GetParameter(parameters, "SoundInterpolation", true).GetBool()
             );
+            GetSubsystem<Audio>()->SetMaxVoices(GetParameter(parameters, "SoundVoices", 0).GetInt());
+            GetSubsystem<Audio>()->SetStreamLookahead(GetParameter(parameters, "SoundStreamLookahead", 250).GetInt());
         }
     }
 
@@ -445,6 +450,12 @@ void Engine::RunFrame()
 
     time->BeginFrame(timeStep_);
 
+    // Release the temporaries of the previous frame
+    frameAllocator_.Reset();
+
+    // Send the events posted from other threads since the last frame
+    context_->SendPostedEvents();
+
     // If pause when minimized -mode is in use, stop updates and audio as necessary
     if (pauseMinimized_ && input->IsMinimized())
     {
@@ -656,20 +667,16 @@ void Engine::Update()
     PROFILE(Update);
 
     // Logic update event
-    using namespace Update;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    SendTypedEvent(UpdateEvent(timeStep_));
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    SendTypedEvent(PostUpdateEvent(timeStep_));
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    SendTypedEvent(RenderUpdateEvent(timeStep_));
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    SendTypedEvent(PostRenderUpdateEvent(timeStep_));
 }
 
 void Engine::Render()
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/LinearAllocator.h"
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 
@@ -93,6 +94,8 @@ public:
     bool IsExiting() const { return exiting_; }
     /// Return whether the engine has been created in headless mode.
     bool IsHeadless() const { return headless_; }
+    /// Return the main thread's frame allocator, which is reset at the start of each frame.
+    LinearAllocator& GetFrameAllocator() { return frameAllocator_; }
     
     /// Send frame update events.
     void Update();
@@ -116,6 +119,8 @@ private:
     
     /// Frame update timer.
     HiresTimer frameTimer_;
+    /// Allocator for temporaries of the main thread that do not outlive the frame.
+    LinearAllocator frameAllocator_;
     /// Previous timesteps for smoothing.
     PODVector<float> lastTimeSteps_;
     /// Next frame timestep in seconds.
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "../Container/LinearAllocator.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
@@ -43,28 +44,29 @@
 namespace Atomic
 {
 
-inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
+typedef PODVector<KeyIndex, ThreadBufferAllocator> KeyIndexVector;
+
+/// Fill sort keys and indices from the batch state keys.
+static void SetStateKeys(KeyIndexVector& items, Batch* const* batches)
 {
-    if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
-    else
-        return lhs->distance_ < rhs->distance_;
+    for (unsigned i = 0; i < items.Size(); ++i)
+        items[i].key_ = batches[items[i].index_]->sortKey_;
 }
 
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+/// Fill sort keys from the batch distances, optionally for descending order.
+static void SetDistanceKeys(KeyIndexVector& items, Batch* const* batches, bool descending)
 {
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned mask = descending ? 0xffffffff : 0;
+    for (unsigned i = 0; i < items.Size(); ++i)
+        items[i].key_ = FloatSortKey(batches[items[i].index_]->distance_) ^ mask;
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+/// Reorder batch pointers to the order of sorted indices.
+static void ReorderBatches(Batch** batches, const KeyIndexVector& items)
 {
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    PODVector<Batch*, ThreadBufferAllocator> original(batches, items.Size());
+    for (unsigned i = 0; i < items.Size(); ++i)
+        batches[i] = original[items[i].index_];
 }
 
 inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
@@ -688,12 +690,28 @@ void BatchQueue::Clear(int maxSortedInstances)
 
 void BatchQueue::SortBackToFront()
 {
-    sortedBatches_.Resize(batches_.Size());
+    unsigned numBatches = batches_.Size();
+    sortedBatches_.Resize(numBatches);
     
-    for (unsigned i = 0; i < batches_.Size(); ++i)
+    // Sort by distance descending, then by state. As radix sort is stable, sort by the secondary key first
+    KeyIndexVector items(numBatches);
+    KeyIndexVector temp(numBatches);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
         sortedBatches_[i] = &batches_[i];
+        items[i].index_ = i;
+    }
     
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    if (numBatches)
+    {
+        SetStateKeys(items, &sortedBatches_[0]);
+        RadixSort(&items[0], &temp[0], numBatches);
+        SetDistanceKeys(items, &sortedBatches_[0], true);
+        RadixSort(&items[0], &temp[0], numBatches);
+        
+        for (unsigned i = 0; i < numBatches; ++i)
+            sortedBatches_[i] = &batches_[items[i].index_];
+    }
     
     // Do not actually sort batch groups, just list them
     sortedBatchGroups_.Resize(batchGroups_.Size());
@@ -741,21 +759,38 @@ void BatchQueue::SortFrontToBack()
 
 void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
 {
+    unsigned numBatches = batches.Size();
+    if (!numBatches)
+        return;
+    
+    // Sort key and index pairs instead of the batch pointers. As radix sort is stable, sorting by the secondary key first
+    // and then by the primary key orders by both
+    KeyIndexVector items(numBatches);
+    KeyIndexVector temp(numBatches);
+    for (unsigned i = 0; i < numBatches; ++i)
+        items[i].index_ = i;
+    
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
     #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    SetDistanceKeys(items, &batches[0], false);
+    RadixSort(&items[0], &temp[0], numBatches);
+    SetStateKeys(items, &batches[0]);
+    RadixSort(&items[0], &temp[0], numBatches);
     #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    SetStateKeys(items, &batches[0]);
+    RadixSort(&items[0], &temp[0], numBatches);
+    SetDistanceKeys(items, &batches[0], false);
+    RadixSort(&items[0], &temp[0], numBatches);
     
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
     unsigned short freeGeometryID = 0;
     
-    for (PODVector<Batch*>::Iterator i = batches.Begin(); i != batches.End(); ++i)
+    for (unsigned i = 0; i < numBatches; ++i)
     {
-        Batch* batch = *i;
+        Batch* batch = batches[items[i].index_];
         
         unsigned shaderID = (batch->sortKey_ >> 32);
         HashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
@@ -767,7 +802,7 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
             ++freeShaderID;
         }
         
-        unsigned short materialID = (unsigned short)(batch->sortKey_ & 0xffff0000);
+        unsigned short materialID = (unsigned short)(batch->sortKey_ >> 16);
         HashMap<unsigned short, unsigned short>::ConstIterator k = materialRemapping_.Find(materialID);
         if (k != materialRemapping_.End())
             materialID = k->second_;
@@ -787,16 +822,20 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
             ++freeGeometryID;
         }
         
-        batch->sortKey_ = (((unsigned long long)shaderID) << 32) || (((unsigned long long)materialID) << 16) | geometryID;
+        batch->sortKey_ = (((unsigned long long)shaderID) << 32) | (((unsigned long long)materialID) << 16) | geometryID;
     }
     
     shaderRemapping_.Clear();
     materialRemapping_.Clear();
     geometryRemapping_.Clear();
     
-    // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    // Finally sort again with the rewritten ID's. The items are already in distance order, which the stable sort keeps
+    // for equal states
+    SetStateKeys(items, &batches[0]);
+    RadixSort(&items[0], &temp[0], numBatches);
     #endif
+    
+    ReorderBatches(&batches[0], items);
 }
 
 void BatchQueue::SetTransforms(void* lockedData, unsigned& freeIndex)
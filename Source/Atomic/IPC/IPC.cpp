@@ -108,31 +108,12 @@ void IPC::HandleUpdate(StringHash eventType, VariantMap& eventData)
     {
         brokers_.Remove(SharedPtr<IPCBroker>(remove[i]));
     }
-
-    eventMutex_.Acquire();
-
-    for (List<QueuedEvent>::Iterator itr = queuedEvents_.Begin(); itr != queuedEvents_.End(); itr++)
-    {
-        StringHash qeventType =  (*itr).eventType_;
-        VariantMap& qeventData =  (*itr).eventData_;
-        SendEvent(qeventType, qeventData);
-    }
-
-    queuedEvents_.Clear();
-
-    eventMutex_.Release();
 }
 
 void IPC::QueueEvent(StringHash eventType, VariantMap& eventData)
 {
-    eventMutex_.Acquire();
-
-    QueuedEvent event;
-    event.eventType_ = eventType;
-    event.eventData_ = eventData;
-    queuedEvents_.Push(event);
-
-    eventMutex_.Release();
+    // sent from the main thread at the beginning of the next frame
+    PostEvent(eventType, eventData);
 }
 
 
@@ -1,8 +1,6 @@
 #pragma once
 
 #include "../Core/Object.h"
-#include "../Core/Mutex.h"
-#include "../Container/List.h"
 
 #include "IPCTypes.h"
 
@@ -12,12 +10,6 @@ namespace Atomic
 class IPCBroker;
 class IPCWorker;
 
-struct QueuedEvent
-{
-    StringHash eventType_;
-    VariantMap eventData_;
-};
-
 class IPC : public Object
 {
     OBJECT(IPC);
@@ -44,13 +36,9 @@ public:
 
 private:
 
-    // processes queued events
+    // updates the worker and brokers
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
 
-    mutable Mutex eventMutex_;
-
-    List<QueuedEvent> queuedEvents_;
-
     Vector<SharedPtr<IPCBroker> > brokers_;
 
     // valid on child
@@ -402,15 +402,19 @@ void CrowdAgent::OnCrowdAgentReposition(const Vector3& newPos, const Vector3& ne
 {
     if (node_)
     {
-        // Notify parent node of the reposition
-        VariantMap& map = GetContext()->GetEventDataMap();
-        map[CrowdAgentReposition::P_NODE] = GetNode();
-        map[CrowdAgentReposition::P_CROWD_AGENT] = this;
-        map[CrowdAgentReposition::P_POSITION] = newPos;
-        map[CrowdAgentReposition::P_VELOCITY] = GetActualVelocity();
-        SendEvent(E_CROWD_AGENT_REPOSITION, map);
-        
-        if (updateNodePosition_)
+        // Notify parent node of the reposition, unless the crowd manager only writes back the positions
+        if (!crowdManager_ || crowdManager_->GetRepositionEvents())
+        {
+            VariantMap& map = GetContext()->GetEventDataMap();
+            map[CrowdAgentReposition::P_NODE] = GetNode();
+            map[CrowdAgentReposition::P_CROWD_AGENT] = this;
+            map[CrowdAgentReposition::P_POSITION] = newPos;
+            map[CrowdAgentReposition::P_VELOCITY] = GetActualVelocity();
+            SendEvent(E_CROWD_AGENT_REPOSITION, map);
+        }
+
+        // Agents standing still do not need their node dirtied
+        if (updateNodePosition_ && node_ && newPos != node_->GetPosition())
         {
             ignoreTransformChanges_ = true;
             node_->SetPosition(newPos);
@@ -493,6 +497,14 @@ void CrowdAgent::OnMarkedDirty(Node* node)
 {
     if (inCrowd_ && crowdManager_ && !ignoreTransformChanges_ && IsEnabledEffective())
     {
+        // If the scene is being updated in worker threads, defer until the main thread
+        Scene* scene = GetScene();
+        if (scene && scene->IsThreadedUpdate())
+        {
+            scene->DelayedMarkedDirty(this);
+            return;
+        }
+
         dtCrowdAgent* agt = crowdManager_->GetCrowd()->getEditableAgent(agentCrowdId_);
         if (agt)
         {
@@ -22,6 +22,7 @@
 
 #include "../Scene/Component.h"
 #include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
 #include "../Navigation/CrowdAgent.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Navigation/DetourCrowdManager.h"
@@ -50,10 +51,64 @@ namespace Atomic
 extern const char* NAVIGATION_CATEGORY;
 
 static const unsigned DEFAULT_MAX_AGENTS = 512;
+/// Minimum number of agents per work item when updating the crowd in the work queue's threads.
+static const int MIN_AGENTS_PER_WORK_ITEM = 64;
+
+/// Range of a crowd update phase to process in a work item.
+struct CrowdRangeTask
+{
+    /// Phase function.
+    dtCrowdRangeFunc* func_;
+    /// Phase context.
+    void* context_;
+    /// First agent index.
+    int begin_;
+    /// End agent index.
+    int end_;
+};
+
+static void CrowdRangeWork(const WorkItem* item, unsigned threadIndex)
+{
+    const CrowdRangeTask* task = reinterpret_cast<const CrowdRangeTask*>(item->start_);
+    task->func_(task->context_, task->begin_, task->end_, (int)threadIndex);
+}
+
+/// Run a crowd update phase in the work queue's threads and the main thread.
+static void CrowdParallelFor(void* userData, dtCrowdRangeFunc* func, void* context, const int count)
+{
+    WorkQueue* queue = static_cast<WorkQueue*>(userData);
+    int numItems = Min((int)queue->GetNumThreads() + 1, (count + MIN_AGENTS_PER_WORK_ITEM - 1) / MIN_AGENTS_PER_WORK_ITEM);
+    if (numItems <= 1)
+    {
+        func(context, 0, count, 0);
+        return;
+    }
+
+    PODVector<CrowdRangeTask> tasks(numItems);
+    int agentsPerItem = (count + numItems - 1) / numItems;
+
+    for (int i = 0; i < numItems; ++i)
+    {
+        CrowdRangeTask& task = tasks[i];
+        task.func_ = func;
+        task.context_ = context;
+        task.begin_ = i * agentsPerItem;
+        task.end_ = Min(task.begin_ + agentsPerItem, count);
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = CrowdRangeWork;
+        item->start_ = &task;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
 
 DetourCrowdManager::DetourCrowdManager(Context* context) :
     Component(context),
     maxAgents_(DEFAULT_MAX_AGENTS),
+    repositionEvents_(true),
     crowd_(0),
     navigationMesh_(0),
     agentDebug_(0)
@@ -74,6 +129,7 @@ void DetourCrowdManager::RegisterObject(Context* context)
     context->RegisterFactory<DetourCrowdManager>(NAVIGATION_CATEGORY);
     
     ACCESSOR_ATTRIBUTE("Max Agents", GetMaxAgents, SetMaxAgents, unsigned, DEFAULT_MAX_AGENTS, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Reposition Events", GetRepositionEvents, SetRepositionEvents, bool, true, AM_DEFAULT);
 }
 
 void DetourCrowdManager::SetNavigationMesh(NavigationMesh* navMesh)
@@ -117,6 +173,12 @@ void DetourCrowdManager::SetMaxAgents(unsigned agentCt)
     MarkNetworkUpdate();
 }
 
+void DetourCrowdManager::SetRepositionEvents(bool enable)
+{
+    repositionEvents_ = enable;
+    MarkNetworkUpdate();
+}
+
 NavigationMesh* DetourCrowdManager::GetNavigationMesh()
 {
     return navigationMesh_.Get();
@@ -223,6 +285,14 @@ bool DetourCrowdManager::CreateCrowd()
     params.adaptiveDepth = 3;
     crowd_->setObstacleAvoidanceParams(3, &params);
 
+    // Run the per-agent phases of the crowd update in the worker threads if there are any
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads())
+    {
+        if (!crowd_->setParallelFor(CrowdParallelFor, queue, queue->GetNumThreads() + 1))
+            LOGWARNING("Could not allocate per-thread queries for DetourCrowd, updating serially");
+    }
+
     return true;
 }
 
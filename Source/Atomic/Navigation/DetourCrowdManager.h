@@ -76,6 +76,10 @@ public:
     float GetAreaCost(unsigned filterTypeID, unsigned areaID) const;
     /// Get the maximum number of agents.
     unsigned GetMaxAgents() const { return maxAgents_; }
+    /// Set whether agents send E_CROWD_AGENT_REPOSITION every update. When disabled, node positions are written back without events. Default true.
+    void SetRepositionEvents(bool enable);
+    /// Return whether agents send E_CROWD_AGENT_REPOSITION every update.
+    bool GetRepositionEvents() const { return repositionEvents_; }
     /// Get the current number of active agents.
     unsigned GetAgentCount() const;
 
@@ -127,6 +131,8 @@ private:
     WeakPtr<NavigationMesh> navigationMesh_;
     /// Max agents for the crowd.
     unsigned maxAgents_;    
+    /// Reposition events flag.
+    bool repositionEvents_;
     /// Internal debug information.
     dtCrowdAgentDebugInfo* agentDebug_;
     /// Container for fetching agents from DetourCrowd during update.
@@ -46,7 +46,7 @@
 #include <Recast/include/Recast.h>
 #include <Recast/include/RecastAlloc.h>
 
-//DebugNew is deliberately not used because the macro 'free' conflicts DetourTileCache's LinearAllocator interface
+//DebugNew is deliberately not used because the macro 'free' conflicts DetourTileCache's TileCacheLinearAllocator interface
 //#include "../DebugNew.h"
 
 #define TILECACHE_MAXLAYERS 128
@@ -102,6 +102,9 @@ struct MeshProcess : public dtTileCacheMeshProcess
 
     virtual void process(struct dtNavMeshCreateParams* params, unsigned char* polyAreas, unsigned short* polyFlags)
     {
+        // The tile cache replaces the navigation mesh tile after processing
+        owner_->MarkPathHierarchyDirty();
+
         // Update poly flags from areas.
         // \todo Assignment of flags from areas?
         for (int i = 0; i < params->polyCount; ++i)
@@ -158,19 +161,19 @@ struct MeshProcess : public dtTileCacheMeshProcess
 
 
 // From the Detour/Recast Sample_TempObstacles.cpp
-struct LinearAllocator : public dtTileCacheAlloc
+struct TileCacheLinearAllocator : public dtTileCacheAlloc
 {
     unsigned char* buffer;
     int capacity;
     int top;
     int high;
 
-    LinearAllocator(const int cap) : buffer(0), capacity(0), top(0), high(0)
+    TileCacheLinearAllocator(const int cap) : buffer(0), capacity(0), top(0), high(0)
     {
         resize(cap);
     }
 
-    ~LinearAllocator()
+    ~TileCacheLinearAllocator()
     {
         dtFree(buffer);
     }
@@ -214,7 +217,7 @@ DynamicNavigationMesh::DynamicNavigationMesh(Context* context) :
     //64 is the largest tile-size that DetourTileCache will tolerate without silently failing
     tileSize_ = 64; 
     partitionType_ = NAVMESH_PARTITION_MONOTONE;
-    allocator_ = new LinearAllocator(32000); //32kb to start
+    allocator_ = new TileCacheLinearAllocator(32000); //32kb to start
     compressor_ = new TileCompressor();
     meshProcessor_ = new MeshProcess(this);
 }
@@ -817,6 +820,29 @@ void DynamicNavigationMesh::ReleaseNavigationMesh()
     ReleaseTileCache();
 }
 
+void DynamicNavigationMesh::RebuildDirtyTiles()
+{
+    UpdateDirtyNavigables();
+
+    if (dirtyTiles_.Empty() || !navMesh_ || !tileCache_)
+        return;
+
+    // Rebuild the rectangle of tiles that covers all dirty tiles. Use the tile centers to not touch the neighbours
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+    BoundingBox localSpaceBox;
+    for (HashSet<Pair<int, int> >::ConstIterator i = dirtyTiles_.Begin(); i != dirtyTiles_.End(); ++i)
+    {
+        localSpaceBox.Merge(Vector3(
+            boundingBox_.min_.x_ + tileEdgeLength * ((float)i->first_ + 0.5f),
+            boundingBox_.min_.y_,
+            boundingBox_.min_.z_ + tileEdgeLength * ((float)i->second_ + 0.5f)
+        ));
+    }
+    dirtyTiles_.Clear();
+
+    Build(localSpaceBox.Transformed(node_->GetWorldTransform()));
+}
+
 void DynamicNavigationMesh::ReleaseTileCache()
 {
     dtFreeTileCache(tileCache_);
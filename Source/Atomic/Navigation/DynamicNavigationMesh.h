@@ -86,6 +86,8 @@ protected:
     PODVector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
     virtual void ReleaseNavigationMesh();
+    /// Rebuild the dirty tiles through the tile cache. Done synchronously in the main thread.
+    virtual void RebuildDirtyTiles();
 
 private:
     /// Free the tile cache.
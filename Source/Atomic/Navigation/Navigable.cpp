@@ -23,6 +23,8 @@
 #include "Precompiled.h"
 #include "../Core/Context.h"
 #include "../Navigation/Navigable.h"
+#include "../Navigation/NavigationMesh.h"
+#include "../Scene/Scene.h"
 
 #include "../DebugNew.h"
 
@@ -54,4 +56,33 @@ void Navigable::SetRecursive(bool enable)
     recursive_ = enable;
 }
 
+void Navigable::OnNodeSet(Node* node)
+{
+    if (node)
+        node->AddListener(this);
+}
+
+void Navigable::OnMarkedDirty(Node* node)
+{
+    // Dirty tile rebuilding is off by default, so avoid searching the parent nodes when no navigation mesh uses it
+    if (!NavigationMesh::IsDirtyTileRebuildInUse())
+        return;
+
+    // If the scene is being updated in worker threads, defer until the main thread
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        scene->DelayedMarkedDirty(this);
+        return;
+    }
+
+    // Notify the navigation meshes this geometry belongs to, so that they can rebuild the affected tiles
+    for (Node* parent = node_; parent; parent = parent->GetParent())
+    {
+        NavigationMesh* navMesh = parent->GetDerivedComponent<NavigationMesh>();
+        if (navMesh && navMesh->GetRebuildDirtyTiles())
+            navMesh->MarkNavigableDirty(this);
+    }
+}
+
 }
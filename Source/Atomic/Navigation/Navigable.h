@@ -45,6 +45,12 @@ public:
     /// Return whether geometry is automatically collected from child nodes.
     bool IsRecursive() const { return recursive_; }
 
+protected:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Handle node transform being dirtied.
+    virtual void OnMarkedDirty(Node* node);
+
 private:
     /// Recursive flag.
     bool recursive_;
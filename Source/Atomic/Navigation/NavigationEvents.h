@@ -43,6 +43,16 @@ EVENT(E_NAVIGATION_AREA_REBUILT, NavigationAreaRebuilt)
     PARAM(P_BOUNDSMAX, BoundsMax); // Vector3
 }
 
+/// Queued path request has finished.
+EVENT(E_NAVIGATION_PATH_COMPLETED, NavigationPathCompleted)
+{
+    PARAM(P_NODE, Node); // Node pointer
+    PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    PARAM(P_REQUEST, Request); // unsigned
+    PARAM(P_SUCCESS, Success); // bool
+    PARAM(P_PATH, Path); // VariantVector of world space Vector3 points
+}
+
 /// Crowd agent has been repositioned.
 EVENT(E_CROWD_AGENT_REPOSITION, CrowdAgentReposition)
 {
@@ -24,7 +24,11 @@
 #ifdef ATOMIC_PHYSICS
 #include "../Physics/CollisionShape.h"
 #endif
+#include "../Core/Condition.h"
 #include "../Core/Context.h"
+#include "../Core/Mutex.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -41,6 +45,7 @@
 #include "../Navigation/OffMeshConnection.h"
 #include "../Core/Profiler.h"
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 #include "../Atomic3D/StaticModel.h"
 #include "../Atomic3D/TerrainPatch.h"
 #include "../IO/VectorBuffer.h"
@@ -83,6 +88,17 @@ static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
 
 static const int MAX_POLYS = 2048;
+/// Number of tiles per thread prepared at a time when building in parallel.
+static const unsigned TILES_PER_THREAD = 4;
+/// Default path search time budget per thread and frame in milliseconds.
+static const float DEFAULT_PATH_BUDGET = 1.0f;
+/// A* iterations between time budget checks.
+static const int PATH_ITERATIONS_PER_SLICE = 32;
+/// Maximum number of tile layers at one tile position.
+static const int MAX_TILE_LAYERS = 32;
+
+/// Number of navigation meshes that rebuild dirty tiles. Lets Navigable components skip searching for them when none do.
+static unsigned numDirtyTileRebuildMeshes = 0;
 
 
 /// Temporary data for finding a path.
@@ -100,12 +116,898 @@ struct FindPathData
     unsigned char pathAreras_[MAX_POLYS];
 };
 
+/// Build of one navigation mesh tile. Holds everything the Recast pipeline needs, so that it can run without accessing the scene or the navigation mesh component.
+struct NavTileBuild
+{
+    /// Construct.
+    NavTileBuild(int x, int z) :
+        x_(x),
+        z_(z),
+        agentHeight_(0.0f),
+        agentRadius_(0.0f),
+        agentMaxClimb_(0.0f),
+        partitionType_(NAVMESH_PARTITION_WATERSHED),
+        navData_(0),
+        navDataSize_(0),
+        success_(false)
+    {
+        memset(&config_, 0, sizeof config_);
+    }
+
+    /// Destruct. Free the tile data if it was not added to the navigation mesh.
+    ~NavTileBuild()
+    {
+        dtFree(navData_);
+    }
+
+    /// Tile X index.
+    int x_;
+    /// Tile Z index.
+    int z_;
+    /// Tile bounding box.
+    BoundingBox tileBoundingBox_;
+    /// Recast configuration.
+    rcConfig config_;
+    /// Navigation agent height.
+    float agentHeight_;
+    /// Navigation agent radius.
+    float agentRadius_;
+    /// Navigation agent max vertical climb.
+    float agentMaxClimb_;
+    /// Type of the heightfield partitioning.
+    NavmeshPartitionType partitionType_;
+    /// Collected geometry and Recast build data.
+    SimpleNavBuildData build_;
+    /// Built Detour tile data.
+    unsigned char* navData_;
+    /// Built Detour tile data size.
+    int navDataSize_;
+    /// Success flag.
+    bool success_;
+    /// Work item when building in the background.
+    SharedPtr<WorkItem> item_;
+    /// Set when the build has finished in a worker thread. The work function does not access the tile afterward.
+    Condition finished_;
+};
+
+/// Run the Recast pipeline on a prepared tile build. Does not access the scene, so it is safe to call from worker threads.
+static bool BuildTileData(NavTileBuild& tile)
+{
+    SimpleNavBuildData& build = tile.build_;
+    const rcConfig& cfg = tile.config_;
+
+    if (build.vertices_.Empty() || build.indices_.Empty())
+        return true; // Nothing to do
+
+    build.heightField_ = rcAllocHeightfield();
+    if (!build.heightField_)
+    {
+        LOGERROR("Could not allocate heightfield");
+        return false;
+    }
+
+    if (!rcCreateHeightfield(build.ctx_, *build.heightField_, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs,
+        cfg.ch))
+    {
+        LOGERROR("Could not create heightfield");
+        return false;
+    }
+
+    unsigned numTriangles = build.indices_.Size() / 3;
+    SharedArrayPtr<unsigned char> triAreas(new unsigned char[numTriangles]);
+    memset(triAreas.Get(), 0, numTriangles);
+
+    rcMarkWalkableTriangles(build.ctx_, cfg.walkableSlopeAngle, &build.vertices_[0].x_, build.vertices_.Size(),
+        &build.indices_[0], numTriangles, triAreas.Get());
+    rcRasterizeTriangles(build.ctx_, &build.vertices_[0].x_, build.vertices_.Size(), &build.indices_[0],
+        triAreas.Get(), numTriangles, *build.heightField_, cfg.walkableClimb);
+    rcFilterLowHangingWalkableObstacles(build.ctx_, cfg.walkableClimb, *build.heightField_);
+    
+    rcFilterWalkableLowHeightSpans(build.ctx_, cfg.walkableHeight, *build.heightField_);
+    rcFilterLedgeSpans(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_);
+
+    build.compactHeightField_ = rcAllocCompactHeightfield();
+    if (!build.compactHeightField_)
+    {
+        LOGERROR("Could not allocate create compact heightfield");
+        return false;
+    }
+    if (!rcBuildCompactHeightfield(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_,
+        *build.compactHeightField_))
+    {
+        LOGERROR("Could not build compact heightfield");
+        return false;
+    }
+    if (!rcErodeWalkableArea(build.ctx_, cfg.walkableRadius, *build.compactHeightField_))
+    {
+        LOGERROR("Could not erode compact heightfield");
+        return false;
+    }
+
+    // Mark area volumes
+    for (unsigned i = 0; i < build.navAreas_.Size(); ++i)
+        rcMarkBoxArea(build.ctx_, &build.navAreas_[i].bounds_.min_.x_, &build.navAreas_[i].bounds_.max_.x_, build.navAreas_[i].areaID_, *build.compactHeightField_);
+
+    if (tile.partitionType_ == NAVMESH_PARTITION_WATERSHED)
+    {
+        if (!rcBuildDistanceField(build.ctx_, *build.compactHeightField_))
+        {
+            LOGERROR("Could not build distance field");
+            return false;
+        }
+        if (!rcBuildRegions(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea,
+            cfg.mergeRegionArea))
+        {
+            LOGERROR("Could not build regions");
+            return false;
+        }
+    }
+    else
+    {
+        if (!rcBuildRegionsMonotone(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+        {
+            LOGERROR("Could not build monotone regions");
+            return false;
+        }
+    }
+
+    build.contourSet_ = rcAllocContourSet();
+    if (!build.contourSet_)
+    {
+        LOGERROR("Could not allocate contour set");
+        return false;
+    }
+    if (!rcBuildContours(build.ctx_, *build.compactHeightField_, cfg.maxSimplificationError, cfg.maxEdgeLen,
+        *build.contourSet_))
+    {
+        LOGERROR("Could not create contours");
+        return false;
+    }
+
+    build.polyMesh_ = rcAllocPolyMesh();
+    if (!build.polyMesh_)
+    {
+        LOGERROR("Could not allocate poly mesh");
+        return false;
+    }
+    if (!rcBuildPolyMesh(build.ctx_, *build.contourSet_, cfg.maxVertsPerPoly, *build.polyMesh_))
+    {
+        LOGERROR("Could not triangulate contours");
+        return false;
+    }
+
+    build.polyMeshDetail_ = rcAllocPolyMeshDetail();
+    if (!build.polyMeshDetail_)
+    {
+        LOGERROR("Could not allocate detail mesh");
+        return false;
+    }
+    if (!rcBuildPolyMeshDetail(build.ctx_, *build.polyMesh_, *build.compactHeightField_, cfg.detailSampleDist,
+        cfg.detailSampleMaxError, *build.polyMeshDetail_))
+    {
+        LOGERROR("Could not build detail mesh");
+        return false;
+    }
+
+    // Set polygon flags
+    /// \todo Assignment of flags from navigation areas?
+    for (int i = 0; i < build.polyMesh_->npolys; ++i)
+    {
+        if (build.polyMesh_->areas[i] != RC_NULL_AREA)
+            build.polyMesh_->flags[i] = 0x1;
+    }
+
+    dtNavMeshCreateParams params;
+    memset(&params, 0, sizeof params);
+    params.verts = build.polyMesh_->verts;
+    params.vertCount = build.polyMesh_->nverts;
+    params.polys = build.polyMesh_->polys;
+    params.polyAreas = build.polyMesh_->areas;
+    params.polyFlags = build.polyMesh_->flags;
+    params.polyCount = build.polyMesh_->npolys;
+    params.nvp = build.polyMesh_->nvp;
+    params.detailMeshes = build.polyMeshDetail_->meshes;
+    params.detailVerts = build.polyMeshDetail_->verts;
+    params.detailVertsCount = build.polyMeshDetail_->nverts;
+    params.detailTris = build.polyMeshDetail_->tris;
+    params.detailTriCount = build.polyMeshDetail_->ntris;
+    params.walkableHeight = tile.agentHeight_;
+    params.walkableRadius = tile.agentRadius_;
+    params.walkableClimb = tile.agentMaxClimb_;
+    params.tileX = tile.x_;
+    params.tileY = tile.z_;
+    rcVcopy(params.bmin, build.polyMesh_->bmin);
+    rcVcopy(params.bmax, build.polyMesh_->bmax);
+    params.cs = cfg.cs;
+    params.ch = cfg.ch;
+    params.buildBvTree = true;
+
+    // Add off-mesh connections if have them
+    if (build.offMeshRadii_.Size())
+    {
+        params.offMeshConCount = build.offMeshRadii_.Size();
+        params.offMeshConVerts = &build.offMeshVertices_[0].x_;
+        params.offMeshConRad = &build.offMeshRadii_[0];
+        params.offMeshConFlags = &build.offMeshFlags_[0];
+        params.offMeshConAreas = &build.offMeshAreas_[0];
+        params.offMeshConDir = &build.offMeshDir_[0];
+    }
+
+    if (!dtCreateNavMeshData(&params, &tile.navData_, &tile.navDataSize_))
+    {
+        LOGERROR("Could not build navigation mesh tile data");
+        return false;
+    }
+
+    return true;
+}
+
+static void BuildNavigationTileWork(const WorkItem* item, unsigned threadIndex)
+{
+    NavTileBuild* tile = reinterpret_cast<NavTileBuild*>(item->start_);
+    tile->success_ = BuildTileData(*tile);
+    tile->finished_.Set();
+}
+
+/// Queued path request.
+struct NavPathRequest
+{
+    /// Request ID.
+    unsigned id_;
+    /// Local space start point.
+    Vector3 start_;
+    /// Local space end point.
+    Vector3 end_;
+    /// Local space path points.
+    PODVector<Vector3> path_;
+};
+
+/// Path search between two polygons, shared by all requests between them.
+struct NavPathSearch
+{
+    /// Start polygon.
+    dtPolyRef startRef_;
+    /// End polygon.
+    dtPolyRef endRef_;
+    /// Requests served by this search.
+    Vector<NavPathRequest> requests_;
+    /// Success flag.
+    bool success_;
+};
+
+/// Path search slot with its own navigation mesh query. A sliced search can stay in a slot across frames.
+struct NavPathSlot
+{
+    /// Construct.
+    NavPathSlot() :
+        query_(dtAllocNavMeshQuery()),
+        search_(0)
+    {
+    }
+
+    /// Destruct.
+    ~NavPathSlot()
+    {
+        dtFreeNavMeshQuery(query_);
+    }
+
+    /// Navigation mesh query.
+    dtNavMeshQuery* query_;
+    /// Search in progress.
+    NavPathSearch* search_;
+    /// Searches finished during the current update.
+    PODVector<NavPathSearch*> completed_;
+    /// Polygons of the finished path.
+    dtPolyRef polys_[MAX_POLYS];
+    /// Straight path points.
+    Vector3 pathPoints_[MAX_POLYS];
+};
+
+/// Queue of path requests.
+struct NavPathQueue
+{
+    /// Construct.
+    NavPathQueue() :
+        filter_(0),
+        next_(0),
+        budget_(0),
+        numRequests_(0),
+        nextRequestId_(1)
+    {
+    }
+
+    /// Destruct.
+    ~NavPathQueue()
+    {
+        for (unsigned i = 0; i < slots_.Size(); ++i)
+            delete slots_[i];
+    }
+
+    /// Query filter.
+    const dtQueryFilter* filter_;
+    /// Searches waiting for a slot.
+    PODVector<NavPathSearch*> searches_;
+    /// Index of the next search to take from the queue.
+    unsigned next_;
+    /// Waiting and active searches by start and end polygon.
+    HashMap<Pair<dtPolyRef, dtPolyRef>, NavPathSearch*> searchMap_;
+    /// Search slots.
+    PODVector<NavPathSlot*> slots_;
+    /// Mutex for taking searches from the queue.
+    Mutex mutex_;
+    /// Time budget per slot and update in microseconds.
+    long long budget_;
+    /// Number of waiting and active requests.
+    unsigned numRequests_;
+    /// Next request ID.
+    unsigned nextRequestId_;
+};
+
+/// Finish the search in a slot and compute the straight paths of its requests.
+static void FinishPathSearch(NavPathSlot& slot, bool success)
+{
+    NavPathSearch* search = slot.search_;
+    search->success_ = false;
+
+    int numPolys = 0;
+    if (success)
+        slot.query_->finalizeSlicedFindPath(slot.polys_, &numPolys, MAX_POLYS);
+
+    if (numPolys)
+    {
+        search->success_ = true;
+
+        for (unsigned i = 0; i < search->requests_.Size(); ++i)
+        {
+            NavPathRequest& request = search->requests_[i];
+            Vector3 actualEnd = request.end_;
+
+            // If full path was not found, clamp end point to the end polygon
+            if (slot.polys_[numPolys - 1] != search->endRef_)
+                slot.query_->closestPointOnPoly(slot.polys_[numPolys - 1], &request.end_.x_, &actualEnd.x_, 0);
+
+            int numPathPoints = 0;
+            slot.query_->findStraightPath(&request.start_.x_, &actualEnd.x_, slot.polys_, numPolys,
+                &slot.pathPoints_[0].x_, 0, 0, &numPathPoints, MAX_POLYS);
+
+            request.path_.Resize(numPathPoints);
+            for (int j = 0; j < numPathPoints; ++j)
+                request.path_[j] = slot.pathPoints_[j];
+        }
+    }
+
+    slot.completed_.Push(search);
+    slot.search_ = 0;
+}
+
+/// Advance the searches of a slot until the time budget runs out or the queue is empty.
+static void UpdatePathSlot(NavPathQueue& queue, NavPathSlot& slot)
+{
+    HiresTimer timer;
+
+    while (timer.GetUSec(false) < queue.budget_)
+    {
+        if (!slot.search_)
+        {
+            {
+                MutexLock lock(queue.mutex_);
+                if (queue.next_ >= queue.searches_.Size())
+                    break;
+                slot.search_ = queue.searches_[queue.next_++];
+            }
+
+            NavPathSearch* search = slot.search_;
+            const NavPathRequest& first = search->requests_.Front();
+            if (dtStatusFailed(slot.query_->initSlicedFindPath(search->startRef_, search->endRef_, &first.start_.x_,
+                &first.end_.x_, queue.filter_)))
+            {
+                FinishPathSearch(slot, false);
+                continue;
+            }
+        }
+
+        int iterations = 0;
+        dtStatus status = slot.query_->updateSlicedFindPath(PATH_ITERATIONS_PER_SLICE, &iterations);
+        if (!dtStatusInProgress(status))
+            FinishPathSearch(slot, dtStatusSucceed(status));
+    }
+}
+
+static void UpdatePathSlotWork(const WorkItem* item, unsigned threadIndex)
+{
+    NavPathQueue* queue = reinterpret_cast<NavPathQueue*>(item->aux_);
+    NavPathSlot* slot = reinterpret_cast<NavPathSlot*>(item->start_);
+    UpdatePathSlot(*queue, *slot);
+}
+
+/// Connection from a tile region to a region of a neighbouring tile.
+struct NavClusterEdge
+{
+    /// Target cluster ID.
+    unsigned target_;
+    /// Cost from the center of the source cluster to the center of the target cluster.
+    float cost_;
+    /// Portal position on the shared edge.
+    Vector3 portal_;
+    /// Polygon on the target side of the portal.
+    dtPolyRef portalRef_;
+};
+
+/// Connected region of polygons within one tile.
+struct NavCluster
+{
+    /// Average polygon center.
+    Vector3 center_;
+    /// Connections to the neighbouring tiles.
+    PODVector<NavClusterEdge> edges_;
+};
+
+/// Regions of one tile.
+struct NavHierarchyTile
+{
+    /// Construct.
+    NavHierarchyTile() :
+        ref_(0),
+        x_(0),
+        z_(0),
+        numClusters_(0)
+    {
+    }
+
+    /// Tile reference when the regions were computed. Changes when the tile is replaced.
+    dtTileRef ref_;
+    /// Tile X position.
+    int x_;
+    /// Tile Z position.
+    int z_;
+    /// Number of regions.
+    unsigned numClusters_;
+    /// Region index of each polygon.
+    PODVector<unsigned short> polyClusters_;
+};
+
+/// Graph of connected tile regions, used to plan long paths before searching the polygons.
+struct NavPathHierarchy
+{
+    /// Construct.
+    NavPathHierarchy() :
+        dirty_(true)
+    {
+    }
+
+    /// Remove all regions.
+    void Clear()
+    {
+        tiles_.Clear();
+        clusters_.Clear();
+        dirty_ = true;
+    }
+
+    /// Return cluster ID from tile index and region index.
+    static unsigned GetClusterId(unsigned tileIndex, unsigned cluster) { return (tileIndex << 16) | cluster; }
+
+    /// Tiles by tile index.
+    Vector<NavHierarchyTile> tiles_;
+    /// Clusters by cluster ID.
+    HashMap<unsigned, NavCluster> clusters_;
+    /// Tiles may have been added, removed or replaced since the last update flag.
+    bool dirty_;
+};
+
+/// Open node of the cluster graph search.
+struct NavClusterOpenNode
+{
+    /// Estimated total cost.
+    float total_;
+    /// Cluster ID.
+    unsigned id_;
+};
+
+/// Search state of a cluster.
+struct NavClusterSearchNode
+{
+    /// Cost from the start.
+    float cost_;
+    /// Previous cluster ID.
+    unsigned parent_;
+    /// Edge index in the previous cluster.
+    unsigned edge_;
+    /// Closed flag.
+    bool closed_;
+};
+
+/// Push a node to the open heap.
+static void PushOpenNode(PODVector<NavClusterOpenNode>& heap, const NavClusterOpenNode& node)
+{
+    heap.Push(node);
+    unsigned i = heap.Size() - 1;
+    while (i > 0)
+    {
+        unsigned parent = (i - 1) / 2;
+        if (heap[parent].total_ <= heap[i].total_)
+            break;
+        Swap(heap[parent], heap[i]);
+        i = parent;
+    }
+}
+
+/// Pop the node with the lowest estimated cost from the open heap.
+static NavClusterOpenNode PopOpenNode(PODVector<NavClusterOpenNode>& heap)
+{
+    NavClusterOpenNode top = heap.Front();
+    heap.Front() = heap.Back();
+    heap.Pop();
+
+    unsigned i = 0;
+    for (;;)
+    {
+        unsigned smallest = i;
+        unsigned left = i * 2 + 1;
+        unsigned right = left + 1;
+        if (left < heap.Size() && heap[left].total_ < heap[smallest].total_)
+            smallest = left;
+        if (right < heap.Size() && heap[right].total_ < heap[smallest].total_)
+            smallest = right;
+        if (smallest == i)
+            break;
+        Swap(heap[smallest], heap[i]);
+        i = smallest;
+    }
+
+    return top;
+}
+
+/// Return the center of a polygon.
+static Vector3 GetPolyCenter(const dtMeshTile* tile, const dtPoly* poly)
+{
+    Vector3 center(Vector3::ZERO);
+    for (unsigned i = 0; i < poly->vertCount; ++i)
+        center += *reinterpret_cast<const Vector3*>(&tile->verts[poly->verts[i] * 3]);
+    return poly->vertCount ? center / (float)poly->vertCount : center;
+}
+
+/// Find the connected regions of a tile.
+static void BuildHierarchyTileClusters(NavPathHierarchy& hierarchy, const dtNavMesh* navMesh, unsigned tileIndex)
+{
+    NavHierarchyTile& hTile = hierarchy.tiles_[tileIndex];
+    for (unsigned i = 0; i < hTile.numClusters_; ++i)
+        hierarchy.clusters_.Erase(NavPathHierarchy::GetClusterId(tileIndex, i));
+    hTile.numClusters_ = 0;
+    hTile.polyClusters_.Clear();
+
+    const dtMeshTile* tile = navMesh->getTile(tileIndex);
+    hTile.ref_ = tile->header ? navMesh->getTileRef(tile) : 0;
+    if (!tile->header)
+        return;
+
+    hTile.x_ = tile->header->x;
+    hTile.z_ = tile->header->y;
+
+    const unsigned numPolys = (unsigned)tile->header->polyCount;
+    hTile.polyClusters_.Resize(numPolys);
+    for (unsigned i = 0; i < numPolys; ++i)
+        hTile.polyClusters_[i] = 0xffff;
+
+    // Flood fill the polygons connected within the tile
+    PODVector<unsigned> stack;
+    for (unsigned i = 0; i < numPolys && hTile.numClusters_ < 0xffff; ++i)
+    {
+        if (hTile.polyClusters_[i] != 0xffff)
+            continue;
+
+        unsigned short cluster = (unsigned short)hTile.numClusters_++;
+        NavCluster& clusterData = hierarchy.clusters_[NavPathHierarchy::GetClusterId(tileIndex, cluster)];
+        unsigned numClusterPolys = 0;
+
+        hTile.polyClusters_[i] = cluster;
+        stack.Push(i);
+        while (!stack.Empty())
+        {
+            unsigned polyIndex = stack.Back();
+            stack.Pop();
+
+            const dtPoly* poly = &tile->polys[polyIndex];
+            clusterData.center_ += GetPolyCenter(tile, poly);
+            ++numClusterPolys;
+
+            for (unsigned k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+            {
+                dtPolyRef ref = tile->links[k].ref;
+                if (navMesh->decodePolyIdTile(ref) != tileIndex)
+                    continue;
+                unsigned neighbour = navMesh->decodePolyIdPoly(ref);
+                if (neighbour < numPolys && hTile.polyClusters_[neighbour] == 0xffff)
+                {
+                    hTile.polyClusters_[neighbour] = cluster;
+                    stack.Push(neighbour);
+                }
+            }
+        }
+
+        clusterData.center_ /= (float)numClusterPolys;
+    }
+}
+
+/// Find the connections of a tile's regions to the neighbouring tiles.
+static void BuildHierarchyTileEdges(NavPathHierarchy& hierarchy, const dtNavMesh* navMesh, unsigned tileIndex)
+{
+    const NavHierarchyTile& hTile = hierarchy.tiles_[tileIndex];
+    const dtMeshTile* tile = navMesh->getTile(tileIndex);
+    if (!tile->header)
+        return;
+
+    PODVector<NavCluster*> clusters(hTile.numClusters_);
+    for (unsigned i = 0; i < hTile.numClusters_; ++i)
+    {
+        clusters[i] = &hierarchy.clusters_[NavPathHierarchy::GetClusterId(tileIndex, i)];
+        clusters[i]->edges_.Clear();
+    }
+
+    for (unsigned i = 0; i < hTile.polyClusters_.Size(); ++i)
+    {
+        if (hTile.polyClusters_[i] == 0xffff)
+            continue;
+
+        const dtPoly* poly = &tile->polys[i];
+        NavCluster* cluster = clusters[hTile.polyClusters_[i]];
+
+        for (unsigned k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+        {
+            const dtLink& link = tile->links[k];
+            unsigned targetTile = navMesh->decodePolyIdTile(link.ref);
+            if (targetTile == tileIndex || targetTile >= hierarchy.tiles_.Size())
+                continue;
+
+            const NavHierarchyTile& hTarget = hierarchy.tiles_[targetTile];
+            unsigned targetPoly = navMesh->decodePolyIdPoly(link.ref);
+            if (targetPoly >= hTarget.polyClusters_.Size() || hTarget.polyClusters_[targetPoly] == 0xffff)
+                continue;
+
+            unsigned target = NavPathHierarchy::GetClusterId(targetTile, hTarget.polyClusters_[targetPoly]);
+            HashMap<unsigned, NavCluster>::ConstIterator targetCluster = hierarchy.clusters_.Find(target);
+            if (targetCluster == hierarchy.clusters_.End())
+                continue;
+
+            // Use the middle of the shared edge as the portal
+            Vector3 portal;
+            if (link.edge < poly->vertCount)
+            {
+                const Vector3& va = *reinterpret_cast<const Vector3*>(&tile->verts[poly->verts[link.edge] * 3]);
+                const Vector3& vb = *reinterpret_cast<const Vector3*>(&tile->verts[poly->verts[(link.edge + 1) % poly->vertCount] * 3]);
+                portal = (va + vb) * 0.5f;
+            }
+            else
+                portal = GetPolyCenter(tile, poly);
+
+            float cost = (portal - cluster->center_).Length() + (targetCluster->second_.center_ - portal).Length();
+
+            // Keep only the cheapest connection between two regions
+            bool found = false;
+            for (unsigned j = 0; j < cluster->edges_.Size(); ++j)
+            {
+                NavClusterEdge& edge = cluster->edges_[j];
+                if (edge.target_ == target)
+                {
+                    if (cost < edge.cost_)
+                    {
+                        edge.cost_ = cost;
+                        edge.portal_ = portal;
+                        edge.portalRef_ = link.ref;
+                    }
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                NavClusterEdge edge;
+                edge.target_ = target;
+                edge.cost_ = cost;
+                edge.portal_ = portal;
+                edge.portalRef_ = link.ref;
+                cluster->edges_.Push(edge);
+            }
+        }
+    }
+}
+
+/// Bring the region graph up to date with the tiles of the navigation mesh. Only tiles that were added, removed or replaced since the last update, and their neighbours, are processed.
+static void UpdatePathHierarchy(NavPathHierarchy& hierarchy, const dtNavMesh* navMesh)
+{
+    hierarchy.dirty_ = false;
+
+    const unsigned maxTiles = (unsigned)navMesh->getMaxTiles();
+    if (hierarchy.tiles_.Size() != maxTiles)
+    {
+        hierarchy.tiles_.Clear();
+        hierarchy.clusters_.Clear();
+        hierarchy.tiles_.Resize(maxTiles);
+    }
+
+    PODVector<unsigned> changedTiles;
+    for (unsigned i = 0; i < maxTiles; ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        dtTileRef ref = tile->header ? navMesh->getTileRef(tile) : 0;
+        if (ref != hierarchy.tiles_[i].ref_)
+            changedTiles.Push(i);
+    }
+
+    if (changedTiles.Empty())
+        return;
+
+    // The connections of the neighbours refer to the regions of the changed tiles, so update them as well
+    HashSet<unsigned> edgeTiles;
+    for (unsigned i = 0; i < changedTiles.Size(); ++i)
+    {
+        unsigned tileIndex = changedTiles[i];
+        NavHierarchyTile& hTile = hierarchy.tiles_[tileIndex];
+
+        // Use the old position for removed tiles
+        const dtMeshTile* tile = navMesh->getTile(tileIndex);
+        int x = tile->header ? tile->header->x : hTile.x_;
+        int z = tile->header ? tile->header->y : hTile.z_;
+
+        BuildHierarchyTileClusters(hierarchy, navMesh, tileIndex);
+        edgeTiles.Insert(tileIndex);
+
+        for (int nz = z - 1; nz <= z + 1; ++nz)
+        {
+            for (int nx = x - 1; nx <= x + 1; ++nx)
+            {
+                const dtMeshTile* neighbours[MAX_TILE_LAYERS];
+                int numNeighbours = navMesh->getTilesAt(nx, nz, neighbours, MAX_TILE_LAYERS);
+                for (int j = 0; j < numNeighbours; ++j)
+                    edgeTiles.Insert(navMesh->decodePolyIdTile(navMesh->getPolyRefBase(neighbours[j])));
+            }
+        }
+    }
+
+    for (HashSet<unsigned>::ConstIterator i = edgeTiles.Begin(); i != edgeTiles.End(); ++i)
+        BuildHierarchyTileEdges(hierarchy, navMesh, *i);
+}
+
+/// Plan a route over the region graph and search the polygons along it one region at a time. Return false if the route could not be planned or followed, in which case a normal search should be used.
+static bool FindHierarchicalPath(NavPathHierarchy& hierarchy, dtNavMeshQuery* query, const dtQueryFilter* filter,
+    dtPolyRef startRef, dtPolyRef endRef, const Vector3& start, const Vector3& end, dtPolyRef* polys, dtPolyRef* segmentPolys,
+    int& numPolys)
+{
+    const dtNavMesh* navMesh = query->getAttachedNavMesh();
+
+    unsigned startTile = navMesh->decodePolyIdTile(startRef);
+    unsigned endTile = navMesh->decodePolyIdTile(endRef);
+    unsigned startPoly = navMesh->decodePolyIdPoly(startRef);
+    unsigned endPoly = navMesh->decodePolyIdPoly(endRef);
+    if (startTile >= hierarchy.tiles_.Size() || endTile >= hierarchy.tiles_.Size() ||
+        startPoly >= hierarchy.tiles_[startTile].polyClusters_.Size() || endPoly >= hierarchy.tiles_[endTile].polyClusters_.Size())
+        return false;
+
+    unsigned startCluster = NavPathHierarchy::GetClusterId(startTile, hierarchy.tiles_[startTile].polyClusters_[startPoly]);
+    unsigned endCluster = NavPathHierarchy::GetClusterId(endTile, hierarchy.tiles_[endTile].polyClusters_[endPoly]);
+
+    // Short paths are searched directly
+    if (startCluster == endCluster)
+        return false;
+
+    // A* over the region graph
+    HashMap<unsigned, NavClusterSearchNode> nodes;
+    PODVector<NavClusterOpenNode> open;
+
+    NavClusterSearchNode& startNode = nodes[startCluster];
+    startNode.cost_ = 0.0f;
+    startNode.parent_ = startCluster;
+    startNode.edge_ = 0;
+    startNode.closed_ = false;
+
+    NavClusterOpenNode openNode;
+    openNode.id_ = startCluster;
+    openNode.total_ = (end - start).Length();
+    PushOpenNode(open, openNode);
+
+    bool found = false;
+    while (!open.Empty())
+    {
+        NavClusterOpenNode current = PopOpenNode(open);
+        NavClusterSearchNode& currentNode = nodes[current.id_];
+        if (currentNode.closed_)
+            continue;
+        currentNode.closed_ = true;
+        if (current.id_ == endCluster)
+        {
+            found = true;
+            break;
+        }
+
+        float currentCost = currentNode.cost_;
+        const NavCluster& cluster = hierarchy.clusters_[current.id_];
+        for (unsigned i = 0; i < cluster.edges_.Size(); ++i)
+        {
+            const NavClusterEdge& edge = cluster.edges_[i];
+            float cost = currentCost + edge.cost_;
+
+            HashMap<unsigned, NavClusterSearchNode>::Iterator j = nodes.Find(edge.target_);
+            if (j != nodes.End() && (j->second_.closed_ || j->second_.cost_ <= cost))
+                continue;
+
+            NavClusterSearchNode& node = nodes[edge.target_];
+            node.cost_ = cost;
+            node.parent_ = current.id_;
+            node.edge_ = i;
+            node.closed_ = false;
+
+            openNode.id_ = edge.target_;
+            openNode.total_ = cost + (end - hierarchy.clusters_[edge.target_].center_).Length();
+            PushOpenNode(open, openNode);
+        }
+    }
+
+    if (!found)
+        return false;
+
+    // Collect the portals of the route from the end backwards
+    PODVector<const NavClusterEdge*> route;
+    for (unsigned id = endCluster; id != startCluster;)
+    {
+        const NavClusterSearchNode& node = nodes[id];
+        route.Push(&hierarchy.clusters_[node.parent_].edges_[node.edge_]);
+        id = node.parent_;
+    }
+
+    // Search the polygons from portal to portal. Each search only crosses one tile
+    HashMap<dtPolyRef, int> polyIndices;
+    dtPolyRef currentRef = startRef;
+    Vector3 currentPos = start;
+    numPolys = 0;
+
+    for (int i = (int)route.Size(); i >= 0; --i)
+    {
+        dtPolyRef targetRef = i > 0 ? route[i - 1]->portalRef_ : endRef;
+        const Vector3& targetPos = i > 0 ? route[i - 1]->portal_ : end;
+
+        int numSegmentPolys = 0;
+        query->findPath(currentRef, targetRef, &currentPos.x_, &targetPos.x_, filter, segmentPolys, &numSegmentPolys, MAX_POLYS);
+        if (!numSegmentPolys)
+            return false;
+        // The route must be followed through every portal, otherwise let the normal search handle the path
+        if (i > 0 && segmentPolys[numSegmentPolys - 1] != targetRef)
+            return false;
+
+        // Append the segment, skipping its first polygon which ends the previous segment. Remove loops where the
+        // segments double back
+        for (int j = numPolys ? 1 : 0; j < numSegmentPolys; ++j)
+        {
+            HashMap<dtPolyRef, int>::Iterator k = polyIndices.Find(segmentPolys[j]);
+            if (k != polyIndices.End())
+            {
+                for (int l = k->second_ + 1; l < numPolys; ++l)
+                    polyIndices.Erase(polys[l]);
+                numPolys = k->second_ + 1;
+                continue;
+            }
+
+            if (numPolys >= MAX_POLYS)
+                return false;
+            polyIndices[segmentPolys[j]] = numPolys;
+            polys[numPolys++] = segmentPolys[j];
+        }
+
+        currentRef = targetRef;
+        currentPos = targetPos;
+    }
+
+    return numPolys > 0;
+}
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(0),
     navMeshQuery_(0),
     queryFilter_(new dtQueryFilter()),
     pathData_(new FindPathData()),
+    pathQueue_(new NavPathQueue()),
+    pathBudget_(DEFAULT_PATH_BUDGET),
+    pathHierarchy_(new NavPathHierarchy()),
+    hierarchicalPathfinding_(false),
     tileSize_(DEFAULT_TILE_SIZE),
     cellSize_(DEFAULT_CELL_SIZE),
     cellHeight_(DEFAULT_CELL_HEIGHT),
@@ -123,7 +1025,8 @@ NavigationMesh::NavigationMesh(Context* context) :
     numTilesX_(0),
     numTilesZ_(0),
     partitionType_(NAVMESH_PARTITION_WATERSHED),
-    keepInterResults_(false)
+    keepInterResults_(false),
+    rebuildDirtyTiles_(false)
 {
 }
 
@@ -131,11 +1034,20 @@ NavigationMesh::~NavigationMesh()
 {
     ReleaseNavigationMesh();
 
+    if (rebuildDirtyTiles_)
+        --numDirtyTileRebuildMeshes;
+
     delete queryFilter_;
     queryFilter_ = 0;
 
     delete pathData_;
     pathData_ = 0;
+
+    delete pathQueue_;
+    pathQueue_ = 0;
+
+    delete pathHierarchy_;
+    pathHierarchy_ = 0;
 }
 
 void NavigationMesh::RegisterObject(Context* context)
@@ -158,6 +1070,9 @@ void NavigationMesh::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE("Bounding Box Padding", GetPadding, SetPadding, Vector3, Vector3::ONE, AM_DEFAULT);
     MIXED_ACCESSOR_ATTRIBUTE("Navigation Data", GetNavigationDataAttr, SetNavigationDataAttr, PODVector<unsigned char>, Variant::emptyBuffer, AM_FILE | AM_NOEDIT);
     ENUM_ACCESSOR_ATTRIBUTE("Partition Type", GetPartitionType, SetPartitionType, NavmeshPartitionType, navmeshPartitionTypeNames, NAVMESH_PARTITION_WATERSHED, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Path Budget", GetPathBudget, SetPathBudget, float, DEFAULT_PATH_BUDGET, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Hierarchical Pathfinding", GetHierarchicalPathfinding, SetHierarchicalPathfinding, bool, false, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Rebuild Dirty Tiles", GetRebuildDirtyTiles, SetRebuildDirtyTiles, bool, false, AM_DEFAULT);
 }
 
 void NavigationMesh::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -371,17 +1286,16 @@ bool NavigationMesh::Build()
         }
 
         // Build each tile
-        unsigned numTiles = 0;
-
+        PODVector<IntVector2> tiles;
+        tiles.Reserve(numTilesX_ * numTilesZ_);
         for (int z = 0; z < numTilesZ_; ++z)
         {
             for (int x = 0; x < numTilesX_; ++x)
-            {
-                if (BuildTile(geometryList, x, z))
-                    ++numTiles;
-            }
+                tiles.Push(IntVector2(x, z));
         }
 
+        unsigned numTiles = BuildTiles(geometryList, tiles);
+
         LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
 
         // Send a notification event to concerned parties that we've been fully rebuilt
@@ -415,27 +1329,25 @@ bool NavigationMesh::Build(const BoundingBox& boundingBox)
 
     BoundingBox localSpaceBox = boundingBox.Transformed(node_->GetWorldTransform().Inverse());
 
-    float tileEdgeLength = (float)tileSize_ * cellSize_;
-
     Vector<NavigationGeometryInfo> geometryList;
     CollectGeometries(geometryList);
 
-    int sx = Clamp((int)((localSpaceBox.min_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
-    int sz = Clamp((int)((localSpaceBox.min_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
-    int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
-    int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
-
-    unsigned numTiles = 0;
+    IntVector2 start = GetTileIndex(localSpaceBox.min_);
+    IntVector2 end = GetTileIndex(localSpaceBox.max_);
 
-    for (int z = sz; z <= ez; ++z)
+    PODVector<IntVector2> tiles;
+    for (int z = start.y_; z <= end.y_; ++z)
     {
-        for (int x = sx; x <= ex; ++x)
+        for (int x = start.x_; x <= end.x_; ++x)
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
+            // The tiles are rebuilt now, so skip them in the background rebuild
+            dirtyTiles_.Erase(MakePair(x, z));
+            tiles.Push(IntVector2(x, z));
         }
     }
 
+    unsigned numTiles = BuildTiles(geometryList, tiles);
+
     LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
     return true;
 }
@@ -511,8 +1423,19 @@ void NavigationMesh::FindPath(PODVector<Vector3>& dest, const Vector3& start, co
     int numPolys = 0;
     int numPathPoints = 0;
 
-    navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter_, pathData_->polys_, &numPolys,
-        MAX_POLYS);
+    // Only scan the tiles for changes when tiles have been built or removed since the last update
+    if (hierarchicalPathfinding_ && pathHierarchy_->dirty_)
+    {
+        PROFILE(UpdatePathHierarchy);
+        UpdatePathHierarchy(*pathHierarchy_, navMesh_);
+    }
+
+    if (!hierarchicalPathfinding_ || !FindHierarchicalPath(*pathHierarchy_, navMeshQuery_, queryFilter_, startRef, endRef,
+        localStart, localEnd, pathData_->polys_, pathData_->pathPolys_, numPolys))
+    {
+        navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter_, pathData_->polys_, &numPolys,
+            MAX_POLYS);
+    }
     if (!numPolys)
         return;
 
@@ -530,6 +1453,75 @@ void NavigationMesh::FindPath(PODVector<Vector3>& dest, const Vector3& start, co
         dest.Push(transform * pathData_->pathPoints_[i]);
 }
 
+unsigned NavigationMesh::FindPathAsync(const Vector3& start, const Vector3& end, const Vector3& extents)
+{
+    Scene* scene = GetScene();
+    if (!scene || !InitializeQuery())
+        return 0;
+
+    // Navigation data is in local space. Transform path points from world to local
+    Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+
+    NavPathRequest request;
+    request.start_ = inverse * start;
+    request.end_ = inverse * end;
+
+    dtPolyRef startRef;
+    dtPolyRef endRef;
+    navMeshQuery_->findNearestPoly(&request.start_.x_, &extents.x_, queryFilter_, &startRef, 0);
+    navMeshQuery_->findNearestPoly(&request.end_.x_, &extents.x_, queryFilter_, &endRef, 0);
+
+    if (!startRef || !endRef)
+        return 0;
+
+    NavPathQueue& queue = *pathQueue_;
+    if (!queue.numRequests_)
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(NavigationMesh, HandleScenePostUpdate));
+
+    request.id_ = queue.nextRequestId_++;
+    if (!queue.nextRequestId_)
+        queue.nextRequestId_ = 1;
+    ++queue.numRequests_;
+
+    // Join a waiting or active search between the same polygons if there is one
+    Pair<dtPolyRef, dtPolyRef> key = MakePair(startRef, endRef);
+    HashMap<Pair<dtPolyRef, dtPolyRef>, NavPathSearch*>::Iterator i = queue.searchMap_.Find(key);
+    if (i != queue.searchMap_.End())
+        i->second_->requests_.Push(request);
+    else
+    {
+        NavPathSearch* search = new NavPathSearch();
+        search->startRef_ = startRef;
+        search->endRef_ = endRef;
+        search->success_ = false;
+        search->requests_.Push(request);
+        queue.searches_.Push(search);
+        queue.searchMap_[key] = search;
+    }
+
+    return request.id_;
+}
+
+void NavigationMesh::SetPathBudget(float milliseconds)
+{
+    pathBudget_ = Max(milliseconds, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::SetHierarchicalPathfinding(bool enable)
+{
+    hierarchicalPathfinding_ = enable;
+    if (!enable && pathHierarchy_)
+        pathHierarchy_->Clear();
+
+    MarkNetworkUpdate();
+}
+
+unsigned NavigationMesh::GetNumPathRequests() const
+{
+    return pathQueue_->numRequests_;
+}
+
 Vector3 NavigationMesh::GetRandomPoint()
 {
     if (!InitializeQuery())
@@ -694,6 +1686,7 @@ void NavigationMesh::SetNavigationDataAttr(const PODVector<unsigned char>& value
         }
 
         buffer.Read(navData, navDataSize);
+        MarkPathHierarchyDirty();
         if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, 0)))
         {
             LOGERROR("Failed to add navigation mesh tile");
@@ -758,7 +1751,16 @@ void NavigationMesh::CollectGeometries(Vector<NavigationGeometryInfo>& geometryL
     for (unsigned i = 0; i < navigables.Size(); ++i)
     {
         if (navigables[i]->IsEnabledEffective())
+        {
+            unsigned first = geometryList.Size();
             CollectGeometries(geometryList, navigables[i]->GetNode(), processedNodes, navigables[i]->IsRecursive());
+
+            // Remember the geometry bounds, so that the old area can be rebuilt if the Navigable moves
+            BoundingBox bounds;
+            for (unsigned j = first; j < geometryList.Size(); ++j)
+                bounds.Merge(geometryList[j].boundingBox_);
+            navigableBounds_[navigables[i]] = bounds;
+        }
     }
 
     // Get offmesh connections
@@ -1044,26 +2046,83 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
 {
     PROFILE(BuildNavigationMeshTile);
 
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), 0, 0);
+    NavTileBuild tile(x, z);
+    PrepareTile(tile, geometryList);
+    tile.success_ = BuildTileData(tile);
+    return AddTile(tile);
+}
+
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const PODVector<IntVector2>& tiles)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+    unsigned numTiles = 0;
+
+    if (!numThreads || tiles.Size() < 2)
+    {
+        for (unsigned i = 0; i < tiles.Size(); ++i)
+        {
+            if (BuildTile(geometryList, tiles[i].x_, tiles[i].y_))
+                ++numTiles;
+        }
+        return numTiles;
+    }
+
+    PROFILE(BuildNavigationMeshTiles);
+
+    // Prepare the geometry of a limited number of tiles at a time to bound memory use, then run the Recast pipeline
+    // for them in the worker threads and the main thread
+    unsigned batchSize = (numThreads + 1) * TILES_PER_THREAD;
+    PODVector<NavTileBuild*> batch;
+
+    for (unsigned start = 0; start < tiles.Size(); start += batchSize)
+    {
+        unsigned end = Min((int)(start + batchSize), (int)tiles.Size());
+
+        for (unsigned i = start; i < end; ++i)
+        {
+            NavTileBuild* tile = new NavTileBuild(tiles[i].x_, tiles[i].y_);
+            PrepareTile(*tile, geometryList);
+            batch.Push(tile);
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = BuildNavigationTileWork;
+            item->start_ = tile;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+
+        // Add the tiles in order from the main thread
+        for (unsigned i = 0; i < batch.Size(); ++i)
+        {
+            if (AddTile(*batch[i]))
+                ++numTiles;
+            delete batch[i];
+        }
+        batch.Clear();
+    }
+
+    return numTiles;
+}
 
+void NavigationMesh::PrepareTile(NavTileBuild& tile, Vector<NavigationGeometryInfo>& geometryList)
+{
     float tileEdgeLength = (float)tileSize_ * cellSize_;
 
-    BoundingBox tileBoundingBox(Vector3(
-        boundingBox_.min_.x_ + tileEdgeLength * (float)x,
+    tile.tileBoundingBox_ = BoundingBox(Vector3(
+        boundingBox_.min_.x_ + tileEdgeLength * (float)tile.x_,
         boundingBox_.min_.y_,
-        boundingBox_.min_.z_ + tileEdgeLength * (float)z
+        boundingBox_.min_.z_ + tileEdgeLength * (float)tile.z_
     ),
     Vector3(
-        boundingBox_.min_.x_ + tileEdgeLength * (float)(x + 1),
+        boundingBox_.min_.x_ + tileEdgeLength * (float)(tile.x_ + 1),
         boundingBox_.max_.y_,
-        boundingBox_.min_.z_ + tileEdgeLength * (float)(z + 1)
+        boundingBox_.min_.z_ + tileEdgeLength * (float)(tile.z_ + 1)
     ));
 
-    SimpleNavBuildData build;
-
-    rcConfig cfg;
-    memset(&cfg, 0, sizeof cfg);
+    rcConfig& cfg = tile.config_;
     cfg.cs = cellSize_;
     cfg.ch = cellHeight_;
     cfg.walkableSlopeAngle = agentMaxSlope_;
@@ -1082,200 +2141,412 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     cfg.detailSampleDist = detailSampleDistance_ < 0.9f ? 0.0f : cellSize_ * detailSampleDistance_;
     cfg.detailSampleMaxError = cellHeight_ * detailSampleMaxError_;
 
-    rcVcopy(cfg.bmin, &tileBoundingBox.min_.x_);
-    rcVcopy(cfg.bmax, &tileBoundingBox.max_.x_);
+    rcVcopy(cfg.bmin, &tile.tileBoundingBox_.min_.x_);
+    rcVcopy(cfg.bmax, &tile.tileBoundingBox_.max_.x_);
     cfg.bmin[0] -= cfg.borderSize * cfg.cs;
     cfg.bmin[2] -= cfg.borderSize * cfg.cs;
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
+    tile.agentHeight_ = agentHeight_;
+    tile.agentRadius_ = agentRadius_;
+    tile.agentMaxClimb_ = agentMaxClimb_;
+    tile.partitionType_ = partitionType_;
+
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    GetTileGeometry(&tile.build_, geometryList, expandedBox);
+}
 
-    if (build.vertices_.Empty() || build.indices_.Empty())
-        return true; // Nothing to do
+bool NavigationMesh::AddTile(NavTileBuild& tile)
+{
+    MarkPathHierarchyDirty();
 
-    build.heightField_ = rcAllocHeightfield();
-    if (!build.heightField_)
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(tile.x_, tile.z_, 0), 0, 0);
+
+    // Tile without geometry or failed build
+    if (!tile.navData_)
+        return tile.success_;
+
+    if (dtStatusFailed(navMesh_->addTile(tile.navData_, tile.navDataSize_, DT_TILE_FREE_DATA, 0, 0)))
     {
-        LOGERROR("Could not allocate heightfield");
+        LOGERROR("Failed to add navigation mesh tile");
         return false;
     }
 
-    if (!rcCreateHeightfield(build.ctx_, *build.heightField_, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs,
-        cfg.ch))
+    // The navigation mesh owns the data now
+    tile.navData_ = 0;
+
+    // Send a notification of the rebuild of this tile to anyone interested
     {
-        LOGERROR("Could not create heightfield");
-        return false;
+        using namespace NavigationAreaRebuilt;
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = GetNode();
+        eventData[P_MESH] = this;
+        eventData[P_BOUNDSMIN] = Variant(tile.tileBoundingBox_.min_);
+        eventData[P_BOUNDSMAX] = Variant(tile.tileBoundingBox_.max_);
+        SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
+    return true;
+}
 
-    unsigned numTriangles = build.indices_.Size() / 3;
-    SharedArrayPtr<unsigned char> triAreas(new unsigned char[numTriangles]);
-    memset(triAreas.Get(), 0, numTriangles);
+void NavigationMesh::MarkPathHierarchyDirty()
+{
+    if (pathHierarchy_)
+        pathHierarchy_->dirty_ = true;
+}
 
-    rcMarkWalkableTriangles(build.ctx_, cfg.walkableSlopeAngle, &build.vertices_[0].x_, build.vertices_.Size(),
-        &build.indices_[0], numTriangles, triAreas.Get());
-    rcRasterizeTriangles(build.ctx_, &build.vertices_[0].x_, build.vertices_.Size(), &build.indices_[0],
-        triAreas.Get(), numTriangles, *build.heightField_, cfg.walkableClimb);
-    rcFilterLowHangingWalkableObstacles(build.ctx_, cfg.walkableClimb, *build.heightField_);
-    
-    rcFilterWalkableLowHeightSpans(build.ctx_, cfg.walkableHeight, *build.heightField_);
-    rcFilterLedgeSpans(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_);
+IntVector2 NavigationMesh::GetTileIndex(const Vector3& position) const
+{
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
 
-    build.compactHeightField_ = rcAllocCompactHeightfield();
-    if (!build.compactHeightField_)
+    return IntVector2(
+        Clamp((int)((position.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1),
+        Clamp((int)((position.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1)
+    );
+}
+
+void NavigationMesh::SetRebuildDirtyTiles(bool enable)
+{
+    if (enable == rebuildDirtyTiles_)
+        return;
+
+    rebuildDirtyTiles_ = enable;
+    if (enable)
+        ++numDirtyTileRebuildMeshes;
+    else
     {
-        LOGERROR("Could not allocate create compact heightfield");
-        return false;
+        --numDirtyTileRebuildMeshes;
+        dirtyTiles_.Clear();
+        dirtyNavigables_.Clear();
     }
-    if (!rcBuildCompactHeightfield(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_,
-        *build.compactHeightField_))
+
+    MarkNetworkUpdate();
+}
+
+bool NavigationMesh::IsDirtyTileRebuildInUse()
+{
+    return numDirtyTileRebuildMeshes != 0;
+}
+
+void NavigationMesh::MarkDirty(const BoundingBox& boundingBox)
+{
+    if (!node_)
+        return;
+
+    MarkTilesDirty(boundingBox.Transformed(node_->GetWorldTransform().Inverse()));
+}
+
+void NavigationMesh::MarkNavigableDirty(Navigable* navigable)
+{
+    Scene* scene = GetScene();
+    if (!rebuildDirtyTiles_ || !navMesh_ || !navigable || !scene)
+        return;
+
+    if (dirtyNavigables_.Empty() && dirtyTiles_.Empty())
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(NavigationMesh, HandleScenePostUpdate));
+
+    dirtyNavigables_.Insert(WeakPtr<Navigable>(navigable));
+}
+
+void NavigationMesh::MarkTilesDirty(const BoundingBox& localSpaceBox)
+{
+    Scene* scene = GetScene();
+    if (!rebuildDirtyTiles_ || !navMesh_ || !localSpaceBox.defined_ || !scene)
+        return;
+
+    if (dirtyNavigables_.Empty() && dirtyTiles_.Empty())
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(NavigationMesh, HandleScenePostUpdate));
+
+    IntVector2 start = GetTileIndex(localSpaceBox.min_);
+    IntVector2 end = GetTileIndex(localSpaceBox.max_);
+
+    for (int z = start.y_; z <= end.y_; ++z)
     {
-        LOGERROR("Could not build compact heightfield");
-        return false;
+        for (int x = start.x_; x <= end.x_; ++x)
+            dirtyTiles_.Insert(MakePair(x, z));
     }
-    if (!rcErodeWalkableArea(build.ctx_, cfg.walkableRadius, *build.compactHeightField_))
+}
+
+void NavigationMesh::UpdateDirtyNavigables()
+{
+    if (dirtyNavigables_.Empty())
+        return;
+
+    // Copy the set, as marking tiles dirty checks it
+    PODVector<Navigable*> navigables;
+    for (HashSet<WeakPtr<Navigable> >::ConstIterator i = dirtyNavigables_.Begin(); i != dirtyNavigables_.End(); ++i)
     {
-        LOGERROR("Could not erode compact heightfield");
-        return false;
+        if (*i)
+            navigables.Push(i->Get());
     }
+    dirtyNavigables_.Clear();
 
-    // Mark area volumes
-    for (unsigned i = 0; i < build.navAreas_.Size(); ++i)
-        rcMarkBoxArea(build.ctx_, &build.navAreas_[i].bounds_.min_.x_, &build.navAreas_[i].bounds_.max_.x_, build.navAreas_[i].areaID_, *build.compactHeightField_);
-
-    if (this->partitionType_ == NAVMESH_PARTITION_WATERSHED)
+    for (unsigned i = 0; i < navigables.Size(); ++i)
     {
-        if (!rcBuildDistanceField(build.ctx_, *build.compactHeightField_))
+        Navigable* navigable = navigables[i];
+
+        BoundingBox bounds;
+        if (navigable->IsEnabledEffective())
         {
-            LOGERROR("Could not build distance field");
-            return false;
+            Vector<NavigationGeometryInfo> geometryList;
+            HashSet<Node*> processedNodes;
+            CollectGeometries(geometryList, navigable->GetNode(), processedNodes, navigable->IsRecursive());
+            for (unsigned j = 0; j < geometryList.Size(); ++j)
+                bounds.Merge(geometryList[j].boundingBox_);
         }
-        if (!rcBuildRegions(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea,
-            cfg.mergeRegionArea))
+
+        // Rebuild both the area the geometry left and the area it moved to
+        HashMap<Navigable*, BoundingBox>::Iterator oldBounds = navigableBounds_.Find(navigable);
+        if (oldBounds != navigableBounds_.End())
         {
-            LOGERROR("Could not build regions");
-            return false;
+            MarkTilesDirty(oldBounds->second_);
+            oldBounds->second_ = bounds;
         }
+        else
+            navigableBounds_[navigable] = bounds;
+
+        MarkTilesDirty(bounds);
     }
-    else
+}
+
+void NavigationMesh::RebuildDirtyTiles()
+{
+    PROFILE(RebuildDirtyNavigationTiles);
+
+    UpdateDirtyNavigables();
+
+    if (dirtyTiles_.Empty() || !navMesh_)
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    Vector<NavigationGeometryInfo> geometryList;
+    CollectGeometries(geometryList);
+
+    for (HashSet<Pair<int, int> >::Iterator i = dirtyTiles_.Begin(); i != dirtyTiles_.End();)
     {
-        if (!rcBuildRegionsMonotone(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+        // If the tile is still being built from older geometry, leave it dirty until that build has been swapped in
+        bool pending = false;
+        for (unsigned j = 0; j < pendingTiles_.Size(); ++j)
         {
-            LOGERROR("Could not build monotone regions");
-            return false;
+            if (pendingTiles_[j]->x_ == i->first_ && pendingTiles_[j]->z_ == i->second_)
+            {
+                pending = true;
+                break;
+            }
+        }
+        if (pending)
+        {
+            ++i;
+            continue;
         }
-    }
 
-    build.contourSet_ = rcAllocContourSet();
-    if (!build.contourSet_)
-    {
-        LOGERROR("Could not allocate contour set");
-        return false;
-    }
-    if (!rcBuildContours(build.ctx_, *build.compactHeightField_, cfg.maxSimplificationError, cfg.maxEdgeLen,
-        *build.contourSet_))
-    {
-        LOGERROR("Could not create contours");
-        return false;
-    }
+        NavTileBuild* tile = new NavTileBuild(i->first_, i->second_);
+        PrepareTile(*tile, geometryList);
+        i = dirtyTiles_.Erase(i);
 
-    build.polyMesh_ = rcAllocPolyMesh();
-    if (!build.polyMesh_)
-    {
-        LOGERROR("Could not allocate poly mesh");
-        return false;
+        if (!queue)
+        {
+            tile->success_ = BuildTileData(*tile);
+            AddTile(*tile);
+            delete tile;
+            continue;
+        }
+
+        if (pendingTiles_.Empty())
+            SubscribeToEvent(E_WORKITEMCOMPLETED, HANDLER(NavigationMesh, HandleWorkItemCompleted));
+
+        // Build at low priority, so that the main thread does not wait for the tile at the end of the frame
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = 0;
+        item->workFunction_ = BuildNavigationTileWork;
+        item->start_ = tile;
+        item->sendEvent_ = true;
+        tile->item_ = item;
+        pendingTiles_.Push(tile);
+        queue->AddWorkItem(item);
     }
-    if (!rcBuildPolyMesh(build.ctx_, *build.contourSet_, cfg.maxVertsPerPoly, *build.polyMesh_))
+}
+
+void NavigationMesh::CancelPendingTiles()
+{
+    if (pendingTiles_.Empty())
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    for (unsigned i = 0; i < pendingTiles_.Size(); ++i)
     {
-        LOGERROR("Could not triangulate contours");
-        return false;
+        NavTileBuild* tile = pendingTiles_[i];
+        // If a worker thread already started the build, wait for it to finish before freeing the data
+        if (!queue || !queue->RemoveWorkItem(tile->item_))
+            tile->finished_.Wait();
+        delete tile;
     }
 
-    build.polyMeshDetail_ = rcAllocPolyMeshDetail();
-    if (!build.polyMeshDetail_)
+    pendingTiles_.Clear();
+    UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
+}
+
+void NavigationMesh::UpdatePathRequests()
+{
+    NavPathQueue& queue = *pathQueue_;
+    if (!queue.numRequests_ || !navMesh_)
+        return;
+
+    PROFILE(UpdatePathRequests);
+
+    WorkQueue* workQueue = GetSubsystem<WorkQueue>();
+    unsigned numSlots = workQueue ? workQueue->GetNumThreads() + 1 : 1;
+
+    while (queue.slots_.Size() < numSlots)
     {
-        LOGERROR("Could not allocate detail mesh");
-        return false;
+        NavPathSlot* slot = new NavPathSlot();
+        if (!slot->query_ || dtStatusFailed(slot->query_->init(navMesh_, MAX_POLYS)))
+        {
+            LOGERROR("Could not create navigation mesh query for path requests");
+            delete slot;
+            break;
+        }
+        queue.slots_.Push(slot);
     }
-    if (!rcBuildPolyMeshDetail(build.ctx_, *build.polyMesh_, *build.compactHeightField_, cfg.detailSampleDist,
-        cfg.detailSampleMaxError, *build.polyMeshDetail_))
+
+    if (queue.slots_.Empty())
+        return;
+
+    queue.filter_ = queryFilter_;
+    queue.budget_ = (long long)(pathBudget_ * 1000.0f);
+
+    // Each slot uses its own query, so the slots can be advanced in parallel
+    if (workQueue && queue.slots_.Size() > 1)
     {
-        LOGERROR("Could not build detail mesh");
-        return false;
+        for (unsigned i = 0; i < queue.slots_.Size(); ++i)
+        {
+            SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = UpdatePathSlotWork;
+            item->start_ = queue.slots_[i];
+            item->aux_ = &queue;
+            workQueue->AddWorkItem(item);
+        }
+        workQueue->Complete(M_MAX_UNSIGNED);
     }
+    else
+        UpdatePathSlot(queue, *queue.slots_[0]);
 
-    // Set polygon flags
-    /// \todo Assignment of flags from navigation areas?
-    for (int i = 0; i < build.polyMesh_->npolys; ++i)
+    queue.searches_.Erase(0, queue.next_);
+    queue.next_ = 0;
+
+    // Collect the finished searches first, as event handlers may queue new requests
+    PODVector<NavPathSearch*> completed;
+    for (unsigned i = 0; i < queue.slots_.Size(); ++i)
     {
-        if (build.polyMesh_->areas[i] != RC_NULL_AREA)
-            build.polyMesh_->flags[i] = 0x1;
+        NavPathSlot* slot = queue.slots_[i];
+        for (unsigned j = 0; j < slot->completed_.Size(); ++j)
+        {
+            NavPathSearch* search = slot->completed_[j];
+            queue.searchMap_.Erase(MakePair(search->startRef_, search->endRef_));
+            queue.numRequests_ -= search->requests_.Size();
+            completed.Push(search);
+        }
+        slot->completed_.Clear();
     }
 
-    unsigned char* navData = 0;
-    int navDataSize = 0;
+    if (completed.Empty())
+        return;
 
-    dtNavMeshCreateParams params;
-    memset(&params, 0, sizeof params);
-    params.verts = build.polyMesh_->verts;
-    params.vertCount = build.polyMesh_->nverts;
-    params.polys = build.polyMesh_->polys;
-    params.polyAreas = build.polyMesh_->areas;
-    params.polyFlags = build.polyMesh_->flags;
-    params.polyCount = build.polyMesh_->npolys;
-    params.nvp = build.polyMesh_->nvp;
-    params.detailMeshes = build.polyMeshDetail_->meshes;
-    params.detailVerts = build.polyMeshDetail_->verts;
-    params.detailVertsCount = build.polyMeshDetail_->nverts;
-    params.detailTris = build.polyMeshDetail_->tris;
-    params.detailTriCount = build.polyMeshDetail_->ntris;
-    params.walkableHeight = agentHeight_;
-    params.walkableRadius = agentRadius_;
-    params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
-    rcVcopy(params.bmin, build.polyMesh_->bmin);
-    rcVcopy(params.bmax, build.polyMesh_->bmax);
-    params.cs = cfg.cs;
-    params.ch = cfg.ch;
-    params.buildBvTree = true;
+    WeakPtr<NavigationMesh> self(this);
+    const Matrix3x4& transform = node_->GetWorldTransform();
 
-    // Add off-mesh connections if have them
-    if (build.offMeshRadii_.Size())
+    for (unsigned i = 0; i < completed.Size(); ++i)
     {
-        params.offMeshConCount = build.offMeshRadii_.Size();
-        params.offMeshConVerts = &build.offMeshVertices_[0].x_;
-        params.offMeshConRad = &build.offMeshRadii_[0];
-        params.offMeshConFlags = &build.offMeshFlags_[0];
-        params.offMeshConAreas = &build.offMeshAreas_[0];
-        params.offMeshConDir = &build.offMeshDir_[0];
+        NavPathSearch* search = completed[i];
+        for (unsigned j = 0; j < search->requests_.Size() && self; ++j)
+        {
+            const NavPathRequest& request = search->requests_[j];
+
+            // Transform path result back to world space
+            VariantVector path;
+            path.Resize(request.path_.Size());
+            for (unsigned k = 0; k < request.path_.Size(); ++k)
+                path[k] = transform * request.path_[k];
+
+            using namespace NavigationPathCompleted;
+            VariantMap& eventData = GetContext()->GetEventDataMap();
+            eventData[P_NODE] = node_;
+            eventData[P_MESH] = this;
+            eventData[P_REQUEST] = request.id_;
+            eventData[P_SUCCESS] = search->success_ && !request.path_.Empty();
+            eventData[P_PATH] = path;
+            SendEvent(E_NAVIGATION_PATH_COMPLETED, eventData);
+        }
+        delete search;
     }
+}
+
+void NavigationMesh::ClearPathRequests(PODVector<unsigned>& cancelledIds)
+{
+    NavPathQueue& queue = *pathQueue_;
 
-    if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+    PODVector<NavPathSearch*> searches;
+    for (unsigned i = queue.next_; i < queue.searches_.Size(); ++i)
+        searches.Push(queue.searches_[i]);
+    for (unsigned i = 0; i < queue.slots_.Size(); ++i)
     {
-        LOGERROR("Could not build navigation mesh tile data");
-        return false;
+        NavPathSlot* slot = queue.slots_[i];
+        if (slot->search_)
+            searches.Push(slot->search_);
+        searches.Push(slot->completed_);
+        delete slot;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, 0)))
+    for (unsigned i = 0; i < searches.Size(); ++i)
     {
-        LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
-        return false;
+        for (unsigned j = 0; j < searches[i]->requests_.Size(); ++j)
+            cancelledIds.Push(searches[i]->requests_[j].id_);
+        delete searches[i];
     }
 
-    // Send a notification of the rebuild of this tile to anyone interested
+    // The queries refer to the navigation mesh, so they are recreated for the next requests
+    queue.slots_.Clear();
+    queue.searches_.Clear();
+    queue.searchMap_.Clear();
+    queue.next_ = 0;
+    queue.numRequests_ = 0;
+}
+
+void NavigationMesh::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (rebuildDirtyTiles_)
+        RebuildDirtyTiles();
+
+    UpdatePathRequests();
+
+    if (dirtyTiles_.Empty() && dirtyNavigables_.Empty() && !pathQueue_->numRequests_)
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void NavigationMesh::HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData)
+{
+    using namespace WorkItemCompleted;
+
+    WorkItem* item = static_cast<WorkItem*>(eventData[P_ITEM].GetPtr());
+
+    for (unsigned i = 0; i < pendingTiles_.Size(); ++i)
     {
-        using namespace NavigationAreaRebuilt;
-        VariantMap& eventData = GetContext()->GetEventDataMap();
-        eventData[P_NODE] = GetNode();
-        eventData[P_MESH] = this;
-        eventData[P_BOUNDSMIN] = Variant(tileBoundingBox.min_);
-        eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
-        SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
+        NavTileBuild* tile = pendingTiles_[i];
+        if (tile->item_ == item)
+        {
+            // Swap the finished tile into the navigation mesh
+            if (navMesh_)
+                AddTile(*tile);
+            delete tile;
+            pendingTiles_.Erase(i);
+            break;
+        }
     }
-    return true;
+
+    if (pendingTiles_.Empty())
+        UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
 }
 
 bool NavigationMesh::InitializeQuery()
@@ -1304,6 +2575,18 @@ bool NavigationMesh::InitializeQuery()
 
 void NavigationMesh::ReleaseNavigationMesh()
 {
+    PODVector<unsigned> cancelledIds;
+    if (pathQueue_)
+        ClearPathRequests(cancelledIds);
+
+    CancelPendingTiles();
+    dirtyTiles_.Clear();
+    dirtyNavigables_.Clear();
+    navigableBounds_.Clear();
+
+    if (pathHierarchy_)
+        pathHierarchy_->Clear();
+
     dtFreeNavMesh(navMesh_);
     navMesh_ = 0;
 
@@ -1314,6 +2597,23 @@ void NavigationMesh::ReleaseNavigationMesh()
     numTilesZ_ = 0;
     boundingBox_.min_ = boundingBox_.max_ = Vector3::ZERO;
     boundingBox_.defined_ = false;
+
+    // Notify about the cancelled path requests last, so that new requests are refused
+    if (node_)
+    {
+        WeakPtr<NavigationMesh> self(this);
+        for (unsigned i = 0; i < cancelledIds.Size() && self; ++i)
+        {
+            using namespace NavigationPathCompleted;
+            VariantMap& eventData = GetContext()->GetEventDataMap();
+            eventData[P_NODE] = node_;
+            eventData[P_MESH] = this;
+            eventData[P_REQUEST] = cancelledIds[i];
+            eventData[P_SUCCESS] = false;
+            eventData[P_PATH] = VariantVector();
+            SendEvent(E_NAVIGATION_PATH_COMPLETED, eventData);
+        }
+    }
 }
 
 void NavigationMesh::SetPartitionType(NavmeshPartitionType ptype)
@@ -50,9 +50,14 @@ enum NavmeshPartitionType
 };
 
 class Geometry;
+class Navigable;
+class WorkItem;
 
 struct FindPathData;
 struct NavBuildData;
+struct NavPathHierarchy;
+struct NavPathQueue;
+struct NavTileBuild;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -118,12 +123,24 @@ public:
     virtual bool Build();
     /// Rebuild part of the navigation mesh contained by the world-space bounding box. Return true if successful.
     virtual bool Build(const BoundingBox& boundingBox);
+    /// Set whether tiles affected by moved Navigable nodes or MarkDirty() are rebuilt automatically after the scene update. The tiles are built in the work queue's threads and swapped in once finished. Default false.
+    void SetRebuildDirtyTiles(bool enable);
+    /// Mark the tiles intersecting a world-space bounding box for rebuilding after the scene update. Has no effect unless rebuilding dirty tiles is enabled.
+    void MarkDirty(const BoundingBox& boundingBox);
+    /// Mark a Navigable's geometry as moved. Called by Navigable.
+    void MarkNavigableDirty(Navigable* navigable);
     /// Find the nearest point on the navigation mesh to a given point. Extens specifies how far out from the specified point to check along each axis.
     Vector3 FindNearestPoint(const Vector3& point, const Vector3& extents=Vector3::ONE);
     /// Try to move along the surface from one point to another.
     Vector3 MoveAlongSurface(const Vector3& start, const Vector3& end, const Vector3& extents=Vector3::ONE, int maxVisited=3);
     /// Find a path between world space points. Return non-empty list of points if successful. Extents specifies how far off the navigation mesh the points can be.
     void FindPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE);
+    /// Queue a path search between world space points. The search runs over the following frames within the path budget, in the work queue's threads if available, and the result is sent with the E_NAVIGATION_PATH_COMPLETED event. Requests between the same polygons share one search. Return request ID, or 0 if the points are not on the navigation mesh.
+    unsigned FindPathAsync(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE);
+    /// Set the time in milliseconds each thread may spend per frame on queued path searches.
+    void SetPathBudget(float milliseconds);
+    /// Set whether FindPath() plans long paths over a graph of connected tile regions first and then searches the polygons locally along that route. Default false.
+    void SetHierarchicalPathfinding(bool enable);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint();
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -177,6 +194,18 @@ public:
     BoundingBox GetWorldBoundingBox() const;
     /// Return number of tiles.
     IntVector2 GetNumTiles() const { return IntVector2(numTilesX_, numTilesZ_); }
+    /// Return path search time budget in milliseconds.
+    float GetPathBudget() const { return pathBudget_; }
+    /// Return whether hierarchical pathfinding is used.
+    bool GetHierarchicalPathfinding() const { return hierarchicalPathfinding_; }
+    /// Return number of queued or active path requests.
+    unsigned GetNumPathRequests() const;
+    /// Return whether dirty tiles are rebuilt automatically.
+    bool GetRebuildDirtyTiles() const { return rebuildDirtyTiles_; }
+    /// Return whether any navigation mesh rebuilds dirty tiles automatically.
+    static bool IsDirtyTileRebuildInUse();
+    /// Return whether tiles are waiting to be rebuilt or being rebuilt in the background.
+    bool IsRebuilding() const { return !dirtyTiles_.Empty() || !dirtyNavigables_.Empty() || !pendingTiles_.Empty(); }
 
     /// Set the partition type used for polygon generation.
     void SetPartitionType(NavmeshPartitionType aType);
@@ -199,6 +228,32 @@ protected:
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
     /// Build one tile of the navigation mesh. Return true if successful.
     virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// Build several tiles of the navigation mesh, in the work queue's threads if available. Return number of tiles built.
+    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const PODVector<IntVector2>& tiles);
+    /// Set up a tile build and collect its geometry. Must be called from the main thread.
+    void PrepareTile(NavTileBuild& tile, Vector<NavigationGeometryInfo>& geometryList);
+    /// Replace a tile of the navigation mesh with the result of a tile build and send the rebuild event. Return true if successful.
+    bool AddTile(NavTileBuild& tile);
+    /// Mark that tiles have been added, removed or replaced, so that the region graph of hierarchical pathfinding is updated before the next path search.
+    void MarkPathHierarchyDirty();
+    /// Return the tile containing a local space position, clamped to the navigation mesh.
+    IntVector2 GetTileIndex(const Vector3& position) const;
+    /// Mark the tiles intersecting a local space bounding box for rebuilding.
+    void MarkTilesDirty(const BoundingBox& localSpaceBox);
+    /// Convert moved Navigable components to dirty tiles, using their old and new geometry bounds.
+    void UpdateDirtyNavigables();
+    /// Start rebuilding the dirty tiles. Called after the scene update.
+    virtual void RebuildDirtyTiles();
+    /// Cancel background tile builds. Waits for the ones already started.
+    void CancelPendingTiles();
+    /// Advance the queued path searches and send the events of the finished ones.
+    void UpdatePathRequests();
+    /// Cancel all path requests and return their IDs.
+    void ClearPathRequests(PODVector<unsigned>& cancelledIds);
+    /// Handle the scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle a work item completing.
+    void HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
     /// Release the navigation mesh and the query.
@@ -214,6 +269,14 @@ protected:
     dtQueryFilter* queryFilter_;
     /// Temporary data for finding a path.
     FindPathData* pathData_;
+    /// Queued path requests and the queries to process them.
+    NavPathQueue* pathQueue_;
+    /// Path search time budget per thread and frame in milliseconds.
+    float pathBudget_;
+    /// Graph of connected tile regions for hierarchical pathfinding.
+    NavPathHierarchy* pathHierarchy_;
+    /// Hierarchical pathfinding flag.
+    bool hierarchicalPathfinding_;
     /// Tile size.
     int tileSize_;
     /// Cell size.
@@ -255,6 +318,16 @@ protected:
     bool keepInterResults_;
     /// Internal build resources for creating the navmesh.
     HashMap<Pair<int, int>, NavBuildData*> builds_;
+    /// Rebuild dirty tiles flag.
+    bool rebuildDirtyTiles_;
+    /// Tiles waiting to be rebuilt.
+    HashSet<Pair<int, int> > dirtyTiles_;
+    /// Navigable components moved since the last rebuild.
+    HashSet<WeakPtr<Navigable> > dirtyNavigables_;
+    /// Local space geometry bounds of each Navigable when its geometry was last collected.
+    HashMap<Navigable*, BoundingBox> navigableBounds_;
+    /// Tile builds running in the background.
+    PODVector<NavTileBuild*> pendingTiles_;
 };
 
 /// Register Navigation library objects.
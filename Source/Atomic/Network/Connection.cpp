@@ -54,6 +54,18 @@ PackageDownload::PackageDownload() :
 {
 }
 
+RemoteEventBatch::RemoteEventBatch() :
+    messageStart_(0)
+{
+}
+
+void RemoteEventBatch::Clear()
+{
+    data_.Clear();
+    splits_.Clear();
+    messageStart_ = 0;
+}
+
 PackageUpload::PackageUpload() :
     fragment_(0),
     totalFragments_(0)
@@ -126,38 +138,54 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const unsig
 
 void Connection::SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
-    RemoteEvent queuedEvent;
-    queuedEvent.senderID_ = 0;
-    queuedEvent.eventType_ = eventType;
-    queuedEvent.eventData_ = eventData;
-    queuedEvent.inOrder_ = inOrder;
-    remoteEvents_.Push(queuedEvent);
+    BeginRemoteEvent(0, eventType, inOrder, 0).WriteVariantMap(eventData);
 }
 
 void Connection::SendRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
-    if (!node)
-    {
-        LOGERROR("Null sender node for remote node event");
+    if (!CheckRemoteEventSender(node))
         return;
-    }
-    if (node->GetScene() != scene_)
+    
+    BeginRemoteEvent(node->GetID(), eventType, inOrder, REMOTEEVENT_NODE).WriteVariantMap(eventData);
+}
+
+void Connection::SendRawRemoteEvent(StringHash eventType, bool inOrder, const void* data, unsigned numBytes)
+{
+    QueueRemoteEvent(0, eventType, inOrder, REMOTEEVENT_RAW, (const unsigned char*)data, numBytes);
+}
+
+void Connection::SendRawRemoteEvent(Node* node, StringHash eventType, bool inOrder, const void* data, unsigned numBytes)
+{
+    if (!CheckRemoteEventSender(node))
+        return;
+    
+    QueueRemoteEvent(node->GetID(), eventType, inOrder, REMOTEEVENT_NODE | REMOTEEVENT_RAW, (const unsigned char*)data,
+        numBytes);
+}
+
+void Connection::QueueRemoteEvent(unsigned senderID, StringHash eventType, bool inOrder, unsigned char flags,
+    const unsigned char* data, unsigned numBytes)
+{
+    if (numBytes && !data)
     {
-        LOGERROR("Sender node is not in the connection's scene, can not send remote node event");
+        LOGERROR("Null pointer supplied for remote event data");
         return;
     }
-    if (node->GetID() >= FIRST_LOCAL_ID)
+    
+    if (flags & REMOTEEVENT_RAW)
     {
-        LOGERROR("Sender node has a local ID, can not send remote node event");
-        return;
+        unsigned layoutSize = GetSubsystem<Network>()->GetRawRemoteEventSize(eventType);
+        if (layoutSize && layoutSize != numBytes)
+        {
+            LOGERROR("Raw remote event " + eventType.ToString() + " payload size does not match its registered layout");
+            return;
+        }
     }
     
-    RemoteEvent queuedEvent;
-    queuedEvent.senderID_ = node->GetID();
-    queuedEvent.eventType_ = eventType;
-    queuedEvent.eventData_ = eventData;
-    queuedEvent.inOrder_ = inOrder;
-    remoteEvents_.Push(queuedEvent);
+    VectorBuffer& dest = BeginRemoteEvent(senderID, eventType, inOrder, flags);
+    if (flags & REMOTEEVENT_RAW)
+        dest.WriteVLE(numBytes);
+    dest.Write(data, numBytes);
 }
 
 void Connection::SetScene(Scene* newScene)
@@ -296,30 +324,31 @@ void Connection::SendRemoteEvents()
     }
     #endif
     
-    if (remoteEvents_.Empty())
+    if (!orderedRemoteEvents_.data_.GetSize() && !unorderedRemoteEvents_.data_.GetSize())
         return;
     
     PROFILE(SendRemoteEvents);
     
-    for (Vector<RemoteEvent>::ConstIterator i = remoteEvents_.Begin(); i != remoteEvents_.End(); ++i)
+    for (unsigned i = 0; i < 2; ++i)
     {
-        msg_.Clear();
-        if (!i->senderID_)
-        {
-            msg_.WriteStringHash(i->eventType_);
-            msg_.WriteVariantMap(i->eventData_);
-            SendMessage(MSG_REMOTEEVENT, true, i->inOrder_, msg_);
-        }
-        else
+        bool inOrder = i == 0;
+        RemoteEventBatch& batch = inOrder ? orderedRemoteEvents_ : unorderedRemoteEvents_;
+        const unsigned char* data = batch.data_.GetData();
+        unsigned size = batch.data_.GetSize();
+        if (!size)
+            continue;
+        
+        // Send all events queued during this update as few messages as possible
+        unsigned start = 0;
+        for (unsigned j = 0; j < batch.splits_.Size(); ++j)
         {
-            msg_.WriteNetID(i->senderID_);
-            msg_.WriteStringHash(i->eventType_);
-            msg_.WriteVariantMap(i->eventData_);
-            SendMessage(MSG_REMOTENODEEVENT, true, i->inOrder_, msg_);
+            SendMessage(MSG_REMOTEEVENTBATCH, true, inOrder, data + start, batch.splits_[j] - start);
+            start = batch.splits_[j];
         }
+        SendMessage(MSG_REMOTEEVENTBATCH, true, inOrder, data + start, size - start);
+        
+        batch.Clear();
     }
-    
-    remoteEvents_.Clear();
 }
 
 void Connection::SendPackages()
@@ -431,6 +460,10 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer &msg)
         case MSG_REMOTENODEEVENT:
             ProcessRemoteEvent(msgID, msg);
             break;
+            
+        case MSG_REMOTEEVENTBATCH:
+            ProcessRemoteEventBatch(msgID, msg);
+            break;
 
         case MSG_PACKAGEINFO:
             ProcessPackageInfo(msgID, msg);
@@ -929,48 +962,148 @@ void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
 }
 
 void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
+{
+    unsigned senderID = msgID == MSG_REMOTENODEEVENT ? msg.ReadNetID() : 0;
+    StringHash eventType = msg.ReadStringHash();
+    if (!GetSubsystem<Network>()->CheckRemoteEvent(eventType))
+    {
+        LOGWARNING("Discarding not allowed remote event " + eventType.ToString());
+        return;
+    }
+    
+    VariantMap& eventData = GetEventDataMap();
+    unsigned numVars = msg.ReadVLE();
+    for (unsigned i = 0; i < numVars; ++i)
+    {
+        StringHash key = msg.ReadStringHash();
+        eventData[key] = msg.ReadVariant();
+    }
+    
+    DispatchRemoteEvent(senderID, eventType, eventData);
+}
+
+void Connection::ProcessRemoteEventBatch(int msgID, MemoryBuffer& msg)
 {
     using namespace RemoteEventData;
     
-    if (msgID == MSG_REMOTEEVENT)
+    Network* network = GetSubsystem<Network>();
+    
+    while (!msg.IsEof())
     {
+        unsigned char flags = msg.ReadUByte();
+        unsigned senderID = (flags & REMOTEEVENT_NODE) ? msg.ReadNetID() : 0;
         StringHash eventType = msg.ReadStringHash();
-        if (!GetSubsystem<Network>()->CheckRemoteEvent(eventType))
-        {
+        bool allowed = network->CheckRemoteEvent(eventType);
+        if (!allowed)
             LOGWARNING("Discarding not allowed remote event " + eventType.ToString());
-            return;
-        }
         
-        VariantMap eventData = msg.ReadVariantMap();
-        eventData[P_CONNECTION] = this;
-        SendEvent(eventType, eventData);
-    }
-    else
-    {
-        if (!scene_)
+        // Read into the context's reusable event data map to avoid allocating a new map per event
+        VariantMap& eventData = GetEventDataMap();
+        if (flags & REMOTEEVENT_RAW)
         {
-            LOGERROR("Can not receive remote node event without an assigned scene");
-            return;
+            unsigned numBytes = msg.ReadVLE();
+            unsigned position = msg.GetPosition();
+            if (position + numBytes > msg.GetSize())
+            {
+                LOGERROR("Malformed remote event batch from " + ToString());
+                return;
+            }
+            msg.Seek(position + numBytes);
+            
+            if (allowed && numBytes != network->GetRawRemoteEventSize(eventType))
+            {
+                LOGWARNING("Discarding raw remote event " + eventType.ToString() + " with mismatching payload size");
+                allowed = false;
+            }
+            if (!allowed)
+                continue;
+            
+            // The payload is passed by pointer into the message data and is only valid during the event
+            eventData[P_DATA] = (void*)(msg.GetData() + position);
+            eventData[P_SIZE] = numBytes;
         }
-        
-        unsigned nodeID = msg.ReadNetID();
-        StringHash eventType = msg.ReadStringHash();
-        if (!GetSubsystem<Network>()->CheckRemoteEvent(eventType))
+        else
         {
-            LOGWARNING("Discarding not allowed remote event " + eventType.ToString());
-            return;
+            unsigned numVars = msg.ReadVLE();
+            for (unsigned i = 0; i < numVars; ++i)
+            {
+                StringHash key = msg.ReadStringHash();
+                eventData[key] = msg.ReadVariant();
+            }
+            if (!allowed)
+                continue;
         }
         
-        VariantMap eventData = msg.ReadVariantMap();
-        Node* sender = scene_->GetNode(nodeID);
-        if (!sender)
-        {
-            LOGWARNING("Missing sender for remote node event, discarding");
-            return;
-        }
+        DispatchRemoteEvent(senderID, eventType, eventData);
+    }
+}
+
+void Connection::DispatchRemoteEvent(unsigned senderID, StringHash eventType, VariantMap& eventData)
+{
+    using namespace RemoteEventData;
+    
+    if (!senderID)
+    {
         eventData[P_CONNECTION] = this;
-        sender->SendEvent(eventType, eventData);
+        SendEvent(eventType, eventData);
+        return;
+    }
+    
+    if (!scene_)
+    {
+        LOGERROR("Can not receive remote node event without an assigned scene");
+        return;
+    }
+    
+    Node* sender = scene_->GetNode(senderID);
+    if (!sender)
+    {
+        LOGWARNING("Missing sender for remote node event, discarding");
+        return;
+    }
+    eventData[P_CONNECTION] = this;
+    sender->SendEvent(eventType, eventData);
+}
+
+bool Connection::CheckRemoteEventSender(Node* node) const
+{
+    if (!node)
+    {
+        LOGERROR("Null sender node for remote node event");
+        return false;
+    }
+    if (node->GetScene() != scene_)
+    {
+        LOGERROR("Sender node is not in the connection's scene, can not send remote node event");
+        return false;
+    }
+    if (node->GetID() >= FIRST_LOCAL_ID)
+    {
+        LOGERROR("Sender node has a local ID, can not send remote node event");
+        return false;
+    }
+    
+    return true;
+}
+
+VectorBuffer& Connection::BeginRemoteEvent(unsigned senderID, StringHash eventType, bool inOrder, unsigned char flags)
+{
+    RemoteEventBatch& batch = inOrder ? orderedRemoteEvents_ : unorderedRemoteEvents_;
+    VectorBuffer& dest = batch.data_;
+    
+    // Start a new message if the current one has grown large enough
+    unsigned size = dest.GetSize();
+    if (size - batch.messageStart_ >= REMOTEEVENT_BATCH_SIZE)
+    {
+        batch.splits_.Push(size);
+        batch.messageStart_ = size;
     }
+    
+    dest.WriteUByte(flags);
+    if (flags & REMOTEEVENT_NODE)
+        dest.WriteNetID(senderID);
+    dest.WriteStringHash(eventType);
+    return dest;
 }
 
 kNet::MessageConnection* Connection::GetMessageConnection() const
@@ -46,17 +46,25 @@ class Scene;
 class Serializable;
 class PackageFile;
 
-/// Queued remote event.
-struct RemoteEvent
+/// Remote event batch entry flags.
+static const unsigned char REMOTEEVENT_NODE = 0x1;
+static const unsigned char REMOTEEVENT_RAW = 0x2;
+
+/// Queued remote events of one ordering mode, serialized into a reusable buffer and sent as batch messages.
+struct RemoteEventBatch
 {
-    /// Remote sender node ID (0 if not a remote node event.)
-    unsigned senderID_;
-    /// Event type.
-    StringHash eventType_;
-    /// Event data.
-    VariantMap eventData_;
-    /// In order flag.
-    bool inOrder_;
+    /// Construct.
+    RemoteEventBatch();
+    
+    /// Clear the queued events. Keeps the allocated buffers for reuse.
+    void Clear();
+    
+    /// Serialized remote events.
+    VectorBuffer data_;
+    /// Offsets at which the data is split into separate messages.
+    PODVector<unsigned> splits_;
+    /// Start offset of the message currently being filled.
+    unsigned messageStart_;
 };
 
 /// Package file receive transfer.
@@ -120,6 +128,12 @@ public:
     void SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
     /// Send a remote event with the specified node as sender.
     void SendRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
+    /// Send a fixed-layout remote event. The payload is sent as-is without Variant serialization. The receiver must have registered the event with Network::RegisterRawRemoteEvent using the same payload size.
+    void SendRawRemoteEvent(StringHash eventType, bool inOrder, const void* data, unsigned numBytes);
+    /// Send a fixed-layout remote event with the specified node as sender.
+    void SendRawRemoteEvent(Node* node, StringHash eventType, bool inOrder, const void* data, unsigned numBytes);
+    /// Queue an already serialized remote event payload. Called by Network.
+    void QueueRemoteEvent(unsigned senderID, StringHash eventType, bool inOrder, unsigned char flags, const unsigned char* data, unsigned numBytes);
     /// Assign scene. On the server, this will cause the client to load it.
     void SetScene(Scene* newScene);
     /// Assign identity. Called by Network.
@@ -217,6 +231,14 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Process a remote event batch message from the client or server. Called by Network.
+    void ProcessRemoteEventBatch(int msgID, MemoryBuffer& msg);
+    /// Dispatch a received remote event, either globally or from the sender node.
+    void DispatchRemoteEvent(unsigned senderID, StringHash eventType, VariantMap& eventData);
+    /// Check that a remote node event sender is valid.
+    bool CheckRemoteEventSender(Node* node) const;
+    /// Begin a remote event entry in the queue of the given ordering mode and return the buffer to write the payload to.
+    VectorBuffer& BeginRemoteEvent(unsigned senderID, StringHash eventType, bool inOrder, unsigned char flags);
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
@@ -256,8 +278,10 @@ private:
     HashSet<unsigned> nodesToProcess_;
     /// Reusable message buffer.
     VectorBuffer msg_;
-    /// Queued remote events.
-    Vector<RemoteEvent> remoteEvents_;
+    /// Queued in order remote events.
+    RemoteEventBatch orderedRemoteEvents_;
+    /// Queued unordered remote events.
+    RemoteEventBatch unorderedRemoteEvents_;
     /// Scene file to load once all packages (if any) have been downloaded.
     String sceneFileName_;
     /// Statistics timer.
@@ -296,19 +296,17 @@ void Network::BroadcastMessage(int msgID, bool reliable, bool inOrder, const uns
 
 void Network::BroadcastRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
-    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
-        i != clientConnections_.End(); ++i)
-        i->second_->SendRemoteEvent(eventType, inOrder, eventData);
+    // Serialize once, then copy the payload to each connection's remote event queue
+    remoteEventBuffer_.Clear();
+    remoteEventBuffer_.WriteVariantMap(eventData);
+    QueueRemoteEvent(0, false, 0, eventType, inOrder, 0, remoteEventBuffer_.GetData(), remoteEventBuffer_.GetSize());
 }
 
 void Network::BroadcastRemoteEvent(Scene* scene, StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
-    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
-        i != clientConnections_.End(); ++i)
-    {
-        if (i->second_->GetScene() == scene)
-            i->second_->SendRemoteEvent(eventType, inOrder, eventData);
-    }
+    remoteEventBuffer_.Clear();
+    remoteEventBuffer_.WriteVariantMap(eventData);
+    QueueRemoteEvent(scene, true, 0, eventType, inOrder, 0, remoteEventBuffer_.GetData(), remoteEventBuffer_.GetSize());
 }
 
 void Network::BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData)
@@ -324,13 +322,37 @@ void Network::BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrde
         return;
     }
     
-    Scene* scene = node->GetScene();
-    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
-        i != clientConnections_.End(); ++i)
+    remoteEventBuffer_.Clear();
+    remoteEventBuffer_.WriteVariantMap(eventData);
+    QueueRemoteEvent(node->GetScene(), true, node->GetID(), eventType, inOrder, REMOTEEVENT_NODE, remoteEventBuffer_.GetData(),
+        remoteEventBuffer_.GetSize());
+}
+
+void Network::BroadcastRawRemoteEvent(StringHash eventType, bool inOrder, const void* data, unsigned numBytes)
+{
+    QueueRemoteEvent(0, false, 0, eventType, inOrder, REMOTEEVENT_RAW, (const unsigned char*)data, numBytes);
+}
+
+void Network::BroadcastRawRemoteEvent(Scene* scene, StringHash eventType, bool inOrder, const void* data, unsigned numBytes)
+{
+    QueueRemoteEvent(scene, true, 0, eventType, inOrder, REMOTEEVENT_RAW, (const unsigned char*)data, numBytes);
+}
+
+void Network::BroadcastRawRemoteEvent(Node* node, StringHash eventType, bool inOrder, const void* data, unsigned numBytes)
+{
+    if (!node)
     {
-        if (i->second_->GetScene() == scene)
-            i->second_->SendRemoteEvent(node, eventType, inOrder, eventData);
+        LOGERROR("Null sender node for remote node event");
+        return;
     }
+    if (node->GetID() >= FIRST_LOCAL_ID)
+    {
+        LOGERROR("Sender node has a local ID, can not send remote node event");
+        return;
+    }
+    
+    QueueRemoteEvent(node->GetScene(), true, node->GetID(), eventType, inOrder, REMOTEEVENT_NODE | REMOTEEVENT_RAW,
+        (const unsigned char*)data, numBytes);
 }
 
 void Network::SetUpdateFps(int fps)
@@ -361,16 +383,36 @@ void Network::RegisterRemoteEvent(StringHash eventType)
     }
     
     allowedRemoteEvents_.Insert(eventType);
+    rawRemoteEventSizes_.Erase(eventType);
+}
+
+void Network::RegisterRawRemoteEvent(StringHash eventType, unsigned payloadSize)
+{
+    if (blacklistedRemoteEvents_.Find(eventType) != blacklistedRemoteEvents_.End())
+    {
+        LOGERROR("Attempted to register blacklisted remote event type " + String(eventType));
+        return;
+    }
+    if (!payloadSize)
+    {
+        LOGERROR("Attempted to register raw remote event type " + String(eventType) + " with zero payload size");
+        return;
+    }
+    
+    allowedRemoteEvents_.Insert(eventType);
+    rawRemoteEventSizes_[eventType] = payloadSize;
 }
 
 void Network::UnregisterRemoteEvent(StringHash eventType)
 {
     allowedRemoteEvents_.Erase(eventType);
+    rawRemoteEventSizes_.Erase(eventType);
 }
 
 void Network::UnregisterAllRemoteEvents()
 {
     allowedRemoteEvents_.Clear();
+    rawRemoteEventSizes_.Clear();
 }
 
 void Network::SetPackageCacheDir(const String& path)
@@ -447,6 +489,12 @@ bool Network::CheckRemoteEvent(StringHash eventType) const
     return allowedRemoteEvents_.Contains(eventType);
 }
 
+unsigned Network::GetRawRemoteEventSize(StringHash eventType) const
+{
+    HashMap<StringHash, unsigned>::ConstIterator i = rawRemoteEventSizes_.Find(eventType);
+    return i != rawRemoteEventSizes_.End() ? i->second_ : 0;
+}
+
 void Network::Update(float timeStep)
 {
     PROFILE(UpdateNetwork);
@@ -593,6 +641,17 @@ void Network::ConfigureNetworkSimulator()
         i->second_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
 }
 
+void Network::QueueRemoteEvent(Scene* scene, bool sceneOnly, unsigned senderID, StringHash eventType, bool inOrder, unsigned char flags,
+    const unsigned char* data, unsigned numBytes)
+{
+    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
+        i != clientConnections_.End(); ++i)
+    {
+        if (!sceneOnly || i->second_->GetScene() == scene)
+            i->second_->QueueRemoteEvent(senderID, eventType, inOrder, flags, data, numBytes);
+    }
+}
+
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
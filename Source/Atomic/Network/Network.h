@@ -81,6 +81,12 @@ public:
     void BroadcastRemoteEvent(Scene* scene, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
     /// Broadcast a remote event with the specified node as a sender. Is sent to all client connections in the node's scene.
     void BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
+    /// Broadcast a fixed-layout remote event to all client connections.
+    void BroadcastRawRemoteEvent(StringHash eventType, bool inOrder, const void* data, unsigned numBytes);
+    /// Broadcast a fixed-layout remote event to all client connections in a specific scene.
+    void BroadcastRawRemoteEvent(Scene* scene, StringHash eventType, bool inOrder, const void* data, unsigned numBytes);
+    /// Broadcast a fixed-layout remote event with the specified node as a sender. Is sent to all client connections in the node's scene.
+    void BroadcastRawRemoteEvent(Node* node, StringHash eventType, bool inOrder, const void* data, unsigned numBytes);
     /// Set network update FPS.
     void SetUpdateFps(int fps);
     /// Set simulated latency in milliseconds. This adds a fixed delay before sending each packet.
@@ -89,6 +95,8 @@ public:
     void SetSimulatedPacketLoss(float probability);
     /// Register a remote event as allowed to be received. There is also a fixed blacklist of events that can not be allowed in any case, such as ConsoleCommand.
     void RegisterRemoteEvent(StringHash eventType);
+    /// Register a fixed-layout remote event as allowed to be received. Its payload is delivered as a pointer in the RemoteEventData P_DATA parameter instead of being deserialized into the event data map. Payloads of a different size are discarded.
+    void RegisterRawRemoteEvent(StringHash eventType, unsigned payloadSize);
     /// Unregister a remote event as allowed to received.
     void UnregisterRemoteEvent(StringHash eventType);
     /// Unregister all remote events.
@@ -116,6 +124,8 @@ public:
     bool IsServerRunning() const;
     /// Return whether a remote event is allowed to be received.
     bool CheckRemoteEvent(StringHash eventType) const;
+    /// Return the registered payload size of a fixed-layout remote event, or 0 if not registered as one.
+    unsigned GetRawRemoteEventSize(StringHash eventType) const;
     /// Return the package download cache directory.
     const String& GetPackageCacheDir() const { return packageCacheDir_; }
     
@@ -135,6 +145,8 @@ private:
     void OnServerDisconnected();
     /// Reconfigure network simulator parameters on all existing connections.
     void ConfigureNetworkSimulator();
+    /// Queue a serialized remote event payload to all client connections, or only those in the specified scene.
+    void QueueRemoteEvent(Scene* scene, bool sceneOnly, unsigned senderID, StringHash eventType, bool inOrder, unsigned char flags, const unsigned char* data, unsigned numBytes);
     
     /// kNet instance.
     kNet::Network* network_;
@@ -144,6 +156,8 @@ private:
     HashMap<kNet::MessageConnection*, SharedPtr<Connection> > clientConnections_;
     /// Allowed remote events.
     HashSet<StringHash> allowedRemoteEvents_;
+    /// Payload sizes of allowed fixed-layout remote events.
+    HashMap<StringHash, unsigned> rawRemoteEventSizes_;
     /// Remote event fixed blacklist.
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
@@ -160,6 +174,8 @@ private:
     float updateAcc_;
     /// Package cache directory.
     String packageCacheDir_;
+    /// Reusable buffer for serializing broadcast remote events once for all connections.
+    VectorBuffer remoteEventBuffer_;
 };
 
 /// Register Network library objects.
@@ -95,6 +95,8 @@ EVENT(E_NETWORKSCENELOADFAILED, NetworkSceneLoadFailed)
 EVENT(E_REMOTEEVENTDATA, RemoteEventData)
 {
     PARAM(P_CONNECTION, Connection);      // Connection pointer
+    PARAM(P_DATA, Data);                  // Void pointer to the payload of a raw remote event, valid only during the event
+    PARAM(P_SIZE, Size);                  // unsigned, payload size of a raw remote event
 }
 
 }
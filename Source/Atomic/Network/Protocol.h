@@ -63,10 +63,14 @@ static const int MSG_REMOTEEVENT = 0x14;
 static const int MSG_REMOTENODEEVENT = 0x15;
 /// Server->client: info about package.
 static const int MSG_PACKAGEINFO = 0x16;
+/// Client->server and server->client: batch of remote events and remote node events queued during one network update.
+static const int MSG_REMOTEEVENTBATCH = 0x17;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
+/// Remote event batch size after which further events are sent in a new message.
+static const unsigned REMOTEEVENT_BATCH_SIZE = 1024;
 
 }
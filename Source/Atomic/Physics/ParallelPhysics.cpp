@@ -0,0 +1,356 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Core/Context.h"
+#include "../Physics/ParallelPhysics.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
+
+#include <Bullet/src/BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h>
+#include <Bullet/src/BulletCollision/BroadphaseCollision/btOverlappingPairCache.h>
+#include <Bullet/src/BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <Bullet/src/BulletCollision/CollisionDispatch/btManifoldResult.h>
+#include <Bullet/src/BulletDynamics/ConstraintSolver/btTypedConstraint.h>
+#include <Bullet/src/BulletDynamics/Dynamics/btRigidBody.h>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Minimum number of overlapping pairs before the narrowphase is split into work items.
+static const unsigned MIN_PARALLEL_PAIRS = 64;
+/// Minimum number of islands before they are split into work items.
+static const unsigned MIN_PARALLEL_ISLANDS = 2;
+
+void ProcessCollisionPairsWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParallelCollisionDispatcher* dispatcher = reinterpret_cast<ParallelCollisionDispatcher*>(item->aux_);
+    btBroadphasePair** start = reinterpret_cast<btBroadphasePair**>(item->start_);
+    btBroadphasePair** end = reinterpret_cast<btBroadphasePair**>(item->end_);
+
+    while (start != end)
+    {
+        dispatcher->ProcessPair(**start);
+        ++start;
+    }
+}
+
+void SolveIslandsWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParallelConstraintSolver* solver = reinterpret_cast<ParallelConstraintSolver*>(item->aux_);
+    unsigned start = (unsigned)(size_t)item->start_;
+    unsigned end = (unsigned)(size_t)item->end_;
+
+    while (start != end)
+    {
+        solver->SolveIsland(start, threadIndex);
+        ++start;
+    }
+}
+
+static bool IsKinematic(const btCollisionObject* object)
+{
+    return object && object->isKinematicObject();
+}
+
+ParallelCollisionDispatcher::ParallelCollisionDispatcher(Context* context, btCollisionConfiguration* collisionConfiguration) :
+    btCollisionDispatcher(collisionConfiguration),
+    context_(context),
+    dispatchInfo_(0),
+    enabled_(false)
+{
+}
+
+btPersistentManifold* ParallelCollisionDispatcher::getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1)
+{
+    MutexLock lock(poolMutex_);
+    return btCollisionDispatcher::getNewManifold(b0, b1);
+}
+
+void ParallelCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
+{
+    MutexLock lock(poolMutex_);
+    btCollisionDispatcher::releaseManifold(manifold);
+}
+
+void* ParallelCollisionDispatcher::allocateCollisionAlgorithm(int size)
+{
+    MutexLock lock(poolMutex_);
+    return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+}
+
+void ParallelCollisionDispatcher::freeCollisionAlgorithm(void* ptr)
+{
+    MutexLock lock(poolMutex_);
+    btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+}
+
+void ParallelCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo,
+    btDispatcher* dispatcher)
+{
+    WorkQueue* queue = context_->GetSubsystem<WorkQueue>();
+
+    // Continuous dispatch accumulates the time of impact into the shared dispatch info, and a custom near callback
+    // can not be assumed to be thread-safe, so fall back to the serial path for those. The work queue can only be
+    // used from the main thread, so a threaded simulation step also runs serially
+    if (!enabled_ || !queue || !queue->GetNumThreads() || !Thread::IsMainThread() ||
+        dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE || getNearCallback() != defaultNearCallback ||
+        (unsigned)pairCache->getNumOverlappingPairs() < MIN_PARALLEL_PAIRS)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+        return;
+    }
+
+    // Filter the pairs and create missing collision algorithms serially, as the algorithm lookup is not thread-safe
+    btBroadphasePairArray& pairArray = pairCache->getOverlappingPairArray();
+    pairs_.Clear();
+
+    for (int i = 0; i < pairArray.size(); ++i)
+    {
+        btBroadphasePair& pair = pairArray[i];
+        btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+        btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+
+        if (!needsCollision(colObj0, colObj1))
+            continue;
+
+        if (!pair.m_algorithm)
+        {
+            btCollisionObjectWrapper obj0Wrap(0, colObj0->getCollisionShape(), colObj0, colObj0->getWorldTransform(), -1, -1);
+            btCollisionObjectWrapper obj1Wrap(0, colObj1->getCollisionShape(), colObj1, colObj1->getWorldTransform(), -1, -1);
+            pair.m_algorithm = findAlgorithm(&obj0Wrap, &obj1Wrap);
+        }
+
+        if (pair.m_algorithm)
+            pairs_.Push(&pair);
+    }
+
+    if (pairs_.Empty())
+        return;
+
+    dispatchInfo_ = &dispatchInfo;
+
+    int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+    int pairsPerItem = Max((int)(pairs_.Size() / numWorkItems), 1);
+
+    PODVector<btBroadphasePair*>::Iterator start = pairs_.Begin();
+    // Create a work item for each thread
+    for (int i = 0; i < numWorkItems; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ProcessCollisionPairsWork;
+        item->aux_ = this;
+
+        PODVector<btBroadphasePair*>::Iterator end = pairs_.End();
+        if (i < numWorkItems - 1 && end - start > pairsPerItem)
+            end = start + pairsPerItem;
+
+        item->start_ = &(*start);
+        item->end_ = &(*end);
+        queue->AddWorkItem(item);
+
+        start = end;
+        if (start == pairs_.End())
+            break;
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+    dispatchInfo_ = 0;
+}
+
+void ParallelCollisionDispatcher::ProcessPair(btBroadphasePair& pair)
+{
+    btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+    btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+
+    btCollisionObjectWrapper obj0Wrap(0, colObj0->getCollisionShape(), colObj0, colObj0->getWorldTransform(), -1, -1);
+    btCollisionObjectWrapper obj1Wrap(0, colObj1->getCollisionShape(), colObj1, colObj1->getWorldTransform(), -1, -1);
+    btManifoldResult contactPointResult(&obj0Wrap, &obj1Wrap);
+
+    pair.m_algorithm->processCollision(&obj0Wrap, &obj1Wrap, *dispatchInfo_, &contactPointResult);
+}
+
+ParallelConstraintSolver::ParallelConstraintSolver(Context* context) :
+    context_(context),
+    info_(0),
+    debugDrawer_(0),
+    dispatcher_(0),
+    enabled_(false),
+    deferring_(false)
+{
+}
+
+ParallelConstraintSolver::~ParallelConstraintSolver()
+{
+    for (unsigned i = 0; i < threadSolvers_.Size(); ++i)
+        delete threadSolvers_[i];
+}
+
+void ParallelConstraintSolver::prepareSolve(int numBodies, int numManifolds)
+{
+    islands_.Clear();
+    serialIslands_.Clear();
+    bodies_.Clear();
+    manifolds_.Clear();
+    constraints_.Clear();
+
+    // The work queue can only be used from the main thread, so a threaded simulation step solves serially
+    WorkQueue* queue = context_->GetSubsystem<WorkQueue>();
+    deferring_ = enabled_ && queue && queue->GetNumThreads() && Thread::IsMainThread();
+
+    if (deferring_)
+    {
+        unsigned numThreads = queue->GetNumThreads() + 1;
+        while (threadSolvers_.Size() < numThreads)
+            threadSolvers_.Push(new btSequentialImpulseConstraintSolver());
+    }
+}
+
+btScalar ParallelConstraintSolver::solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds,
+    int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info,
+    btIDebugDraw* debugDrawer, btDispatcher* dispatcher)
+{
+    if (!deferring_)
+    {
+        return btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies, manifolds, numManifolds, constraints,
+            numConstraints, info, debugDrawer, dispatcher);
+    }
+
+    info_ = &info;
+    debugDrawer_ = debugDrawer;
+    dispatcher_ = dispatcher;
+    AddIsland(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints);
+    return 0.0f;
+}
+
+void ParallelConstraintSolver::allSolved(const btContactSolverInfo& info, btIDebugDraw* debugDrawer)
+{
+    if (!deferring_)
+        return;
+
+    deferring_ = false;
+
+    if (islands_.Size() < MIN_PARALLEL_ISLANDS)
+    {
+        // Not worth splitting, solve everything on the main thread
+        for (unsigned i = 0; i < islands_.Size(); ++i)
+            SolveIsland(i, 0);
+    }
+    else
+    {
+        WorkQueue* queue = context_->GetSubsystem<WorkQueue>();
+
+        int numWorkItems = Min((int)islands_.Size(), (int)queue->GetNumThreads() + 1);
+        int islandsPerItem = Max((int)(islands_.Size() / numWorkItems), 1);
+
+        unsigned start = 0;
+        for (int i = 0; i < numWorkItems; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = SolveIslandsWork;
+            item->aux_ = this;
+
+            unsigned end = islands_.Size();
+            if (i < numWorkItems - 1 && end - start > (unsigned)islandsPerItem)
+                end = start + islandsPerItem;
+
+            item->start_ = (void*)(size_t)start;
+            item->end_ = (void*)(size_t)end;
+            queue->AddWorkItem(item);
+
+            start = end;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+
+    // Islands sharing kinematic bodies would race on the bodies' solver indices, so solve them one by one
+    for (unsigned i = 0; i < serialIslands_.Size(); ++i)
+    {
+        const Island& island = serialIslands_[i];
+        btSequentialImpulseConstraintSolver::solveGroup(island.numBodies_ ? &bodies_[island.bodyStart_] : 0, island.numBodies_,
+            island.numManifolds_ ? &manifolds_[island.manifoldStart_] : 0, island.numManifolds_,
+            island.numConstraints_ ? &constraints_[island.constraintStart_] : 0, island.numConstraints_, *info_, debugDrawer_,
+            dispatcher_);
+    }
+}
+
+void ParallelConstraintSolver::reset()
+{
+    btSequentialImpulseConstraintSolver::reset();
+
+    for (unsigned i = 0; i < threadSolvers_.Size(); ++i)
+        threadSolvers_[i]->reset();
+}
+
+void ParallelConstraintSolver::SolveIsland(unsigned index, unsigned threadIndex)
+{
+    const Island& island = islands_[index];
+    threadSolvers_[threadIndex]->solveGroup(island.numBodies_ ? &bodies_[island.bodyStart_] : 0, island.numBodies_,
+        island.numManifolds_ ? &manifolds_[island.manifoldStart_] : 0, island.numManifolds_,
+        island.numConstraints_ ? &constraints_[island.constraintStart_] : 0, island.numConstraints_, *info_, debugDrawer_,
+        dispatcher_);
+}
+
+void ParallelConstraintSolver::AddIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds,
+    int numManifolds, btTypedConstraint** constraints, int numConstraints)
+{
+    Island island;
+    island.bodyStart_ = bodies_.Size();
+    island.numBodies_ = (unsigned)numBodies;
+    island.manifoldStart_ = manifolds_.Size();
+    island.numManifolds_ = (unsigned)numManifolds;
+    island.constraintStart_ = constraints_.Size();
+    island.numConstraints_ = (unsigned)numConstraints;
+
+    // The arrays are reused by the island manager, so copy them
+    bool kinematic = false;
+    for (int i = 0; i < numBodies; ++i)
+        bodies_.Push(bodies[i]);
+
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        btPersistentManifold* manifold = manifolds[i];
+        if (IsKinematic(manifold->getBody0()) || IsKinematic(manifold->getBody1()))
+            kinematic = true;
+        manifolds_.Push(manifold);
+    }
+
+    for (int i = 0; i < numConstraints; ++i)
+    {
+        btTypedConstraint* constraint = constraints[i];
+        if (IsKinematic(&constraint->getRigidBodyA()) || IsKinematic(&constraint->getRigidBodyB()))
+            kinematic = true;
+        constraints_.Push(constraint);
+    }
+
+    if (kinematic)
+        serialIslands_.Push(island);
+    else
+        islands_.Push(island);
+}
+
+}
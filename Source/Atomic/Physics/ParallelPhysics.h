@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+#include <Bullet/src/BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <Bullet/src/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+
+namespace Atomic
+{
+
+class Context;
+
+/// %Collision dispatcher that runs the narrowphase of overlapping pairs in the work queue's threads.
+class ParallelCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+    /// Construct.
+    ParallelCollisionDispatcher(Context* context, btCollisionConfiguration* collisionConfiguration);
+
+    /// Set whether to process pairs in worker threads. When disabled, behaves exactly like btCollisionDispatcher.
+    void SetEnabled(bool enable) { enabled_ = enable; }
+    /// Return whether pairs are processed in worker threads.
+    bool IsEnabled() const { return enabled_; }
+
+    /// Create a new contact manifold. Thread-safe.
+    virtual btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1);
+    /// Release a contact manifold. Thread-safe.
+    virtual void releaseManifold(btPersistentManifold* manifold);
+    /// Allocate memory for a collision algorithm. Thread-safe.
+    virtual void* allocateCollisionAlgorithm(int size);
+    /// Free memory of a collision algorithm. Thread-safe.
+    virtual void freeCollisionAlgorithm(void* ptr);
+    /// Run the narrowphase for all overlapping pairs.
+    virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher);
+
+    /// Process one pair that already has a collision algorithm. Called by the work functions.
+    void ProcessPair(btBroadphasePair& pair);
+
+private:
+    /// Context.
+    Context* context_;
+    /// Pairs to process on the current dispatch.
+    PODVector<btBroadphasePair*> pairs_;
+    /// Dispatch info of the current dispatch.
+    const btDispatcherInfo* dispatchInfo_;
+    /// Mutex for the manifold and collision algorithm pools.
+    Mutex poolMutex_;
+    /// Enabled flag.
+    bool enabled_;
+};
+
+/// Constraint solver that solves simulation islands in the work queue's threads.
+class ParallelConstraintSolver : public btSequentialImpulseConstraintSolver
+{
+public:
+    /// Construct.
+    ParallelConstraintSolver(Context* context);
+    /// Destruct.
+    virtual ~ParallelConstraintSolver();
+
+    /// Set whether to solve islands in worker threads. When disabled, behaves exactly like btSequentialImpulseConstraintSolver.
+    void SetEnabled(bool enable) { enabled_ = enable; }
+    /// Return whether islands are solved in worker threads.
+    bool IsEnabled() const { return enabled_; }
+
+    /// Begin solving the islands of a simulation step.
+    virtual void prepareSolve(int numBodies, int numManifolds);
+    /// Solve an island, or record it to be solved in allSolved().
+    virtual btScalar solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btDispatcher* dispatcher);
+    /// Solve the recorded islands.
+    virtual void allSolved(const btContactSolverInfo& info, btIDebugDraw* debugDrawer);
+    /// Reset the solvers.
+    virtual void reset();
+
+    /// Solve a recorded island. Called by the work functions.
+    void SolveIsland(unsigned index, unsigned threadIndex);
+
+private:
+    /// Recorded simulation island.
+    struct Island
+    {
+        /// Index of first body.
+        unsigned bodyStart_;
+        /// Number of bodies.
+        unsigned numBodies_;
+        /// Index of first contact manifold.
+        unsigned manifoldStart_;
+        /// Number of contact manifolds.
+        unsigned numManifolds_;
+        /// Index of first constraint.
+        unsigned constraintStart_;
+        /// Number of constraints.
+        unsigned numConstraints_;
+    };
+
+    /// Record an island for solving later.
+    void AddIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, btTypedConstraint** constraints, int numConstraints);
+
+    /// Context.
+    Context* context_;
+    /// Per-thread solvers. Index 0 is the main thread.
+    PODVector<btSequentialImpulseConstraintSolver*> threadSolvers_;
+    /// Recorded islands that can be solved in parallel.
+    PODVector<Island> islands_;
+    /// Recorded islands that touch kinematic bodies. These are solved serially afterward, as the solver writes to all non-static bodies it touches.
+    PODVector<Island> serialIslands_;
+    /// Bodies of the recorded islands.
+    PODVector<btCollisionObject*> bodies_;
+    /// Contact manifolds of the recorded islands.
+    PODVector<btPersistentManifold*> manifolds_;
+    /// Constraints of the recorded islands.
+    PODVector<btTypedConstraint*> constraints_;
+    /// Solver info of the current step.
+    const btContactSolverInfo* info_;
+    /// Debug drawer of the current step.
+    btIDebugDraw* debugDrawer_;
+    /// Dispatcher of the current step.
+    btDispatcher* dispatcher_;
+    /// Enabled flag.
+    bool enabled_;
+    /// Recording islands on the current step flag.
+    bool deferring_;
+};
+
+}
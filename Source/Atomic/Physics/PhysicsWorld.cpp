@@ -23,15 +23,21 @@
 #include "Precompiled.h"
 #include "../Physics/CollisionShape.h"
 #include "../Physics/Constraint.h"
+#include "../Core/Condition.h"
 #include "../Core/Context.h"
+#include "../Core/CoreEvents.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../Atomic3D/Model.h"
 #include "../Core/Mutex.h"
+#include "../Physics/ParallelPhysics.h"
 #include "../Physics/PhysicsEvents.h"
 #include "../Physics/PhysicsUtils.h"
 #include "../Physics/PhysicsWorld.h"
+#include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../Math/Ray.h"
 #include "../Physics/RigidBody.h"
 #include "../Scene/Scene.h"
@@ -44,7 +50,6 @@
 #include <Bullet/src/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
 #include <Bullet/src/BulletCollision/CollisionShapes/btBoxShape.h>
 #include <Bullet/src/BulletCollision/CollisionShapes/btSphereShape.h>
-#include <Bullet/src/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
 #include <Bullet/src/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
 
 extern ContactAddedCallback gContactAddedCallback;
@@ -58,6 +63,8 @@ extern const char* SUBSYSTEM_CATEGORY;
 static const int MAX_SOLVER_ITERATIONS = 256;
 static const int DEFAULT_FPS = 60;
 static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
+/// Minimum number of batched queries before they are split into work items.
+static const unsigned MIN_PARALLEL_QUERIES = 16;
 
 static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const PhysicsRaycastResult& rhs)
 {
@@ -66,14 +73,75 @@ static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const Physics
 
 void InternalPreTickCallback(btDynamicsWorld *world, btScalar timeStep)
 {
-    static_cast<PhysicsWorld*>(world->getWorldUserInfo())->PreStep(timeStep);
+    // When stepping on the physics thread, transforms are applied and events are sent on the main thread once per frame
+    // instead. Otherwise apply the transforms of the previous substep first, so that event handlers see current node transforms
+    PhysicsWorld* physicsWorld = static_cast<PhysicsWorld*>(world->getWorldUserInfo());
+    if (!physicsWorld->IsStepping())
+    {
+        physicsWorld->ApplyBufferedTransforms();
+        physicsWorld->PreStep(timeStep);
+    }
 }
 
 void InternalTickCallback(btDynamicsWorld *world, btScalar timeStep)
 {
-    static_cast<PhysicsWorld*>(world->getWorldUserInfo())->PostStep(timeStep);
+    PhysicsWorld* physicsWorld = static_cast<PhysicsWorld*>(world->getWorldUserInfo());
+    if (!physicsWorld->IsStepping())
+    {
+        physicsWorld->ApplyBufferedTransforms();
+        physicsWorld->PostStep(timeStep);
+    }
 }
 
+/// Dedicated thread for stepping the physics simulation.
+class PhysicsStepThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    PhysicsStepThread(PhysicsWorld* owner) :
+        owner_(owner)
+    {
+    }
+    
+    /// Step the simulation whenever signaled, until stopped.
+    virtual void ThreadFunction()
+    {
+        // Init FPU state first
+        InitFPU();
+        
+        for (;;)
+        {
+            startCondition_.Wait();
+            if (!shouldRun_)
+                break;
+            
+            owner_->ThreadedStep();
+            finishCondition_.Set();
+        }
+    }
+    
+    /// Signal the thread to step the simulation.
+    void Start() { startCondition_.Set(); }
+    /// Wait until the simulation step has finished.
+    void WaitForFinish() { finishCondition_.Wait(); }
+    
+    /// Stop the thread. Must not be stepping.
+    void Shutdown()
+    {
+        shouldRun_ = false;
+        startCondition_.Set();
+        Stop();
+    }
+    
+private:
+    /// Physics world.
+    PhysicsWorld* owner_;
+    /// Condition for starting a simulation step.
+    Condition startCondition_;
+    /// Condition for a finished simulation step.
+    Condition finishCondition_;
+};
+
 static bool CustomMaterialCombinerCallback(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0, const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1)
 {
     btAdjustInternalEdgeContacts(cp, colObj1Wrap, colObj0Wrap, partId1, index1);
@@ -84,6 +152,180 @@ static bool CustomMaterialCombinerCallback(btManifoldPoint& cp, const btCollisio
     return true;
 }
 
+/// Batched physics query type.
+enum PhysicsQueryType
+{
+    PQ_RAYCAST = 0,
+    PQ_SPHERECAST,
+    PQ_CONVEXCAST
+};
+
+/// Batched physics query work data.
+struct PhysicsQueryBatch
+{
+    /// Bullet physics world.
+    btDiscreteDynamicsWorld* world_;
+    /// Query type.
+    PhysicsQueryType type_;
+    /// Query array.
+    const void* queries_;
+    /// Result array.
+    PhysicsRaycastResult* results_;
+    /// Shape for convex casts.
+    btConvexShape* shape_;
+};
+
+static void ClearRaycastResult(PhysicsRaycastResult& result)
+{
+    result.body_ = 0;
+    result.position_ = Vector3::ZERO;
+    result.normal_ = Vector3::ZERO;
+    result.distance_ = M_INFINITY;
+}
+
+static void RaycastSingleInternal(btDiscreteDynamicsWorld* world, PhysicsRaycastResult& result, const Ray& ray, float maxDistance,
+    unsigned collisionMask)
+{
+    btCollisionWorld::ClosestRayResultCallback rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ +
+        maxDistance * ray.direction_));
+    rayCallback.m_collisionFilterGroup = (short)0xffff;
+    rayCallback.m_collisionFilterMask = collisionMask;
+
+    world->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+
+    if (rayCallback.hasHit())
+    {
+        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
+        result.distance_ = (result.position_ - ray.origin_).Length();
+        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+static void SphereCastInternal(btDiscreteDynamicsWorld* world, PhysicsRaycastResult& result, const Ray& ray, float radius,
+    float maxDistance, unsigned collisionMask)
+{
+    btSphereShape shape(radius);
+
+    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ +
+        maxDistance * ray.direction_));
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = collisionMask;
+
+    world->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
+        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
+
+    if (convexCallback.hasHit())
+    {
+        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+        result.distance_ = (result.position_ - ray.origin_).Length();
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+static void ConvexCastInternal(btDiscreteDynamicsWorld* world, PhysicsRaycastResult& result, btConvexShape* shape,
+    const Vector3& startPos, const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask)
+{
+    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = collisionMask;
+
+    world->convexSweepTest(shape, btTransform(ToBtQuaternion(startRot), convexCallback.m_convexFromWorld),
+        btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld), convexCallback);
+
+    if (convexCallback.hasHit())
+    {
+        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+        result.distance_ = (result.position_ - startPos).Length();
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+static void ProcessQueryBatch(const PhysicsQueryBatch& batch, unsigned start, unsigned end)
+{
+    switch (batch.type_)
+    {
+    case PQ_RAYCAST:
+        {
+            const PhysicsRaycastQuery* queries = reinterpret_cast<const PhysicsRaycastQuery*>(batch.queries_);
+            for (unsigned i = start; i < end; ++i)
+                RaycastSingleInternal(batch.world_, batch.results_[i], queries[i].ray_, queries[i].maxDistance_, queries[i].collisionMask_);
+        }
+        break;
+
+    case PQ_SPHERECAST:
+        {
+            const PhysicsSphereCastQuery* queries = reinterpret_cast<const PhysicsSphereCastQuery*>(batch.queries_);
+            for (unsigned i = start; i < end; ++i)
+            {
+                SphereCastInternal(batch.world_, batch.results_[i], queries[i].ray_, queries[i].radius_, queries[i].maxDistance_,
+                    queries[i].collisionMask_);
+            }
+        }
+        break;
+
+    case PQ_CONVEXCAST:
+        {
+            const PhysicsConvexCastQuery* queries = reinterpret_cast<const PhysicsConvexCastQuery*>(batch.queries_);
+            for (unsigned i = start; i < end; ++i)
+            {
+                ConvexCastInternal(batch.world_, batch.results_[i], batch.shape_, queries[i].startPos_, queries[i].startRot_,
+                    queries[i].endPos_, queries[i].endRot_, queries[i].collisionMask_);
+            }
+        }
+        break;
+    }
+}
+
+void PhysicsQueryBatchWork(const WorkItem* item, unsigned threadIndex)
+{
+    const PhysicsQueryBatch& batch = *(reinterpret_cast<PhysicsQueryBatch*>(item->aux_));
+    ProcessQueryBatch(batch, (unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
+
+static void ExecuteQueryBatch(WorkQueue* queue, PhysicsQueryBatch& batch, unsigned numQueries)
+{
+    // Only the main thread may complete work, so run the queries serially when called from elsewhere
+    if (!queue || !queue->GetNumThreads() || numQueries < MIN_PARALLEL_QUERIES || !Thread::IsMainThread())
+    {
+        ProcessQueryBatch(batch, 0, numQueries);
+        return;
+    }
+
+    unsigned numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+    unsigned queriesPerItem = (unsigned)Max((int)(numQueries / numWorkItems), 1);
+
+    unsigned start = 0;
+    // Create a work item for each thread
+    for (unsigned i = 0; i < numWorkItems && start < numQueries; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = PhysicsQueryBatchWork;
+        item->aux_ = &batch;
+
+        unsigned end = numQueries;
+        if (i < numWorkItems - 1 && end - start > queriesPerItem)
+            end = start + queriesPerItem;
+
+        item->start_ = (void*)(size_t)start;
+        item->end_ = (void*)(size_t)end;
+        queue->AddWorkItem(item);
+
+        start = end;
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
 /// Callback for physics world queries.
 struct PhysicsQueryCallback : public btCollisionWorld::ContactResultCallback
 {
@@ -121,19 +363,24 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     fps_(DEFAULT_FPS),
     maxSubSteps_(0),
     timeAcc_(0.0f),
+    pendingTimeStep_(0.0f),
+    steppedTimeStep_(0.0f),
     maxNetworkAngularVelocity_(DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY),
+    numActiveBodies_(0),
     interpolation_(true),
     internalEdge_(true),
     applyingTransforms_(false),
+    threaded_(false),
+    stepping_(false),
     debugRenderer_(0),
     debugMode_(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawConstraints | btIDebugDraw::DBG_DrawConstraintLimits)
 {
     gContactAddedCallback = CustomMaterialCombinerCallback;
 
     collisionConfiguration_ = new btDefaultCollisionConfiguration();
-    collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
+    collisionDispatcher_ = new ParallelCollisionDispatcher(context_, collisionConfiguration_);
     broadphase_ = new btDbvtBroadphase();
-    solver_ = new btSequentialImpulseConstraintSolver();
+    solver_ = new ParallelConstraintSolver(context_);
     world_ = new btDiscreteDynamicsWorld(collisionDispatcher_, broadphase_, solver_, collisionConfiguration_);
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
@@ -146,6 +393,13 @@ PhysicsWorld::PhysicsWorld(Context* context) :
 
 PhysicsWorld::~PhysicsWorld()
 {
+    if (stepThread_)
+    {
+        WaitForStep();
+        stepThread_->Shutdown();
+        stepThread_.Reset();
+    }
+
     if (scene_)
     {
         // Force all remaining constraints, rigid bodies and collision shapes to release themselves
@@ -185,6 +439,9 @@ void PhysicsWorld::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE("Solver Iterations", GetNumIterations, SetNumIterations, int, 10, AM_DEFAULT);
     ATTRIBUTE("Net Max Angular Vel.", float, maxNetworkAngularVelocity_, DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY, AM_DEFAULT);
     ATTRIBUTE("Interpolation", bool, interpolation_, true, AM_FILE);
+    ACCESSOR_ATTRIBUTE("Threaded", GetThreaded, SetThreaded, bool, false, AM_FILE);
+    ACCESSOR_ATTRIBUTE("Parallel Solver", GetParallelSolver, SetParallelSolver, bool, false, AM_FILE);
+    ACCESSOR_ATTRIBUTE("Parallel Narrowphase", GetParallelNarrowphase, SetParallelNarrowphase, bool, false, AM_FILE);
     ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
 }
@@ -207,6 +464,8 @@ void PhysicsWorld::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
 {
     if (debug)
     {
+        WaitForStep();
+
         PROFILE(PhysicsDrawDebug);
 
         debugRenderer_ = debug;
@@ -233,51 +492,14 @@ void PhysicsWorld::Update(float timeStep)
 {
     PROFILE(UpdatePhysics);
 
-    float internalTimeStep = 1.0f / fps_;
-    int maxSubSteps = (int)(timeStep * fps_) + 1;
-    if (maxSubSteps_ < 0)
-    {
-        internalTimeStep = timeStep;
-        maxSubSteps = 1;
-    }
-    else if (maxSubSteps_ > 0)
-        maxSubSteps = Min(maxSubSteps, maxSubSteps_);
-
-    delayedWorldTransforms_.Clear();
+    WaitForStep();
 
-    if (interpolation_)
-        world_->stepSimulation(timeStep, maxSubSteps, internalTimeStep);
-    else
-    {
-        timeAcc_ += timeStep;
-        while (timeAcc_ >= internalTimeStep && maxSubSteps > 0)
-        {
-            world_->stepSimulation(internalTimeStep, 0, internalTimeStep);
-            timeAcc_ -= internalTimeStep;
-            --maxSubSteps;
-        }
-    }
-
-    // Apply delayed (parented) world transforms now
-    while (!delayedWorldTransforms_.Empty())
-    {
-        for (HashMap<RigidBody*, DelayedWorldTransform>::Iterator i = delayedWorldTransforms_.Begin();
-            i != delayedWorldTransforms_.End(); ++i)
-        {
-            const DelayedWorldTransform& transform = i->second_;
-
-            // If parent's transform has already been assigned, can proceed
-            if (!delayedWorldTransforms_.Contains(transform.parentRigidBody_))
-            {
-                transform.rigidBody_->ApplyWorldTransform(transform.worldPosition_, transform.worldRotation_);
-                delayedWorldTransforms_.Erase(i);
-            }
-        }
-    }
+    StepSimulation(timeStep);
 }
 
 void PhysicsWorld::UpdateCollisions()
 {
+    WaitForStep();
     world_->performDiscreteCollisionDetection();
 }
 
@@ -314,6 +536,52 @@ void PhysicsWorld::SetInterpolation(bool enable)
     interpolation_ = enable;
 }
 
+void PhysicsWorld::SetThreaded(bool enable)
+{
+    if (enable == threaded_)
+        return;
+
+    // Finish a pending threaded step and deliver its events before switching modes, so that they are not lost
+    WaitForStep();
+    SendSteppedEvents();
+    // An event handler may have already switched the mode
+    if (enable == threaded_)
+        return;
+
+    threaded_ = enable;
+
+    if (threaded_)
+    {
+        // Start the threaded step after all logic and rendering updates, and finish it before the next frame
+        SubscribeToEvent(E_POSTRENDERUPDATE, HANDLER(PhysicsWorld, HandlePostRenderUpdate));
+        SubscribeToEvent(E_ENDFRAME, HANDLER(PhysicsWorld, HandleEndFrame));
+    }
+    else
+    {
+        UnsubscribeFromEvent(E_POSTRENDERUPDATE);
+        UnsubscribeFromEvent(E_ENDFRAME);
+
+        if (stepThread_)
+        {
+            stepThread_->Shutdown();
+            stepThread_.Reset();
+        }
+        pendingTimeStep_ = 0.0f;
+    }
+}
+
+void PhysicsWorld::SetParallelSolver(bool enable)
+{
+    WaitForStep();
+    solver_->SetEnabled(enable);
+}
+
+void PhysicsWorld::SetParallelNarrowphase(bool enable)
+{
+    WaitForStep();
+    collisionDispatcher_->SetEnabled(enable);
+}
+
 void PhysicsWorld::SetInternalEdge(bool enable)
 {
     internalEdge_ = enable;
@@ -339,6 +607,8 @@ void PhysicsWorld::Raycast(PODVector<PhysicsRaycastResult>& result, const Ray& r
 {
     PROFILE(PhysicsRaycast);
 
+    WaitForStep();
+
     btCollisionWorld::AllHitsRayResultCallback rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ +
         maxDistance * ray.direction_));
     rayCallback.m_collisionFilterGroup = (short)0xffff;
@@ -363,57 +633,18 @@ void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, f
 {
     PROFILE(PhysicsRaycastSingle);
 
-    btCollisionWorld::ClosestRayResultCallback rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ +
-        maxDistance * ray.direction_));
-    rayCallback.m_collisionFilterGroup = (short)0xffff;
-    rayCallback.m_collisionFilterMask = collisionMask;
-
-    world_->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+    WaitForStep();
 
-    if (rayCallback.hasHit())
-    {
-        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
-        result.distance_ = (result.position_ - ray.origin_).Length();
-        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
-    }
-    else
-    {
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.body_ = 0;
-    }
+    RaycastSingleInternal(world_, result, ray, maxDistance, collisionMask);
 }
 
 void PhysicsWorld::SphereCast(PhysicsRaycastResult& result, const Ray& ray, float radius, float maxDistance, unsigned collisionMask)
 {
     PROFILE(PhysicsSphereCast);
 
-    btSphereShape shape(radius);
-
-    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ +
-        maxDistance * ray.direction_));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = collisionMask;
-
-    world_->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
-        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
+    WaitForStep();
 
-    if (convexCallback.hasHit())
-    {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = (result.position_ - ray.origin_).Length();
-    }
-    else
-    {
-        result.body_ = 0;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-    }
+    SphereCastInternal(world_, result, ray, radius, maxDistance, collisionMask);
 }
 
 void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos, const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask)
@@ -421,13 +652,12 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, CollisionShape* shap
     if (!shape || !shape->GetCollisionShape())
     {
         LOGERROR("Null collision shape for convex cast");
-        result.body_ = 0;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
+        ClearRaycastResult(result);
         return;
     }
 
+    WaitForStep();
+
     // If shape is attached in a rigidbody, set its collision group temporarily to 0 to make sure it is not returned in the sweep result
     RigidBody* bodyComp = shape->GetComponent<RigidBody>();
     btRigidBody* body = bodyComp ? bodyComp->GetBody() : (btRigidBody*)0;
@@ -451,47 +681,131 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, btCollisionShape* sh
     if (!shape)
     {
         LOGERROR("Null collision shape for convex cast");
-        result.body_ = 0;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
+        ClearRaycastResult(result);
         return;
     }
 
     if (!shape->isConvex())
     {
         LOGERROR("Can not use non-convex collision shape for convex cast");
-        result.body_ = 0;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
+        ClearRaycastResult(result);
         return;
     }
 
     PROFILE(PhysicsConvexCast);
 
-    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = collisionMask;
+    WaitForStep();
 
-    world_->convexSweepTest(static_cast<btConvexShape*>(shape), btTransform(ToBtQuaternion(startRot),
-        convexCallback.m_convexFromWorld), btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld),
-        convexCallback);
+    ConvexCastInternal(world_, result, static_cast<btConvexShape*>(shape), startPos, startRot, endPos, endRot, collisionMask);
+}
 
-    if (convexCallback.hasHit())
+void PhysicsWorld::RaycastSingleBatch(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries)
+{
+    if (!numQueries)
+        return;
+
+    PROFILE(PhysicsRaycastSingleBatch);
+
+    WaitForStep();
+
+    PhysicsQueryBatch batch;
+    batch.world_ = world_;
+    batch.type_ = PQ_RAYCAST;
+    batch.queries_ = queries;
+    batch.results_ = results;
+    batch.shape_ = 0;
+    ExecuteQueryBatch(GetSubsystem<WorkQueue>(), batch, numQueries);
+}
+
+void PhysicsWorld::RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries)
+{
+    results.Resize(queries.Size());
+    if (!queries.Empty())
+        RaycastSingleBatch(&results[0], &queries[0], queries.Size());
+}
+
+void PhysicsWorld::SphereCastBatch(PhysicsRaycastResult* results, const PhysicsSphereCastQuery* queries, unsigned numQueries)
+{
+    if (!numQueries)
+        return;
+
+    PROFILE(PhysicsSphereCastBatch);
+
+    WaitForStep();
+
+    PhysicsQueryBatch batch;
+    batch.world_ = world_;
+    batch.type_ = PQ_SPHERECAST;
+    batch.queries_ = queries;
+    batch.results_ = results;
+    batch.shape_ = 0;
+    ExecuteQueryBatch(GetSubsystem<WorkQueue>(), batch, numQueries);
+}
+
+void PhysicsWorld::SphereCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsSphereCastQuery>& queries)
+{
+    results.Resize(queries.Size());
+    if (!queries.Empty())
+        SphereCastBatch(&results[0], &queries[0], queries.Size());
+}
+
+void PhysicsWorld::ConvexCastBatch(PhysicsRaycastResult* results, CollisionShape* shape, const PhysicsConvexCastQuery* queries, unsigned numQueries)
+{
+    if (!shape || !shape->GetCollisionShape())
     {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = (result.position_ - startPos).Length();
+        LOGERROR("Null collision shape for convex cast");
+        for (unsigned i = 0; i < numQueries; ++i)
+            ClearRaycastResult(results[i]);
+        return;
     }
-    else
+
+    WaitForStep();
+
+    // If shape is attached in a rigidbody, set its collision group temporarily to 0 for the whole batch
+    RigidBody* bodyComp = shape->GetComponent<RigidBody>();
+    btRigidBody* body = bodyComp ? bodyComp->GetBody() : (btRigidBody*)0;
+    btBroadphaseProxy* proxy = body ? body->getBroadphaseProxy() : (btBroadphaseProxy*)0;
+    short group = 0;
+    if (proxy)
     {
-        result.body_ = 0;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
+        group = proxy->m_collisionFilterGroup;
+        proxy->m_collisionFilterGroup = 0;
     }
+
+    ConvexCastBatch(results, shape->GetCollisionShape(), queries, numQueries);
+
+    // Restore the collision group
+    if (proxy)
+        proxy->m_collisionFilterGroup = group;
+}
+
+void PhysicsWorld::ConvexCastBatch(PhysicsRaycastResult* results, btCollisionShape* shape, const PhysicsConvexCastQuery* queries, unsigned numQueries)
+{
+    if (!shape || !shape->isConvex())
+    {
+        if (!shape)
+            LOGERROR("Null collision shape for convex cast");
+        else
+            LOGERROR("Can not use non-convex collision shape for convex cast");
+        for (unsigned i = 0; i < numQueries; ++i)
+            ClearRaycastResult(results[i]);
+        return;
+    }
+
+    if (!numQueries)
+        return;
+
+    PROFILE(PhysicsConvexCastBatch);
+
+    WaitForStep();
+
+    PhysicsQueryBatch batch;
+    batch.world_ = world_;
+    batch.type_ = PQ_CONVEXCAST;
+    batch.queries_ = queries;
+    batch.results_ = results;
+    batch.shape_ = static_cast<btConvexShape*>(shape);
+    ExecuteQueryBatch(GetSubsystem<WorkQueue>(), batch, numQueries);
 }
 
 void PhysicsWorld::RemoveCachedGeometry(Model* model)
@@ -516,6 +830,8 @@ void PhysicsWorld::GetRigidBodies(PODVector<RigidBody*>& result, const Sphere& s
 {
     PROFILE(PhysicsSphereQuery);
 
+    WaitForStep();
+
     result.Clear();
 
     btSphereShape sphereShape(sphere.radius_);
@@ -536,6 +852,8 @@ void PhysicsWorld::GetRigidBodies(PODVector<RigidBody*>& result, const BoundingB
 {
     PROFILE(PhysicsBoxQuery);
 
+    WaitForStep();
+
     result.Clear();
 
     btBoxShape boxShape(ToBtVector3(box.HalfSize()));
@@ -582,6 +900,16 @@ bool PhysicsWorld::GetSplitImpulse() const
     return world_->getSolverInfo().m_splitImpulse != 0;
 }
 
+bool PhysicsWorld::GetParallelSolver() const
+{
+    return solver_->IsEnabled();
+}
+
+bool PhysicsWorld::GetParallelNarrowphase() const
+{
+    return collisionDispatcher_->IsEnabled();
+}
+
 void PhysicsWorld::AddRigidBody(RigidBody* body)
 {
     rigidBodies_.Push(body);
@@ -589,9 +917,11 @@ void PhysicsWorld::AddRigidBody(RigidBody* body)
 
 void PhysicsWorld::RemoveRigidBody(RigidBody* body)
 {
+    WaitForStep();
     rigidBodies_.Remove(body);
-    // Remove possible dangling pointer from the delayedWorldTransforms structure
-    delayedWorldTransforms_.Erase(body);
+    // Remove possible dangling pointer from the buffered transforms
+    if (body->HasBufferedTransform())
+        bufferedTransforms_.Remove(body);
 }
 
 void PhysicsWorld::AddCollisionShape(CollisionShape* shape)
@@ -614,9 +944,24 @@ void PhysicsWorld::RemoveConstraint(Constraint* constraint)
     constraints_.Remove(constraint);
 }
 
-void PhysicsWorld::AddDelayedWorldTransform(const DelayedWorldTransform& transform)
+void PhysicsWorld::AddBufferedTransform(RigidBody* body)
+{
+    bufferedTransforms_.Push(body);
+}
+
+void PhysicsWorld::WaitForStep()
 {
-    delayedWorldTransforms_[transform.rigidBody_] = transform;
+    // Only the main thread may wait; the physics thread itself accesses the world freely
+    if (!stepping_ || !Thread::IsMainThread())
+        return;
+
+    {
+        PROFILE(WaitForPhysicsStep);
+        stepThread_->WaitForFinish();
+    }
+    stepping_ = false;
+
+    ApplyBufferedTransforms();
 }
 
 void PhysicsWorld::DrawDebugGeometry(bool depthTest)
@@ -666,9 +1011,146 @@ void PhysicsWorld::OnNodeSet(Node* node)
 
 void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
 {
-    using namespace SceneSubsystemUpdate;
+    float timeStep = eventData[SceneSubsystemUpdate::P_TIMESTEP].GetFloat();
 
-    Update(eventData[P_TIMESTEP].GetFloat());
+    if (!threaded_)
+    {
+        Update(timeStep);
+        return;
+    }
+
+    // Sync point for the threaded step: send the collision and post-step events of the step that was run during
+    // the previous frame's rendering, then the pre-step event for the step that will be run during this frame's rendering
+    WaitForStep();
+    SendSteppedEvents();
+
+    {
+        using namespace PhysicsPreStep;
+
+        VariantMap& preStepData = GetEventDataMap();
+        preStepData[P_WORLD] = this;
+        preStepData[P_TIMESTEP] = timeStep;
+        SendEvent(E_PHYSICSPRESTEP, preStepData);
+    }
+
+    pendingTimeStep_ += timeStep;
+}
+
+void PhysicsWorld::HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (pendingTimeStep_ > 0.0f)
+        StartStep();
+}
+
+void PhysicsWorld::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    WaitForStep();
+}
+
+void PhysicsWorld::StepSimulation(float timeStep)
+{
+    float internalTimeStep = 1.0f / fps_;
+    int maxSubSteps = (int)(timeStep * fps_) + 1;
+    if (maxSubSteps_ < 0)
+    {
+        internalTimeStep = timeStep;
+        maxSubSteps = 1;
+    }
+    else if (maxSubSteps_ > 0)
+        maxSubSteps = Min(maxSubSteps, maxSubSteps_);
+
+    // Bullet synchronizes the motion states after each substep. The buffered transforms are applied in the tick callbacks
+    // and after the last substep, or during a threaded step on the main thread in WaitForStep()
+    if (interpolation_)
+    {
+        world_->stepSimulation(timeStep, maxSubSteps, internalTimeStep);
+        if (!stepping_)
+            ApplyBufferedTransforms();
+    }
+    else
+    {
+        timeAcc_ += timeStep;
+        while (timeAcc_ >= internalTimeStep && maxSubSteps > 0)
+        {
+            world_->stepSimulation(internalTimeStep, 0, internalTimeStep);
+            if (!stepping_)
+                ApplyBufferedTransforms();
+            timeAcc_ -= internalTimeStep;
+            --maxSubSteps;
+        }
+    }
+}
+
+void PhysicsWorld::ApplyBufferedTransforms()
+{
+    numActiveBodies_ = bufferedTransforms_.Size();
+    if (bufferedTransforms_.Empty())
+        return;
+
+    PROFILE(ApplyPhysicsTransforms);
+
+    Scene* scene = GetScene();
+    hierarchyTransforms_.Clear();
+
+    // Bodies directly below the scene do not depend on other bodies, so assign them right away. Deeper bodies are sorted
+    // by hierarchy depth, so that a parent rigid body always has its transform assigned before its children
+    for (PODVector<RigidBody*>::ConstIterator i = bufferedTransforms_.Begin(); i != bufferedTransforms_.End(); ++i)
+    {
+        RigidBody* body = *i;
+        Node* node = body->GetNode();
+        Node* parent = node ? node->GetParent() : (Node*)0;
+
+        if (!parent || parent == scene)
+            body->ApplyBufferedTransform();
+        else
+        {
+            unsigned depth = 0;
+            while (parent && parent != scene)
+            {
+                ++depth;
+                parent = parent->GetParent();
+            }
+            hierarchyTransforms_.Push(MakePair(depth, body));
+        }
+    }
+
+    bufferedTransforms_.Clear();
+
+    if (!hierarchyTransforms_.Empty())
+    {
+        Sort(hierarchyTransforms_.Begin(), hierarchyTransforms_.End());
+        for (PODVector<Pair<unsigned, RigidBody*> >::ConstIterator i = hierarchyTransforms_.Begin(); i !=
+            hierarchyTransforms_.End(); ++i)
+            i->second_->ApplyBufferedTransform();
+    }
+}
+
+void PhysicsWorld::StartStep()
+{
+    PROFILE(StartPhysicsStep);
+
+    if (!stepThread_)
+    {
+        stepThread_ = new PhysicsStepThread(this);
+        stepThread_->Run();
+    }
+
+    // The physics thread must not access scene nodes, so cache kinematic body transforms for Bullet beforehand
+    for (PODVector<RigidBody*>::ConstIterator i = rigidBodies_.Begin(); i != rigidBodies_.End(); ++i)
+    {
+        if ((*i)->IsKinematic())
+            (*i)->CacheWorldTransform();
+    }
+
+    steppedTimeStep_ = pendingTimeStep_;
+    pendingTimeStep_ = 0.0f;
+    stepping_ = true;
+    stepThread_->Start();
+}
+
+void PhysicsWorld::ThreadedStep()
+{
+    StepSimulation(steppedTimeStep_);
 }
 
 void PhysicsWorld::PreStep(float timeStep)
@@ -708,6 +1190,22 @@ void PhysicsWorld::PostStep(float timeStep)
     SendEvent(E_PHYSICSPOSTSTEP, eventData);
 }
 
+void PhysicsWorld::SendSteppedEvents()
+{
+    if (steppedTimeStep_ <= 0.0f)
+        return;
+
+    SendCollisionEvents();
+
+    using namespace PhysicsPostStep;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_WORLD] = this;
+    eventData[P_TIMESTEP] = steppedTimeStep_;
+    steppedTimeStep_ = 0.0f;
+    SendEvent(E_PHYSICSPOSTSTEP, eventData);
+}
+
 void PhysicsWorld::SendCollisionEvents()
 {
     PROFILE(SendCollisionEvents);
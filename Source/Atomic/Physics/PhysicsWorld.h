@@ -23,6 +23,8 @@
 #pragma once
 
 #include "../Math/BoundingBox.h"
+#include "../Math/Quaternion.h"
+#include "../Math/Ray.h"
 #include "../Scene/Component.h"
 #include "../Container/HashSet.h"
 #include "../Math/Sphere.h"
@@ -48,7 +50,9 @@ class Deserializer;
 class Constraint;
 class Model;
 class Node;
-class Ray;
+class ParallelCollisionDispatcher;
+class ParallelConstraintSolver;
+class PhysicsStepThread;
 class RigidBody;
 class Scene;
 class Serializer;
@@ -78,17 +82,91 @@ struct ATOMIC_API PhysicsRaycastResult
     RigidBody* body_;
 };
 
-/// Delayed world transform assignment for parented rigidbodies.
-struct DelayedWorldTransform
+/// Physics raycast query for batched raycasts.
+struct ATOMIC_API PhysicsRaycastQuery
 {
-    /// Rigid body.
-    RigidBody* rigidBody_;
-    /// Parent rigid body.
-    RigidBody* parentRigidBody_;
-    /// New world position.
-    Vector3 worldPosition_;
-    /// New world rotation.
-    Quaternion worldRotation_;
+    /// Construct with defaults.
+    PhysicsRaycastQuery() :
+        maxDistance_(0.0f),
+        collisionMask_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Construct with parameters.
+    PhysicsRaycastQuery(const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED) :
+        ray_(ray),
+        maxDistance_(maxDistance),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Ray.
+    Ray ray_;
+    /// Maximum distance.
+    float maxDistance_;
+    /// Collision mask.
+    unsigned collisionMask_;
+};
+
+/// Physics swept sphere query for batched sphere casts.
+struct ATOMIC_API PhysicsSphereCastQuery
+{
+    /// Construct with defaults.
+    PhysicsSphereCastQuery() :
+        radius_(0.0f),
+        maxDistance_(0.0f),
+        collisionMask_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Construct with parameters.
+    PhysicsSphereCastQuery(const Ray& ray, float radius, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED) :
+        ray_(ray),
+        radius_(radius),
+        maxDistance_(maxDistance),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Ray.
+    Ray ray_;
+    /// Sphere radius.
+    float radius_;
+    /// Maximum distance.
+    float maxDistance_;
+    /// Collision mask.
+    unsigned collisionMask_;
+};
+
+/// Physics swept convex query for batched convex casts.
+struct ATOMIC_API PhysicsConvexCastQuery
+{
+    /// Construct with defaults.
+    PhysicsConvexCastQuery() :
+        collisionMask_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Construct with parameters.
+    PhysicsConvexCastQuery(const Vector3& startPos, const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED) :
+        startPos_(startPos),
+        startRot_(startRot),
+        endPos_(endPos),
+        endRot_(endRot),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Start position.
+    Vector3 startPos_;
+    /// Start rotation.
+    Quaternion startRot_;
+    /// End position.
+    Vector3 endPos_;
+    /// End rotation.
+    Quaternion endRot_;
+    /// Collision mask.
+    unsigned collisionMask_;
 };
 
 static const float DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY = 100.0f;
@@ -100,6 +178,7 @@ class ATOMIC_API PhysicsWorld : public Component, public btIDebugDraw
 
     friend void InternalPreTickCallback(btDynamicsWorld *world, btScalar timeStep);
     friend void InternalTickCallback(btDynamicsWorld *world, btScalar timeStep);
+    friend class PhysicsStepThread;
 
 public:
     /// Construct.
@@ -140,6 +219,12 @@ public:
     void SetNumIterations(int num);
     /// Set whether to interpolate between simulation steps.
     void SetInterpolation(bool enable);
+    /// Set whether to step the simulation on a dedicated thread while the main thread renders. Transforms and collision events lag one frame behind, and physics pre- and post-step events are sent once per frame instead of per substep. Disabled by default.
+    void SetThreaded(bool enable);
+    /// Set whether to solve simulation islands in the work queue's threads. Has no effect during a threaded step. Disabled by default.
+    void SetParallelSolver(bool enable);
+    /// Set whether to run the collision narrowphase in the work queue's threads. Has no effect during a threaded step. Disabled by default.
+    void SetParallelNarrowphase(bool enable);
     /// Set whether to use Bullet's internal edge utility for trimesh collisions. Disabled by default.
     void SetInternalEdge(bool enable);
     /// Set split impulse collision mode. This is more accurate, but slower. Disabled by default.
@@ -156,6 +241,18 @@ public:
     void ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos, const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Perform a physics world swept convex test using a user-supplied Bullet collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, btCollisionShape* shape, const Vector3& startPos, const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform physics world raycasts in the work queue's threads and return the closest hit of each. The result array must hold numQueries elements. When not called from the main thread, the queries are performed serially in the calling thread.
+    void RaycastSingleBatch(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries);
+    /// Perform physics world raycasts in the work queue's threads and return the closest hit of each.
+    void RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries);
+    /// Perform physics world swept sphere tests in the work queue's threads and return the closest hit of each. The result array must hold numQueries elements.
+    void SphereCastBatch(PhysicsRaycastResult* results, const PhysicsSphereCastQuery* queries, unsigned numQueries);
+    /// Perform physics world swept sphere tests in the work queue's threads and return the closest hit of each.
+    void SphereCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsSphereCastQuery>& queries);
+    /// Perform physics world swept convex tests of a user-supplied collision shape in the work queue's threads and return the first hit of each. The result array must hold numQueries elements.
+    void ConvexCastBatch(PhysicsRaycastResult* results, CollisionShape* shape, const PhysicsConvexCastQuery* queries, unsigned numQueries);
+    /// Perform physics world swept convex tests of a user-supplied Bullet collision shape in the work queue's threads and return the first hit of each. The result array must hold numQueries elements.
+    void ConvexCastBatch(PhysicsRaycastResult* results, btCollisionShape* shape, const PhysicsConvexCastQuery* queries, unsigned numQueries);
     /// Invalidate cached collision geometry for a model.
     void RemoveCachedGeometry(Model* model);
     /// Return rigid bodies by a sphere query.
@@ -173,12 +270,24 @@ public:
     int GetNumIterations() const;
     /// Return whether interpolation between simulation steps is enabled.
     bool GetInterpolation() const { return interpolation_; }
+    /// Return whether the simulation is stepped on a dedicated thread.
+    bool GetThreaded() const { return threaded_; }
+    /// Return whether a threaded simulation step is currently in progress.
+    bool IsStepping() const { return stepping_; }
+    /// Return whether simulation islands are solved in the work queue's threads.
+    bool GetParallelSolver() const;
+    /// Return whether the collision narrowphase runs in the work queue's threads.
+    bool GetParallelNarrowphase() const;
     /// Return whether Bullet's internal edge utility for trimesh collisions is enabled.
     bool GetInternalEdge() const { return internalEdge_; }
     /// Return whether split impulse collision mode is enabled.
     bool GetSplitImpulse() const;
     /// Return simulation steps per second.
     int GetFps() const { return fps_; }
+    /// Return number of rigid bodies in the world.
+    unsigned GetNumRigidBodies() const { return rigidBodies_.Size(); }
+    /// Return number of awake rigid bodies whose transforms were assigned to scene nodes on the last simulation step.
+    unsigned GetNumActiveBodies() const { return numActiveBodies_; }
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
@@ -194,8 +303,10 @@ public:
     void AddConstraint(Constraint* joint);
     /// Remove a constraint. Called by Constraint.
     void RemoveConstraint(Constraint* joint);
-    /// Add a delayed world transform assignment. Called by RigidBody.
-    void AddDelayedWorldTransform(const DelayedWorldTransform& transform);
+    /// Add an awake rigid body whose transform was buffered during the simulation step. Called by RigidBody, from the physics thread if stepping threaded.
+    void AddBufferedTransform(RigidBody* body);
+    /// Wait for a threaded simulation step to finish and apply the resulting transforms to the scene nodes. Called automatically before accessing the Bullet world from the main thread.
+    void WaitForStep();
     /// Add debug geometry to the debug renderer.
     void DrawDebugGeometry(bool depthTest);
     /// Set debug renderer to use. Called both by PhysicsWorld itself and physics components.
@@ -203,8 +314,8 @@ public:
     /// Set debug geometry depth test mode. Called both by PhysicsWorld itself and physics components.
     void SetDebugDepthTest(bool enable);
 
-    /// Return the Bullet physics world.
-    btDiscreteDynamicsWorld* GetWorld() { return world_; }
+    /// Return the Bullet physics world. Waits for a threaded simulation step to finish first.
+    btDiscreteDynamicsWorld* GetWorld() { WaitForStep(); return world_; }
     /// Clean up the geometry cache.
     void CleanupGeometryCache();
     /// Return trimesh collision geometry cache.
@@ -225,21 +336,35 @@ private:
     void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle collision model reload finished.
     void HandleModelReloadFinished(StringHash eventType, VariantMap& eventData);
+    /// Handle post render update event, start the threaded simulation step here.
+    void HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle end frame event, wait for the threaded simulation step here.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Step the Bullet world, substepping as necessary.
+    void StepSimulation(float timeStep);
+    /// Assign the buffered transforms of awake rigid bodies to the scene nodes, parents before children.
+    void ApplyBufferedTransforms();
+    /// Start the threaded simulation step with the accumulated timestep.
+    void StartStep();
+    /// Step the simulation. Called by the physics thread.
+    void ThreadedStep();
     /// Trigger update before each physics simulation step.
     void PreStep(float timeStep);
     /// Trigger update after ecah physics simulation step.
     void PostStep(float timeStep);
     /// Send accumulated collision events.
     void SendCollisionEvents();
+    /// Send the collision and post-step events of the last finished threaded simulation step, if not sent yet.
+    void SendSteppedEvents();
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_;
     /// Bullet collision dispatcher.
-    btDispatcher* collisionDispatcher_;
+    ParallelCollisionDispatcher* collisionDispatcher_;
     /// Bullet collision broadphase.
     btBroadphaseInterface* broadphase_;
     /// Bullet constraint solver.
-    btConstraintSolver* solver_;
+    ParallelConstraintSolver* solver_;
     /// Bullet physics world.
     btDiscreteDynamicsWorld* world_;
     /// Extra weak pointer to scene to allow for cleanup in case the world is destroyed before other components.
@@ -254,8 +379,12 @@ private:
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold* > currentCollisions_;
     /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold* > previousCollisions_;
-    /// Delayed (parented) world transform assignments.
-    HashMap<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
+    /// Awake rigid bodies with transforms buffered during the simulation step.
+    PODVector<RigidBody*> bufferedTransforms_;
+    /// Buffered transforms of rigid bodies below the scene's direct children, sorted by hierarchy depth.
+    PODVector<Pair<unsigned, RigidBody*> > hierarchyTransforms_;
+    /// Physics simulation thread.
+    SharedPtr<PhysicsStepThread> stepThread_;
     /// Cache for trimesh geometry data by model and LOD level.
     HashMap<Pair<Model*, unsigned>, SharedPtr<CollisionGeometryData> > triMeshCache_;
     /// Cache for convex geometry data by model and LOD level.
@@ -272,14 +401,24 @@ private:
     int maxSubSteps_;
     /// Time accumulator for non-interpolated mode.
     float timeAcc_;
+    /// Timestep for the next threaded simulation step.
+    float pendingTimeStep_;
+    /// Timestep of the last finished threaded simulation step, for which collision events have not been sent yet.
+    float steppedTimeStep_;
     /// Maximum angular velocity for network replication.
     float maxNetworkAngularVelocity_;
+    /// Number of awake rigid bodies on the last simulation step.
+    unsigned numActiveBodies_;
     /// Interpolation flag.
     bool interpolation_;
     /// Use internal edge utility flag.
     bool internalEdge_;
     /// Applying transforms flag.
     bool applyingTransforms_;
+    /// Threaded stepping flag.
+    bool threaded_;
+    /// Threaded simulation step in progress flag.
+    volatile bool stepping_;
     /// Debug renderer.
     DebugRenderer* debugRenderer_;
     /// Debug draw flags.
@@ -73,13 +73,16 @@ RigidBody::RigidBody(Context* context) :
     collisionEventMode_(COLLISION_ACTIVE),
     lastPosition_(Vector3::ZERO),
     lastRotation_(Quaternion::IDENTITY),
+    bufferedPosition_(Vector3::ZERO),
+    bufferedRotation_(Quaternion::IDENTITY),
     kinematic_(false),
     trigger_(false),
     useGravity_(true),
     hasSmoothedTransform_(false),
     readdBody_(false),
     inWorld_(false),
-    enableMassUpdate_(true)
+    enableMassUpdate_(true),
+    hasBufferedTransform_(false)
 {
     compoundShape_ = new btCompoundShape();
     shiftedCompoundShape_ = new btCompoundShape();
@@ -158,6 +161,14 @@ void RigidBody::OnSetEnabled()
 
 void RigidBody::getWorldTransform(btTransform &worldTrans) const
 {
+    // During a threaded simulation step the node must not be accessed, use the transform cached before the step
+    if (physicsWorld_ && physicsWorld_->IsStepping())
+    {
+        worldTrans.setOrigin(ToBtVector3(lastPosition_ + lastRotation_ * centerOfMass_));
+        worldTrans.setRotation(ToBtQuaternion(lastRotation_));
+        return;
+    }
+
     // We may be in a pathological state where a RigidBody exists without a scene node when this callback is fired,
     // so check to be sure
     if (node_)
@@ -171,33 +182,18 @@ void RigidBody::getWorldTransform(btTransform &worldTrans) const
 
 void RigidBody::setWorldTransform(const btTransform &worldTrans)
 {
-    Quaternion newWorldRotation = ToQuaternion(worldTrans.getRotation());
-    Vector3 newWorldPosition = ToVector3(worldTrans.getOrigin()) - newWorldRotation * centerOfMass_;
-    RigidBody* parentRigidBody = 0;
+    if (!physicsWorld_)
+        return;
 
-    // It is possible that the RigidBody component has been kept alive via a shared pointer,
-    // while its scene node has already been destroyed
-    if (node_)
+    // Bullet only calls this for awake bodies. Buffer the transform so that PhysicsWorld can assign all transforms
+    // in hierarchy order after the step. During a threaded step this also keeps the physics thread off the scene nodes
+    Quaternion newWorldRotation = ToQuaternion(worldTrans.getRotation());
+    bufferedPosition_ = ToVector3(worldTrans.getOrigin()) - newWorldRotation * centerOfMass_;
+    bufferedRotation_ = newWorldRotation;
+    if (!hasBufferedTransform_)
     {
-        // If the rigid body is parented to another rigid body, can not set the transform immediately.
-        // In that case store it to PhysicsWorld for delayed assignment
-        Node* parent = node_->GetParent();
-        if (parent != GetScene() && parent)
-            parentRigidBody = parent->GetComponent<RigidBody>();
-
-        if (!parentRigidBody)
-            ApplyWorldTransform(newWorldPosition, newWorldRotation);
-        else
-        {
-            DelayedWorldTransform delayed;
-            delayed.rigidBody_ = this;
-            delayed.parentRigidBody_ = parentRigidBody;
-            delayed.worldPosition_ = newWorldPosition;
-            delayed.worldRotation_ = newWorldRotation;
-            physicsWorld_->AddDelayedWorldTransform(delayed);
-        }
-
-        MarkNetworkUpdate();
+        hasBufferedTransform_ = true;
+        physicsWorld_->AddBufferedTransform(this);
     }
 }
 
@@ -230,6 +226,7 @@ void RigidBody::SetMass(float mass)
 
 void RigidBody::SetPosition(const Vector3& position)
 {
+    WaitForStep();
     if (body_)
     {
         btTransform& worldTrans = body_->getWorldTransform();
@@ -247,6 +244,7 @@ void RigidBody::SetPosition(const Vector3& position)
 
 void RigidBody::SetRotation(const Quaternion& rotation)
 {
+    WaitForStep();
     if (body_)
     {
         Vector3 oldPosition = GetPosition();
@@ -269,6 +267,7 @@ void RigidBody::SetRotation(const Quaternion& rotation)
 
 void RigidBody::SetTransform(const Vector3& position, const Quaternion& rotation)
 {
+    WaitForStep();
     if (body_)
     {
         btTransform& worldTrans = body_->getWorldTransform();
@@ -288,6 +287,7 @@ void RigidBody::SetTransform(const Vector3& position, const Quaternion& rotation
 
 void RigidBody::SetLinearVelocity(const Vector3& velocity)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setLinearVelocity(ToBtVector3(velocity));
@@ -299,6 +299,7 @@ void RigidBody::SetLinearVelocity(const Vector3& velocity)
 
 void RigidBody::SetLinearFactor(const Vector3& factor)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setLinearFactor(ToBtVector3(factor));
@@ -308,6 +309,7 @@ void RigidBody::SetLinearFactor(const Vector3& factor)
 
 void RigidBody::SetLinearRestThreshold(float threshold)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setSleepingThresholds(threshold, body_->getAngularSleepingThreshold());
@@ -317,6 +319,7 @@ void RigidBody::SetLinearRestThreshold(float threshold)
 
 void RigidBody::SetLinearDamping(float damping)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setDamping(damping, body_->getAngularDamping());
@@ -326,6 +329,7 @@ void RigidBody::SetLinearDamping(float damping)
 
 void RigidBody::SetAngularVelocity(const Vector3& velocity)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setAngularVelocity(ToBtVector3(velocity));
@@ -337,6 +341,7 @@ void RigidBody::SetAngularVelocity(const Vector3& velocity)
 
 void RigidBody::SetAngularFactor(const Vector3& factor)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setAngularFactor(ToBtVector3(factor));
@@ -346,6 +351,7 @@ void RigidBody::SetAngularFactor(const Vector3& factor)
 
 void RigidBody::SetAngularRestThreshold(float threshold)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setSleepingThresholds(body_->getLinearSleepingThreshold(), threshold);
@@ -355,6 +361,7 @@ void RigidBody::SetAngularRestThreshold(float threshold)
 
 void RigidBody::SetAngularDamping(float damping)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setDamping(body_->getLinearDamping(), damping);
@@ -364,6 +371,7 @@ void RigidBody::SetAngularDamping(float damping)
 
 void RigidBody::SetFriction(float friction)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setFriction(friction);
@@ -373,6 +381,7 @@ void RigidBody::SetFriction(float friction)
 
 void RigidBody::SetAnisotropicFriction(const Vector3& friction)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setAnisotropicFriction(ToBtVector3(friction));
@@ -382,6 +391,7 @@ void RigidBody::SetAnisotropicFriction(const Vector3& friction)
 
 void RigidBody::SetRollingFriction(float friction)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setRollingFriction(friction);
@@ -391,6 +401,7 @@ void RigidBody::SetRollingFriction(float friction)
 
 void RigidBody::SetRestitution(float restitution)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setRestitution(restitution);
@@ -400,6 +411,7 @@ void RigidBody::SetRestitution(float restitution)
 
 void RigidBody::SetContactProcessingThreshold(float threshold)
 {
+    WaitForStep();
     if (body_)
     {
         body_->setContactProcessingThreshold(threshold);
@@ -409,6 +421,7 @@ void RigidBody::SetContactProcessingThreshold(float threshold)
 
 void RigidBody::SetCcdRadius(float radius)
 {
+    WaitForStep();
     radius = Max(radius, 0.0f);
     if (body_)
     {
@@ -419,6 +432,7 @@ void RigidBody::SetCcdRadius(float radius)
 
 void RigidBody::SetCcdMotionThreshold(float threshold)
 {
+    WaitForStep();
     threshold = Max(threshold, 0.0f);
     if (body_)
     {
@@ -506,6 +520,7 @@ void RigidBody::SetCollisionEventMode(CollisionEventMode mode)
 
 void RigidBody::ApplyForce(const Vector3& force)
 {
+    WaitForStep();
     if (body_ && force != Vector3::ZERO)
     {
         Activate();
@@ -515,6 +530,7 @@ void RigidBody::ApplyForce(const Vector3& force)
 
 void RigidBody::ApplyForce(const Vector3& force, const Vector3& position)
 {
+    WaitForStep();
     if (body_ && force != Vector3::ZERO)
     {
         Activate();
@@ -524,6 +540,7 @@ void RigidBody::ApplyForce(const Vector3& force, const Vector3& position)
 
 void RigidBody::ApplyTorque(const Vector3& torque)
 {
+    WaitForStep();
     if (body_ && torque != Vector3::ZERO)
     {
         Activate();
@@ -533,6 +550,7 @@ void RigidBody::ApplyTorque(const Vector3& torque)
 
 void RigidBody::ApplyImpulse(const Vector3& impulse)
 {
+    WaitForStep();
     if (body_ && impulse != Vector3::ZERO)
     {
         Activate();
@@ -542,6 +560,7 @@ void RigidBody::ApplyImpulse(const Vector3& impulse)
 
 void RigidBody::ApplyImpulse(const Vector3& impulse, const Vector3& position)
 {
+    WaitForStep();
     if (body_ && impulse != Vector3::ZERO)
     {
         Activate();
@@ -551,6 +570,7 @@ void RigidBody::ApplyImpulse(const Vector3& impulse, const Vector3& position)
 
 void RigidBody::ApplyTorqueImpulse(const Vector3& torque)
 {
+    WaitForStep();
     if (body_ && torque != Vector3::ZERO)
     {
         Activate();
@@ -560,12 +580,14 @@ void RigidBody::ApplyTorqueImpulse(const Vector3& torque)
 
 void RigidBody::ResetForces()
 {
+    WaitForStep();
     if (body_)
         body_->clearForces();
 }
 
 void RigidBody::Activate()
 {
+    WaitForStep();
     if (body_ && mass_ > 0.0f)
         body_->activate(true);
 }
@@ -592,6 +614,7 @@ void RigidBody::EnableMassUpdate()
 
 Vector3 RigidBody::GetPosition() const
 {
+    WaitForStep();
     if (body_)
     {
         const btTransform& transform = body_->getWorldTransform();
@@ -603,91 +626,109 @@ Vector3 RigidBody::GetPosition() const
 
 Quaternion RigidBody::GetRotation() const
 {
+    WaitForStep();
     return body_ ? ToQuaternion(body_->getWorldTransform().getRotation()) : Quaternion::IDENTITY;
 }
 
 Vector3 RigidBody::GetLinearVelocity() const
 {
+    WaitForStep();
     return body_ ? ToVector3(body_->getLinearVelocity()) : Vector3::ZERO;
 }
 
 Vector3 RigidBody::GetLinearFactor() const
 {
+    WaitForStep();
     return body_ ? ToVector3(body_->getLinearFactor()) : Vector3::ZERO;
 }
 
 Vector3 RigidBody::GetVelocityAtPoint(const Vector3& position) const
 {
+    WaitForStep();
     return body_ ? ToVector3(body_->getVelocityInLocalPoint(ToBtVector3(position - centerOfMass_))) : Vector3::ZERO;
 }
 
 float RigidBody::GetLinearRestThreshold() const
 {
+    WaitForStep();
     return body_ ? body_->getLinearSleepingThreshold() : 0.0f;
 }
 
 float RigidBody::GetLinearDamping() const
 {
+    WaitForStep();
     return body_ ? body_->getLinearDamping() : 0.0f;
 }
 
 Vector3 RigidBody::GetAngularVelocity() const
 {
+    WaitForStep();
     return body_ ? ToVector3(body_->getAngularVelocity()) : Vector3::ZERO;
 }
 
 Vector3 RigidBody::GetAngularFactor() const
 {
+    WaitForStep();
     return body_ ? ToVector3(body_->getAngularFactor()) : Vector3::ZERO;
 }
 
 float RigidBody::GetAngularRestThreshold() const
 {
+    WaitForStep();
     return body_ ? body_->getAngularSleepingThreshold() : 0.0f;
 }
 
 float RigidBody::GetAngularDamping() const
 {
+    WaitForStep();
     return body_ ? body_->getAngularDamping() : 0.0f;
 }
 
 float RigidBody::GetFriction() const
 {
+    WaitForStep();
     return body_ ? body_->getFriction() : 0.0f;
 }
 
 Vector3 RigidBody::GetAnisotropicFriction() const
 {
+    WaitForStep();
     return body_ ? ToVector3(body_->getAnisotropicFriction()) : Vector3::ZERO;
 }
 
 float RigidBody::GetRollingFriction() const
 {
+    WaitForStep();
     return body_ ? body_->getRollingFriction() : 0.0f;
 }
 
 float RigidBody::GetRestitution() const
 {
+    WaitForStep();
     return body_ ? body_->getRestitution() : 0.0f;
 }
 
 float RigidBody::GetContactProcessingThreshold() const
 {
+    WaitForStep();
     return body_ ? body_->getContactProcessingThreshold() : 0.0f;
 }
 
 float RigidBody::GetCcdRadius() const
 {
+    WaitForStep();
     return body_ ? body_->getCcdSweptSphereRadius() : 0.0f;
 }
 
 float RigidBody::GetCcdMotionThreshold() const
 {
+    WaitForStep();
     return body_ ? body_->getCcdMotionThreshold() : 0.0f;
 }
 
 bool RigidBody::IsActive() const
 {
+    WaitForStep();
     return body_ ? body_->isActive() : false;
 }
 
@@ -731,8 +772,34 @@ void RigidBody::ApplyWorldTransform(const Vector3& newWorldPosition, const Quate
     physicsWorld_->SetApplyingTransforms(false);
 }
 
+void RigidBody::ApplyBufferedTransform()
+{
+    if (!hasBufferedTransform_)
+        return;
+
+    hasBufferedTransform_ = false;
+
+    // It is possible that the RigidBody component has been kept alive via a shared pointer,
+    // while its scene node has already been destroyed
+    if (node_)
+    {
+        ApplyWorldTransform(bufferedPosition_, bufferedRotation_);
+        MarkNetworkUpdate();
+    }
+}
+
+void RigidBody::CacheWorldTransform()
+{
+    if (node_)
+    {
+        lastPosition_ = node_->GetWorldPosition();
+        lastRotation_ = node_->GetWorldRotation();
+    }
+}
+
 void RigidBody::UpdateMass()
 {
+    WaitForStep();
     if (!body_ || !enableMassUpdate_)
         return;
 
@@ -806,6 +873,7 @@ void RigidBody::UpdateMass()
 
 void RigidBody::UpdateGravity()
 {
+    WaitForStep();
     if (physicsWorld_ && body_)
     {
         btDiscreteDynamicsWorld* world = physicsWorld_->GetWorld();
@@ -859,6 +927,7 @@ void RigidBody::RemoveConstraint(Constraint* constraint)
 
 void RigidBody::ReleaseBody()
 {
+    WaitForStep();
     if (body_)
     {
         // Release all constraints which refer to this body
@@ -931,6 +1000,7 @@ void RigidBody::OnNodeSet(Node* node)
 
 void RigidBody::AddBodyToWorld()
 {
+    WaitForStep();
     if (!physicsWorld_)
         return;
 
@@ -1015,6 +1085,13 @@ void RigidBody::RemoveBodyFromWorld()
     }
 }
 
+void RigidBody::WaitForStep() const
+{
+    // Bullet bodies must not be accessed from the main thread while a threaded simulation step is running
+    if (physicsWorld_)
+        physicsWorld_->WaitForStep();
+}
+
 void RigidBody::HandleTargetPosition(StringHash eventType, VariantMap& eventData)
 {
     // Copy the smoothing target position to the rigid body
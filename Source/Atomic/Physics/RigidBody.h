@@ -216,6 +216,12 @@ public:
 
     /// Apply new world transform after a simulation step. Called internally.
     void ApplyWorldTransform(const Vector3& newWorldPosition, const Quaternion& newWorldRotation);
+    /// Apply the world transform buffered during the simulation step. Called by PhysicsWorld.
+    void ApplyBufferedTransform();
+    /// Return whether a world transform is buffered and waiting to be applied.
+    bool HasBufferedTransform() const { return hasBufferedTransform_; }
+    /// Cache the node world transform for a threaded simulation step, during which the node must not be accessed. Called by PhysicsWorld.
+    void CacheWorldTransform();
     /// Update mass and inertia to the Bullet rigid body.
     void UpdateMass();
     /// Update gravity parameters to the Bullet rigid body.
@@ -242,6 +248,8 @@ private:
     void AddBodyToWorld();
     /// Remove the rigid body from the physics world.
     void RemoveBodyFromWorld();
+    /// Wait for a threaded simulation step to finish before accessing the Bullet rigid body.
+    void WaitForStep() const;
     /// Handle SmoothedTransform target position update.
     void HandleTargetPosition(StringHash eventType, VariantMap& eventData);
     /// Handle SmoothedTransform target rotation update.
@@ -275,6 +283,10 @@ private:
     mutable Vector3 lastPosition_;
     /// Last interpolated rotation from the simulation.
     mutable Quaternion lastRotation_;
+    /// World position buffered during the simulation step.
+    Vector3 bufferedPosition_;
+    /// World rotation buffered during the simulation step.
+    Quaternion bufferedRotation_;
     /// Kinematic flag.
     bool kinematic_;
     /// Trigger flag.
@@ -289,6 +301,8 @@ private:
     bool inWorld_;
     /// Mass update enable flag.
     bool enableMassUpdate_;
+    /// Transform buffered during the simulation step flag.
+    bool hasBufferedTransform_;
 };
 
 }
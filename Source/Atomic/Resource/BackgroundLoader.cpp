@@ -121,13 +121,23 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
     {
         LOGERROR("Could not load unknown resource type " + String(type));
 
-        if (sendEventOnFailure && Thread::IsMainThread())
+        if (sendEventOnFailure)
         {
             using namespace UnknownResourceType;
-            
-            VariantMap& eventData = owner_->GetEventDataMap();
-            eventData[P_RESOURCETYPE] = type;
-            owner_->SendEvent(E_UNKNOWNRESOURCETYPE, eventData);
+
+            // Resources may be queued from a background loading thread, which must post the event instead
+            if (Thread::IsMainThread())
+            {
+                VariantMap& eventData = owner_->GetEventDataMap();
+                eventData[P_RESOURCETYPE] = type;
+                owner_->SendEvent(E_UNKNOWNRESOURCETYPE, eventData);
+            }
+            else
+            {
+                VariantMap eventData;
+                eventData[P_RESOURCETYPE] = type;
+                owner_->PostEvent(E_UNKNOWNRESOURCETYPE, eventData);
+            }
         }
         
         backgroundLoadQueue_.Erase(key);
@@ -84,8 +84,7 @@ bool Resource::Save(Serializer& dest) const
 
 void Resource::SetName(const String& name)
 {
-    name_ = name;
-    nameHash_ = name;
+    name_ = InternedString(name);
 }
 
 void Resource::SetMemoryUse(unsigned size)
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Core/InternedString.h"
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 
@@ -75,9 +76,9 @@ public:
     void SetAsyncLoadState(AsyncLoadState newState);
     
     /// Return name.
-    const String& GetName() const { return name_; }
+    const String& GetName() const { return name_.GetString(); }
     /// Return name hash.
-    StringHash GetNameHash() const { return nameHash_; }
+    StringHash GetNameHash() const { return name_.GetHash(); }
     /// Return memory use in bytes, possibly approximate.
     unsigned GetMemoryUse() const { return memoryUse_; }
     /// Return time since last use in milliseconds. If referred to elsewhere than in the resource cache, returns always zero.
@@ -86,10 +87,8 @@ public:
     AsyncLoadState GetAsyncLoadState() const { return asyncLoadState_; }
     
 private:
-    /// Name.
-    String name_;
-    /// Name hash.
-    StringHash nameHash_;
+    /// Name. Interned, as resources are looked up and reloaded by name repeatedly.
+    InternedString name_;
     /// Last used timer.
     Timer useTimer_;
     /// Memory use in bytes.
@@ -355,6 +355,9 @@ void ResourceCache::ReleaseAllResources(bool force)
                 UpdateResourceGroup(i->first_);
         }
     }
+    
+    // Free the interned names of the released resources
+    InternedString::PurgeUnused();
 }
 
 bool ResourceCache::ReloadResource(Resource* resource)
@@ -487,14 +490,21 @@ SharedPtr<File> ResourceCache::GetFile(const String& nameIn, bool sendEventOnFai
         else
             LOGERROR("Could not find resource " + name);
 
+        using namespace ResourceNotFound;
+
+        // When called from a background loading thread, post the event to be sent in the main thread
         if (Thread::IsMainThread())
         {
-            using namespace ResourceNotFound;
-
             VariantMap& eventData = GetEventDataMap();
             eventData[P_RESOURCENAME] = name.Length() ? name : nameIn;
             SendEvent(E_RESOURCENOTFOUND, eventData);
         }
+        else
+        {
+            VariantMap eventData;
+            eventData[P_RESOURCENAME] = name.Length() ? name : nameIn;
+            PostEvent(E_RESOURCENOTFOUND, eventData);
+        }
     }
 
     return SharedPtr<File>();
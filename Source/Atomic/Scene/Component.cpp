@@ -35,7 +35,9 @@ namespace Atomic
 Component::Component(Context* context) :
     Animatable(context),
     node_(0),
+    storage_(0),
     id_(0),
+    storageIndex_(M_MAX_UNSIGNED),
     networkUpdate_(false),
     enabled_(true)
 {
@@ -27,6 +27,7 @@
 namespace Atomic
 {
 
+class ComponentStorage;
 class DebugRenderer;
 class Node;
 class Scene;
@@ -39,6 +40,7 @@ class ATOMIC_API Component : public Animatable
     OBJECT(Component);
     BASEOBJECT(Component);
 
+    friend class ComponentStorage;
     friend class Node;
     friend class Scene;
 
@@ -77,6 +79,10 @@ public:
 
     /// Return whether is enabled (so JS picks it up as a property);
     bool GetEnabled() const { return enabled_; }
+    /// Return the packed storage the component's data is kept in, or null if not stored.
+    ComponentStorage* GetStorage() const { return storage_; }
+    /// Return index in the packed storage.
+    unsigned GetStorageIndex() const { return storageIndex_; }
 
     /// Return whether is effectively enabled (node is also enabled.)
     bool IsEnabledEffective() const;
@@ -107,6 +113,8 @@ protected:
     virtual void OnMarkedDirty(Node* node);
     /// Handle scene node enabled status changing.
     virtual void OnNodeSetEnabled(Node* node);
+    /// Handle being added to or removed from a packed component storage. The data has already been moved.
+    virtual void OnStorageSet(ComponentStorage* storage) {}
     /// Set ID. Called by Scene.
     void SetID(unsigned id);
     /// Set scene node. Called by Node when creating the component.
@@ -116,8 +124,12 @@ protected:
 
     /// Scene node.
     Node* node_;
+    /// Packed storage of the component's data.
+    ComponentStorage* storage_;
     /// Unique ID within the scene.
     unsigned id_;
+    /// Index in the packed storage.
+    unsigned storageIndex_;
     /// Network update queued flag.
     bool networkUpdate_;
     /// Enabled flag.
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "../Scene/ComponentStorage.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+ComponentStorage::ComponentStorage(StringHash componentType) :
+    scene_(0),
+    componentType_(componentType)
+{
+}
+
+ComponentStorage::~ComponentStorage()
+{
+}
+
+void ComponentStorage::Add(Component* component)
+{
+    if (!component || component->storage_)
+        return;
+
+    component->storage_ = this;
+    component->storageIndex_ = components_.Size();
+    components_.Push(component);
+    AddData(component);
+    component->OnStorageSet(this);
+}
+
+void ComponentStorage::Remove(Component* component, bool notify)
+{
+    if (!component || component->storage_ != this)
+        return;
+
+    unsigned index = component->storageIndex_;
+    RemoveData(component, index);
+
+    Component* last = components_.Back();
+    components_[index] = last;
+    last->storageIndex_ = index;
+    components_.Pop();
+
+    component->storage_ = 0;
+    component->storageIndex_ = M_MAX_UNSIGNED;
+    if (notify)
+        component->OnStorageSet(0);
+}
+
+void ComponentStorage::RemoveAll(bool notify)
+{
+    while (components_.Size())
+        Remove(components_.Back(), notify);
+}
+
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Math/StringHash.h"
+#include "../Scene/Component.h"
+
+namespace Atomic
+{
+
+class Scene;
+
+/// Base class for opt-in per-scene storage of one component type. Keeps the frequently updated data of the components in packed arrays and updates them in batches instead of through per-component events. The components remain normal objects in their scene nodes. Add to a scene with Scene::AddComponentStorage().
+class ATOMIC_API ComponentStorage : public RefCounted
+{
+    friend class Scene;
+
+public:
+    /// Construct for a component type. Derived types of the component are not stored.
+    ComponentStorage(StringHash componentType);
+    /// Destruct.
+    virtual ~ComponentStorage();
+
+    /// Update the components in a batch after the scene update event.
+    virtual void Update(float timeStep) {}
+    /// Update the components in a batch after the scene subsystems and before the scene post-update event.
+    virtual void PostUpdate(float timeStep) {}
+
+    /// Return the component type.
+    StringHash GetComponentType() const { return componentType_; }
+    /// Return the scene, or null if not added to a scene.
+    Scene* GetScene() const { return scene_; }
+    /// Return number of stored components.
+    unsigned GetNumComponents() const { return components_.Size(); }
+    /// Return stored component by index.
+    Component* GetComponent(unsigned index) const { return index < components_.Size() ? components_[index] : (Component*)0; }
+    /// Return all stored components. The order changes when components are removed.
+    const PODVector<Component*>& GetComponents() const { return components_; }
+
+protected:
+    /// Append the data of a component to the end of the arrays.
+    virtual void AddData(Component* component) = 0;
+    /// Copy the data at an index back to the component, then move the last element of the arrays to the index and shrink them by one.
+    virtual void RemoveData(Component* component, unsigned index) = 0;
+
+    /// Stored components. The index of a component is the index of its data.
+    PODVector<Component*> components_;
+    /// Scene.
+    Scene* scene_;
+    /// Component type.
+    StringHash componentType_;
+
+private:
+    /// Add a component. Called by Scene.
+    void Add(Component* component);
+    /// Remove a component. Called by Scene. Notify is false when the component is leaving the scene, so that it does not react by subscribing to the scene's events.
+    void Remove(Component* component, bool notify = true);
+    /// Remove all components. Called by Scene.
+    void RemoveAll(bool notify = true);
+};
+
+/// Component storage template that keeps one data structure per component in a packed array. The component class T must declare the storage a friend and keep its data in a member "D localData_" while it is not stored. Access the current data through the storage and the component's storage index when the component is stored.
+template <class T, class D> class PackedComponentStorage : public ComponentStorage
+{
+public:
+    /// Construct.
+    PackedComponentStorage() :
+        ComponentStorage(T::GetTypeStatic())
+    {
+    }
+
+    /// Return the data of a component by index.
+    D& GetData(unsigned index) { return data_[index]; }
+    /// Return the data of a component by index.
+    const D& GetData(unsigned index) const { return data_[index]; }
+    /// Return the stored component by index.
+    T* GetComponent(unsigned index) const { return static_cast<T*>(components_[index]); }
+
+protected:
+    /// Append the data of a component to the end of the array.
+    virtual void AddData(Component* component) { data_.Push(static_cast<T*>(component)->localData_); }
+    /// Copy the data at an index back to the component, then move the last element to the index and shrink the array by one.
+    virtual void RemoveData(Component* component, unsigned index)
+    {
+        static_cast<T*>(component)->localData_ = data_[index];
+        data_[index] = data_.Back();
+        data_.Pop();
+    }
+
+    /// Packed component data.
+    PODVector<D> data_;
+};
+
+}
@@ -35,9 +35,12 @@ namespace Atomic
 
 LogicComponent::LogicComponent(Context* context) :
     Component(context),
+    threadedReadMask_(0),
+    threadedWriteMask_(0),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    delayedStartCalled_(false),
+    threadedUpdateListed_(false)
 {
 }
 
@@ -66,6 +69,10 @@ void LogicComponent::FixedPostUpdate(float timeStep)
 {
 }
 
+void LogicComponent::ThreadedUpdate(float timeStep)
+{
+}
+
 void LogicComponent::SetUpdateEventMask(unsigned char mask)
 {
     if (updateEventMask_ != mask)
@@ -75,6 +82,12 @@ void LogicComponent::SetUpdateEventMask(unsigned char mask)
     }
 }
 
+void LogicComponent::SetThreadedUpdateAccess(unsigned readMask, unsigned writeMask)
+{
+    threadedReadMask_ = readMask;
+    threadedWriteMask_ = writeMask;
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -109,7 +122,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
     if (needUpdate && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, HANDLER(LogicComponent, HandleSceneUpdate));
+        SubscribeToEvent(scene, TYPED_HANDLER(LogicComponent, HandleSceneUpdate));
         currentEventMask_ |= USE_UPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
@@ -121,7 +134,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(LogicComponent, HandleScenePostUpdate));
+        SubscribeToEvent(scene, TYPED_HANDLER(LogicComponent, HandleScenePostUpdate));
         currentEventMask_ |= USE_POSTUPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
@@ -130,6 +143,16 @@ void LogicComponent::UpdateEventSubscription()
         currentEventMask_ &= ~USE_POSTUPDATE;
     }
 
+    // The scene drops components without the flag from its threaded update list on the next update
+    bool needThreadedUpdate = enabled && (updateEventMask_ & USE_THREADEDUPDATE);
+    if (needThreadedUpdate && !(currentEventMask_ & USE_THREADEDUPDATE))
+    {
+        scene->AddThreadedUpdate(this);
+        currentEventMask_ |= USE_THREADEDUPDATE;
+    }
+    else if (!needThreadedUpdate && (currentEventMask_ & USE_THREADEDUPDATE))
+        currentEventMask_ &= ~USE_THREADEDUPDATE;
+
 #ifdef ATOMIC_PHYSICS
     PhysicsWorld* world = scene->GetComponent<PhysicsWorld>();
     if (!world)
@@ -161,10 +184,8 @@ void LogicComponent::UpdateEventSubscription()
 #endif 
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleSceneUpdate(const SceneUpdateEvent& payload)
 {
-    using namespace SceneUpdate;
-    
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
@@ -181,15 +202,13 @@ void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventDa
     }
     
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(payload.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(const ScenePostUpdateEvent& payload)
 {
-    using namespace ScenePostUpdate;
-    
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(payload.timeStep_);
 }
 
 #ifdef ATOMIC_PHYSICS
@@ -27,6 +27,9 @@
 namespace Atomic
 {
 
+struct SceneUpdateEvent;
+struct ScenePostUpdateEvent;
+
 /// Bitmask for using the scene update event.
 static const unsigned char USE_UPDATE = 0x1;
 /// Bitmask for using the scene post-update event.
@@ -35,12 +38,16 @@ static const unsigned char USE_POSTUPDATE = 0x2;
 static const unsigned char USE_FIXEDUPDATE = 0x4;
 /// Bitmask for using the physics post-update event.
 static const unsigned char USE_FIXEDPOSTUPDATE = 0x8;
+/// Bitmask for using the threaded update phase of the scene.
+static const unsigned char USE_THREADEDUPDATE = 0x10;
 
 /// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
 class ATOMIC_API LogicComponent : public Component
 {
     OBJECT(LogicComponent);
     
+    friend class Scene;
+    
     /// Construct.
     LogicComponent(Context* context);
     /// Destruct.
@@ -62,14 +69,22 @@ class ATOMIC_API LogicComponent : public Component
     virtual void FixedUpdate(float timeStep);
     /// Called on physics post-update, fixed timestep.
     virtual void FixedPostUpdate(float timeStep);
+    /// Called on scene update after the scene update event, variable timestep, in parallel with other components, possibly in a worker thread. Enabled with USE_THREADEDUPDATE, which is not set by default. May modify the own node hierarchy and the data channels declared with SetThreadedUpdateAccess(). Must not send events, create or remove nodes or components, or access other nodes.
+    virtual void ThreadedUpdate(float timeStep);
     
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(unsigned char mask);
+    /// Declare the data ThreadedUpdate() reads and writes outside the own node hierarchy, as bitmasks of application-defined data channels. Components writing a channel are updated before the components that only read, and components sharing a written channel are updated serially. Like the update event mask, this is not an attribute and should be called eg. in the subclass constructor.
+    void SetThreadedUpdateAccess(unsigned readMask, unsigned writeMask);
     
     /// Return what update events are subscribed to.
     unsigned char GetUpdateEventMask() const { return updateEventMask_; }
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
+    /// Return the data channels read by ThreadedUpdate().
+    unsigned GetThreadedUpdateReadMask() const { return threadedReadMask_; }
+    /// Return the data channels written by ThreadedUpdate().
+    unsigned GetThreadedUpdateWriteMask() const { return threadedWriteMask_; }
     
 protected:
     /// Handle scene node being assigned at creation.
@@ -79,21 +94,27 @@ private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(const SceneUpdateEvent& payload);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const ScenePostUpdateEvent& payload);
 #ifdef ATOMIC_PHYSICS
     /// Handle physics pre-step event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
     /// Handle physics post-step event.
     void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
 #endif
+    /// Data channels read by the threaded update.
+    unsigned threadedReadMask_;
+    /// Data channels written by the threaded update.
+    unsigned threadedWriteMask_;
     /// Requested event subscription mask.
     unsigned char updateEventMask_;
     /// Current event subscription mask.
     unsigned char currentEventMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Listed in the scene's threaded update components flag. Accessed by Scene.
+    bool threadedUpdateListed_;
 };
 
 }
@@ -21,11 +21,14 @@
 //
 
 #include "Precompiled.h"
+#include "../Container/LinearAllocator.h"
+#include "../Container/Sort.h"
 #include "../Scene/Component.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../IO/File.h"
 #include "../IO/Log.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../IO/PackageFile.h"
 #include "../Core/Profiler.h"
@@ -52,6 +55,43 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const unsigned THREADED_UPDATE_ITEMS_PER_THREAD = 4;
+static const unsigned NUM_DATA_CHANNELS = 32;
+
+/// Return the ancestor of a node that is a direct child of the scene.
+static Node* GetTopLevelNode(Node* node, Scene* scene)
+{
+    while (node->GetParent() && node->GetParent() != scene)
+        node = node->GetParent();
+    return node;
+}
+
+/// Return the group of a component in the union-find array, compressing the path.
+static unsigned FindGroup(PODVector<unsigned, ThreadBufferAllocator>& groups, unsigned index)
+{
+    while (groups[index] != index)
+    {
+        groups[index] = groups[groups[index]];
+        index = groups[index];
+    }
+    return index;
+}
+
+/// Merge the groups of two components in the union-find array.
+static void MergeGroups(PODVector<unsigned, ThreadBufferAllocator>& groups, unsigned first, unsigned second)
+{
+    groups[FindGroup(groups, first)] = FindGroup(groups, second);
+}
+
+static void ThreadedUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    LogicComponent** start = reinterpret_cast<LogicComponent**>(item->start_);
+    LogicComponent** end = reinterpret_cast<LogicComponent**>(item->end_);
+    float timeStep = *reinterpret_cast<float*>(item->aux_);
+
+    while (start != end)
+        (*start++)->ThreadedUpdate(timeStep);
+}
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -73,7 +113,7 @@ Scene::Scene(Context* context) :
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, HANDLER(Scene, HandleUpdate));
+    SubscribeToEvent(TYPED_HANDLER(Scene, HandleUpdate));
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
@@ -84,10 +124,17 @@ Scene::~Scene()
     RemoveAllComponents();
     RemoveAllChildren();
 
+    // Return data to any components that still exist
+    for (HashMap<StringHash, SharedPtr<ComponentStorage> >::Iterator i = componentStorages_.Begin(); i != componentStorages_.End(); ++i)
+    {
+        i->second_->RemoveAll(false);
+        i->second_->scene_ = 0;
+    }
+
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
 }
 
@@ -190,7 +237,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -537,11 +584,44 @@ void Scene::UnregisterAllVars()
     varNames_.Clear();
 }
 
+void Scene::AddComponentStorage(ComponentStorage* storage)
+{
+    if (!storage || storage->scene_)
+        return;
+
+    StringHash componentType = storage->GetComponentType();
+    RemoveComponentStorage(componentType);
+    componentStorages_[componentType] = storage;
+    storage->scene_ = this;
+
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    {
+        if (i->second_->GetType() == componentType)
+            storage->Add(i->second_);
+    }
+    for (FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Begin(); i != localComponents_.End(); ++i)
+    {
+        if (i->second_->GetType() == componentType)
+            storage->Add(i->second_);
+    }
+}
+
+void Scene::RemoveComponentStorage(StringHash componentType)
+{
+    HashMap<StringHash, SharedPtr<ComponentStorage> >::Iterator i = componentStorages_.Find(componentType);
+    if (i == componentStorages_.End())
+        return;
+
+    i->second_->RemoveAll();
+    i->second_->scene_ = 0;
+    componentStorages_.Erase(i);
+}
+
 Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End())
             return i->second_;
         else
@@ -549,7 +629,7 @@ Node* Scene::GetNode(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
         if (i != localNodes_.End())
             return i->second_;
         else
@@ -561,7 +641,7 @@ Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End())
             return i->second_;
         else
@@ -569,7 +649,7 @@ Component* Scene::GetComponent(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
         if (i != localComponents_.End())
             return i->second_;
         else
@@ -594,6 +674,12 @@ const String& Scene::GetVarName(StringHash hash) const
     return i != varNames_.End() ? i->second_ : String::EMPTY;
 }
 
+ComponentStorage* Scene::GetComponentStorage(StringHash componentType) const
+{
+    HashMap<StringHash, SharedPtr<ComponentStorage> >::ConstIterator i = componentStorages_.Find(componentType);
+    return i != componentStorages_.End() ? i->second_.Get() : 0;
+}
+
 void Scene::Update(float timeStep)
 {
     if (asyncLoading_)
@@ -608,15 +694,20 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
+    // Update variable timestep logic
+    SendTypedEvent(SceneUpdateEvent(this, timeStep));
+    ThreadedUpdateComponents(timeStep);
+
+    // Update packed component storages
+    for (HashMap<StringHash, SharedPtr<ComponentStorage> >::Iterator i = componentStorages_.Begin(); i != componentStorages_.End(); ++i)
+        i->second_->Update(timeStep);
+
     using namespace SceneUpdate;
 
     VariantMap& eventData = GetEventDataMap();
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
 
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
-
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
@@ -637,8 +728,17 @@ void Scene::Update(float timeStep)
         SendEvent(E_UPDATESMOOTHING, smoothingData_);
     }
 
+    // Post-update packed component storages, including transform smoothing of stored components
+    if (!componentStorages_.Empty())
+    {
+        PROFILE(PostUpdateComponentStorages);
+
+        for (HashMap<StringHash, SharedPtr<ComponentStorage> >::Iterator i = componentStorages_.Begin(); i != componentStorages_.End(); ++i)
+            i->second_->PostUpdate(timeStep);
+    }
+
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    SendTypedEvent(ScenePostUpdateEvent(this, timeStep));
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -676,6 +776,15 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::AddThreadedUpdate(LogicComponent* component)
+{
+    if (!component || component->threadedUpdateListed_)
+        return;
+
+    threadedUpdateComponents_.Push(WeakPtr<LogicComponent>(component));
+    component->threadedUpdateListed_ = true;
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -767,7 +876,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -781,7 +890,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -825,7 +934,7 @@ void Scene::ComponentAdded(Component* component)
     unsigned id = component->GetID();
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -836,7 +945,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -845,6 +954,13 @@ void Scene::ComponentAdded(Component* component)
 
         localComponents_[id] = component;
     }
+
+    if (!componentStorages_.Empty())
+    {
+        HashMap<StringHash, SharedPtr<ComponentStorage> >::Iterator i = componentStorages_.Find(component->GetType());
+        if (i != componentStorages_.End())
+            i->second_->Add(component);
+    }
 }
 
 void Scene::ComponentRemoved(Component* component)
@@ -858,6 +974,10 @@ void Scene::ComponentRemoved(Component* component)
     else
         localComponents_.Erase(id);
 
+    // The component is leaving the scene, so detach it from the storage without letting it subscribe to the scene's events
+    if (component->storage_)
+        component->storage_->Remove(component, false);
+
     component->SetID(0);
 }
 
@@ -909,10 +1029,10 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
@@ -959,12 +1079,133 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::HandleUpdate(const UpdateEvent& payload)
 {
-    using namespace Update;
-
     if (updateEnabled_)
-        Update(eventData[P_TIMESTEP].GetFloat());
+        Update(payload.timeStep_);
+}
+
+void Scene::ThreadedUpdateComponents(float timeStep)
+{
+    if (threadedUpdateComponents_.Empty())
+        return;
+
+    PROFILE(ThreadedUpdateComponents);
+
+    // Drop expired, disabled and removed components, and split the rest to writers and readers of data channels
+    PODVector<LogicComponent*, ThreadBufferAllocator> writers;
+    PODVector<LogicComponent*, ThreadBufferAllocator> readers;
+    for (unsigned i = 0; i < threadedUpdateComponents_.Size();)
+    {
+        LogicComponent* component = threadedUpdateComponents_[i];
+        if (!component || !(component->currentEventMask_ & USE_THREADEDUPDATE) || component->GetScene() != this)
+        {
+            if (component)
+                component->threadedUpdateListed_ = false;
+            if (i < threadedUpdateComponents_.Size() - 1)
+                threadedUpdateComponents_[i] = threadedUpdateComponents_.Back();
+            threadedUpdateComponents_.Pop();
+            continue;
+        }
+
+        ++i;
+        // The scene update event calls DelayedStart() before the first update
+        if (!component->delayedStartCalled_)
+            continue;
+        if (component->threadedWriteMask_)
+            writers.Push(component);
+        else
+            readers.Push(component);
+    }
+
+    // Update the writers of data channels first, so that the readers see the finished data. Node transform changes
+    // are delayed by the components listening to them
+    BeginThreadedUpdate();
+    if (!writers.Empty())
+        RunThreadedUpdates(&writers[0], writers.Size(), true, timeStep);
+    if (!readers.Empty())
+        RunThreadedUpdates(&readers[0], readers.Size(), false, timeStep);
+    EndThreadedUpdate();
+}
+
+void Scene::RunThreadedUpdates(LogicComponent** components, unsigned count, bool groupByChannels, float timeStep)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue->GetNumThreads();
+    if (!numThreads)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            components[i]->ThreadedUpdate(timeStep);
+        return;
+    }
+
+    // Components under the same top-level node update serially, as transform changes propagate down the hierarchy
+    PODVector<KeyIndex, ThreadBufferAllocator> keys(count);
+    PODVector<KeyIndex, ThreadBufferAllocator> temp(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        keys[i].key_ = (unsigned long long)(size_t)GetTopLevelNode(components[i]->GetNode(), this);
+        keys[i].index_ = i;
+    }
+    RadixSort(&keys[0], &temp[0], count);
+
+    // Components using the same data channels also update serially
+    if (groupByChannels)
+    {
+        PODVector<unsigned, ThreadBufferAllocator> groups(count);
+        for (unsigned i = 0; i < count; ++i)
+            groups[i] = i;
+
+        unsigned channelOwners[NUM_DATA_CHANNELS];
+        for (unsigned i = 0; i < NUM_DATA_CHANNELS; ++i)
+            channelOwners[i] = M_MAX_UNSIGNED;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            unsigned index = keys[i].index_;
+            if (i && keys[i].key_ == keys[i - 1].key_)
+                MergeGroups(groups, index, keys[i - 1].index_);
+
+            unsigned channels = components[index]->threadedReadMask_ | components[index]->threadedWriteMask_;
+            for (unsigned j = 0; j < NUM_DATA_CHANNELS; ++j)
+            {
+                if (!(channels & (1u << j)))
+                    continue;
+                if (channelOwners[j] == M_MAX_UNSIGNED)
+                    channelOwners[j] = index;
+                else
+                    MergeGroups(groups, index, channelOwners[j]);
+            }
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+            keys[i].key_ = FindGroup(groups, keys[i].index_);
+        RadixSort(&keys[0], &temp[0], count);
+    }
+
+    PODVector<LogicComponent*, ThreadBufferAllocator> unordered(components, count);
+    for (unsigned i = 0; i < count; ++i)
+        components[i] = unordered[keys[i].index_];
+
+    // Split to work items at group boundaries, a few items per thread for load balancing
+    unsigned itemSize = Max((int)(count / ((numThreads + 1) * THREADED_UPDATE_ITEMS_PER_THREAD)), 1);
+    unsigned start = 0;
+    for (unsigned i = 1; i <= count; ++i)
+    {
+        if (i == count || (i - start >= itemSize && keys[i].key_ != keys[i - 1].key_))
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = ThreadedUpdateWork;
+            item->start_ = components + start;
+            item->end_ = components + i;
+            item->aux_ = &timeStep;
+            queue->AddWorkItem(item);
+            start = i;
+        }
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
 }
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
@@ -1235,4 +1476,36 @@ void RegisterSceneLibrary(Context* context)
     SplinePath::RegisterObject(context);
 }
 
+void SceneUpdateEvent::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace SceneUpdate;
+
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
+void SceneUpdateEvent::FromVariantMap(VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    scene_ = static_cast<Scene*>(eventData[P_SCENE].GetPtr());
+    timeStep_ = eventData[P_TIMESTEP].GetFloat();
+}
+
+void ScenePostUpdateEvent::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace ScenePostUpdate;
+
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
+void ScenePostUpdateEvent::FromVariantMap(VariantMap& eventData)
+{
+    using namespace ScenePostUpdate;
+
+    scene_ = static_cast<Scene*>(eventData[P_SCENE].GetPtr());
+    timeStep_ = eventData[P_TIMESTEP].GetFloat();
+}
+
 }
@@ -22,8 +22,10 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 #include "../Core/Mutex.h"
+#include "../Scene/ComponentStorage.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
 #include "../Resource/XMLElement.h"
@@ -32,7 +34,9 @@ namespace Atomic
 {
 
 class File;
+class LogicComponent;
 class PackageFile;
+struct UpdateEvent;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -140,6 +144,10 @@ public:
     void UnregisterVar(const String& name);
     /// Clear all registered node user variable hash reverse mappings.
     void UnregisterAllVars();
+    /// Add a packed storage for a component type. Existing and future components of that exact type in the scene move their data into it. Replaces an existing storage of the same type.
+    void AddComponentStorage(ComponentStorage* storage);
+    /// Remove the packed storage of a component type. The components take their data back.
+    void RemoveComponentStorage(StringHash componentType);
 
     /// Return node from the whole scene by ID, or null if not found.
     Node* GetNode(unsigned id) const;
@@ -171,6 +179,8 @@ public:
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
     /// Return a node user variable name, or empty if not registered.
     const String& GetVarName(StringHash hash) const;
+    /// Return the packed storage of a component type, or null if none.
+    ComponentStorage* GetComponentStorage(StringHash componentType) const;
 
     /// Update scene. Called by HandleUpdate.
     void Update(float timeStep);
@@ -180,6 +190,8 @@ public:
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Add a logic component to the threaded update phase. Called by LogicComponent.
+    void AddThreadedUpdate(LogicComponent* component);
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
     /// Get free node ID, either non-local or local.
@@ -211,7 +223,11 @@ public:
 
 private:
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(const UpdateEvent& payload);
+    /// Run the threaded update of logic components, in the work queue's threads if available.
+    void ThreadedUpdateComponents(float timeStep);
+    /// Reorder components into groups that must update serially, and update the groups in parallel in the work queue. Groups by top-level node, and optionally by shared data channels.
+    void RunThreadedUpdates(LogicComponent** components, unsigned count, bool groupByChannels, float timeStep);
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
@@ -228,13 +244,13 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    FlatHashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    FlatHashMap<unsigned, Component*> localComponents_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
@@ -249,6 +265,10 @@ private:
     HashSet<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     HashSet<unsigned> networkUpdateComponents_;
+    /// Packed component storages by component type.
+    HashMap<StringHash, SharedPtr<ComponentStorage> > componentStorages_;
+    /// Logic components using the threaded update phase. Compacted on each update.
+    Vector<WeakPtr<LogicComponent> > threadedUpdateComponents_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
@@ -27,6 +27,8 @@
 namespace Atomic
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -93,6 +95,52 @@ EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of the variable timestep scene update event.
+struct ATOMIC_API SceneUpdateEvent
+{
+    /// Construct.
+    SceneUpdateEvent(Scene* scene = 0, float timeStep = 0.0f) :
+        scene_(scene),
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_SCENEUPDATE; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const;
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData);
+
+    /// Scene.
+    Scene* scene_;
+    /// Time step.
+    float timeStep_;
+};
+
+/// Typed payload of the variable timestep scene post-update event.
+struct ATOMIC_API ScenePostUpdateEvent
+{
+    /// Construct.
+    ScenePostUpdateEvent(Scene* scene = 0, float timeStep = 0.0f) :
+        scene_(scene),
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_SCENEPOSTUPDATE; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const;
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData);
+
+    /// Scene.
+    Scene* scene_;
+    /// Time step.
+    float timeStep_;
+};
+
 /// Asynchronous scene loading progress.
 EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
@@ -31,13 +31,52 @@
 namespace Atomic
 {
 
+/// Move a node toward the smoothing targets and clear the completed smoothing operations.
+static void ApplySmoothing(Node* node, SmoothedTransformData& data, float constant, float squaredSnapThreshold)
+{
+    Vector3 position = node->GetPosition();
+    Quaternion rotation = node->GetRotation();
+
+    if (data.smoothingMask_ & SMOOTH_POSITION)
+    {
+        // If position snaps, snap everything to the end
+        float delta = (position - data.targetPosition_).LengthSquared();
+        if (delta > squaredSnapThreshold)
+            constant = 1.0f;
+
+        if (delta < M_EPSILON || constant >= 1.0f)
+        {
+            position = data.targetPosition_;
+            data.smoothingMask_ &= ~SMOOTH_POSITION;
+        }
+        else
+            position = position.Lerp(data.targetPosition_, constant);
+
+        node->SetPosition(position);
+    }
+
+    if (data.smoothingMask_ & SMOOTH_ROTATION)
+    {
+        float delta = (rotation - data.targetRotation_).LengthSquared();
+        if (delta < M_EPSILON || constant >= 1.0f)
+        {
+            rotation = data.targetRotation_;
+            data.smoothingMask_ &= ~SMOOTH_ROTATION;
+        }
+        else
+            rotation = rotation.Slerp(data.targetRotation_, constant);
+
+        node->SetRotation(rotation);
+    }
+}
+
 SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
-    targetPosition_(Vector3::ZERO),
-    targetRotation_(Quaternion::IDENTITY),
-    smoothingMask_(SMOOTH_NONE),
     subscribed_(false)
 {
+    localData_.targetPosition_ = Vector3::ZERO;
+    localData_.targetRotation_ = Quaternion::IDENTITY;
+    localData_.smoothingMask_ = SMOOTH_NONE;
 }
 
 SmoothedTransform::~SmoothedTransform()
@@ -51,77 +90,34 @@ void SmoothedTransform::RegisterObject(Context* context)
 
 void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
 {
-    if (smoothingMask_ && node_)
-    {
-        Vector3 position = node_->GetPosition();
-        Quaternion rotation = node_->GetRotation();
-
-        if (smoothingMask_ & SMOOTH_POSITION)
-        {
-            // If position snaps, snap everything to the end
-            float delta = (position - targetPosition_).LengthSquared();
-            if (delta > squaredSnapThreshold)
-                constant = 1.0f;
-
-            if (delta < M_EPSILON || constant >= 1.0f)
-            {
-                position = targetPosition_;
-                smoothingMask_ &= ~SMOOTH_POSITION;
-            }
-            else
-                position = position.Lerp(targetPosition_, constant);
-
-            node_->SetPosition(position);
-        }
-
-        if (smoothingMask_ & SMOOTH_ROTATION)
-        {
-            float delta = (rotation - targetRotation_).LengthSquared();
-            if (delta < M_EPSILON || constant >= 1.0f)
-            {
-                rotation = targetRotation_;
-                smoothingMask_ &= ~SMOOTH_ROTATION;
-            }
-            else
-                rotation = rotation.Slerp(targetRotation_, constant);
-
-            node_->SetRotation(rotation);
-        }
-    }
+    SmoothedTransformData& data = GetData();
+    if (data.smoothingMask_ && node_)
+        ApplySmoothing(node_, data, constant, squaredSnapThreshold);
 
     // If smoothing has completed, unsubscribe from the update event
-    if (!smoothingMask_)
-    {
-        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
-        subscribed_ = false;
-    }
+    if (!data.smoothingMask_)
+        UpdateEventSubscription();
 }
 
 void SmoothedTransform::SetTargetPosition(const Vector3& position)
 {
-    targetPosition_ = position;
-    smoothingMask_ |= SMOOTH_POSITION;
+    SmoothedTransformData& data = GetData();
+    data.targetPosition_ = position;
+    data.smoothingMask_ |= SMOOTH_POSITION;
 
     // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    UpdateEventSubscription();
 
     SendEvent(E_TARGETPOSITION);
 }
 
 void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 {
-    targetRotation_ = rotation;
-    smoothingMask_ |= SMOOTH_ROTATION;
+    SmoothedTransformData& data = GetData();
+    data.targetRotation_ = rotation;
+    data.smoothingMask_ |= SMOOTH_ROTATION;
 
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    UpdateEventSubscription();
 
     SendEvent(E_TARGETROTATION);
 }
@@ -145,17 +141,17 @@ void SmoothedTransform::SetTargetWorldRotation(const Quaternion& rotation)
 Vector3 SmoothedTransform::GetTargetWorldPosition() const
 {
     if (node_ && node_->GetParent())
-        return node_->GetParent()->GetWorldTransform() * targetPosition_;
+        return node_->GetParent()->GetWorldTransform() * GetData().targetPosition_;
     else
-        return targetPosition_;
+        return GetData().targetPosition_;
 }
 
 Quaternion SmoothedTransform::GetTargetWorldRotation() const
 {
     if (node_ && node_->GetParent())
-        return node_->GetParent()->GetWorldRotation() * targetRotation_;
+        return node_->GetParent()->GetWorldRotation() * GetData().targetRotation_;
     else
-        return targetRotation_;
+        return GetData().targetRotation_;
 }
 
 void SmoothedTransform::OnNodeSet(Node* node)
@@ -163,8 +159,34 @@ void SmoothedTransform::OnNodeSet(Node* node)
     if (node)
     {
         // Copy initial target transform
-        targetPosition_ = node->GetPosition();
-        targetRotation_ = node->GetRotation();
+        SmoothedTransformData& data = GetData();
+        data.targetPosition_ = node->GetPosition();
+        data.targetRotation_ = node->GetRotation();
+    }
+}
+
+void SmoothedTransform::OnStorageSet(ComponentStorage* storage)
+{
+    // The storage updates its components in a batch, so the update event is only needed while not stored
+    UpdateEventSubscription();
+}
+
+void SmoothedTransform::UpdateEventSubscription()
+{
+    bool needUpdate = !storage_ && GetData().smoothingMask_;
+    if (needUpdate && !subscribed_)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+        {
+            SubscribeToEvent(scene, E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+            subscribed_ = true;
+        }
+    }
+    else if (!needUpdate && subscribed_)
+    {
+        UnsubscribeFromEvent(E_UPDATESMOOTHING);
+        subscribed_ = false;
     }
 }
 
@@ -177,4 +199,26 @@ void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap&
     Update(constant, squaredSnapThreshold);
 }
 
+void SmoothedTransformStorage::PostUpdate(float timeStep)
+{
+    if (!scene_ || data_.Empty())
+        return;
+
+    float constant = 1.0f - Clamp(powf(2.0f, -timeStep * scene_->GetSmoothingConstant()), 0.0f, 1.0f);
+    float snapThreshold = scene_->GetSnapThreshold();
+    float squaredSnapThreshold = snapThreshold * snapThreshold;
+
+    // Scan the packed masks and touch only the nodes that are being smoothed
+    for (unsigned i = 0; i < data_.Size(); ++i)
+    {
+        SmoothedTransformData& data = data_[i];
+        if (!data.smoothingMask_)
+            continue;
+
+        Node* node = components_[i]->GetNode();
+        if (node)
+            ApplySmoothing(node, data, constant, squaredSnapThreshold);
+    }
+}
+
 }
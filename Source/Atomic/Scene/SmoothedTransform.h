@@ -22,7 +22,7 @@
 
 #pragma once
 
-#include "../Scene/Component.h"
+#include "../Scene/ComponentStorage.h"
 
 namespace Atomic
 {
@@ -34,11 +34,27 @@ static const unsigned SMOOTH_POSITION = 1;
 /// Ongoing rotation smoothing.
 static const unsigned SMOOTH_ROTATION = 2;
 
+/// Smoothing data of a SmoothedTransform component.
+struct SmoothedTransformData
+{
+    /// Target position.
+    Vector3 targetPosition_;
+    /// Target rotation.
+    Quaternion targetRotation_;
+    /// Active smoothing operations bitmask.
+    unsigned char smoothingMask_;
+};
+
+class SmoothedTransformStorage;
+
 /// Transform smoothing component for network updates.
 class ATOMIC_API SmoothedTransform : public Component
 {
     OBJECT(SmoothedTransform);
     
+    friend class PackedComponentStorage<SmoothedTransform, SmoothedTransformData>;
+    friend class SmoothedTransformStorage;
+    
 public:
     /// Construct.
     SmoothedTransform(Context* context);
@@ -59,32 +75,56 @@ public:
     void SetTargetWorldRotation(const Quaternion& rotation);
     
     /// Return target position in parent space.
-    const Vector3& GetTargetPosition() const { return targetPosition_; }
+    const Vector3& GetTargetPosition() const { return GetData().targetPosition_; }
     /// Return target rotation in parent space.
-    const Quaternion& GetTargetRotation() const { return targetRotation_; }
+    const Quaternion& GetTargetRotation() const { return GetData().targetRotation_; }
     /// Return target position in world space.
     Vector3 GetTargetWorldPosition() const;
     /// Return target rotation in world space.
     Quaternion GetTargetWorldRotation() const;
     /// Return whether smoothing is in progress.
-    bool IsInProgress() const { return smoothingMask_ != 0; }
+    bool IsInProgress() const { return GetData().smoothingMask_ != 0; }
     
 protected:
     /// Handle scene node being assigned at creation.
     virtual void OnNodeSet(Node* node);
+    /// Handle being added to or removed from a packed component storage.
+    virtual void OnStorageSet(ComponentStorage* storage);
     
 private:
+    /// Return the smoothing data, either from the packed storage or the component.
+    SmoothedTransformData& GetData();
+    /// Return the smoothing data, either from the packed storage or the component.
+    const SmoothedTransformData& GetData() const;
+    /// Subscribe to the smoothing update event if smoothing is in progress and the component is not stored, or unsubscribe otherwise.
+    void UpdateEventSubscription();
     /// Handle smoothing update event.
     void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
     
-    /// Target position.
-    Vector3 targetPosition_;
-    /// Target rotation.
-    Quaternion targetRotation_;
-    /// Active smoothing operations bitmask.
-    unsigned char smoothingMask_;
+    /// Smoothing data while not in a packed storage.
+    SmoothedTransformData localData_;
     /// Subscribed to smoothing update event flag.
     bool subscribed_;
 };
 
+/// Packed storage of SmoothedTransform components, which smooths all of them in one loop instead of through per-component update events. Opt-in by adding to the scene with Scene::AddComponentStorage().
+class ATOMIC_API SmoothedTransformStorage : public PackedComponentStorage<SmoothedTransform, SmoothedTransformData>
+{
+public:
+    /// Update smoothing of all stored components.
+    virtual void PostUpdate(float timeStep);
+};
+
+inline SmoothedTransformData& SmoothedTransform::GetData()
+{
+    return storage_ ? static_cast<PackedComponentStorage<SmoothedTransform, SmoothedTransformData>*>(storage_)->GetData(storageIndex_) :
+        localData_;
+}
+
+inline const SmoothedTransformData& SmoothedTransform::GetData() const
+{
+    return storage_ ? static_cast<const PackedComponentStorage<SmoothedTransform, SmoothedTransformData>*>(storage_)->GetData(storageIndex_) :
+        localData_;
+}
+
 }
@@ -282,7 +282,7 @@ Variant ValueAnimation::GetAnimationValue(float scaledTime)
     }
 }
 
-void ValueAnimation::GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*>& eventFrames) const
+void ValueAnimation::GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*, ThreadBufferAllocator>& eventFrames) const
 {
     for (unsigned i = 0; i < eventFrames_.Size(); ++i)
     {
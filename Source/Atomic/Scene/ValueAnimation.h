@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/LinearAllocator.h"
 #include "../Resource/Resource.h"
 #include "../Core/Variant.h"
 
@@ -114,7 +115,7 @@ public:
     /// Has event frames.
     bool HasEventFrames() const { return !eventFrames_.Empty(); }
     /// Return all event frames between time.
-    void GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*>& eventFrames) const;
+    void GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*, ThreadBufferAllocator>& eventFrames) const;
 
 protected:
     /// Linear interpolation.
@@ -86,7 +86,7 @@ bool ValueAnimationInfo::Update(float timeStep)
     // Send keyframe event if necessary
     if (animation_->HasEventFrames())
     {
-        PODVector<const VAnimEventFrame*> eventFrames;
+        PODVector<const VAnimEventFrame*, ThreadBufferAllocator> eventFrames;
         GetEventFrames(lastScaledTime_, scaledTime, eventFrames);
 
         for (unsigned i = 0; i < eventFrames.Size(); ++i)
@@ -136,7 +136,7 @@ float ValueAnimationInfo::CalculateScaledTime(float currentTime, bool& finished)
     }
 }
 
-void ValueAnimationInfo::GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*>& eventFrames)
+void ValueAnimationInfo::GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*, ThreadBufferAllocator>& eventFrames)
 {
     switch (wrapMode_)
     {
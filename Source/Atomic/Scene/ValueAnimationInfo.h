@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Scene/AnimationDefs.h"
+#include "../Container/LinearAllocator.h"
 #include "../Container/RefCounted.h"
 
 namespace Atomic
@@ -67,7 +68,7 @@ protected:
     /// Calculate scaled time.
     float CalculateScaledTime(float currentTime, bool& finished) const;
     /// Return event frames.
-    void GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*>& eventFrames);
+    void GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*, ThreadBufferAllocator>& eventFrames);
 
     /// Target object.
     WeakPtr<Object> target_;
@@ -969,8 +969,11 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 
 		int								depth=1;
 		int								treshold=DOUBLE_STACKSIZE-2;
-		btAlignedObjectArray<const btDbvtNode*>&	stack = m_rayTestStack;
-		stack.resize(DOUBLE_STACKSIZE);
+		// Atomic: traverse with a local stack so that rays can be cast from several threads at once.
+		// Only spill to the heap if the tree is deeper than the fixed stack
+		const btDbvtNode*				localStack[DOUBLE_STACKSIZE];
+		btAlignedObjectArray<const btDbvtNode*>	heapStack;
+		const btDbvtNode**				stack = localStack;
 		stack[0]=root;
 		btVector3 bounds[2];
 		do	
@@ -987,8 +990,17 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 				{
 					if(depth>treshold)
 					{
-						stack.resize(stack.size()*2);
-						treshold=stack.size()-2;
+						if(heapStack.size()==0)
+						{
+							heapStack.resize(DOUBLE_STACKSIZE*2);
+							for(int i=0;i<depth;++i) heapStack[i]=localStack[i];
+						}
+						else
+						{
+							heapStack.resize(heapStack.size()*2);
+						}
+						stack=&heapStack[0];
+						treshold=heapStack.size()-2;
 					}
 					stack[depth++]=node->childs[0];
 					stack[depth++]=node->childs[1];
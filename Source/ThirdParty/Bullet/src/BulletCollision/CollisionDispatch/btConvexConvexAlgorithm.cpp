@@ -350,7 +350,10 @@ void btConvexConvexAlgorithm ::processCollision (const btCollisionObjectWrapper*
 	
 	btGjkPairDetector::ClosestPointInput input;
 
-	btGjkPairDetector	gjkPairDetector(min0,min1,m_simplexSolver,m_pdSolver);
+	// Atomic: use a local simplex solver so that pairs can be processed from several threads at once
+	// (the shared solver from the collision configuration holds per-query state)
+	btVoronoiSimplexSolver localSimplexSolver;
+	btGjkPairDetector	gjkPairDetector(min0,min1,&localSimplexSolver,m_pdSolver);
 	//TODO: if (dispatchInfo.m_useContinuous)
 	gjkPairDetector.setMinkowskiA(min0);
 	gjkPairDetector.setMinkowskiB(min1);
@@ -198,6 +198,17 @@ struct dtCrowdAgentDebugInfo
 	dtObstacleAvoidanceDebugData* vod;
 };
 
+// Atomic: callbacks for running the per-agent phases of dtCrowd::update() in parallel.
+
+/// Processes the items [@p begin, @p end) of a crowd update phase.
+///  @param[in]		context		The phase context passed to the parallel for callback.
+///  @param[in]		threadIndex	The index of the calling thread. [Limits: 0 <= value < maxThreads]
+typedef void (dtCrowdRangeFunc)(void* context, const int begin, const int end, const int threadIndex);
+
+/// Runs @p func over the items [0, @p count), split into ranges that may be processed in parallel.
+/// Must return only after all ranges have been processed.
+typedef void (dtCrowdParallelForFunc)(void* userData, dtCrowdRangeFunc* func, void* context, const int count);
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
@@ -227,6 +238,36 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	// Atomic: parallel update state.
+	dtCrowdParallelForFunc* m_parallelFor;
+	void* m_parallelForUserData;
+	int m_maxThreads;
+	dtNavMeshQuery** m_threadNavQueries;
+	dtObstacleAvoidanceQuery** m_threadObstacleQueries;
+	int* m_threadVelocitySampleCounts;
+	int m_updateAgentCount;
+	float m_updateDt;
+	dtCrowdAgentDebugInfo* m_updateDebug;
+
+	typedef void (dtCrowd::*PhaseFunc)(const int begin, const int end, const int threadIndex);
+	struct PhaseContext
+	{
+		dtCrowd* crowd;
+		PhaseFunc func;
+	};
+	static void runPhaseRange(void* context, const int begin, const int end, const int threadIndex);
+	void runPhase(PhaseFunc func, const int count);
+	void freeThreadQueries();
+
+	void updateNeighbours(const int begin, const int end, const int threadIndex);
+	void updateCorners(const int begin, const int end, const int threadIndex);
+	void updateSteering(const int begin, const int end, const int threadIndex);
+	void updateVelocityPlanning(const int begin, const int end, const int threadIndex);
+	void updateIntegration(const int begin, const int end, const int threadIndex);
+	void updateCollisionDisplacement(const int begin, const int end, const int threadIndex);
+	void applyCollisionDisplacement(const int begin, const int end, const int threadIndex);
+	void updateMovePosition(const int begin, const int end, const int threadIndex);
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
@@ -248,6 +289,14 @@ public:
 	/// @return True if the initialization succeeded.
 	bool init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav);
 	
+	/// Sets the callback used to run the per-agent phases of update() in parallel. (Atomic)
+	/// Each thread gets its own navigation mesh and obstacle avoidance queries. The results are identical to a serial update.
+	///  @param[in]		func		The parallel for callback, or null to update serially.
+	///  @param[in]		userData	User data passed to the callback.
+	///  @param[in]		maxThreads	The number of threads that may call the range functions, including the calling thread.
+	/// @return True if the per-thread queries could be allocated.
+	bool setParallelFor(dtCrowdParallelForFunc* func, void* userData, const int maxThreads);
+
 	/// Sets the shared avoidance configuration for the specified index.
 	///  @param[in]		idx		The index. [Limits: 0 <= value < #DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS]
 	///  @param[in]		params	The new configuration.
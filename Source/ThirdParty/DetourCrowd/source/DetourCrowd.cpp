@@ -340,7 +340,16 @@ dtCrowd::dtCrowd() :
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_navquery(0),
+	m_parallelFor(0),
+	m_parallelForUserData(0),
+	m_maxThreads(1),
+	m_threadNavQueries(0),
+	m_threadObstacleQueries(0),
+	m_threadVelocitySampleCounts(0),
+	m_updateAgentCount(0),
+	m_updateDt(0),
+	m_updateDebug(0)
 {
 }
 
@@ -351,6 +360,10 @@ dtCrowd::~dtCrowd()
 
 void dtCrowd::purge()
 {
+	freeThreadQueries();
+	m_parallelFor = 0;
+	m_parallelForUserData = 0;
+
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -461,6 +474,71 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	return true;
 }
 
+void dtCrowd::freeThreadQueries()
+{
+	// Index 0 is the crowd's own query and is freed separately.
+	for (int i = 1; i < m_maxThreads; ++i)
+	{
+		if (m_threadNavQueries)
+			dtFreeNavMeshQuery(m_threadNavQueries[i]);
+		if (m_threadObstacleQueries)
+			dtFreeObstacleAvoidanceQuery(m_threadObstacleQueries[i]);
+	}
+	dtFree(m_threadNavQueries);
+	m_threadNavQueries = 0;
+	dtFree(m_threadObstacleQueries);
+	m_threadObstacleQueries = 0;
+	dtFree(m_threadVelocitySampleCounts);
+	m_threadVelocitySampleCounts = 0;
+	m_maxThreads = 1;
+}
+
+bool dtCrowd::setParallelFor(dtCrowdParallelForFunc* func, void* userData, const int maxThreads)
+{
+	freeThreadQueries();
+	m_parallelFor = 0;
+	m_parallelForUserData = 0;
+	
+	if (!func || maxThreads <= 1)
+		return true;
+	if (!m_navquery || !m_obstacleQuery)
+		return false;
+	
+	m_threadNavQueries = (dtNavMeshQuery**)dtAlloc(sizeof(dtNavMeshQuery*)*maxThreads, DT_ALLOC_PERM);
+	m_threadObstacleQueries = (dtObstacleAvoidanceQuery**)dtAlloc(sizeof(dtObstacleAvoidanceQuery*)*maxThreads, DT_ALLOC_PERM);
+	m_threadVelocitySampleCounts = (int*)dtAlloc(sizeof(int)*maxThreads, DT_ALLOC_PERM);
+	if (!m_threadNavQueries || !m_threadObstacleQueries || !m_threadVelocitySampleCounts)
+	{
+		freeThreadQueries();
+		return false;
+	}
+	memset(m_threadNavQueries, 0, sizeof(dtNavMeshQuery*)*maxThreads);
+	memset(m_threadObstacleQueries, 0, sizeof(dtObstacleAvoidanceQuery*)*maxThreads);
+	m_maxThreads = maxThreads;
+	
+	m_threadNavQueries[0] = m_navquery;
+	m_threadObstacleQueries[0] = m_obstacleQuery;
+	for (int i = 1; i < maxThreads; ++i)
+	{
+		m_threadNavQueries[i] = dtAllocNavMeshQuery();
+		if (!m_threadNavQueries[i] || dtStatusFailed(m_threadNavQueries[i]->init(m_navquery->getAttachedNavMesh(), MAX_COMMON_NODES)))
+		{
+			freeThreadQueries();
+			return false;
+		}
+		m_threadObstacleQueries[i] = dtAllocObstacleAvoidanceQuery();
+		if (!m_threadObstacleQueries[i] || !m_threadObstacleQueries[i]->init(6, 8))
+		{
+			freeThreadQueries();
+			return false;
+		}
+	}
+	
+	m_parallelFor = func;
+	m_parallelForUserData = userData;
+	return true;
+}
+
 void dtCrowd::setObstacleAvoidanceParams(const int idx, const dtObstacleAvoidanceParams* params)
 {
 	if (idx >= 0 && idx < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
@@ -1046,8 +1124,6 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 {
 	m_velocitySampleCount = 0;
 	
-	const int debugIdx = debug ? debug->idx : -1;
-	
 	dtCrowdAgent** agents = m_activeAgents;
 	int nagents = getActiveAgents(agents, m_maxAgents);
 
@@ -1070,8 +1146,157 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
 	}
 	
+	// Atomic: the per-agent phases only write the data of their own agent, so they are run through runPhase(),
+	// which can split them over several threads.
+	m_updateAgentCount = nagents;
+	m_updateDt = dt;
+	m_updateDebug = debug;
+	
 	// Get nearby navmesh segments and agents to collide with.
+	runPhase(&dtCrowd::updateNeighbours, nagents);
+	
+	// Find next corner to steer to.
+	runPhase(&dtCrowd::updateCorners, nagents);
+	
+	// Trigger off-mesh connections (depends on corners).
 	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			continue;
+		
+		// Check 
+		const float triggerRadius = ag->params.radius*2.25f;
+		if (overOffmeshConnection(ag, triggerRadius))
+		{
+			// Prepare to off-mesh connection.
+			const int idx = (int)(ag - m_agents);
+			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+			
+			// Adjust the path over the off-mesh connection.
+			dtPolyRef refs[2];
+			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
+													   anim->startPos, anim->endPos, m_navquery))
+			{
+				dtVcopy(anim->initPos, ag->npos);
+				anim->polyRef = refs[1];
+				anim->active = true;
+				anim->t = 0.0f;
+				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+				
+				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+				ag->ncorners = 0;
+				ag->nneis = 0;
+				continue;
+			}
+			else
+			{
+				// Path validity check will ensure that bad/blocked connections will be replanned.
+			}
+		}
+	}
+		
+	// Calculate steering.
+	runPhase(&dtCrowd::updateSteering, nagents);
+	
+	// Velocity planning.
+	for (int i = 0; i < m_maxThreads; ++i)
+	{
+		if (m_threadVelocitySampleCounts)
+			m_threadVelocitySampleCounts[i] = 0;
+	}
+	runPhase(&dtCrowd::updateVelocityPlanning, nagents);
+	if (m_threadVelocitySampleCounts)
+	{
+		for (int i = 0; i < m_maxThreads; ++i)
+			m_velocitySampleCount += m_threadVelocitySampleCounts[i];
+	}
+	
+	// Integrate.
+	runPhase(&dtCrowd::updateIntegration, nagents);
+	
+	// Handle collisions.
+	for (int iter = 0; iter < 4; ++iter)
+	{
+		runPhase(&dtCrowd::updateCollisionDisplacement, nagents);
+		runPhase(&dtCrowd::applyCollisionDisplacement, nagents);
+	}
+	
+	// Move along navmesh.
+	runPhase(&dtCrowd::updateMovePosition, nagents);
+	
+	// Update agents using off-mesh connection.
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		dtCrowdAgentAnimation* anim = &m_agentAnims[i];
+		if (!anim->active)
+			continue;
+		dtCrowdAgent* ag = agents[i];
+
+		anim->t += dt;
+		if (anim->t > anim->tmax)
+		{
+			// Reset animation
+			anim->active = false;
+			// Prepare agent for walking.
+			ag->state = DT_CROWDAGENT_STATE_WALKING;
+			continue;
+		}
+		
+		// Update position
+		const float ta = anim->tmax*0.15f;
+		const float tb = anim->tmax;
+		if (anim->t < ta)
+		{
+			const float u = tween(anim->t, 0.0, ta);
+			dtVlerp(ag->npos, anim->initPos, anim->startPos, u);
+		}
+		else
+		{
+			const float u = tween(anim->t, ta, tb);
+			dtVlerp(ag->npos, anim->startPos, anim->endPos, u);
+		}
+			
+		// Update velocity.
+		dtVset(ag->vel, 0,0,0);
+		dtVset(ag->dvel, 0,0,0);
+	}
+	
+}
+
+void dtCrowd::runPhaseRange(void* context, const int begin, const int end, const int threadIndex)
+{
+	PhaseContext* phase = (PhaseContext*)context;
+	(phase->crowd->*phase->func)(begin, end, threadIndex);
+}
+
+void dtCrowd::runPhase(PhaseFunc func, const int count)
+{
+	if (count <= 0)
+		return;
+	
+	if (!m_parallelFor)
+	{
+		(this->*func)(0, count, 0);
+		return;
+	}
+	
+	PhaseContext context;
+	context.crowd = this;
+	context.func = func;
+	m_parallelFor(m_parallelForUserData, runPhaseRange, &context, count);
+}
+
+void dtCrowd::updateNeighbours(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+	const int nagents = m_updateAgentCount;
+	dtNavMeshQuery* navquery = m_threadNavQueries ? m_threadNavQueries[threadIndex] : m_navquery;
+	
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
@@ -1081,10 +1306,10 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		// if it has become invalid.
 		const float updateThr = ag->params.collisionQueryRange*0.25f;
 		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
+			!ag->boundary.isValid(navquery, &m_filters[ag->params.queryFilterType]))
 		{
 			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
+								navquery, &m_filters[ag->params.queryFilterType]);
 		}
 		// Query neighbour agents
 		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
@@ -1093,9 +1318,16 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		for (int j = 0; j < ag->nneis; j++)
 			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
 	}
+}
+
+void dtCrowd::updateCorners(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+	dtCrowdAgentDebugInfo* debug = m_updateDebug;
+	const int debugIdx = debug ? debug->idx : -1;
+	dtNavMeshQuery* navquery = m_threadNavQueries ? m_threadNavQueries[threadIndex] : m_navquery;
 	
-	// Find next corner to steer to.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
@@ -1106,14 +1338,14 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		
 		// Find corners for steering
 		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
+												DT_CROWDAGENT_MAX_CORNERS, navquery, &m_filters[ag->params.queryFilterType]);
 		
 		// Check to see if the corner after the next corner is directly visible,
 		// and short cut to there.
 		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
 		{
 			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
+			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, navquery, &m_filters[ag->params.queryFilterType]);
 			
 			// Copy data for debug purposes.
 			if (debugIdx == i)
@@ -1132,50 +1364,13 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			}
 		}
 	}
+}
+
+void dtCrowd::updateSteering(const int begin, const int end, const int /*threadIndex*/)
+{
+	dtCrowdAgent** agents = m_activeAgents;
 	
-	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
-		
-		// Check 
-		const float triggerRadius = ag->params.radius*2.25f;
-		if (overOffmeshConnection(ag, triggerRadius))
-		{
-			// Prepare to off-mesh connection.
-			const int idx = (int)(ag - m_agents);
-			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
-			
-			// Adjust the path over the off-mesh connection.
-			dtPolyRef refs[2];
-			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
-													   anim->startPos, anim->endPos, m_navquery))
-			{
-				dtVcopy(anim->initPos, ag->npos);
-				anim->polyRef = refs[1];
-				anim->active = true;
-				anim->t = 0.0f;
-				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
-				
-				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
-				ag->ncorners = 0;
-				ag->nneis = 0;
-				continue;
-			}
-			else
-			{
-				// Path validity check will ensure that bad/blocked connections will be replanned.
-			}
-		}
-	}
-		
-	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 
@@ -1252,9 +1447,17 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		// Set the desired velocity.
 		dtVcopy(ag->dvel, dvel);
 	}
+}
+
+void dtCrowd::updateVelocityPlanning(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+	dtCrowdAgentDebugInfo* debug = m_updateDebug;
+	const int debugIdx = debug ? debug->idx : -1;
+	dtObstacleAvoidanceQuery* obstacleQuery = m_threadObstacleQueries ? m_threadObstacleQueries[threadIndex] : m_obstacleQuery;
+	int velocitySampleCount = 0;
 	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
@@ -1263,13 +1466,13 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		
 		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
 		{
-			m_obstacleQuery->reset();
+			obstacleQuery->reset();
 			
 			// Add neighbours as obstacles.
 			for (int j = 0; j < ag->nneis; ++j)
 			{
 				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
+				obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
 			}
 
 			// Append neighbour segments as obstacles.
@@ -1278,7 +1481,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				const float* s = ag->boundary.getSegment(j);
 				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
 					continue;
-				m_obstacleQuery->addSegment(s, s+3);
+				obstacleQuery->addSegment(s, s+3);
 			}
 
 			dtObstacleAvoidanceDebugData* vod = 0;
@@ -1293,15 +1496,15 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				
 			if (adaptive)
 			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
-															 ag->vel, ag->dvel, ag->nvel, params, vod);
+				ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+														   ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
 			else
 			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
+				ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
+													   ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
-			m_velocitySampleCount += ns;
+			velocitySampleCount += ns;
 		}
 		else
 		{
@@ -1309,91 +1512,112 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			dtVcopy(ag->nvel, ag->dvel);
 		}
 	}
+	
+	if (m_threadVelocitySampleCounts)
+		m_threadVelocitySampleCounts[threadIndex] += velocitySampleCount;
+	else
+		m_velocitySampleCount += velocitySampleCount;
+}
 
-	// Integrate.
-	for (int i = 0; i < nagents; ++i)
+void dtCrowd::updateIntegration(const int begin, const int end, const int /*threadIndex*/)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
-		integrate(ag, dt);
+		integrate(ag, m_updateDt);
 	}
-	
-	// Handle collisions.
+}
+
+void dtCrowd::updateCollisionDisplacement(const int begin, const int end, const int /*threadIndex*/)
+{
 	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
 	
-	for (int iter = 0; iter < 4; ++iter)
+	dtCrowdAgent** agents = m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
 	{
-		for (int i = 0; i < nagents; ++i)
+		dtCrowdAgent* ag = agents[i];
+		const int idx0 = getAgentIndex(ag);
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+
+		dtVset(ag->disp, 0,0,0);
+		
+		float w = 0;
+
+		for (int j = 0; j < ag->nneis; ++j)
 		{
-			dtCrowdAgent* ag = agents[i];
-			const int idx0 = getAgentIndex(ag);
-			
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
+			const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+			const int idx1 = getAgentIndex(nei);
 
-			dtVset(ag->disp, 0,0,0);
+			float diff[3];
+			dtVsub(diff, ag->npos, nei->npos);
+			diff[1] = 0;
 			
-			float w = 0;
-
-			for (int j = 0; j < ag->nneis; ++j)
+			float dist = dtVlenSqr(diff);
+			if (dist > dtSqr(ag->params.radius + nei->params.radius))
+				continue;
+			dist = dtMathSqrtf(dist);
+			float pen = (ag->params.radius + nei->params.radius) - dist;
+			if (dist < 0.0001f)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				const int idx1 = getAgentIndex(nei);
-
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				float dist = dtVlenSqr(diff);
-				if (dist > dtSqr(ag->params.radius + nei->params.radius))
-					continue;
-				dist = dtMathSqrtf(dist);
-				float pen = (ag->params.radius + nei->params.radius) - dist;
-				if (dist < 0.0001f)
-				{
-					// Agents on top of each other, try to choose diverging separation directions.
-					if (idx0 > idx1)
-						dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
-					else
-						dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
-					pen = 0.01f;
-				}
+				// Agents on top of each other, try to choose diverging separation directions.
+				if (idx0 > idx1)
+					dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
 				else
-				{
-					pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
-				}
-				
-				dtVmad(ag->disp, ag->disp, diff, pen);			
-				
-				w += 1.0f;
+					dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
+				pen = 0.01f;
 			}
-			
-			if (w > 0.0001f)
+			else
 			{
-				const float iw = 1.0f / w;
-				dtVscale(ag->disp, ag->disp, iw);
+				pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
 			}
+			
+			dtVmad(ag->disp, ag->disp, diff, pen);			
+			
+			w += 1.0f;
 		}
 		
-		for (int i = 0; i < nagents; ++i)
+		if (w > 0.0001f)
 		{
-			dtCrowdAgent* ag = agents[i];
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
-			
-			dtVadd(ag->npos, ag->npos, ag->disp);
+			const float iw = 1.0f / w;
+			dtVscale(ag->disp, ag->disp, iw);
 		}
 	}
+}
+
+void dtCrowd::applyCollisionDisplacement(const int begin, const int end, const int /*threadIndex*/)
+{
+	dtCrowdAgent** agents = m_activeAgents;
 	
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		
+		dtVadd(ag->npos, ag->npos, ag->disp);
+	}
+}
+
+void dtCrowd::updateMovePosition(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_activeAgents;
+	dtNavMeshQuery* navquery = m_threadNavQueries ? m_threadNavQueries[threadIndex] : m_navquery;
+	
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
 		
 		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
+		ag->corridor.movePosition(ag->npos, navquery, &m_filters[ag->params.queryFilterType]);
 		// Get valid constrained position back.
 		dtVcopy(ag->npos, ag->corridor.getPos());
 
@@ -1403,44 +1627,5 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
 			ag->partial = false;
 		}
-
-	}
-	
-	// Update agents using off-mesh connection.
-	for (int i = 0; i < m_maxAgents; ++i)
-	{
-		dtCrowdAgentAnimation* anim = &m_agentAnims[i];
-		if (!anim->active)
-			continue;
-		dtCrowdAgent* ag = agents[i];
-
-		anim->t += dt;
-		if (anim->t > anim->tmax)
-		{
-			// Reset animation
-			anim->active = false;
-			// Prepare agent for walking.
-			ag->state = DT_CROWDAGENT_STATE_WALKING;
-			continue;
-		}
-		
-		// Update position
-		const float ta = anim->tmax*0.15f;
-		const float tb = anim->tmax;
-		if (anim->t < ta)
-		{
-			const float u = tween(anim->t, 0.0, ta);
-			dtVlerp(ag->npos, anim->initPos, anim->startPos, u);
-		}
-		else
-		{
-			const float u = tween(anim->t, ta, tb);
-			dtVlerp(ag->npos, anim->startPos, anim->endPos, u);
-		}
-			
-		// Update velocity.
-		dtVset(ag->vel, 0,0,0);
-		dtVset(ag->dvel, 0,0,0);
 	}
-	
 }
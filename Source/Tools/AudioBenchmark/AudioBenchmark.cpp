@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Audio/Audio.h>
+#include <Atomic/Audio/Sound.h>
+#include <Atomic/Audio/SoundSource.h>
+#include <Atomic/Container/ArrayPtr.h>
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/IO/File.h>
+#include <Atomic/Math/MathDefs.h>
+#include <Atomic/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+/// Length of the generated test sounds in sample frames.
+static const unsigned TEST_SOUND_FRAMES = 44100;
+
+SharedPtr<Context> context_(new Context());
+SharedPtr<Audio> audio_;
+unsigned numSources_ = 32;
+float duration_ = 10.0f;
+int mixRate_ = 44100;
+bool stereoOutput_ = true;
+String oggFileName_;
+String wavFileName_;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+SharedPtr<Sound> CreateTestSound(bool sixteenBit, bool stereo);
+void Benchmark(const String& name, Sound* sound, bool interpolation);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+        if (argument == "-n" && !value.Empty())
+        {
+            numSources_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-t" && !value.Empty())
+        {
+            duration_ = Max(ToFloat(value), 0.01f);
+            ++i;
+        }
+        else if (argument == "-r" && !value.Empty())
+        {
+            mixRate_ = ToInt(value);
+            ++i;
+        }
+        else if (argument == "-m")
+            stereoOutput_ = false;
+        else if (argument == "-o" && !value.Empty())
+        {
+            oggFileName_ = value;
+            ++i;
+        }
+        else if (argument == "-w" && !value.Empty())
+        {
+            wavFileName_ = value;
+            ++i;
+        }
+        else
+        {
+            ErrorExit(
+                "Usage: AudioBenchmark [options]\n"
+                "\n"
+                "Mixes sound sources without an audio device and reports the mixing time.\n"
+                "\n"
+                "Options:\n"
+                "-n <sources>  Number of sound sources to mix, default 32\n"
+                "-t <seconds>  Length of output to mix per test, default 10\n"
+                "-r <rate>     Mixing rate, default 44100\n"
+                "-m            Mono output\n"
+                "-o <file>     Also test Ogg Vorbis streaming with the given file\n"
+                "-w <file>     Write the output of the first test to a WAV file\n"
+            );
+        }
+    }
+
+    audio_ = new Audio(context_);
+    context_->RegisterSubsystem(audio_);
+
+    PrintLine(String(numSources_) + " sources, " + String(duration_) + " s of " + (stereoOutput_ ? "stereo" : "mono") +
+        " output per test");
+
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        bool sixteenBit = (i & 1) != 0;
+        bool stereo = (i & 2) != 0;
+        String name = String(stereo ? "stereo " : "mono ") + (sixteenBit ? "16-bit" : "8-bit");
+        SharedPtr<Sound> sound = CreateTestSound(sixteenBit, stereo);
+
+        Benchmark(name, sound, false);
+        Benchmark(name + " interpolated", sound, true);
+    }
+
+    if (!oggFileName_.Empty())
+    {
+        File file(context_, oggFileName_);
+        SharedPtr<Sound> sound(new Sound(context_));
+        if (!file.IsOpen() || !sound->LoadOggVorbis(file))
+            ErrorExit("Could not load Ogg Vorbis file " + oggFileName_);
+        sound->SetLooped(true);
+
+        Benchmark("Ogg Vorbis stream", sound, false);
+        Benchmark("Ogg Vorbis stream interpolated", sound, true);
+    }
+}
+
+SharedPtr<Sound> CreateTestSound(bool sixteenBit, bool stereo)
+{
+    unsigned channels = stereo ? 2 : 1;
+    unsigned numSamples = TEST_SOUND_FRAMES * channels;
+
+    SharedPtr<Sound> sound(new Sound(context_));
+    sound->SetSize(numSamples * (sixteenBit ? sizeof(short) : sizeof(signed char)));
+    sound->SetFormat(44100, sixteenBit, stereo);
+
+    // A sine with some noise, different per channel
+    signed char* data = sound->GetStart();
+    for (unsigned i = 0; i < numSamples; ++i)
+    {
+        float value = Sin((float)(i / channels) * (i % channels ? 5.0f : 4.0f)) * 0.75f + (Random() - 0.5f) * 0.25f;
+        if (sixteenBit)
+            ((short*)data)[i] = (short)(value * 32767.0f);
+        else
+            data[i] = (signed char)(value * 127.0f);
+    }
+
+    sound->SetLooped(true);
+    return sound;
+}
+
+void Benchmark(const String& name, Sound* sound, bool interpolation)
+{
+    if (!audio_->SetOfflineMode(mixRate_, stereoOutput_, interpolation))
+        ErrorExit("Could not set offline audio mode");
+
+    // Detune the sound sources so that they resample at different rates
+    SharedPtr<Scene> scene(new Scene(context_));
+    for (unsigned i = 0; i < numSources_; ++i)
+    {
+        SoundSource* source = scene->CreateChild()->CreateComponent<SoundSource>();
+        source->SetGain(1.0f / numSources_);
+        source->SetPanning(Random(-1.0f, 1.0f));
+        source->Play(sound, sound->GetFrequency() * Random(0.9f, 1.1f));
+    }
+
+    if (!wavFileName_.Empty())
+    {
+        File file(context_, wavFileName_, FILE_WRITE);
+        if (!file.IsOpen() || !audio_->RenderToWav(file, duration_))
+            ErrorExit("Could not write WAV file " + wavFileName_);
+        PrintLine("Wrote " + name + " output to " + wavFileName_);
+        wavFileName_.Clear();
+    }
+
+    unsigned samples = (unsigned)(duration_ * audio_->GetMixRate());
+    unsigned fragmentSamples = (unsigned)audio_->GetMixRate() / 100;
+    SharedArrayPtr<unsigned char> buffer(new unsigned char[fragmentSamples * audio_->GetSampleSize() * Audio::SAMPLE_SIZE_MUL]);
+
+    HiresTimer timer;
+    for (unsigned mixed = 0; mixed < samples; mixed += fragmentSamples)
+        audio_->MixOutput(buffer.Get(), Min((int)fragmentSamples, (int)(samples - mixed)));
+    long long usec = timer.GetUSec(false);
+
+    double nsPerSample = (double)usec * 1000.0 / (double)samples;
+    PrintLine(name + ": " + String((float)nsPerSample) + " ns per output sample, " +
+        String((float)(nsPerSample / numSources_)) + " ns per source sample");
+}
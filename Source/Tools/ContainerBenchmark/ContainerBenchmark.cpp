@@ -0,0 +1,277 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/IO/VectorBuffer.h>
+#include <Atomic/Scene/Node.h>
+#include <Atomic/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+/// Vector element that counts how many times it is copied and moved.
+struct CountedValue
+{
+    /// Construct empty.
+    CountedValue()
+    {
+    }
+
+    /// Construct with a name.
+    CountedValue(const String& name) :
+        name_(name)
+    {
+    }
+
+    /// Copy-construct.
+    CountedValue(const CountedValue& rhs) :
+        name_(rhs.name_)
+    {
+        ++copies_;
+    }
+
+    /// Move-construct.
+    CountedValue(CountedValue&& rhs) :
+        name_(static_cast<String&&>(rhs.name_))
+    {
+        ++moves_;
+    }
+
+    /// Copy-assign.
+    CountedValue& operator = (const CountedValue& rhs)
+    {
+        name_ = rhs.name_;
+        ++copies_;
+        return *this;
+    }
+
+    /// Move-assign.
+    CountedValue& operator = (CountedValue&& rhs)
+    {
+        name_ = static_cast<String&&>(rhs.name_);
+        ++moves_;
+        return *this;
+    }
+
+    /// Name, long enough to need a heap allocation.
+    String name_;
+
+    /// Number of copies.
+    static unsigned copies_;
+    /// Number of moves.
+    static unsigned moves_;
+};
+
+unsigned CountedValue::copies_ = 0;
+unsigned CountedValue::moves_ = 0;
+
+SharedPtr<Context> context_(new Context());
+unsigned count_ = 100000;
+unsigned rounds_ = 10;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void Report(const char* test, long long usec);
+void BenchmarkVector();
+void BenchmarkSharedPtrVector();
+void BenchmarkHashMap();
+void BenchmarkSceneLoad();
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+        if (argument == "-n" && !value.Empty())
+        {
+            count_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-r" && !value.Empty())
+        {
+            rounds_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else
+        {
+            ErrorExit(
+                "Usage: ContainerBenchmark [options]\n"
+                "\n"
+                "Measures element copies and moves in container growth, and scene loading.\n"
+                "\n"
+                "Options:\n"
+                "-n <count>  Number of elements, default 100000\n"
+                "-r <count>  Number of rounds per test, default 10\n"
+            );
+        }
+    }
+
+    RegisterSceneLibrary(context_);
+
+    PrintLine(String(count_) + " elements, " + String(rounds_) + " rounds per test");
+
+    BenchmarkVector();
+    BenchmarkSharedPtrVector();
+    BenchmarkHashMap();
+    BenchmarkSceneLoad();
+}
+
+void Report(const char* test, long long usec)
+{
+    PrintLine(String(test) + ": " + String((float)((double)usec / 1000.0 / (double)rounds_)) + " ms");
+}
+
+void BenchmarkVector()
+{
+    String name("A value long enough to need a heap allocation");
+    CountedValue::copies_ = 0;
+    CountedValue::moves_ = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < rounds_; ++i)
+    {
+        Vector<CountedValue> values;
+        for (unsigned j = 0; j < count_; ++j)
+            values.Push(CountedValue(name));
+        // Erasing from the front shifts the remaining elements
+        for (unsigned j = 0; j < 100 && !values.Empty(); ++j)
+            values.Erase(0);
+    }
+    Report("Vector push and erase", timer.GetUSec(false));
+
+    PrintLine("Element copies " + String(CountedValue::copies_ / rounds_) + ", moves " + String(CountedValue::moves_ / rounds_) +
+        " per round");
+}
+
+void BenchmarkSharedPtrVector()
+{
+    SharedPtr<Scene> scene(new Scene(context_));
+    Vector<SharedPtr<Node> > nodes;
+    for (unsigned i = 0; i < count_; ++i)
+        nodes.Push(SharedPtr<Node>(new Node(context_)));
+
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < rounds_; ++i)
+    {
+        // Growth relocates the pointers. Copying instead of moving them would touch the reference count of every node
+        Vector<SharedPtr<Node> > copy;
+        for (unsigned j = 0; j < count_; ++j)
+            copy.Push(nodes[j]);
+        for (unsigned j = 0; j < 100 && !copy.Empty(); ++j)
+            copy.Erase(0);
+    }
+    Report("Vector<SharedPtr> push and erase", timer.GetUSec(false));
+}
+
+void BenchmarkHashMap()
+{
+    VariantMap variables;
+    variables["Health"] = 100;
+    variables["Description"] = "A value long enough to need a heap allocation";
+
+    HiresTimer timer;
+    unsigned size = 0;
+
+    for (unsigned i = 0; i < rounds_; ++i)
+    {
+        HashMap<unsigned, Vector<String> > map;
+        for (unsigned j = 0; j < count_; ++j)
+        {
+            Vector<String> names;
+            names.Push("First");
+            names.Push("A value long enough to need a heap allocation");
+            map.Insert(MakePair(j, names));
+        }
+
+        // Returning the map by value and assigning it should not copy the contents
+        HashMap<unsigned, Vector<String> > other;
+        other = static_cast<HashMap<unsigned, Vector<String> >&&>(map);
+        size += other.Size();
+    }
+    Report("HashMap insert and move", timer.GetUSec(false));
+
+    PrintLine("HashMap checksum " + String(size));
+}
+
+void BenchmarkSceneLoad()
+{
+    SharedPtr<Scene> scene(new Scene(context_));
+    unsigned numNodes = Max(count_ / 100, 1);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = scene->CreateChild("Node" + String(i));
+        node->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+        node->SetVar("Health", 100);
+        node->SetVar("Description", "A value long enough to need a heap allocation");
+        for (unsigned j = 0; j < 4; ++j)
+            node->CreateChild("Child" + String(j));
+    }
+
+    VectorBuffer xml;
+    scene->SaveXML(xml);
+    VectorBuffer binary;
+    scene->Save(binary);
+
+    SharedPtr<Scene> loadScene(new Scene(context_));
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < rounds_; ++i)
+    {
+        xml.Seek(0);
+        loadScene->LoadXML(xml);
+    }
+    Report("Scene load XML", timer.GetUSec(true));
+
+    for (unsigned i = 0; i < rounds_; ++i)
+    {
+        binary.Seek(0);
+        loadScene->Load(binary);
+    }
+    Report("Scene load binary", timer.GetUSec(false));
+}
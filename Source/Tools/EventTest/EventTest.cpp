@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/ProcessUtils.h>
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+EVENT(E_TESTEVENT, TestEvent)
+{
+    PARAM(P_VALUE, Value);          // int
+}
+
+/// Typed payload of the test event.
+struct TestEventPayload
+{
+    /// Construct.
+    TestEventPayload(int value = 0) :
+        value_(value)
+    {
+    }
+
+    /// Return event type.
+    static StringHash GetEventTypeStatic() { return E_TESTEVENT; }
+    /// Write to event data.
+    void ToVariantMap(VariantMap& eventData) const { eventData[TestEvent::P_VALUE] = value_; }
+    /// Read from event data.
+    void FromVariantMap(VariantMap& eventData) { value_ = eventData[TestEvent::P_VALUE].GetInt(); }
+
+    /// Value.
+    int value_;
+};
+
+/// Event sender.
+class TestSender : public Object
+{
+    OBJECT(TestSender)
+
+public:
+    /// Construct.
+    TestSender(Context* context) :
+        Object(context)
+    {
+    }
+};
+
+/// Event receiver that counts the invocations of its typed and event data handlers.
+class TestReceiver : public Object
+{
+    OBJECT(TestReceiver)
+
+public:
+    /// Construct.
+    TestReceiver(Context* context) :
+        Object(context)
+    {
+        Reset();
+    }
+
+    /// Reset the counters.
+    void Reset()
+    {
+        numTyped_ = 0;
+        numUntyped_ = 0;
+        lastValue_ = 0;
+    }
+
+    /// Handle the event as a typed payload.
+    void HandleTyped(const TestEventPayload& payload)
+    {
+        ++numTyped_;
+        lastValue_ = payload.value_;
+    }
+
+    /// Handle the event as event data.
+    void HandleUntyped(StringHash eventType, VariantMap& eventData)
+    {
+        ++numUntyped_;
+        lastValue_ = eventData[TestEvent::P_VALUE].GetInt();
+    }
+
+    /// Typed handler invocations.
+    unsigned numTyped_;
+    /// Event data handler invocations.
+    unsigned numUntyped_;
+    /// Last received value.
+    int lastValue_;
+};
+
+SharedPtr<Context> context_(new Context());
+unsigned failures_ = 0;
+
+int main(int argc, char** argv);
+void Check(bool condition, const String& description);
+void CheckCounts(TestReceiver* receiver, unsigned numTyped, unsigned numUntyped, const String& description);
+void TestTypedSpecificUntypedNonSpecific();
+void TestUntypedSpecificTypedNonSpecific();
+
+int main(int argc, char** argv)
+{
+    TestTypedSpecificUntypedNonSpecific();
+    TestUntypedSpecificTypedNonSpecific();
+
+    if (failures_)
+    {
+        PrintLine(String(failures_) + " checks failed", true);
+        return EXIT_FAILURE;
+    }
+
+    PrintLine("All checks passed");
+    return EXIT_SUCCESS;
+}
+
+void Check(bool condition, const String& description)
+{
+    if (!condition)
+    {
+        PrintLine("FAILED: " + description, true);
+        ++failures_;
+    }
+}
+
+void CheckCounts(TestReceiver* receiver, unsigned numTyped, unsigned numUntyped, const String& description)
+{
+    Check(receiver->numTyped_ == numTyped, description + ": typed handler called " + String(receiver->numTyped_) +
+        " times, expected " + String(numTyped));
+    Check(receiver->numUntyped_ == numUntyped, description + ": event data handler called " + String(receiver->numUntyped_) +
+        " times, expected " + String(numUntyped));
+    Check(receiver->lastValue_ == 42, description + ": wrong value received");
+    receiver->Reset();
+}
+
+void TestTypedSpecificUntypedNonSpecific()
+{
+    SharedPtr<TestSender> sender(new TestSender(context_));
+    SharedPtr<TestReceiver> receiver(new TestReceiver(context_));
+    receiver->SubscribeToEvent(sender, Atomic::MakeTypedEventHandler<TestReceiver>(receiver.Get(), &TestReceiver::HandleTyped));
+    receiver->SubscribeToEvent(E_TESTEVENT, new EventHandlerImpl<TestReceiver>(receiver.Get(), &TestReceiver::HandleUntyped));
+
+    sender->SendTypedEvent(TestEventPayload(42));
+    CheckCounts(receiver, 1, 1, "Typed specific and event data non-specific, typed send");
+
+    VariantMap eventData;
+    eventData[TestEvent::P_VALUE] = 42;
+    sender->SendEvent(E_TESTEVENT, eventData);
+    CheckCounts(receiver, 1, 1, "Typed specific and event data non-specific, event data send");
+}
+
+void TestUntypedSpecificTypedNonSpecific()
+{
+    SharedPtr<TestSender> sender(new TestSender(context_));
+    SharedPtr<TestReceiver> receiver(new TestReceiver(context_));
+    receiver->SubscribeToEvent(sender, E_TESTEVENT, new EventHandlerImpl<TestReceiver>(receiver.Get(), &TestReceiver::HandleUntyped));
+    receiver->SubscribeToEvent(Atomic::MakeTypedEventHandler<TestReceiver>(receiver.Get(), &TestReceiver::HandleTyped));
+
+    sender->SendTypedEvent(TestEventPayload(42));
+    CheckCounts(receiver, 1, 1, "Event data specific and typed non-specific, typed send");
+
+    VariantMap eventData;
+    eventData[TestEvent::P_VALUE] = 42;
+    sender->SendEvent(E_TESTEVENT, eventData);
+    CheckCounts(receiver, 1, 1, "Event data specific and typed non-specific, event data send");
+}
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Container/FlatHashMap.h>
+#include <Atomic/Container/HashMap.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Math/StringHash.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+unsigned numKeys_ = 100000;
+unsigned numRounds_ = 10;
+PODVector<StringHash> keys_;
+PODVector<StringHash> missingKeys_;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void Report(const String& name, const char* test, long long usec, unsigned operations);
+template <class T> void Benchmark(const String& name);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+        if (argument == "-n" && !value.Empty())
+        {
+            numKeys_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-r" && !value.Empty())
+        {
+            numRounds_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else
+        {
+            ErrorExit(
+                "Usage: HashMapBenchmark [options]\n"
+                "\n"
+                "Compares HashMap and FlatHashMap with StringHash keys.\n"
+                "\n"
+                "Options:\n"
+                "-n <keys>    Number of keys, default 100000\n"
+                "-r <rounds>  Number of rounds per test, default 10\n"
+            );
+        }
+    }
+
+    // Hash generated names like the engine does for attribute and event names
+    keys_.Resize(numKeys_);
+    missingKeys_.Resize(numKeys_);
+    for (unsigned i = 0; i < numKeys_; ++i)
+    {
+        keys_[i] = StringHash("Key" + String(i));
+        missingKeys_[i] = StringHash("Missing" + String(i));
+    }
+
+    PrintLine(String(numKeys_) + " keys, " + String(numRounds_) + " rounds per test");
+
+    Benchmark<HashMap<StringHash, unsigned> >("HashMap");
+    Benchmark<FlatHashMap<StringHash, unsigned> >("FlatHashMap");
+}
+
+void Report(const String& name, const char* test, long long usec, unsigned operations)
+{
+    PrintLine(name + " " + test + ": " + String((float)((double)usec * 1000.0 / (double)operations)) + " ns per operation");
+}
+
+template <class T> void Benchmark(const String& name)
+{
+    unsigned operations = numKeys_ * numRounds_;
+    unsigned sum = 0;
+    long long insertUSec = 0;
+    long long findUSec = 0;
+    long long missUSec = 0;
+    long long iterateUSec = 0;
+    long long eraseUSec = 0;
+    HiresTimer timer;
+
+    for (unsigned round = 0; round < numRounds_; ++round)
+    {
+        T map;
+
+        timer.Reset();
+        for (unsigned i = 0; i < numKeys_; ++i)
+            map[keys_[i]] = i;
+        insertUSec += timer.GetUSec(true);
+
+        for (unsigned i = 0; i < numKeys_; ++i)
+        {
+            typename T::ConstIterator j = map.Find(keys_[i]);
+            if (j != map.End())
+                sum += j->second_;
+        }
+        findUSec += timer.GetUSec(true);
+
+        for (unsigned i = 0; i < numKeys_; ++i)
+        {
+            if (map.Find(missingKeys_[i]) != map.End())
+                ++sum;
+        }
+        missUSec += timer.GetUSec(true);
+
+        for (typename T::ConstIterator i = map.Begin(); i != map.End(); ++i)
+            sum += i->second_;
+        iterateUSec += timer.GetUSec(true);
+
+        for (unsigned i = 0; i < numKeys_; ++i)
+            map.Erase(keys_[i]);
+        eraseUSec += timer.GetUSec(true);
+    }
+
+    Report(name, "insert", insertUSec, operations);
+    Report(name, "find", findUSec, operations);
+    Report(name, "find missing", missUSec, operations);
+    Report(name, "iterate", iterateUSec, operations);
+    Report(name, "erase", eraseUSec, operations);
+    // Print the checksum so that the lookups can not be optimized away
+    PrintLine(name + " checksum " + String(sum));
+}
@@ -0,0 +1,204 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/CoreEvents.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Core/WorkQueue.h>
+#include <Atomic/Physics/CollisionShape.h>
+#include <Atomic/Physics/PhysicsWorld.h>
+#include <Atomic/Physics/RigidBody.h>
+#include <Atomic/Scene/Node.h>
+#include <Atomic/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+/// Physics stepping mode to benchmark.
+enum StepMode
+{
+    STEP_SERIAL = 0,
+    STEP_THREADED,
+    STEP_PARALLEL
+};
+
+SharedPtr<Context> context_(new Context());
+unsigned gridSize_ = 10;
+unsigned stackHeight_ = 10;
+unsigned numSteps_ = 600;
+int numThreads_ = -1;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+SharedPtr<Scene> CreateScene();
+void Benchmark(const String& name, StepMode mode);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+        if (argument == "-g" && !value.Empty())
+        {
+            gridSize_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-h" && !value.Empty())
+        {
+            stackHeight_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-s" && !value.Empty())
+        {
+            numSteps_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-w" && !value.Empty())
+        {
+            numThreads_ = Max(ToInt(value), 0);
+            ++i;
+        }
+        else
+        {
+            ErrorExit(
+                "Usage: PhysicsBenchmark [options]\n"
+                "\n"
+                "Steps a scene of stacked rigid bodies serially, on the physics thread and with the parallel island\n"
+                "solver and narrowphase, and reports the time per step.\n"
+                "\n"
+                "Options:\n"
+                "-g <size>     Grid size of the stacks, default 10 (10 x 10 stacks)\n"
+                "-h <height>   Number of boxes per stack, default 10\n"
+                "-s <steps>    Number of steps per test, default 600\n"
+                "-w <threads>  Number of worker threads, default one less than the physical CPU count\n"
+            );
+        }
+    }
+
+    RegisterSceneLibrary(context_);
+    RegisterPhysicsLibrary(context_);
+
+    WorkQueue* queue = new WorkQueue(context_);
+    context_->RegisterSubsystem(queue);
+    queue->CreateThreads(numThreads_ >= 0 ? numThreads_ : Max((int)GetNumPhysicalCPUs() - 1, 0));
+
+    PrintLine(String(gridSize_ * gridSize_ * stackHeight_) + " bodies in " + String(gridSize_ * gridSize_) + " stacks, " +
+        String(numSteps_) + " steps per test, " + String(queue->GetNumThreads()) + " worker threads");
+
+    Benchmark("Serial", STEP_SERIAL);
+    Benchmark("Threaded", STEP_THREADED);
+    Benchmark("Parallel islands", STEP_PARALLEL);
+}
+
+SharedPtr<Scene> CreateScene()
+{
+    SharedPtr<Scene> scene(new Scene(context_));
+    scene->CreateComponent<PhysicsWorld>();
+
+    float extent = (float)gridSize_ * 2.0f;
+    Node* floorNode = scene->CreateChild("Floor");
+    floorNode->SetPosition(Vector3(0.0f, -0.5f, 0.0f));
+    floorNode->CreateComponent<RigidBody>();
+    floorNode->CreateComponent<CollisionShape>()->SetBox(Vector3(extent * 2.0f, 1.0f, extent * 2.0f));
+
+    // Separate stacks form separate simulation islands once they touch only the static floor
+    for (unsigned x = 0; x < gridSize_; ++x)
+    {
+        for (unsigned z = 0; z < gridSize_; ++z)
+        {
+            for (unsigned y = 0; y < stackHeight_; ++y)
+            {
+                Node* boxNode = scene->CreateChild("Box");
+                boxNode->SetPosition(Vector3((float)x * 2.0f - extent * 0.5f, (float)y + 0.5f, (float)z * 2.0f - extent * 0.5f));
+                RigidBody* body = boxNode->CreateComponent<RigidBody>();
+                body->SetMass(1.0f);
+                body->SetFriction(0.75f);
+                boxNode->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+            }
+        }
+    }
+
+    return scene;
+}
+
+void Benchmark(const String& name, StepMode mode)
+{
+    SharedPtr<Scene> scene = CreateScene();
+    PhysicsWorld* physicsWorld = scene->GetComponent<PhysicsWorld>();
+    physicsWorld->SetThreaded(mode == STEP_THREADED);
+    physicsWorld->SetParallelSolver(mode == STEP_PARALLEL);
+    physicsWorld->SetParallelNarrowphase(mode == STEP_PARALLEL);
+
+    float timeStep = 1.0f / physicsWorld->GetFps();
+    VariantMap& eventData = scene->GetEventDataMap();
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numSteps_; ++i)
+    {
+        scene->Update(timeStep);
+        // The threaded step runs between the post-render update and the end of the frame
+        if (mode == STEP_THREADED)
+        {
+            scene->SendEvent(E_POSTRENDERUPDATE, eventData);
+            scene->SendEvent(E_ENDFRAME, eventData);
+        }
+    }
+    long long usec = timer.GetUSec(false);
+
+    // Count the bodies still moving, so that differing results between the modes are visible
+    unsigned numActive = 0;
+    PODVector<RigidBody*> bodies;
+    scene->GetComponents<RigidBody>(bodies, true);
+    for (unsigned i = 0; i < bodies.Size(); ++i)
+    {
+        if (bodies[i]->IsActive())
+            ++numActive;
+    }
+
+    PrintLine(name + ": " + String((float)((double)usec / 1000.0 / numSteps_)) + " ms per step, " + String(numActive) +
+        " bodies active at the end");
+}
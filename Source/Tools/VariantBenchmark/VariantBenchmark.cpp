@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Scene/Node.h>
+#include <Atomic/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+EVENT(E_BENCHMARK, Benchmark)
+{
+    PARAM(P_POSITION, Position);    // Vector3
+    PARAM(P_TRANSFORM, Transform);  // Matrix3x4
+    PARAM(P_NAME, Name);            // String
+    PARAM(P_VARIABLES, Variables);  // VariantMap
+}
+
+/// Event receiver that reads the benchmark event parameters.
+class BenchmarkReceiver : public Object
+{
+    OBJECT(BenchmarkReceiver)
+
+public:
+    /// Construct and subscribe to the benchmark event.
+    BenchmarkReceiver(Context* context) :
+        Object(context),
+        sum_(0.0f)
+    {
+        SubscribeToEvent(E_BENCHMARK, HANDLER(BenchmarkReceiver, HandleBenchmark));
+    }
+
+    /// Handle the benchmark event.
+    void HandleBenchmark(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace Benchmark;
+
+        sum_ += eventData[P_POSITION].GetVector3().x_;
+        sum_ += eventData[P_TRANSFORM].GetMatrix3x4().m03_;
+        sum_ += (float)eventData[P_NAME].GetString().Length();
+        sum_ += (float)eventData[P_VARIABLES].GetVariantMap().Size();
+    }
+
+    /// Sum of the read values.
+    float sum_;
+};
+
+SharedPtr<Context> context_(new Context());
+unsigned iterations_ = 1000000;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void Report(const char* test, long long usec);
+void BenchmarkCopy();
+void BenchmarkAttributes();
+void BenchmarkEvents();
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+        if (argument == "-n" && !value.Empty())
+        {
+            iterations_ = Max(ToInt(value), 1);
+            ++i;
+        }
+        else
+        {
+            ErrorExit(
+                "Usage: VariantBenchmark [options]\n"
+                "\n"
+                "Measures Variant copying, attribute access and event sending.\n"
+                "\n"
+                "Options:\n"
+                "-n <count>  Number of iterations per test, default 1000000\n"
+            );
+        }
+    }
+
+    RegisterSceneLibrary(context_);
+
+    PrintLine(String(iterations_) + " iterations per test");
+
+    BenchmarkCopy();
+    BenchmarkAttributes();
+    BenchmarkEvents();
+}
+
+void Report(const char* test, long long usec)
+{
+    PrintLine(String(test) + ": " + String((float)((double)usec * 1000.0 / (double)iterations_)) + " ns");
+}
+
+void BenchmarkCopy()
+{
+    VariantMap variables;
+    variables["Health"] = 100;
+    variables["Target"] = Vector3(1.0f, 2.0f, 3.0f);
+    variables["Description"] = "A value long enough to need a heap allocation";
+
+    Variant sources[] = {
+        Variant(Vector3(1.0f, 2.0f, 3.0f)),
+        Variant(Matrix3x4(Vector3::ONE, Quaternion::IDENTITY, 2.0f)),
+        Variant("Short"),
+        Variant(ResourceRef(StringHash("Texture2D"), "Textures/Texture.png")),
+        Variant(variables)
+    };
+    const char* names[] = {
+        "Copy Vector3 variant",
+        "Copy Matrix3x4 variant",
+        "Copy short String variant",
+        "Copy ResourceRef variant",
+        "Copy VariantMap variant"
+    };
+
+    HiresTimer timer;
+    unsigned count = 0;
+    for (unsigned i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i)
+    {
+        timer.Reset();
+        for (unsigned j = 0; j < iterations_; ++j)
+        {
+            Variant copy(sources[i]);
+            count += copy.GetType();
+        }
+        Report(names[i], timer.GetUSec(false));
+    }
+
+    // Print the count so that the copies can not be optimized away
+    PrintLine("Copy checksum " + String(count));
+}
+
+void BenchmarkAttributes()
+{
+    SharedPtr<Scene> scene(new Scene(context_));
+    Node* node = scene->CreateChild("Node");
+    node->SetVar("Health", 100);
+    node->SetVar("Description", "A value long enough to need a heap allocation");
+
+    Variant position(Vector3(1.0f, 2.0f, 3.0f));
+    Variant value;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < iterations_; ++i)
+        node->SetAttribute("Position", position);
+    Report("SetAttribute Position", timer.GetUSec(true));
+
+    for (unsigned i = 0; i < iterations_; ++i)
+        value = node->GetAttribute("Position");
+    Report("GetAttribute Position", timer.GetUSec(true));
+
+    for (unsigned i = 0; i < iterations_; ++i)
+        value = node->GetAttribute("Variables");
+    Report("GetAttribute Variables", timer.GetUSec(true));
+
+    for (unsigned i = 0; i < iterations_; ++i)
+        node->SetAttribute("Variables", value);
+    Report("SetAttribute Variables", timer.GetUSec(true));
+}
+
+void BenchmarkEvents()
+{
+    using namespace Benchmark;
+
+    // The receiver also sends the event, which it receives as a non-specific event
+    SharedPtr<BenchmarkReceiver> receiver(new BenchmarkReceiver(context_));
+
+    VariantMap variables;
+    variables["Health"] = 100;
+
+    VariantMap& eventData = receiver->GetEventDataMap();
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < iterations_; ++i)
+    {
+        eventData[P_POSITION] = Vector3((float)i, 0.0f, 0.0f);
+        eventData[P_TRANSFORM] = Matrix3x4::IDENTITY;
+        eventData[P_NAME] = "Event";
+        eventData[P_VARIABLES] = variables;
+        receiver->SendEvent(E_BENCHMARK, eventData);
+    }
+    Report("SendEvent", timer.GetUSec(false));
+
+    // Print the sum so that the reads can not be optimized away
+    PrintLine("Event checksum " + String(receiver->sum_));
+}